@@ -0,0 +1,208 @@
+#include "Core/Core.hpp"
+
+#include <vector>
+
+using namespace Xor;
+
+// Replays allocation traces recorded with AllocationTrace against
+// different heap allocators, so they can be compared with real workloads.
+//
+// Usage: AllocationReplay [trace files...]
+// Without arguments, a synthetic trace is recorded and replayed.
+
+static const uint FragmentationSamples = 10;
+
+template <typename Heap>
+void replay(const char *name, const AllocationTrace &trace)
+{
+    auto events   = trace.events();
+    size_t size   = std::max<size_t>(trace.capacity(), 1);
+    Heap heap(size, 1);
+
+    std::vector<Block>  blocks(trace.allocationCount());
+    std::vector<size_t> sizes(trace.allocationCount());
+    std::vector<size_t> failurePoints;
+    size_t recovered    = 0;
+    size_t liveBytes    = 0;
+    size_t peakConsumed = 0;
+
+    struct Sample
+    {
+        size_t event;
+        size_t liveBytes;
+        size_t consumedBytes;
+    };
+    std::vector<Sample> samples;
+    size_t sampleInterval = std::max<size_t>(events.size() / FragmentationSamples, 1);
+
+    Timer timer;
+    double seconds = 0;
+
+    for (size_t i = 0; i < events.size(); ++i)
+    {
+        auto &e = events[i];
+
+        switch (e.type)
+        {
+        case AllocationEvent::Type::Allocate:
+        {
+            Block b = heap.allocate(static_cast<size_t>(e.size), static_cast<uint>(e.alignment()));
+            blocks[e.allocation] = b;
+            sizes[e.allocation]  = static_cast<size_t>(e.size);
+            if (b)
+                liveBytes += sizes[e.allocation];
+            else
+                failurePoints.emplace_back(i);
+            break;
+        }
+        case AllocationEvent::Type::Release:
+        {
+            Block &b = blocks[e.allocation];
+            if (b)
+            {
+                heap.release(b);
+                liveBytes -= sizes[e.allocation];
+                b = Block();
+            }
+            break;
+        }
+        case AllocationEvent::Type::Failure:
+        {
+            // The original allocator failed here, so the allocation was never
+            // used. See if this one would have succeeded.
+            Block b = heap.allocate(static_cast<size_t>(e.size), static_cast<uint>(e.alignment()));
+            if (b)
+            {
+                heap.release(b);
+                ++recovered;
+            }
+            break;
+        }
+        }
+
+        // Keep the bookkeeping out of the timings.
+        if (i % sampleInterval == sampleInterval - 1 || i == events.size() - 1)
+        {
+            seconds += timer.seconds();
+
+            size_t consumed = size - heap.freeSpace();
+            peakConsumed    = std::max(peakConsumed, consumed);
+            samples.emplace_back(Sample { i + 1, liveBytes, consumed });
+
+            timer.reset();
+        }
+        else
+        {
+            peakConsumed = std::max(peakConsumed, size - heap.freeSpace());
+        }
+    }
+
+    seconds += timer.seconds();
+
+    print("%-16s %10.2f ns/op, peak %zu bytes (%.2f%%), %zu failed, %zu recovered\n",
+          name,
+          seconds * 1e9 / static_cast<double>(std::max<size_t>(events.size(), 1)),
+          peakConsumed,
+          100.0 * static_cast<double>(peakConsumed) / static_cast<double>(size),
+          failurePoints.size(),
+          recovered);
+
+    print("    fragmentation over time (event: live / consumed bytes, overhead):\n");
+    for (auto &s : samples)
+    {
+        double overhead = s.liveBytes
+            ? 100.0 * (static_cast<double>(s.consumedBytes) / static_cast<double>(s.liveBytes) - 1.0)
+            : 0.0;
+        print("    %10zu: %12zu / %12zu, %7.2f%%\n",
+              s.event, s.liveBytes, s.consumedBytes, overhead);
+    }
+
+    if (!failurePoints.empty())
+    {
+        static const size_t MaxFailuresShown = 10;
+        print("    failure points:");
+        for (size_t i = 0; i < std::min(failurePoints.size(), MaxFailuresShown); ++i)
+            print(" %zu", failurePoints[i]);
+        if (failurePoints.size() > MaxFailuresShown)
+            print(" ... (%zu more)", failurePoints.size() - MaxFailuresShown);
+        print("\n");
+    }
+}
+
+// Record a synthetic trace of mostly small, short-lived allocations
+// with occasional large ones, similar to upload heap traffic.
+AllocationTrace recordSyntheticTrace()
+{
+    static const size_t HeapSize   = 64 * 1024 * 1024;
+    static const size_t Operations = 1000000;
+    static const size_t MaxLive    = 4096;
+
+    AllocationTrace trace("Synthetic", HeapSize);
+    TracedHeap<OffsetHeap> heap(HeapSize, 1);
+    heap.setTrace(&trace);
+
+    Random gen;
+    std::vector<Block> blocks;
+    blocks.reserve(MaxLive);
+
+    for (size_t i = 0; i < Operations; ++i)
+    {
+        if (blocks.size() < MaxLive && (blocks.empty() || gen() % 2 == 0))
+        {
+            size_t size = (gen() % 16 == 0)
+                ? 1 + gen() % (256 * 1024)
+                : 1 + gen() % 1024;
+            uint alignment = 1U << (gen() % 9);
+
+            Block b = heap.allocate(size, alignment);
+            if (b)
+                blocks.emplace_back(b);
+        }
+        else
+        {
+            auto j = static_cast<size_t>(gen() % blocks.size());
+            heap.release(blocks[j]);
+            blocks[j] = blocks.back();
+            blocks.pop_back();
+        }
+    }
+
+    return trace;
+}
+
+void replayAll(const AllocationTrace &trace)
+{
+    print("Trace \"%s\", %zu events, %zu allocations, capacity %zu bytes:\n",
+          trace.name().cStr(),
+          trace.events().size(),
+          trace.allocationCount(),
+          trace.capacity());
+
+    replay<OffsetHeap>("OffsetHeap", trace);
+    replay<OffsetHeapTLSF>("OffsetHeapTLSF", trace);
+    replay<OffsetBuddy>("OffsetBuddy", trace);
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2)
+    {
+        replayAll(recordSyntheticTrace());
+        return 0;
+    }
+
+    for (int i = 1; i < argc; ++i)
+    {
+        try
+        {
+            replayAll(AllocationTrace::load(argv[i]));
+        }
+        catch (const Exception &e)
+        {
+            print("Failed to load trace \"%s\": %s\n", argv[i], e.what());
+            return 1;
+        }
+    }
+
+    return 0;
+}
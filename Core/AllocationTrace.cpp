@@ -0,0 +1,183 @@
+#include "Core/AllocationTrace.hpp"
+#include "Core/Serialization.hpp"
+#include "Core/File.hpp"
+
+namespace Xor
+{
+    struct AllocationTraceHeader
+    {
+        static const uint VersionNumber = 1;
+        FourCC   fourCC;
+        uint64_t capacity = 0;
+        uint64_t events   = 0;
+    };
+
+    static const FourCC AllocationTraceFourCC { "XATR" };
+
+    // Events are stored as a type byte followed by variable length
+    // integers, which typically makes them 4-6 bytes each.
+    template <typename Buffer>
+    static void writeVarint(Writer<Buffer> &writer, uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            writer.write(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        writer.write(static_cast<uint8_t>(value));
+    }
+
+    static uint64_t readVarint(Reader &reader)
+    {
+        uint64_t value = 0;
+        for (uint shift = 0; shift < 64; shift += 7)
+        {
+            auto byte = reader.read<uint8_t>();
+            value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+            if (!(byte & 0x80))
+                return value;
+        }
+
+        XOR_THROW(false, SerializationException, "Invalid variable length integer");
+        return value;
+    }
+
+    AllocationTrace::AllocationTrace(String name, size_t capacity)
+        : m_name(std::move(name))
+        , m_capacity(capacity)
+    {}
+
+    void AllocationTrace::record(AllocationEvent::Type type, uint32_t allocation, size_t size, size_t alignment)
+    {
+        AllocationEvent e;
+        e.type          = type;
+        e.allocation    = allocation;
+        e.size          = size;
+        e.alignmentLog2 = static_cast<uint8_t>(countTrailingZeros(std::max<size_t>(alignment, 1)));
+        e.time          = static_cast<uint64_t>(m_timer.seconds() * 1e9);
+        m_events.emplace_back(e);
+    }
+
+    void AllocationTrace::allocate(size_t size, size_t alignment, int64_t offset)
+    {
+        if (offset < 0)
+        {
+            record(AllocationEvent::Type::Failure, 0, size, alignment);
+        }
+        else
+        {
+            uint32_t allocation = m_allocations++;
+            record(AllocationEvent::Type::Allocate, allocation, size, alignment);
+            m_live[offset] = allocation;
+        }
+    }
+
+    void AllocationTrace::release(int64_t offset)
+    {
+        auto it = m_live.find(offset);
+        XOR_ASSERT(it != m_live.end(), "Released an allocation that was not traced");
+        if (it == m_live.end())
+            return;
+
+        record(AllocationEvent::Type::Release, it->second, 0, 1);
+        m_live.erase(it);
+    }
+
+    void AllocationTrace::releaseRange(Block block)
+    {
+        auto begin = m_live.lower_bound(block.begin);
+        auto end   = m_live.lower_bound(block.end);
+
+        for (auto it = begin; it != end; ++it)
+            record(AllocationEvent::Type::Release, it->second, 0, 1);
+
+        m_live.erase(begin, end);
+    }
+
+    void AllocationTrace::save(const String &filename) const
+    {
+        std::vector<uint8_t> bytes;
+        auto writer = makeWriter(bytes, m_events.size() * 6);
+
+        AllocationTraceHeader header;
+        header.fourCC   = AllocationTraceFourCC;
+        header.capacity = m_capacity;
+        header.events   = m_events.size();
+        writer.writeStruct(header);
+        writer.writeString(m_name);
+
+        uint64_t time           = 0;
+        uint32_t nextAllocation = 0;
+        for (auto &e : m_events)
+        {
+            writer.write(static_cast<uint8_t>(static_cast<uint8_t>(e.type) | (e.alignmentLog2 << 2)));
+            writeVarint(writer, e.time - time);
+            time = e.time;
+
+            // Releases store how many allocations ago the released one was
+            // made, which is a small number for short-lived allocations.
+            if (e.type == AllocationEvent::Type::Release)
+            {
+                writeVarint(writer, nextAllocation - 1 - e.allocation);
+            }
+            else
+            {
+                writeVarint(writer, e.size);
+                if (e.type == AllocationEvent::Type::Allocate)
+                    ++nextAllocation;
+            }
+        }
+
+        File::ensureDirectoryExists(filename);
+        File f(filename, File::Mode::ReadWrite, File::Create::CreateAlways);
+        XOR_THROW(!!f, SerializationException, "Failed to open file");
+        XOR_THROW_HR(f.write(Span<const uint8_t>(bytes.data(), writer.bytesWritten())), SerializationException);
+    }
+
+    AllocationTrace AllocationTrace::load(const String &filename)
+    {
+        File f(filename);
+        XOR_THROW(!!f, SerializationException, "Failed to open file");
+        auto bytes = f.read();
+
+        Reader reader(bytes);
+        auto header = reader.readStruct<AllocationTraceHeader>();
+        XOR_THROW(header.fourCC.asUint() == AllocationTraceFourCC.asUint(),
+                  SerializationException,
+                  "File is not an allocation trace");
+
+        AllocationTrace trace(reader.readString(), static_cast<size_t>(header.capacity));
+        trace.m_events.reserve(static_cast<size_t>(header.events));
+
+        uint64_t time = 0;
+        for (uint64_t i = 0; i < header.events; ++i)
+        {
+            AllocationEvent e;
+            auto typeByte   = reader.read<uint8_t>();
+            e.type          = static_cast<AllocationEvent::Type>(typeByte & 3);
+            e.alignmentLog2 = static_cast<uint8_t>(typeByte >> 2);
+            time           += readVarint(reader);
+            e.time          = time;
+
+            if (e.type == AllocationEvent::Type::Release)
+            {
+                auto age = readVarint(reader);
+                XOR_THROW(age < trace.m_allocations, SerializationException, "Released allocation does not exist");
+                e.allocation = trace.m_allocations - 1 - static_cast<uint32_t>(age);
+            }
+            else
+            {
+                XOR_THROW(e.type == AllocationEvent::Type::Allocate ||
+                          e.type == AllocationEvent::Type::Failure,
+                          SerializationException, "Invalid allocation event");
+                e.size = readVarint(reader);
+                if (e.type == AllocationEvent::Type::Allocate)
+                    e.allocation = trace.m_allocations++;
+            }
+
+            trace.m_events.emplace_back(e);
+        }
+
+        return trace;
+    }
+}
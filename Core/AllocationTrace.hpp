@@ -0,0 +1,100 @@
+#pragma once
+
+#include "Core/Utils.hpp"
+#include "Core/String.hpp"
+#include "Core/Allocators.hpp"
+
+#include <vector>
+#include <map>
+
+namespace Xor
+{
+    struct AllocationEvent
+    {
+        enum class Type : uint8_t
+        {
+            Allocate,
+            Release,
+            Failure,
+        };
+
+        Type     type          = Type::Allocate;
+        uint8_t  alignmentLog2 = 0;
+        // Allocations are numbered in the order they were made, and
+        // releases refer to the number of the released allocation.
+        // Failed allocations don't get a number.
+        uint32_t allocation    = 0;
+        // Nanoseconds since the trace was started.
+        uint64_t time          = 0;
+        uint64_t size          = 0;
+
+        size_t alignment() const { return size_t(1) << alignmentLog2; }
+    };
+
+    // Records the operations done to an allocator, so they can be saved
+    // into a compact binary file and replayed later with other allocators.
+    // Tracing is opt-in: allocators only record into a trace that has
+    // been explicitly given to them.
+    class AllocationTrace
+    {
+        String                          m_name;
+        size_t                          m_capacity = 0;
+        Timer                           m_timer;
+        std::vector<AllocationEvent>    m_events;
+        // Live allocations by their offset.
+        std::map<int64_t, uint32_t>     m_live;
+        uint32_t                        m_allocations = 0;
+
+        void record(AllocationEvent::Type type, uint32_t allocation, size_t size, size_t alignment);
+    public:
+        AllocationTrace() = default;
+        AllocationTrace(String name, size_t capacity);
+
+        const String &name() const { return m_name; }
+        size_t capacity() const { return m_capacity; }
+        size_t allocationCount() const { return m_allocations; }
+        Span<const AllocationEvent> events() const { return m_events; }
+
+        // A negative offset means that the allocation failed.
+        void allocate(size_t size, size_t alignment, int64_t offset);
+        void release(int64_t offset);
+        // Release every live allocation that begins within the block.
+        void releaseRange(Block block);
+
+        void save(const String &filename) const;
+        static AllocationTrace load(const String &filename);
+    };
+
+    // Wraps a heap-like allocator (e.g. OffsetHeap) so that all
+    // allocations and releases are recorded into a trace, if one is set.
+    template <typename Heap>
+    class TracedHeap : public Heap
+    {
+        AllocationTrace *m_trace = nullptr;
+    public:
+        using Heap::Heap;
+
+        void setTrace(AllocationTrace *trace) { m_trace = trace; }
+        AllocationTrace *trace() const { return m_trace; }
+
+        Block allocate(size_t size)
+        {
+            return allocate(size, 1);
+        }
+
+        Block allocate(size_t size, uint alignment)
+        {
+            Block b = Heap::allocate(size, alignment);
+            if (m_trace)
+                m_trace->allocate(size, alignment, b.begin);
+            return b;
+        }
+
+        void release(Block block)
+        {
+            if (m_trace)
+                m_trace->release(block.begin);
+            Heap::release(block);
+        }
+    };
+}
@@ -3,6 +3,7 @@
 #include "Math.hpp"
 
 #include <numeric>
+#include <thread>
 
 namespace Xor
 {
@@ -61,6 +62,283 @@ namespace Xor
         m_freeOffsets.emplace_back(offset);
     }
 
+    static std::atomic<uint> g_nextThreadIndex { 0 };
+
+    static uint64_t packStackTop(uint32_t index, uint32_t tag)
+    {
+        return (static_cast<uint64_t>(tag) << 32) | static_cast<uint64_t>(index);
+    }
+
+    static uint32_t stackTopIndex(uint64_t top)
+    {
+        return static_cast<uint32_t>(top);
+    }
+
+    static uint32_t stackTopTag(uint64_t top)
+    {
+        return static_cast<uint32_t>(top >> 32);
+    }
+
+    ConcurrentOffsetPool::ConcurrentOffsetPool(size_t size)
+        : m_size(size)
+        , m_stacks(new Stack[NumStacks])
+        , m_available(new std::atomic<int64_t>(0))
+        , m_next(new std::atomic<uint32_t>[size])
+    {
+        XOR_ASSERT(size < static_cast<size_t>(InvalidIndex),
+                   "Size must be representable with an unsigned 32-bit integer.");
+
+#if XOR_ASSERTIONS
+        m_allocated.reset(new std::atomic<uint8_t>[size]);
+        for (size_t i = 0; i < size; ++i)
+            m_allocated[i].store(0, std::memory_order_relaxed);
+#endif
+
+        for (uint i = 0; i < NumStacks; ++i)
+            m_stacks[i].top.store(packStackTop(InvalidIndex, 0));
+
+        // Put all the offsets in the first stack so offset 0 is
+        // the first to get allocated, like with OffsetPool.
+        uint32_t size32 = static_cast<uint32_t>(size);
+        for (uint32_t i = 0; i < size32; ++i)
+            m_next[i].store(i + 1 < size32 ? i + 1 : InvalidIndex);
+
+        if (size32 > 0)
+            m_stacks[0].top.store(packStackTop(0, 0));
+
+        m_available->store(static_cast<int64_t>(size32));
+    }
+
+    bool ConcurrentOffsetPool::empty() const
+    {
+        return spaceLeft() == 0;
+    }
+
+    bool ConcurrentOffsetPool::full() const
+    {
+        return spaceLeft() == size();
+    }
+
+    size_t ConcurrentOffsetPool::size() const
+    {
+        return m_size;
+    }
+
+    size_t ConcurrentOffsetPool::spaceLeft() const
+    {
+        if (!m_available)
+            return 0;
+
+        return static_cast<size_t>(m_available->load(std::memory_order_relaxed));
+    }
+
+    int64_t ConcurrentOffsetPool::allocate()
+    {
+        if (!m_stacks)
+            return -1;
+
+        // Reserve one of the free offsets first. If that succeeds, there is
+        // an offset for us somewhere in the stacks, and we only fail if
+        // the pool is really empty.
+        int64_t available = m_available->load(std::memory_order_relaxed);
+        do
+        {
+            if (available <= 0)
+                return -1;
+        } while (!m_available->compare_exchange_weak(available, available - 1,
+                                                     std::memory_order_acquire,
+                                                     std::memory_order_relaxed));
+
+        Stack &stack = threadStack();
+        uint own = static_cast<uint>(&stack - m_stacks.get());
+
+        for (;;)
+        {
+            uint32_t offset = pop(stack);
+            if (offset != InvalidIndex)
+                return markAllocated(offset);
+
+            // Our own stack is empty, so steal a batch of offsets from some other
+            // stack. Keep the first one, and put the rest in our own stack.
+            for (uint i = 1; i < NumStacks; ++i)
+            {
+                Stack &victim = m_stacks[(own + i) % NumStacks];
+
+                uint32_t last   = InvalidIndex;
+                uint     length = 0;
+                uint32_t first  = popChain(victim, StealBatch, last, length);
+
+                if (first == InvalidIndex)
+                    continue;
+
+                if (length > 1)
+                    pushChain(stack, m_next[first].load(std::memory_order_relaxed), last, length - 1);
+
+                return markAllocated(first);
+            }
+
+            // All stacks looked empty, but our reservation means that some
+            // offset was released into a stack we already scanned, or another
+            // thread is in the middle of moving a stolen batch. Try again.
+            std::this_thread::yield();
+        }
+    }
+
+    void ConcurrentOffsetPool::release(int64_t offset)
+    {
+        XOR_ASSERT(offset >= 0 && static_cast<size_t>(offset) < m_size,
+                   "Attempted to release an invalid offset.");
+
+        uint32_t offset32 = static_cast<uint32_t>(offset);
+#if XOR_ASSERTIONS
+        XOR_ASSERT(m_allocated[offset32].exchange(0, std::memory_order_relaxed),
+                   "Attempted to release an offset that is not allocated.");
+#endif
+        pushChain(threadStack(), offset32, offset32, 1);
+        m_available->fetch_add(1, std::memory_order_release);
+    }
+
+    int64_t ConcurrentOffsetPool::markAllocated(uint32_t offset)
+    {
+#if XOR_ASSERTIONS
+        XOR_ASSERT(!m_allocated[offset].exchange(1, std::memory_order_relaxed),
+                   "Allocated an offset that is already allocated.");
+#endif
+        return static_cast<int64_t>(offset);
+    }
+
+    ConcurrentOffsetPool::Stack &ConcurrentOffsetPool::threadStack()
+    {
+        // Threads get consecutive indices the first time they use any pool,
+        // so up to NumStacks threads get a stack of their own.
+        thread_local uint threadIndex = g_nextThreadIndex.fetch_add(1, std::memory_order_relaxed);
+        return m_stacks[threadIndex % NumStacks];
+    }
+
+    uint32_t ConcurrentOffsetPool::pop(Stack &stack)
+    {
+        uint32_t last   = InvalidIndex;
+        uint     length = 0;
+        return popChain(stack, 1, last, length);
+    }
+
+    uint32_t ConcurrentOffsetPool::popChain(Stack &stack, uint maxLength, uint32_t &last, uint &length)
+    {
+        uint64_t top = stack.top.load(std::memory_order_acquire);
+
+        for (;;)
+        {
+            uint32_t first = stackTopIndex(top);
+            if (first == InvalidIndex)
+                return InvalidIndex;
+
+            // Walk down the stack to find the end of the chain. If some other
+            // thread modifies the stack meanwhile, the links might be garbage,
+            // but then the tag will also have changed and we will try again.
+            last   = first;
+            length = 1;
+            uint32_t next = m_next[first].load(std::memory_order_relaxed);
+            while (length < maxLength && next != InvalidIndex)
+            {
+                last = next;
+                ++length;
+                next = m_next[next].load(std::memory_order_relaxed);
+            }
+
+            if (stack.top.compare_exchange_weak(top, packStackTop(next, stackTopTag(top) + 1),
+                                                std::memory_order_acquire,
+                                                std::memory_order_acquire))
+            {
+                return first;
+            }
+        }
+    }
+
+    void ConcurrentOffsetPool::pushChain(Stack &stack, uint32_t first, uint32_t last, uint length)
+    {
+        uint64_t top = stack.top.load(std::memory_order_relaxed);
+
+        for (;;)
+        {
+            m_next[last].store(stackTopIndex(top), std::memory_order_relaxed);
+
+            if (stack.top.compare_exchange_weak(top, packStackTop(first, stackTopTag(top) + 1),
+                                                std::memory_order_release,
+                                                std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+    }
+
+    FrameArena::FrameArena(size_t chunkSize)
+        : m_chunkSize(chunkSize)
+    {}
+
+    FrameArena &FrameArena::thisThread()
+    {
+        thread_local FrameArena arena;
+        return arena;
+    }
+
+    void *FrameArena::allocate(size_t bytes, size_t alignment)
+    {
+        XOR_ASSERT(popCount(alignment) == 1, "Alignment must be a power of 2");
+
+        for (;;)
+        {
+            // Allocate a new chunk if we have used up all of them. Chunks
+            // are never freed, so this will not happen after warming up.
+            if (m_top.chunk == m_chunks.size())
+            {
+                Chunk chunk;
+                chunk.size   = std::max(m_chunkSize, bytes + alignment - 1);
+                chunk.memory = std::unique_ptr<uint8_t[]>(new uint8_t[chunk.size]);
+                m_chunks.emplace_back(std::move(chunk));
+
+                ++m_statistics.heapAllocations;
+                m_statistics.reservedBytes += m_chunks.back().size;
+            }
+
+            auto &chunk   = m_chunks[m_top.chunk];
+            auto base     = reinterpret_cast<uintptr_t>(chunk.memory.get());
+            size_t begin  = static_cast<size_t>(alignTo<uintptr_t>(base + m_top.offset, alignment) - base);
+            size_t end    = begin + bytes;
+
+            if (end <= chunk.size)
+            {
+                m_top.used  += end - m_top.offset;
+                m_top.offset = end;
+
+                ++m_statistics.allocations;
+                m_statistics.usedBytes     = m_top.used;
+                m_statistics.peakUsedBytes = std::max(m_statistics.peakUsedBytes, m_top.used);
+
+                return chunk.memory.get() + begin;
+            }
+
+            // The rest of this chunk goes unused until the arena is rewound.
+            ++m_top.chunk;
+            m_top.offset = 0;
+        }
+    }
+
+    void FrameArena::rewind(Marker marker)
+    {
+        XOR_ASSERT(marker.chunk < m_top.chunk ||
+                   (marker.chunk == m_top.chunk && marker.offset <= m_top.offset),
+                   "Attempted to rewind past the top of the arena.");
+        m_top = marker;
+        m_statistics.usedBytes = m_top.used;
+    }
+
+    void FrameArena::resetStatistics()
+    {
+        m_statistics.allocations     = 0;
+        m_statistics.heapAllocations = 0;
+        m_statistics.peakUsedBytes   = m_statistics.usedBytes;
+    }
+
     size_t OffsetRing::freeSpace() const
     {
         if (m_full)
@@ -192,6 +470,89 @@ namespace Xor
         m_full = false;
     }
 
+    size_t ConcurrentOffsetRing::freeSpace() const
+    {
+        int64_t head = m_head.load();
+        int64_t tail = m_tail.load();
+        int64_t used = std::max<int64_t>(tail - head, 0);
+        return static_cast<size_t>(std::max<int64_t>(m_size - used, 0));
+    }
+
+    Block ConcurrentOffsetRing::allocateBlock(size_t amount, size_t alignment)
+    {
+        int64_t position;
+        return allocateBlock(amount, alignment, position);
+    }
+
+    Block ConcurrentOffsetRing::allocateBlock(size_t amount, size_t alignment, int64_t &position)
+    {
+        XOR_ASSERT(m_size > 0, "Attempted to allocate from an invalid ring.");
+        XOR_ASSERT(amount > 0, "Attempted to allocate zero elements.");
+        XOR_ASSERT(alignment > 0, "Attempted to allocate with zero alignment.");
+
+        int64_t iAmount = static_cast<int64_t>(amount);
+
+        if (iAmount > m_size)
+            return Block();
+
+        int64_t tail = m_tail.load();
+
+        for (;;)
+        {
+            int64_t offset = tail % m_size;
+            int64_t begin  = alignTo(offset, static_cast<int64_t>(alignment));
+
+            // If the block doesn't fit before the end, skip the rest of the
+            // ring and allocate from the start, which is always aligned.
+            if (begin + iAmount > m_size)
+                begin = m_size;
+
+            int64_t newTail = tail + (begin - offset) + iAmount;
+
+            // The head only ever moves forward, so if there is not enough
+            // space now, there would not be enough space in any case when
+            // the tail was loaded.
+            if (newTail - m_head.load() > m_size)
+                return Block();
+
+            if (m_tail.compare_exchange_weak(tail, newTail))
+            {
+                position = newTail;
+                begin    = begin % m_size;
+                return Block(begin, begin + iAmount);
+            }
+        }
+    }
+
+    void ConcurrentOffsetRing::releaseEnd(int64_t onePastLastOffset)
+    {
+        XOR_ASSERT(onePastLastOffset >= 0 && onePastLastOffset <= m_size,
+                   "Released range out of bounds.");
+
+        int64_t head = m_head.load();
+
+        // Releasing always moves the head forward, so find the next
+        // position that has the given offset.
+        int64_t distance = onePastLastOffset - head % m_size;
+        if (distance <= 0)
+            distance += m_size;
+
+        releaseUntilPosition(head + distance);
+    }
+
+    void ConcurrentOffsetRing::releaseUntilPosition(int64_t position)
+    {
+        XOR_ASSERT(position <= m_tail.load(),
+                   "Attempted to release unallocated elements.");
+
+        int64_t head = m_head.load();
+        while (head < position)
+        {
+            if (m_head.compare_exchange_weak(head, position))
+                break;
+        }
+    }
+
     OffsetHeap::OffsetHeap(size_t size, uint minimumAlignment)
         : m_size(static_cast<int64_t>(size))
         , m_minAlignment(minimumAlignment)
@@ -244,8 +605,50 @@ namespace Xor
         return freeSize >= requiredSize;
     }
 
+    // The size class of a free block, which is aligned
+    // by the lowest set bit of its offset.
+    OffsetHeap::SizeAlignment OffsetHeap::blockSizeAlignment(Block block)
+    {
+        size_t size = block.size();
+        XOR_ASSERT(size % m_minAlignment == 0,
+                   "All blocks must be aligned by the minimum alignment");
+        // Offset 0 has no set bits, so clamp its alignment to the largest
+        // one we can represent.
+        uint log2Alignment = std::min(countTrailingZeros(static_cast<uint64_t>(block.begin)), 31U);
+        uint alignment = 1U << log2Alignment;
+        return encodeSizeAlignment(size, alignment);
+    }
+
+    size_t OffsetHeap::freeBlockCount() const
+    {
+        size_t count = 0;
+        for (auto &&kv : m_sizeBins)
+            count += kv.second.freeOffsets.size();
+        return count;
+    }
+
+    bool OffsetHeap::isFree(Block block) const
+    {
+        auto it = m_blocksToCoalesce.find(block.begin);
+        return it != m_blocksToCoalesce.end() && it->second == block.end;
+    }
+
+    void OffsetHeap::removeFromSizeBin(Block block)
+    {
+        auto it = m_sizeBins.find(blockSizeAlignment(block));
+        XOR_ASSERT(it != m_sizeBins.end(), "The free block has no size bin");
+        auto erased = it->second.freeOffsets.erase(block.begin);
+        XOR_ASSERT(erased == 1, "The free block was not in its size bin");
+
+        // Empty size bins are removed from the map.
+        if (it->second.freeOffsets.empty())
+            m_sizeBins.erase(it);
+    }
+
     void OffsetHeap::allocateBlock(Block block)
     {
+        removeFromSizeBin(block);
+
         auto erasedBegin = m_blocksToCoalesce.erase(block.begin);
         auto erasedEnd   = m_blocksToCoalesce.erase(block.end);
         XOR_ASSERT(erasedBegin == 1, "The allocated block was not free");
@@ -337,21 +740,18 @@ namespace Xor
                 auto &sizeBin = it->second;
                 XOR_ASSERT(!sizeBin.freeOffsets.empty(),
                            "Size bins should always be non-empty.");
-                int64_t offset = sizeBin.freeOffsets.top();
-                sizeBin.freeOffsets.pop();
+                int64_t offset = *sizeBin.freeOffsets.begin();
 
                 Block entireBlock;
                 entireBlock.begin = offset;
                 entireBlock.end   = offset
                                   + static_cast<int64_t>(decodeSize(it->first));
 
-                // If we just emptied the size bin, remove it from the
-                // map.
-                if (sizeBin.freeOffsets.empty())
-                    m_sizeBins.erase(it);
+                XOR_ASSERT(isFree(entireBlock), "Size bins should only contain free blocks");
 
-                // Mark the space as allocated. We might chop off and re-release
-                // some parts after.
+                // Mark the space as allocated, which also removes it from
+                // its size bin. We might chop off and re-release some parts
+                // after.
                 allocateBlock(entireBlock);
 
                 // Check if we need to chop off extra bits.
@@ -406,6 +806,8 @@ namespace Xor
                    "Released block is out of bounds");
         XOR_ASSERT(block.size() > 0, "Released block is empty");
 
+        size_t releasedSize = block.size();
+
         // Check if there's a block on the left we can merge with.
         auto left = m_blocksToCoalesce.find(block.begin);
         if (left != m_blocksToCoalesce.end())
@@ -413,8 +815,10 @@ namespace Xor
             // Yes there is, merge it to the block being released.
             XOR_ASSERT(left->second < block.begin,
                        "Coalesced block invalid");
-            block.begin = left->second;
+            Block leftBlock(left->second, block.begin);
             m_blocksToCoalesce.erase(left);
+            removeFromSizeBin(leftBlock);
+            block.begin = leftBlock.begin;
         }
 
         // Check on the right.
@@ -423,25 +827,20 @@ namespace Xor
         {
             XOR_ASSERT(right->second > block.end,
                        "Coalesced block invalid");
-            block.end = right->second;
+            Block rightBlock(block.end, right->second);
             m_blocksToCoalesce.erase(right);
+            removeFromSizeBin(rightBlock);
+            block.end = rightBlock.end;
         }
 
         // Insert this block in the coalescing table.
         m_blocksToCoalesce[block.begin] = block.end;
         m_blocksToCoalesce[block.end]   = block.begin;
 
-        // Determine the size class to put this block in.
-        size_t size = block.size();
-        XOR_ASSERT(size % m_minAlignment == 0,
-                   "All blocks must be aligned by the minimum alignment");
-        uint alignment = 1U << countTrailingZeros(static_cast<uint64_t>(block.begin));
-        auto key = encodeSizeAlignment(size, alignment);
-
-        // Finally, insert it to the free list.
-        m_sizeBins[key].freeOffsets.emplace(block.begin);
+        // Finally, insert it to the free list of its size class.
+        m_sizeBins[blockSizeAlignment(block)].freeOffsets.emplace(block.begin);
 
-        m_freeSpace += block.size();
+        m_freeSpace += releasedSize;
         XOR_ASSERT(m_freeSpace <= static_cast<size_t>(m_size),
                    "More free space than the total size");
     }
@@ -484,6 +883,696 @@ namespace Xor
         return false;
     }
 
+    OffsetHeapTLSF::OffsetHeapTLSF()
+    {
+        for (auto &bits : m_binBits)
+            bits = 0;
+        for (auto &bin : m_bins)
+            bin = InvalidNode;
+    }
+
+    OffsetHeapTLSF::OffsetHeapTLSF(size_t size, uint minimumAlignment)
+        : OffsetHeapTLSF()
+    {
+        XOR_ASSERT(popCount(minimumAlignment) == 1, "Alignment must be a power of 2");
+        m_minAlignment = minimumAlignment;
+        resize(size);
+    }
+
+    OffsetHeapTLSF::Bin OffsetHeapTLSF::binForSize(size_t size)
+    {
+        Bin bin;
+
+        // Sizes smaller than the subdivision count all go in
+        // the first size class, one bin per size.
+        if (size < Subdivisions)
+        {
+            bin.sizeClass   = 0;
+            bin.subdivision = static_cast<uint>(size);
+        }
+        else
+        {
+            uint log2Size   = static_cast<uint>(firstbithigh(size));
+            bin.sizeClass   = log2Size - SubdivisionBits + 1;
+            bin.subdivision = static_cast<uint>(size >> (log2Size - SubdivisionBits)) - Subdivisions;
+        }
+
+        return bin;
+    }
+
+    OffsetHeapTLSF::Bin OffsetHeapTLSF::binForAllocation(size_t size)
+    {
+        // Round the size up to the beginning of the next bin, so every
+        // block in the resulting bin is large enough.
+        if (size >= Subdivisions)
+        {
+            uint log2Size = static_cast<uint>(firstbithigh(size));
+            size += (1ULL << (log2Size - SubdivisionBits)) - 1;
+        }
+
+        return binForSize(size);
+    }
+
+    uint32_t OffsetHeapTLSF::newNode(int64_t begin, int64_t end)
+    {
+        uint32_t node;
+
+        if (!m_unusedNodes.empty())
+        {
+            node = m_unusedNodes.back();
+            m_unusedNodes.pop_back();
+        }
+        else
+        {
+            XOR_CHECK(m_nodes.size() < InvalidNode, "Ran out of node indices.");
+            node = static_cast<uint32_t>(m_nodes.size());
+            m_nodes.emplace_back();
+        }
+
+        Node &n = m_nodes[node];
+        n       = Node();
+        n.begin = begin;
+        n.end   = end;
+        return node;
+    }
+
+    void OffsetHeapTLSF::deleteNode(uint32_t node)
+    {
+        m_nodes[node] = Node();
+        m_unusedNodes.emplace_back(node);
+    }
+
+    uint32_t OffsetHeapTLSF::split(uint32_t node, int64_t offset)
+    {
+        XOR_ASSERT(offset > m_nodes[node].begin && offset < m_nodes[node].end,
+                   "Split offset must be inside the node");
+
+        // Splitting creates a new node, which might reallocate the
+        // node array, so only access nodes through indices here.
+        uint32_t right = newNode(offset, m_nodes[node].end);
+        uint32_t next  = m_nodes[node].next;
+
+        m_nodes[right].prev = node;
+        m_nodes[right].next = next;
+        m_nodes[node].next  = right;
+        m_nodes[node].end   = offset;
+
+        if (next != InvalidNode)
+            m_nodes[next].prev = right;
+        else
+            m_lastNode = right;
+
+        return right;
+    }
+
+    uint32_t OffsetHeapTLSF::coalesce(uint32_t node)
+    {
+        // Merge a right neighbor into a left one and discard the right one.
+        auto merge = [&] (uint32_t left, uint32_t right)
+        {
+            uint32_t next = m_nodes[right].next;
+            m_nodes[left].end  = m_nodes[right].end;
+            m_nodes[left].next = next;
+
+            if (next != InvalidNode)
+                m_nodes[next].prev = left;
+            else
+                m_lastNode = left;
+
+            deleteNode(right);
+        };
+
+        uint32_t prev = m_nodes[node].prev;
+        if (prev != InvalidNode && m_nodes[prev].free)
+        {
+            removeFree(prev);
+            merge(prev, node);
+            node = prev;
+        }
+
+        uint32_t next = m_nodes[node].next;
+        if (next != InvalidNode && m_nodes[next].free)
+        {
+            removeFree(next);
+            merge(node, next);
+        }
+
+        return node;
+    }
+
+    void OffsetHeapTLSF::insertFree(uint32_t node)
+    {
+        Node &n = m_nodes[node];
+        Bin bin = binForSize(n.size());
+        uint i  = bin.index();
+
+        n.free     = true;
+        n.prevFree = InvalidNode;
+        n.nextFree = m_bins[i];
+
+        if (n.nextFree != InvalidNode)
+            m_nodes[n.nextFree].prevFree = node;
+
+        m_bins[i] = node;
+        m_binBits[bin.sizeClass] |= 1U << bin.subdivision;
+        m_sizeClassBits          |= 1ULL << bin.sizeClass;
+    }
+
+    void OffsetHeapTLSF::removeFree(uint32_t node)
+    {
+        Node &n = m_nodes[node];
+        XOR_ASSERT(n.free, "Removed node is not free");
+
+        if (n.prevFree != InvalidNode)
+            m_nodes[n.prevFree].nextFree = n.nextFree;
+        if (n.nextFree != InvalidNode)
+            m_nodes[n.nextFree].prevFree = n.prevFree;
+
+        Bin bin = binForSize(n.size());
+        uint i  = bin.index();
+
+        if (m_bins[i] == node)
+        {
+            m_bins[i] = n.nextFree;
+
+            if (m_bins[i] == InvalidNode)
+            {
+                m_binBits[bin.sizeClass] &= ~(1U << bin.subdivision);
+                if (!m_binBits[bin.sizeClass])
+                    m_sizeClassBits &= ~(1ULL << bin.sizeClass);
+            }
+        }
+
+        n.free     = false;
+        n.prevFree = InvalidNode;
+        n.nextFree = InvalidNode;
+    }
+
+    uint32_t OffsetHeapTLSF::findFree(size_t size, uint alignment)
+    {
+        // Free blocks are only guaranteed to be aligned by the minimum
+        // alignment, so larger alignments need extra space for moving
+        // the beginning of the block forward.
+        size_t searchSize = size;
+        if (alignment > m_minAlignment)
+            searchSize += alignment - m_minAlignment;
+
+        Bin bin = binForAllocation(searchSize);
+
+        // Look for the smallest non-empty bin in the same size class,
+        // and then in the larger size classes.
+        uint32_t binBits = m_binBits[bin.sizeClass] & (~0U << bin.subdivision);
+        if (!binBits && bin.sizeClass + 1 < SizeClasses)
+        {
+            uint64_t classBits = m_sizeClassBits & (~0ULL << (bin.sizeClass + 1));
+            if (classBits)
+            {
+                bin.sizeClass = countTrailingZeros(classBits);
+                binBits       = m_binBits[bin.sizeClass];
+            }
+        }
+
+        if (binBits)
+        {
+            bin.subdivision = countTrailingZeros(binBits);
+            return m_bins[bin.index()];
+        }
+
+        // All the larger bins are empty, but the first block in the bin
+        // of the exact size might still fit, e.g. when allocating the
+        // entire heap at once.
+        uint32_t node = m_bins[binForSize(searchSize).index()];
+        if (node != InvalidNode)
+        {
+            Block b(m_nodes[node].begin, m_nodes[node].end);
+            if (b.canFit(size, alignment))
+                return node;
+        }
+
+        return InvalidNode;
+    }
+
+    void OffsetHeapTLSF::allocateNode(uint32_t node)
+    {
+        XOR_ASSERT(!m_nodes[node].free, "Allocated node is still in a free list");
+        XOR_ASSERT(m_freeSpace >= m_nodes[node].size(),
+                   "Allocating block that is larger than the free size");
+        m_freeSpace -= m_nodes[node].size();
+        insertAllocated(node);
+    }
+
+    size_t OffsetHeapTLSF::allocatedHome(int64_t begin) const
+    {
+        // Fibonacci hashing, the table size is always a power of two.
+        uint64_t h = static_cast<uint64_t>(begin) * 0x9e3779b97f4a7c15ULL;
+        return static_cast<size_t>(h >> 32) & (m_allocated.size() - 1);
+    }
+
+    void OffsetHeapTLSF::insertAllocated(uint32_t node)
+    {
+        static const size_t MinimumTableSize = 64;
+
+        // Keep the load factor at most 1/2 to keep probe sequences short.
+        if ((m_allocatedCount + 1) * 2 > m_allocated.size())
+        {
+            std::vector<AllocatedSlot> old;
+            old.swap(m_allocated);
+            m_allocated.resize(std::max(MinimumTableSize, old.size() * 2));
+
+            for (auto &s : old)
+            {
+                if (s.begin < 0)
+                    continue;
+
+                size_t i = allocatedHome(s.begin);
+                while (m_allocated[i].begin >= 0)
+                    i = (i + 1) & (m_allocated.size() - 1);
+                m_allocated[i] = s;
+            }
+        }
+
+        int64_t begin = m_nodes[node].begin;
+        size_t i      = allocatedHome(begin);
+        while (m_allocated[i].begin >= 0)
+        {
+            XOR_ASSERT(m_allocated[i].begin != begin, "Block was allocated twice");
+            i = (i + 1) & (m_allocated.size() - 1);
+        }
+
+        m_allocated[i].begin = begin;
+        m_allocated[i].node  = node;
+        ++m_allocatedCount;
+    }
+
+    uint32_t OffsetHeapTLSF::removeAllocated(int64_t begin)
+    {
+        if (m_allocated.empty())
+            return InvalidNode;
+
+        size_t mask = m_allocated.size() - 1;
+        size_t i    = allocatedHome(begin);
+
+        while (m_allocated[i].begin != begin)
+        {
+            if (m_allocated[i].begin < 0)
+                return InvalidNode;
+            i = (i + 1) & mask;
+        }
+
+        uint32_t node = m_allocated[i].node;
+
+        // Remove the slot by shifting back any following slots which
+        // would become unreachable from their home slots.
+        size_t j = i;
+        for (;;)
+        {
+            j = (j + 1) & mask;
+            if (m_allocated[j].begin < 0)
+                break;
+
+            size_t home = allocatedHome(m_allocated[j].begin);
+            bool canMove = (i <= j)
+                ? (home <= i || home > j)
+                : (home <= i && home > j);
+
+            if (canMove)
+            {
+                m_allocated[i] = m_allocated[j];
+                i = j;
+            }
+        }
+
+        m_allocated[i] = AllocatedSlot();
+        --m_allocatedCount;
+
+        return node;
+    }
+
+    bool OffsetHeapTLSF::resize(size_t newSize)
+    {
+        int64_t iNewSize = static_cast<int64_t>(newSize);
+
+        if (iNewSize == m_size)
+            return true;
+
+        if (iNewSize > m_size)
+        {
+            // Grow by either extending the last block if it's free,
+            // or adding a new free block after it.
+            uint32_t last = m_lastNode;
+            if (last != InvalidNode && m_nodes[last].free)
+            {
+                removeFree(last);
+                m_nodes[last].end = iNewSize;
+            }
+            else
+            {
+                uint32_t node = newNode(m_size, iNewSize);
+                m_nodes[node].prev = last;
+                if (last != InvalidNode)
+                    m_nodes[last].next = node;
+                m_lastNode = node;
+                last       = node;
+            }
+
+            insertFree(last);
+            m_freeSpace += static_cast<size_t>(iNewSize - m_size);
+            m_size       = iNewSize;
+            return true;
+        }
+        else
+        {
+            // We can only shrink if the end of the heap is free, and
+            // the free block is large enough.
+            uint32_t last = m_lastNode;
+            if (last == InvalidNode ||
+                !m_nodes[last].free ||
+                m_nodes[last].begin > iNewSize)
+            {
+                return false;
+            }
+
+            removeFree(last);
+            m_freeSpace -= static_cast<size_t>(m_size - iNewSize);
+            m_size       = iNewSize;
+
+            if (m_nodes[last].begin < iNewSize)
+            {
+                m_nodes[last].end = iNewSize;
+                insertFree(last);
+            }
+            else
+            {
+                // The entire block was cut off.
+                uint32_t prev = m_nodes[last].prev;
+                if (prev != InvalidNode)
+                    m_nodes[prev].next = InvalidNode;
+                m_lastNode = prev;
+                deleteNode(last);
+            }
+
+            return true;
+        }
+    }
+
+    Block OffsetHeapTLSF::allocate(size_t size)
+    {
+        return allocate(size, m_minAlignment);
+    }
+
+    Block OffsetHeapTLSF::allocate(size_t size, uint alignment)
+    {
+        XOR_ASSERT(popCount(alignment) == 1, "Alignment must be a power of 2");
+        alignment = std::max(alignment, m_minAlignment);
+        size      = roundUpToMultiple<size_t>(size, alignment);
+        XOR_ASSERT(size > 0, "Attempted to allocate zero bytes");
+
+        uint32_t node = findFree(size, alignment);
+        if (node == InvalidNode)
+            return Block();
+
+        removeFree(node);
+
+        Block b;
+        b.begin = roundUpToMultiple<int64_t>(m_nodes[node].begin, alignment);
+        b.end   = b.begin + static_cast<int64_t>(size);
+
+        XOR_ASSERT(b.end <= m_nodes[node].end,
+                   "Allocated block does not fit in the free block");
+
+        // Give back the space that was skipped because of alignment.
+        if (b.begin > m_nodes[node].begin)
+        {
+            uint32_t aligned = split(node, b.begin);
+            insertFree(node);
+            node = aligned;
+        }
+
+        // Give back the space that was not needed.
+        if (b.end < m_nodes[node].end)
+            insertFree(split(node, b.end));
+
+        allocateNode(node);
+        return b;
+    }
+
+    void OffsetHeapTLSF::release(Block block)
+    {
+        XOR_ASSERT(block.begin >= 0 && block.begin < m_size,
+                   "Released block is out of bounds");
+        XOR_ASSERT(block.end > 0 && block.end <= m_size,
+                   "Released block is out of bounds");
+
+        uint32_t node = removeAllocated(block.begin);
+        XOR_CHECK(node != InvalidNode, "Released block was not allocated");
+        XOR_ASSERT(m_nodes[node].end == block.end,
+                   "Blocks must be released exactly as they were allocated");
+
+        m_freeSpace += m_nodes[node].size();
+        XOR_ASSERT(m_freeSpace <= static_cast<size_t>(m_size),
+                   "More free space than the total size");
+
+        insertFree(coalesce(node));
+    }
+
+    bool OffsetHeapTLSF::markAsAllocated(Block block)
+    {
+        XOR_ASSERT(block.begin % m_minAlignment == 0,
+                   "Allocated blocks must be aligned by the minimum alignment");
+        XOR_ASSERT(block.end % m_minAlignment == 0,
+                   "Allocated blocks must be aligned by the minimum alignment");
+
+        // Free blocks are always coalesced, so the block must fit
+        // entirely within one free block.
+        for (uint32_t node = 0; node < static_cast<uint32_t>(m_nodes.size()); ++node)
+        {
+            const Node &n = m_nodes[node];
+
+            if (n.free &&
+                n.begin <= block.begin &&
+                n.end   >= block.end)
+            {
+                removeFree(node);
+
+                if (m_nodes[node].begin < block.begin)
+                {
+                    uint32_t marked = split(node, block.begin);
+                    insertFree(node);
+                    node = marked;
+                }
+
+                if (m_nodes[node].end > block.end)
+                    insertFree(split(node, block.end));
+
+                allocateNode(node);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void OffsetBuddy::FreeBits::resize(size_t bits)
+    {
+        m_levels.clear();
+        m_bits = bits;
+        do
+        {
+            size_t words = divRoundUp<size_t>(std::max<size_t>(bits, 1), 64);
+            m_levels.emplace_back(words, 0);
+            bits = words;
+        } while (bits > 1);
+    }
+
+    void OffsetBuddy::FreeBits::set(size_t i)
+    {
+        for (auto &level : m_levels)
+        {
+            uint64_t &word = level[i / 64];
+            bool wasZero   = word == 0;
+            word |= 1ULL << (i % 64);
+
+            // The next levels already know about this word.
+            if (!wasZero)
+                break;
+
+            i /= 64;
+        }
+    }
+
+    void OffsetBuddy::FreeBits::clear(size_t i)
+    {
+        for (auto &level : m_levels)
+        {
+            uint64_t &word = level[i / 64];
+            word &= ~(1ULL << (i % 64));
+
+            // The next levels only need to change if the word became zero.
+            if (word != 0)
+                break;
+
+            i /= 64;
+        }
+    }
+
+    int64_t OffsetBuddy::FreeBits::findFirst() const
+    {
+        if (empty())
+            return -1;
+
+        size_t i = 0;
+        for (size_t l = m_levels.size(); l > 0; --l)
+        {
+            uint64_t word = m_levels[l - 1][i];
+            XOR_ASSERT(word != 0, "Non-zero summary bit refers to a zero word");
+            i = i * 64 + countTrailingZeros(word);
+        }
+
+        return static_cast<int64_t>(i);
+    }
+
+    size_t OffsetBuddy::FreeBits::count() const
+    {
+        size_t bits = 0;
+        for (uint64_t word : m_levels[0])
+            bits += popCount(word);
+        return bits;
+    }
+
+    OffsetBuddy::OffsetBuddy(size_t size, size_t minBlockSize)
+    {
+        XOR_ASSERT(popCount(minBlockSize) == 1, "Minimum block size must be a power of 2");
+
+        m_minBlockSize = minBlockSize;
+        m_minBlockLog2 = countTrailingZeros(minBlockSize);
+
+        size_t blocks = size >> m_minBlockLog2;
+        m_size        = blocks << m_minBlockLog2;
+
+        if (blocks == 0)
+            return;
+
+        uint maxOrder = static_cast<uint>(firstbithigh(roundUpToPow2<uint64_t>(blocks)));
+        m_orders.resize(maxOrder + 1);
+        for (uint k = 0; k <= maxOrder; ++k)
+            m_orders[k].resize(divRoundUp<size_t>(blocks, size_t(1) << k));
+
+        // Cover the size with the largest possible aligned blocks.
+        // The buddies of these blocks lie past the end, so they
+        // never get merged into anything larger.
+        size_t offset = 0;
+        while (offset < blocks)
+        {
+            uint order = static_cast<uint>(firstbithigh(blocks - offset));
+            if (offset > 0)
+                order = std::min(order, countTrailingZeros(offset));
+
+            m_orders[order].set(offset >> order);
+            offset += size_t(1) << order;
+        }
+
+        m_freeSpace = m_size;
+    }
+
+    uint OffsetBuddy::orderForSize(size_t size) const
+    {
+        size_t blocks = divRoundUp<size_t>(std::max<size_t>(size, 1), m_minBlockSize);
+        return static_cast<uint>(firstbithigh(roundUpToPow2<uint64_t>(blocks)));
+    }
+
+    Block OffsetBuddy::allocate(size_t size)
+    {
+        return allocate(size, 1);
+    }
+
+    Block OffsetBuddy::allocate(size_t size, size_t alignment)
+    {
+        XOR_ASSERT(popCount(alignment) == 1, "Alignment must be a power of 2");
+
+        // Blocks are aligned to their size, so larger alignments
+        // can be satisfied by allocating larger blocks.
+        uint order = std::max(orderForSize(size), orderForSize(alignment));
+
+        for (uint k = order; k < orders(); ++k)
+        {
+            int64_t found = m_orders[k].findFirst();
+            if (found < 0)
+                continue;
+
+            size_t index = static_cast<size_t>(found);
+            m_orders[k].clear(index);
+
+            // Split the block until it has the right size, and
+            // release the upper halves.
+            while (k > order)
+            {
+                --k;
+                index *= 2;
+                m_orders[k].set(index + 1);
+            }
+
+            size_t bytes = blockSize(order);
+            m_freeSpace -= bytes;
+
+            int64_t begin = static_cast<int64_t>(index << (order + m_minBlockLog2));
+            return Block(begin, begin + static_cast<int64_t>(bytes));
+        }
+
+        return Block();
+    }
+
+    void OffsetBuddy::release(Block block)
+    {
+        XOR_ASSERT(block.begin >= 0 && block.end <= static_cast<int64_t>(m_size),
+                   "Released block is out of bounds");
+
+        uint order = orderForSize(block.size());
+        XOR_ASSERT(block.size() == blockSize(order),
+                   "Released block does not have a power of two size");
+
+        size_t index = static_cast<size_t>(block.begin) >> (order + m_minBlockLog2);
+        XOR_ASSERT(static_cast<size_t>(block.begin) == index << (order + m_minBlockLog2),
+                   "Released block is misaligned");
+
+        m_freeSpace += block.size();
+        releaseBlock(order, index);
+    }
+
+    void OffsetBuddy::releaseBlock(uint order, size_t index)
+    {
+        // Merge with the buddy as long as it's free.
+        while (order + 1 < orders())
+        {
+            size_t buddy = index ^ 1;
+            if (buddy >= m_orders[order].size() || !m_orders[order].test(buddy))
+                break;
+
+            m_orders[order].clear(buddy);
+            index /= 2;
+            ++order;
+        }
+
+        XOR_ASSERT(!m_orders[order].test(index), "Released block was already free");
+        m_orders[order].set(index);
+    }
+
+    OffsetBuddy::FragmentationReport OffsetBuddy::fragmentation() const
+    {
+        FragmentationReport report;
+        report.freeBytes = m_freeSpace;
+        report.freeBytesPerOrder.resize(orders());
+
+        for (uint k = 0; k < orders(); ++k)
+        {
+            size_t blocks = m_orders[k].count();
+            report.freeBytesPerOrder[k] = blocks * blockSize(k);
+            if (blocks > 0)
+                report.largestFreeBlock = blockSize(k);
+        }
+
+        return report;
+    }
+
     Block Block::fitAtBegin(size_t size, size_t alignment) const
     {
         int64_t iSize = static_cast<int64_t>(size);
@@ -6,9 +6,11 @@
 #include <vector>
 #include <map>
 #include <unordered_map>
-#include <queue>
+#include <set>
 #include <algorithm>
 #include <functional>
+#include <atomic>
+#include <cstddef>
 
 namespace Xor
 {
@@ -31,6 +33,64 @@ namespace Xor
         void release(int64_t offset);
     };
 
+    // Thread-safe pool allocator that manages abstract offsets.
+    // Free offsets are kept in several lock-free stacks, and each thread
+    // uses its own stack so threads don't contend with each other. If a
+    // thread runs out of offsets, it steals a batch from another stack.
+    // When used from a single thread, offsets are allocated in the same
+    // order as OffsetPool allocates them.
+    class ConcurrentOffsetPool
+    {
+        static const uint     NumStacks    = 32;
+        static const uint     StealBatch   = 32;
+        static const uint32_t InvalidIndex = ~0U;
+
+        // The top of the stack is packed into 64 bits together with
+        // a tag that changes on every modification to avoid ABA problems.
+        // Stacks are padded so that no two of them share a cache line.
+        struct Stack
+        {
+            std::atomic<uint64_t> top;
+            uint8_t               padding[128 - sizeof(uint64_t)];
+        };
+
+        size_t                                   m_size = 0;
+        std::unique_ptr<Stack[]>                 m_stacks;
+        // Number of free offsets not yet reserved by allocate(). An offset is
+        // only counted after it has been pushed to a stack, so a successful
+        // reservation guarantees that allocate() will eventually find one,
+        // even if it is in the middle of being stolen by another thread.
+        std::unique_ptr<std::atomic<int64_t>>    m_available;
+        // Next free offset in the same stack for each free offset.
+        std::unique_ptr<std::atomic<uint32_t>[]> m_next;
+#if XOR_ASSERTIONS
+        // Releasing an offset twice would link it into the stacks twice,
+        // so track which offsets are allocated in debug builds.
+        std::unique_ptr<std::atomic<uint8_t>[]>  m_allocated;
+#endif
+    public:
+        ConcurrentOffsetPool() = default;
+        ConcurrentOffsetPool(size_t size);
+
+        // These are only approximate if other threads are
+        // allocating or releasing at the same time.
+        bool empty() const;
+        bool full() const;
+
+        size_t size() const;
+        size_t spaceLeft() const;
+
+        int64_t allocate();
+        void release(int64_t offset);
+
+    private:
+        Stack &threadStack();
+        uint32_t pop(Stack &stack);
+        uint32_t popChain(Stack &stack, uint maxLength, uint32_t &last, uint &length);
+        void pushChain(Stack &stack, uint32_t first, uint32_t last, uint length);
+        int64_t markAllocated(uint32_t offset);
+    };
+
     // Object pool allocator using a simple std::vector.
     template <typename T>
     class Pool
@@ -95,6 +155,121 @@ namespace Xor
         }
     };
 
+    // Linear bump pointer allocator for short-lived temporary memory.
+    // Memory is allocated from large chunks that are kept around when
+    // the arena is reset or rewound, so once the arena has warmed up,
+    // allocating from it causes no heap allocations at all. Individual
+    // allocations are never freed. Instead, everything allocated after
+    // a marker is freed at once by rewinding to it, or by resetting.
+    // Arenas are not thread-safe, but each thread has one of its own.
+    class FrameArena
+    {
+    public:
+        static const size_t DefaultChunkSize = 1024 * 1024;
+
+        struct Marker
+        {
+            size_t chunk  = 0;
+            size_t offset = 0;
+            size_t used   = 0;
+        };
+
+        struct Statistics
+        {
+            // Number of allocations made from the arena.
+            size_t allocations     = 0;
+            // Number of chunks allocated from the general heap.
+            size_t heapAllocations = 0;
+            // Bytes currently allocated from the arena including
+            // alignment padding, and the peak of that.
+            size_t usedBytes       = 0;
+            size_t peakUsedBytes   = 0;
+            // Total size of all chunks.
+            size_t reservedBytes   = 0;
+        };
+
+    private:
+        struct Chunk
+        {
+            std::unique_ptr<uint8_t[]> memory;
+            size_t                     size = 0;
+        };
+
+        std::vector<Chunk> m_chunks;
+        size_t             m_chunkSize = DefaultChunkSize;
+        Marker             m_top;
+        Statistics         m_statistics;
+    public:
+        FrameArena(size_t chunkSize = DefaultChunkSize);
+
+        // The arena of the calling thread.
+        static FrameArena &thisThread();
+
+        void *allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+
+        template <typename T>
+        T *allocate(size_t count = 1)
+        {
+            return static_cast<T *>(allocate(count * sizeof(T), alignof(T)));
+        }
+
+        // Free everything allocated after the marker was obtained.
+        Marker marker() const { return m_top; }
+        void rewind(Marker marker);
+        // Free everything allocated from the arena in constant time.
+        void reset() { rewind(Marker()); }
+
+        const Statistics &statistics() const { return m_statistics; }
+        // Zero the allocation counts, and set the peak to the current usage.
+        void resetStatistics();
+    };
+
+    // Rewinds the arena to where it was when the scope was entered.
+    class FrameArenaScope
+    {
+        FrameArena        *m_arena = nullptr;
+        FrameArena::Marker m_marker;
+    public:
+        FrameArenaScope(FrameArena &arena = FrameArena::thisThread())
+            : m_arena(&arena)
+            , m_marker(arena.marker())
+        {}
+        ~FrameArenaScope() { m_arena->rewind(m_marker); }
+
+        FrameArenaScope(const FrameArenaScope &) = delete;
+        FrameArenaScope &operator=(const FrameArenaScope &) = delete;
+    };
+
+    // STL allocator that allocates from a FrameArena, by default
+    // from the arena of the thread that created the allocator.
+    template <typename T>
+    class FrameAllocator
+    {
+        template <typename U> friend class FrameAllocator;
+        FrameArena *m_arena = nullptr;
+    public:
+        using value_type = T;
+
+        FrameAllocator() : m_arena(&FrameArena::thisThread()) {}
+        FrameAllocator(FrameArena &arena) : m_arena(&arena) {}
+
+        template <typename U>
+        FrameAllocator(const FrameAllocator<U> &other) : m_arena(other.m_arena) {}
+
+        T *allocate(size_t count) { return m_arena->allocate<T>(count); }
+        void deallocate(T *, size_t) {}
+
+        FrameArena &arena() const { return *m_arena; }
+
+        template <typename U>
+        bool operator==(const FrameAllocator<U> &other) const { return m_arena == other.m_arena; }
+        template <typename U>
+        bool operator!=(const FrameAllocator<U> &other) const { return m_arena != other.m_arena; }
+    };
+
+    template <typename T>
+    using FrameVector = std::vector<T, FrameAllocator<T>>;
+
     struct Block
     {
         int64_t begin = -1;
@@ -232,6 +407,49 @@ namespace Xor
         }
     };
 
+    // Ring buffer suballocator that several threads can allocate from
+    // at the same time without locks. Releasing is FIFO like with OffsetRing.
+    // Positions grow monotonically, and offsets are positions modulo the size.
+    // Each allocation also consumes any padding needed to align it or to wrap
+    // it around to the start, so releasing a block also releases its padding.
+    class ConcurrentOffsetRing
+    {
+        // Position of the oldest allocated element, unless equal to tail.
+        std::atomic<int64_t> m_head { 0 };
+        // Position of the first free element.
+        std::atomic<int64_t> m_tail { 0 };
+        int64_t              m_size = 0;
+    public:
+        ConcurrentOffsetRing() = default;
+        ConcurrentOffsetRing(size_t size) : m_size(static_cast<int64_t>(size)) {}
+
+        // These are only approximate if other threads are
+        // allocating or releasing at the same time.
+        bool empty() const { return freeSpace() == size(); }
+        bool full() const  { return freeSpace() == 0; }
+        size_t size() const { return static_cast<size_t>(m_size); }
+        size_t freeSpace() const;
+
+        // Position one past the newest allocation.
+        int64_t position() const { return m_tail.load(); }
+
+        // Allocate a contiguous block. Return an invalid block on failure.
+        Block allocateBlock(size_t amount, size_t alignment = 1);
+        // Allocate a contiguous block, and also return the position one
+        // past the allocation, which can be used with releaseUntilPosition().
+        Block allocateBlock(size_t amount, size_t alignment, int64_t &position);
+
+        // Release the oldest allocated elements up to the given offset,
+        // which must lie within the allocated region.
+        void releaseEnd(int64_t onePastLastOffset);
+        // Release the oldest allocated block.
+        void release(Block block) { releaseEnd(block.end); }
+        // Release everything that was allocated before the given position.
+        // Positions older than what has already been released are ignored,
+        // so several threads can call this at the same time.
+        void releaseUntilPosition(int64_t position);
+    };
+
     // Generic best-fit address-ordered heap suballocator.
     class OffsetHeap
     {
@@ -244,9 +462,10 @@ namespace Xor
 
         struct SizeBin
         {
-            // Every free offset of this size bin in a priority
-            // queue so we can always obtain the lowest address.
-            std::priority_queue<int64_t> freeOffsets;
+            // Every free offset of this size bin in a sorted
+            // set so we can always obtain the lowest address, and
+            // remove blocks that get coalesced with their neighbors.
+            std::set<int64_t> freeOffsets;
         };
 
         // Contains the address-ordered free list of each non-empty
@@ -270,6 +489,8 @@ namespace Xor
         bool empty() const { return freeSpace() == static_cast<size_t>(m_size); }
         bool full() const { return freeSpace() == 0; }
         size_t freeSpace() const { return m_freeSpace; }
+        // Number of separate free blocks, which grows with fragmentation.
+        size_t freeBlockCount() const;
 
         // Attempt to shrink or grow this allocator. Growing always succeeds,
         // but shrinking fails if it would turn allocated areas invalid.
@@ -296,7 +517,192 @@ namespace Xor
         size_t decodeSize(SizeAlignment sa);
         uint decodeAlignment(SizeAlignment sa);
         bool canFit(SizeAlignment blockSA, size_t size, uint alignment);
+        SizeAlignment blockSizeAlignment(Block block);
+        bool isFree(Block block) const;
+        void removeFromSizeBin(Block block);
         void allocateBlock(Block block);
     };
+
+    // Two-level segregated fit (TLSF) heap suballocator with the same
+    // interface as OffsetHeap. Allocating and releasing run in constant
+    // time, and all bookkeeping is kept in flat arrays. Allocation is
+    // good-fit instead of best-fit, so fragmentation can be slightly
+    // worse than with OffsetHeap.
+    // Unlike OffsetHeap, blocks must be released exactly as they were
+    // returned by allocate() or given to markAsAllocated().
+    class OffsetHeapTLSF
+    {
+        // Every power of two size class is further split into
+        // this many linearly spaced bins.
+        static const uint SubdivisionBits = 5;
+        static const uint Subdivisions    = 1U << SubdivisionBits;
+        static const uint SizeClasses     = 64 - SubdivisionBits + 1;
+        static const uint32_t InvalidNode = ~0U;
+
+        // Every contiguous range of the heap, allocated or free, is
+        // described by one node. Nodes are linked to their physical
+        // neighbors so they can be coalesced, and free nodes are
+        // also linked to the free list of their bin.
+        struct Node
+        {
+            int64_t  begin    = -1;
+            int64_t  end      = -1;
+            uint32_t prev     = InvalidNode;
+            uint32_t next     = InvalidNode;
+            uint32_t prevFree = InvalidNode;
+            uint32_t nextFree = InvalidNode;
+            bool     free     = false;
+
+            size_t size() const { return static_cast<size_t>(end - begin); }
+        };
+
+        struct Bin
+        {
+            uint sizeClass   = 0;
+            uint subdivision = 0;
+
+            uint index() const { return sizeClass * Subdivisions + subdivision; }
+        };
+
+        // Slot of the open addressing hash table that maps the begin
+        // offsets of allocated blocks to their nodes.
+        struct AllocatedSlot
+        {
+            int64_t  begin = -1;
+            uint32_t node  = InvalidNode;
+        };
+
+        std::vector<Node>          m_nodes;
+        std::vector<uint32_t>      m_unusedNodes;
+        std::vector<AllocatedSlot> m_allocated;
+        size_t                     m_allocatedCount = 0;
+        // One bit per size class that has at least one non-empty bin.
+        uint64_t                   m_sizeClassBits  = 0;
+        // One bit per non-empty bin in each size class.
+        uint32_t                   m_binBits[SizeClasses];
+        // First node of the free list of each bin.
+        uint32_t                   m_bins[SizeClasses * Subdivisions];
+        // The node that ends at the end of the heap.
+        uint32_t                   m_lastNode = InvalidNode;
+
+        int64_t m_size      = 0;
+        uint m_minAlignment = 1;
+        size_t m_freeSpace  = 0;
+    public:
+        OffsetHeapTLSF();
+        OffsetHeapTLSF(size_t size, uint minimumAlignment = 1);
+
+        bool empty() const { return freeSpace() == static_cast<size_t>(m_size); }
+        bool full() const { return freeSpace() == 0; }
+        size_t freeSpace() const { return m_freeSpace; }
+
+        // Attempt to shrink or grow this allocator. Growing always succeeds,
+        // but shrinking fails if it would turn allocated areas invalid.
+        // Returns true on success.
+        bool resize(size_t newSize);
+
+        // Allocate a block of the given size using the minimum alignment
+        // of this allocator. The size is rounded up to an aligned multiple.
+        // Return an invalid block on failure.
+        Block allocate(size_t size);
+        // Allocate a block with the given size and alignment.
+        // The size is rounded up to be aligned with the minimum alignment.
+        // Return an invalid block on failure.
+        Block allocate(size_t size, uint alignment);
+        // Release a previously allocated block.
+        void release(Block block);
+        // Try to mark the given block (which should currently be free)
+        // as allocated. Return true on success, and false if some part
+        // of the block was allocated already. Unlike the other operations,
+        // this takes time linear in the number of blocks.
+        bool markAsAllocated(Block block);
+
+    private:
+        static Bin binForSize(size_t size);
+        static Bin binForAllocation(size_t size);
+
+        uint32_t newNode(int64_t begin, int64_t end);
+        void deleteNode(uint32_t node);
+        uint32_t split(uint32_t node, int64_t offset);
+        uint32_t coalesce(uint32_t node);
+
+        void insertFree(uint32_t node);
+        void removeFree(uint32_t node);
+        uint32_t findFree(size_t size, uint alignment);
+        void allocateNode(uint32_t node);
+
+        size_t allocatedHome(int64_t begin) const;
+        void insertAllocated(uint32_t node);
+        uint32_t removeAllocated(int64_t begin);
+    };
+
+    // Binary buddy suballocator. Every block is a power of two multiple of
+    // the minimum block size, and aligned to its own size. Free blocks
+    // of each order are tracked in hierarchical bitmaps, so finding,
+    // splitting and merging blocks takes O(log n) time. The lowest free
+    // address of the smallest fitting order is always used.
+    // The returned blocks are rounded up to the full power of two size,
+    // and must be released as they were returned.
+    class OffsetBuddy
+    {
+        // Set of bits where the first set bit can be found quickly.
+        // The first level has one bit per block, and every following
+        // level has one bit per non-zero word of the previous level.
+        class FreeBits
+        {
+            std::vector<std::vector<uint64_t>> m_levels;
+            size_t                             m_bits = 0;
+        public:
+            void resize(size_t bits);
+            size_t size() const { return m_bits; }
+            bool empty() const { return m_levels.empty() || m_levels.back()[0] == 0; }
+            bool test(size_t i) const { return ((m_levels[0][i / 64] >> (i % 64)) & 1) != 0; }
+            void set(size_t i);
+            void clear(size_t i);
+            int64_t findFirst() const;
+            size_t count() const;
+        };
+
+        std::vector<FreeBits> m_orders;
+        size_t m_size         = 0;
+        size_t m_minBlockSize = 1;
+        uint   m_minBlockLog2 = 0;
+        size_t m_freeSpace    = 0;
+    public:
+        struct FragmentationReport
+        {
+            size_t freeBytes        = 0;
+            size_t largestFreeBlock = 0;
+            // Total size of the free blocks of each order,
+            // starting from the minimum block size.
+            std::vector<size_t> freeBytesPerOrder;
+        };
+
+        OffsetBuddy() = default;
+        // Sizes that are not a power of two multiple of the minimum
+        // block size are supported, but the excess cannot be merged
+        // into larger blocks.
+        OffsetBuddy(size_t size, size_t minBlockSize = 1);
+
+        bool empty() const { return freeSpace() == m_size; }
+        bool full() const { return freeSpace() == 0; }
+        size_t size() const { return m_size; }
+        size_t freeSpace() const { return m_freeSpace; }
+
+        size_t minBlockSize() const { return m_minBlockSize; }
+        uint orders() const { return static_cast<uint>(m_orders.size()); }
+        size_t blockSize(uint order) const { return m_minBlockSize << order; }
+
+        // Return an invalid block on failure.
+        Block allocate(size_t size);
+        Block allocate(size_t size, size_t alignment);
+        void release(Block block);
+
+        FragmentationReport fragmentation() const;
+
+    private:
+        uint orderForSize(size_t size) const;
+        void releaseBlock(uint order, size_t index);
+    };
 }
 
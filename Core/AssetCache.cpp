@@ -0,0 +1,358 @@
+#include "Core/AssetCache.hpp"
+#include "Core/File.hpp"
+#include "Core/Serialization.hpp"
+#include "Core/Log.hpp"
+
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+
+namespace Xor
+{
+    struct AssetCacheManifestHeader
+    {
+        static const uint VersionNumber = 1;
+
+        // Use clock of the cache when the manifest was written.
+        uint64_t clock = 0;
+        uint64_t count = 0;
+    };
+
+    struct AssetCacheManifestEntry
+    {
+        AssetKey key;
+        uint64_t size     = 0;
+        uint64_t lastUsed = 0;
+    };
+
+    static const char AssetExtension[]     = ".xasset";
+    static const char TemporaryExtension[] = ".tmp";
+
+    String AssetKey::toString() const
+    {
+        return String::format("%016llx%016llx", static_cast<llu>(a), static_cast<llu>(b));
+    }
+
+    static bool parseAssetKey(StringView name, AssetKey &key)
+    {
+        if (name.length() != 32)
+            return false;
+
+        uint64_t words[2] = {};
+        for (int i = 0; i < 32; ++i)
+        {
+            char c = name[i];
+            uint digit;
+            if (c >= '0' && c <= '9')
+                digit = static_cast<uint>(c - '0');
+            else if (c >= 'a' && c <= 'f')
+                digit = static_cast<uint>(c - 'a' + 10);
+            else
+                return false;
+
+            words[i / 16] = (words[i / 16] << 4) | digit;
+        }
+
+        key.a = words[0];
+        key.b = words[1];
+        return true;
+    }
+
+    AssetCache::AssetCache(String directory, uint64_t maxSize)
+        : m_directory(std::move(directory))
+        , m_maxSize(maxSize)
+    {
+        std::error_code error;
+        fs::create_directories(m_directory.cStr(), error);
+
+        try
+        {
+            readManifest();
+        }
+        catch (const Exception &)
+        {
+            // If the manifest is missing or broken, the cache contents
+            // are still valid, since they are named after their keys.
+            scanDirectory();
+        }
+
+        removeStaleTemporaries();
+    }
+
+    AssetCache::~AssetCache()
+    {
+        try
+        {
+            flush();
+        }
+        catch (const Exception &) {}
+    }
+
+    AssetCache &AssetCache::global()
+    {
+        static AssetCache cache("cache");
+        return cache;
+    }
+
+    String AssetCache::manifestPath() const
+    {
+        return m_directory + "/manifest.bin";
+    }
+
+    String AssetCache::assetPath(const AssetKey &key) const
+    {
+        return m_directory + "/" + key.toString() + AssetExtension;
+    }
+
+    void AssetCache::readManifest()
+    {
+        auto path = manifestPath();
+        XOR_THROW(File::exists(path), AssetCacheException, "Asset cache manifest does not exist");
+
+        auto bytes = File(path).read();
+        Reader reader(bytes);
+
+        // Manifests of other versions are rebuilt from the cache contents.
+        uint version = reader.peekStructVersion();
+        XOR_THROW(version == AssetCacheManifestHeader::VersionNumber, AssetCacheException,
+                  "Asset cache manifest version %u differs from expected version %u",
+                  version, AssetCacheManifestHeader::VersionNumber);
+        auto header = reader.readStruct<AssetCacheManifestHeader>();
+
+        m_entries.clear();
+        m_entries.reserve(static_cast<size_t>(header.count));
+        m_totalSize = 0;
+        m_clock     = header.clock;
+
+        for (uint64_t i = 0; i < header.count; ++i)
+        {
+            auto e = reader.read<AssetCacheManifestEntry>();
+
+            Entry entry;
+            entry.size     = e.size;
+            entry.lastUsed = e.lastUsed;
+            m_entries[e.key] = entry;
+            m_totalSize     += e.size;
+            m_clock          = std::max(m_clock, e.lastUsed);
+        }
+
+        m_dirty = false;
+    }
+
+    void AssetCache::scanDirectory()
+    {
+        m_entries.clear();
+        m_totalSize = 0;
+        m_clock     = 0;
+
+        std::error_code error;
+        for (fs::directory_iterator it(m_directory.cStr(), error), end; !error && it != end; it.increment(error))
+        {
+            auto path = it->path();
+            if (path.extension().string() != AssetExtension)
+                continue;
+
+            AssetKey key;
+            if (!parseAssetKey(path.stem().string(), key))
+                continue;
+
+            // The order of use is unknown, so all assets start out equal.
+            Entry entry;
+            entry.size = static_cast<uint64_t>(fs::file_size(path, error));
+            if (error)
+            {
+                error.clear();
+                continue;
+            }
+
+            m_entries[key] = entry;
+            m_totalSize   += entry.size;
+        }
+
+        log("AssetCache", "Rebuilt the manifest of \"%s\" with %zu assets\n",
+            m_directory.cStr(), m_entries.size());
+
+        m_dirty = true;
+    }
+
+    void AssetCache::removeStaleTemporaries()
+    {
+        // Temporary files that are not that old might belong to imports
+        // that are still running in other processes.
+        auto now = fs::file_time_type::clock::now();
+        auto maxAge = std::chrono::hours(StaleTemporaryHours);
+
+        std::vector<fs::path> stale;
+        std::error_code error;
+        for (fs::directory_iterator it(m_directory.cStr(), error), end; !error && it != end; it.increment(error))
+        {
+            auto path = it->path();
+            if (path.extension().string() != TemporaryExtension)
+                continue;
+
+            std::error_code timeError;
+            auto written = fs::last_write_time(path, timeError);
+            if (!timeError && now - written > maxAge)
+                stale.emplace_back(std::move(path));
+        }
+
+        for (auto &path : stale)
+        {
+            std::error_code removeError;
+            if (fs::remove(path, removeError))
+                log("AssetCache", "Removed stale temporary file \"%s\"\n", path.string().c_str());
+        }
+    }
+
+    void AssetCache::writeManifest()
+    {
+        AssetCacheManifestHeader header;
+        header.clock = m_clock;
+        header.count = m_entries.size();
+
+        DynamicBuffer<uint8_t> bytes;
+        auto writer = makeWriter(bytes, sizeof(header) + 4 + m_entries.size() * sizeof(AssetCacheManifestEntry));
+        writer.writeStruct(header);
+        for (auto &kv : m_entries)
+        {
+            AssetCacheManifestEntry e;
+            e.key      = kv.first;
+            e.size     = kv.second.size;
+            e.lastUsed = kv.second.lastUsed;
+            writer.write(e);
+        }
+
+        // Replace the old manifest atomically, so that it is never
+        // seen half written.
+        auto path      = manifestPath();
+        auto tempPath  = path + TemporaryExtension;
+        {
+            File file(tempPath, File::Mode::ReadWrite, File::Create::CreateAlways);
+            XOR_THROW_HR(file.hr(), AssetCacheException);
+            XOR_THROW_HR(file.write(Span<const uint8_t>(bytes.data(), writer.bytesWritten())), AssetCacheException);
+        }
+
+        std::error_code error;
+        fs::rename(tempPath.cStr(), path.cStr(), error);
+        XOR_THROW(!error, AssetCacheException, "Could not replace \"%s\": %s", path.cStr(), error.message().c_str());
+
+        m_dirty = false;
+    }
+
+    void AssetCache::evict()
+    {
+        if (m_totalSize <= m_maxSize)
+            return;
+
+        std::vector<std::pair<uint64_t, AssetKey>> byAge;
+        byAge.reserve(m_entries.size());
+        for (auto &kv : m_entries)
+            byAge.emplace_back(kv.second.lastUsed, kv.first);
+        std::sort(byAge.begin(), byAge.end(),
+                  [] (const std::pair<uint64_t, AssetKey> &a, const std::pair<uint64_t, AssetKey> &b)
+        {
+            return a.first < b.first;
+        });
+
+        // Never evict the most recently used asset, which was just inserted.
+        for (size_t i = 0; i + 1 < byAge.size() && m_totalSize > m_maxSize; ++i)
+        {
+            auto &key  = byAge[i].second;
+            auto path  = assetPath(key);
+
+            // Assets that are in use cannot be removed on Windows,
+            // so they are left for next time.
+            std::error_code error;
+            fs::remove(path.cStr(), error);
+            if (error && File::exists(path))
+                continue;
+
+            m_totalSize -= m_entries.find(key)->second.size;
+            m_entries.erase(key);
+            m_dirty = true;
+
+            log("AssetCache", "Evicted asset %s\n", key.toString().cStr());
+        }
+    }
+
+    String AssetCache::find(const AssetKey &key)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto it = m_entries.find(key);
+        if (it == m_entries.end())
+            return String();
+
+        auto path = assetPath(key);
+        // The asset might have been removed behind our back.
+        if (!File::exists(path))
+        {
+            m_totalSize -= it->second.size;
+            m_entries.erase(it);
+            m_dirty = true;
+            return String();
+        }
+
+        it->second.lastUsed = ++m_clock;
+        m_dirty = true;
+        return path;
+    }
+
+    String AssetCache::temporaryPath(const AssetKey &key) const
+    {
+        // Unique even if several threads or processes import the same asset.
+        static std::atomic<uint> counter { 0 };
+        return String::format("%s.%u.%u%s",
+                              assetPath(key).cStr(),
+                              static_cast<uint>(GetCurrentProcessId()),
+                              counter++,
+                              TemporaryExtension);
+    }
+
+    void AssetCache::discard(const String &temporaryPath) const
+    {
+        std::error_code error;
+        fs::remove(temporaryPath.cStr(), error);
+    }
+
+    String AssetCache::insert(const AssetKey &key, const String &temporaryPath)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        auto path = assetPath(key);
+
+        std::error_code error;
+        uint64_t size = static_cast<uint64_t>(fs::file_size(temporaryPath.cStr(), error));
+        XOR_THROW(!error, AssetCacheException, "Could not find imported asset \"%s\"", temporaryPath.cStr());
+
+        fs::rename(temporaryPath.cStr(), path.cStr(), error);
+        if (error)
+        {
+            // Another importer may have won the race and be using the
+            // asset already, in which case its copy is just as good.
+            std::error_code removeError;
+            fs::remove(temporaryPath.cStr(), removeError);
+            XOR_THROW(File::exists(path), AssetCacheException,
+                      "Could not insert \"%s\" into the asset cache: %s", path.cStr(), error.message().c_str());
+        }
+
+        auto &entry = m_entries[key];
+        m_totalSize   -= entry.size;
+        entry.size     = size;
+        entry.lastUsed = ++m_clock;
+        m_totalSize   += size;
+
+        evict();
+        writeManifest();
+
+        return path;
+    }
+
+    void AssetCache::flush()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_dirty)
+            writeManifest();
+    }
+}
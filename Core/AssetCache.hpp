@@ -0,0 +1,100 @@
+#pragma once
+
+#include "Core/Utils.hpp"
+#include "Core/String.hpp"
+#include "Core/Hash.hpp"
+#include "Core/FlatHash.hpp"
+
+#include <mutex>
+
+namespace Xor
+{
+    // Identifies an imported asset by a 128-bit hash of everything it was
+    // imported from, i.e. the source data and the import options.
+    struct AssetKey
+    {
+        uint64_t a = 0;
+        uint64_t b = 0;
+
+        AssetKey() = default;
+        AssetKey(std::pair<uint64_t, uint64_t> hash)
+            : a(hash.first)
+            , b(hash.second)
+        {}
+
+        bool operator==(const AssetKey &k) const { return a == k.a && b == k.b; }
+        bool operator!=(const AssetKey &k) const { return !operator==(k); }
+
+        // 32 hexadecimal digits, used as the file name in the cache.
+        String toString() const;
+    };
+
+    XOR_EXCEPTION_TYPE(AssetCacheException)
+
+    // Directory of imported assets that are stored under their AssetKey,
+    // so changed sources are always reimported and unchanged ones are
+    // never, regardless of file timestamps. A manifest of all assets is
+    // kept in memory for lookups, and the least recently used assets
+    // are evicted when the cache grows too large.
+    class AssetCache
+    {
+        struct Entry
+        {
+            uint64_t size     = 0;
+            // Value of the use clock when the asset was last used.
+            uint64_t lastUsed = 0;
+        };
+
+        String                       m_directory;
+        uint64_t                     m_maxSize   = 0;
+        uint64_t                     m_totalSize = 0;
+        uint64_t                     m_clock     = 0;
+        bool                         m_dirty     = false;
+        FlatHashMap<AssetKey, Entry> m_entries;
+        std::mutex                   m_mutex;
+
+        String manifestPath() const;
+        String assetPath(const AssetKey &key) const;
+        void readManifest();
+        void scanDirectory();
+        void removeStaleTemporaries();
+        void writeManifest();
+        void evict();
+    public:
+        static const uint64_t DefaultMaxSize = 4ull * 1024 * 1024 * 1024;
+        // Temporary files older than this are left over from crashed
+        // imports, and are removed when the cache is opened.
+        static const uint     StaleTemporaryHours = 1;
+
+        AssetCache(String directory, uint64_t maxSize = DefaultMaxSize);
+        ~AssetCache();
+
+        AssetCache(const AssetCache &) = delete;
+        AssetCache &operator=(const AssetCache &) = delete;
+
+        // The cache in the "cache" directory, shared by all importers.
+        static AssetCache &global();
+
+        const String &directory() const { return m_directory; }
+        uint64_t totalSize() const { return m_totalSize; }
+        size_t assetCount() const { return m_entries.size(); }
+
+        // Return the path of the cached asset, or an empty string if it is
+        // not in the cache. Found assets become the most recently used.
+        String find(const AssetKey &key);
+        // Unique path for writing a new asset. It only becomes visible to
+        // find() once it is inserted, so an interrupted import never leaves
+        // a partial asset behind.
+        String temporaryPath(const AssetKey &key) const;
+        // Remove a temporaryPath() that will not be inserted, e.g. because
+        // the import failed.
+        void discard(const String &temporaryPath) const;
+        // Atomically move an asset written into a temporaryPath() into the
+        // cache, and return its path. Evicts the least recently used assets
+        // if the cache has grown too large.
+        String insert(const AssetKey &key, const String &temporaryPath);
+        // Write the manifest if it has changed. This also happens when the
+        // cache is destroyed.
+        void flush();
+    };
+}
@@ -1,5 +1,8 @@
 #include "Core/ChunkFile.hpp"
 #include "Core/Utils.hpp"
+#include "Core/Compression.hpp"
+#include "Core/Hash.hpp"
+#include "Core/ThreadPool.hpp"
 
 // #define XOR_LOG_CHUNKFILE_OPS
 
@@ -13,21 +16,22 @@ namespace Xor
 {
     namespace serialization
     {
-        struct FileBlock
+        template <typename T>
+        struct BasicFileBlock
         {
-            int32_t begin = -1;
-            int32_t end   = -1;
+            T begin = -1;
+            T end   = -1;
 
-            FileBlock() = default;
+            BasicFileBlock() = default;
 
-            FileBlock(int32_t begin, int32_t end)
+            BasicFileBlock(T begin, T end)
                 : begin(begin)
                 , end(end)
             {}
 
-            FileBlock(Block b)
-                : begin(static_cast<int32_t>(b.begin))
-                , end(static_cast<int32_t>(b.end))
+            BasicFileBlock(Block b)
+                : begin(static_cast<T>(b.begin))
+                , end(static_cast<T>(b.end))
             {}
 
             Block block() const
@@ -38,22 +42,167 @@ namespace Xor
             explicit operator bool() const { return begin >= 0; }
             operator Block() const { return block(); }
         };
+
+        // Version 1 files used 32-bit offsets, which limited them to 2 GB.
+        using FileBlock   = BasicFileBlock<int32_t>;
+        using FileBlock64 = BasicFileBlock<int64_t>;
     }
 
     using namespace Xor::serialization;
 
-    struct ChunkFileHeader
+    // Version 1 chunks contain:
+    //   - subchunk count (length)
+    //   - data size in bytes (length)
+    //   - for each subchunk, its name (string) and block (FileBlock)
+    //   - data
+    // Version 2 chunks are identical, except that the data size
+    // is an uint64_t and the blocks are FileBlock64s.
+    // Version 3 chunks add the codec (uint8_t) after the data size,
+    // followed by the uncompressed size (uint64_t) and checksum (uint64_t)
+    // of the data if it is compressed. The data size is the stored size.
+    struct ChunkFileHeaderV1
     {
         static const uint VersionNumber = 1;
         FourCC fourCC;
         FileBlock mainChunk;
     };
 
+    struct ChunkFileHeaderV2
+    {
+        static const uint VersionNumber = 2;
+        FourCC      fourCC;
+        uint32_t    padding = 0;
+        FileBlock64 mainChunk;
+    };
+
+    // The header itself did not change in version 3.
+    struct ChunkFileHeader : ChunkFileHeaderV2
+    {
+        static const uint VersionNumber = 3;
+    };
+
     static const FourCC ChunkFileFourCC { "XORC" };
-    static const size_t ChunkFileMaxSize = 1024ULL * 1024ULL * 1024ULL;
+    static const char   DictionaryChunkName[] = "zstd-dictionary";
+
+    static const char *codecName(ChunkFile::Codec codec)
+    {
+        switch (codec)
+        {
+        case ChunkFile::Codec::None:           return "None";
+        case ChunkFile::Codec::Zstd:           return "Zstd";
+        case ChunkFile::Codec::ZstdFrames:     return "ZstdFrames";
+        case ChunkFile::Codec::ZstdDictionary: return "ZstdDictionary";
+        default:                               return "Unknown";
+        }
+    }
+
+    static ChunkFile::StoredData compressData(ChunkFile::Codec codec,
+                                              Span<const uint8_t> data,
+                                              DynamicBuffer<uint8_t> &compressed,
+                                              const ZstdDictionary *dictionary)
+    {
+        ChunkFile::StoredData stored;
+        stored.codec            = codec;
+        stored.uncompressedSize = data.sizeBytes();
+
+        switch (codec)
+        {
+        case ChunkFile::Codec::None:
+            stored.bytes = data;
+            return stored;
+        case ChunkFile::Codec::Zstd:
+            compressed = compressZstd(data);
+            break;
+        case ChunkFile::Codec::ZstdFrames:
+            compressed = compressParallel(data);
+            break;
+        case ChunkFile::Codec::ZstdDictionary:
+            XOR_THROW(dictionary, SerializationException, "Chunk needs a dictionary, but the file has none");
+            compressed = compressZstd(data, dictionary->cdict());
+            break;
+        default:
+            XOR_THROW(false, SerializationException, "Unknown chunk codec %u", static_cast<uint>(codec));
+            break;
+        }
+
+        stored.bytes    = compressed;
+        stored.checksum = hashBytes(data);
+        return stored;
+    }
+
+    static DynamicBuffer<uint8_t> decompressData(const ChunkFile::StoredData &stored,
+                                                 const ZstdDictionary *dictionary)
+    {
+        DynamicBuffer<uint8_t> data;
+
+        switch (stored.codec)
+        {
+        case ChunkFile::Codec::Zstd:
+            data = decompressZstd(static_cast<size_t>(stored.uncompressedSize), stored.bytes);
+            break;
+        case ChunkFile::Codec::ZstdFrames:
+            data = decompressParallel(stored.bytes);
+            break;
+        case ChunkFile::Codec::ZstdDictionary:
+            XOR_THROW(dictionary, SerializationException, "Chunk needs a dictionary, but the file has none");
+            data = decompressZstd(static_cast<size_t>(stored.uncompressedSize), stored.bytes, dictionary->ddict());
+            break;
+        default:
+            XOR_THROW(false, SerializationException, "Unknown chunk codec %u", static_cast<uint>(stored.codec));
+            break;
+        }
+
+        XOR_THROW(data.size() == stored.uncompressedSize && hashBytes(data) == stored.checksum,
+                  SerializationException, "Compressed chunk data is corrupted");
+        return data;
+    }
+
+    static size_t writeChunkDirectory(DynamicBuffer<uint8_t> &buffer,
+                                      Span<const std::pair<String, Block>> subchunks,
+                                      const ChunkFile::StoredData &data)
+    {
+        auto writer = makeWriter(buffer, 1024);
+        XOR_CHUNKFILE_OP("Writing subchunk count: %zu\n", subchunks.size());
+        writer.writeLength(static_cast<uint>(subchunks.size()));
+        XOR_CHUNKFILE_OP("Writing chunk data size: %zu\n", data.bytes.sizeBytes());
+        writer.write(static_cast<uint64_t>(data.bytes.sizeBytes()));
+        XOR_CHUNKFILE_OP("Writing chunk codec: %s\n", codecName(data.codec));
+        writer.write(data.codec);
+        if (data.codec != ChunkFile::Codec::None)
+        {
+            writer.write(data.uncompressedSize);
+            writer.write(data.checksum);
+        }
+
+        for (auto &&kv : subchunks)
+        {
+            XOR_CHUNKFILE_OP("Writing subchunk name: %s\n", kv.first.cStr());
+            writer.writeString(kv.first);
+            XOR_CHUNKFILE_OP("Writing subchunk block: (%lld, %lld)\n",
+                             static_cast<lld>(kv.second.begin),
+                             static_cast<lld>(kv.second.end));
+            writer.write(FileBlock64(kv.second));
+        }
+
+        return writer.bytesWritten();
+    }
+
+    static void writeChunkFileHeader(File &file, Block mainChunk)
+    {
+        ChunkFileHeader header;
+        header.fourCC    = ChunkFileFourCC;
+        header.mainChunk = mainChunk;
+
+        DynamicBuffer<uint8_t> buffer;
+        makeWriter(buffer).writeStruct(header);
+
+        file.seek(0);
+        XOR_THROW_HR(file.write(buffer), SerializationException);
+    }
 
     ChunkFile::Chunk *ChunkFile::Chunk::maybeChunk(StringView name)
     {
+        parse();
         auto it = m_chunks.find(name);
         if (it == m_chunks.end())
             return nullptr;
@@ -63,6 +212,7 @@ namespace Xor
 
     const ChunkFile::Chunk * ChunkFile::Chunk::maybeChunk(StringView name) const
     {
+        parse();
         auto it = m_chunks.find(name);
         if (it == m_chunks.end())
             return nullptr;
@@ -86,12 +236,21 @@ namespace Xor
 
     ChunkFile::Chunk & ChunkFile::Chunk::setChunk(StringView name)
     {
-        m_chunks[name].reset(new Chunk(*m_file));
-        return *m_chunks[name];
+        parse();
+        auto &chunk = m_chunks[name];
+
+        // The replaced chunk will no longer be in the file.
+        if (chunk && m_file->m_updatable)
+            chunk->releaseFileBlocks(m_file->m_allocator);
+
+        chunk.reset(new Chunk(*m_file));
+        m_directoryDirty = true;
+        return *chunk;
     }
 
     std::vector<std::pair<String, ChunkFile::Chunk *>> ChunkFile::Chunk::allChunks()
     {
+        parse();
         std::vector<std::pair<String, Chunk *>> chunks;
         for (auto &c : m_chunks)
             chunks.emplace_back(c.first, c.second.get());
@@ -100,46 +259,34 @@ namespace Xor
 
     std::vector<std::pair<String, const ChunkFile::Chunk *>> ChunkFile::Chunk::allChunks() const
     {
+        parse();
         std::vector<std::pair<String, const Chunk *>> chunks;
         for (auto &c : m_chunks)
             chunks.emplace_back(c.first, c.second.get());
         return chunks;
     }
 
-    Span<uint8_t> ChunkFile::span(Block block)
+    Span<const uint8_t> ChunkFile::contents() const
     {
-        return makeSpan(m_contents.data() + block.begin, block.size());
+        if (mapped())
+            return makeSpan(m_mapping.data(), m_mapping.size());
+        else
+            return m_contents;
     }
 
     Span<const uint8_t> ChunkFile::span(Block block) const
     {
-        return makeSpan(m_contents.data() + block.begin, block.size());
-    }
-
-    void ChunkFile::obtainBlock(Block & block, size_t bytes)
-    {
-        if (!block || block.size() != bytes)
-        {
-            if (block)
-                m_allocator.release(block);
-
-            block = m_allocator.allocate(bytes);
-
-            if (static_cast<size_t>(block.end) > m_contents.size())
-                m_contents.resize(static_cast<size_t>(block.end));
-        }
+        auto bytes = contents();
+        XOR_THROW(block.begin >= 0 && block.begin <= block.end && static_cast<size_t>(block.end) <= bytes.size(),
+                  SerializationException,
+                  "Chunk (%lld, %lld) is out of bounds",
+                  static_cast<lld>(block.begin), static_cast<lld>(block.end));
+        return makeSpan(bytes.data() + block.begin, block.size());
     }
 
     ChunkFile::ChunkFile(String path)
         : m_path(std::move(path))
-        , m_contents(ChunkFileMaxSize)
-    {
-        XOR_CHECK(m_allocator.resize(ChunkFileMaxSize),
-                  "Could not resize allocator to desired size");
-        XOR_CHECK(m_allocator.markAsAllocated(
-            Block(0, static_cast<int64_t>(serializedStructSize<ChunkFileHeader>()))),
-            "Failed to mark header as allocated");
-    }
+    {}
 
     ChunkFile::Chunk & ChunkFile::mainChunk()
     {
@@ -155,36 +302,181 @@ namespace Xor
         return *m_mainChunk;
     }
 
+    void ChunkFile::readHeader()
+    {
+        Reader reader(contents());
+        Block mainChunk;
+
+        m_version = reader.peekStructVersion();
+        if (m_version == ChunkFileHeaderV1::VersionNumber)
+        {
+            auto header = reader.readStruct<ChunkFileHeaderV1>();
+            XOR_THROW(header.fourCC.asUint() == ChunkFileFourCC.asUint(), SerializationException, "Wrong 4CC");
+            mainChunk = header.mainChunk;
+        }
+        else if (m_version == ChunkFileHeaderV2::VersionNumber)
+        {
+            auto header = reader.readStruct<ChunkFileHeaderV2>();
+            XOR_THROW(header.fourCC.asUint() == ChunkFileFourCC.asUint(), SerializationException, "Wrong 4CC");
+            mainChunk = header.mainChunk;
+        }
+        else
+        {
+            auto header = reader.readStruct<ChunkFileHeader>();
+            XOR_THROW(header.fourCC.asUint() == ChunkFileFourCC.asUint(), SerializationException, "Wrong 4CC");
+            mainChunk = header.mainChunk;
+        }
+
+        XOR_CHUNKFILE_OP("Reading ChunkFile version %u\n", m_version);
+        m_mainChunk.reset(new Chunk(*this, mainChunk));
+    }
+
     void ChunkFile::read()
     {
         XOR_CHUNKFILE_OP("\nReading ChunkFile(\"%s\")\n", m_path.cStr());
+        close();
         File f(m_path);
         XOR_THROW(!!f, SerializationException, "Failed to open file");
-        m_contents.resize(f.size());
-        XOR_THROW_HR(f.read(m_contents), SerializationException);
+        m_contents = f.read();
 
-        auto header = Reader(m_contents).readStruct<ChunkFileHeader>();
-        XOR_THROW(header.fourCC.asUint() == ChunkFileFourCC.asUint(), SerializationException, "Wrong 4CC");
-
-        m_mainChunk.reset(new Chunk(*this, header.mainChunk));
+        readHeader();
         m_mainChunk->read();
+
+        // Track which parts of the file are in use, so it can be updated in place.
+        if (m_version == ChunkFileHeader::VersionNumber)
+        {
+            m_fileSize  = static_cast<int64_t>(m_contents.size());
+            m_allocator = OffsetHeap(static_cast<size_t>(m_fileSize));
+            XOR_THROW(m_allocator.markAsAllocated(
+                Block(0, static_cast<int64_t>(serializedStructSize<ChunkFileHeader>()))),
+                SerializationException, "Chunk overlaps the header");
+            m_mainChunk->markAllocated(m_allocator);
+            m_updatable = true;
+        }
     }
 
-    void ChunkFile::write() 
+    void ChunkFile::readMapped()
     {
-        XOR_CHUNKFILE_OP("\nWriting ChunkFile(\"%s\")\n", m_path.cStr());
-        mainChunk().write();
+        XOR_CHUNKFILE_OP("\nMapping ChunkFile(\"%s\")\n", m_path.cStr());
+        close();
+        m_mapping = File(m_path, File::Mode::ReadMapped);
+        XOR_THROW(!!m_mapping, SerializationException, "Failed to map file");
 
-        ChunkFileHeader header;
-        header.fourCC    = ChunkFileFourCC;
-        header.mainChunk = mainChunk().m_block;
+        readHeader();
+    }
 
-        makeWriter(m_contents).writeStruct(header);
+    void ChunkFile::close()
+    {
+        m_mainChunk.reset();
+        m_mapping.close();
+        m_contents  = DynamicBuffer<uint8_t>();
+        m_version   = 0;
+        m_allocator = OffsetHeap();
+        m_fileSize  = 0;
+        m_updatable = false;
+        m_dictionary.reset();
+    }
 
-        File::ensureDirectoryExists(m_path);
-        File f(m_path, File::Mode::ReadWrite, File::Create::CreateAlways);
+    void ChunkFile::setDictionary(ZstdDictionary dictionary)
+    {
+        XOR_THROW(!this->dictionary(), SerializationException, "ChunkFile already has a dictionary");
+
+        auto writer = mainChunk().setChunk(DictionaryChunkName).writer(dictionary.bytes().size());
+        writer.writeBytes(dictionary.bytes());
+        m_dictionary.reset(new ZstdDictionary(std::move(dictionary)));
+    }
+
+    const ZstdDictionary *ChunkFile::dictionary() const
+    {
+        if (!m_dictionary && m_mainChunk)
+        {
+            if (auto chunk = m_mainChunk->maybeChunk(DictionaryChunkName))
+                m_dictionary.reset(new ZstdDictionary(chunk->data()));
+        }
+
+        return m_dictionary.get();
+    }
+
+    void ChunkFile::write()
+    {
+        XOR_THROW(!mapped(), SerializationException, "Cannot write a mapped ChunkFile");
+
+        if (m_updatable)
+            update();
+        else
+            rewrite();
+    }
+
+    void ChunkFile::rewrite()
+    {
+        XOR_THROW(!mapped(), SerializationException, "Cannot write a mapped ChunkFile");
+
+        compressChunks();
+
+        // Chunks that have not been modified still refer to m_contents,
+        // which stays valid even though the file itself is overwritten.
+        ChunkFileWriter writer(m_path);
+        writer.finish(mainChunk().write(writer));
+
+        // The new file has no unused space.
+        m_fileSize  = writer.bytesWritten();
+        m_allocator = OffsetHeap(static_cast<size_t>(m_fileSize));
+        m_allocator.markAsAllocated(Block(0, m_fileSize));
+        m_updatable = true;
+    }
+
+    void ChunkFile::update()
+    {
+        XOR_CHUNKFILE_OP("\nUpdating ChunkFile(\"%s\")\n", m_path.cStr());
+
+        compressChunks();
+
+        File f(m_path, File::Mode::ReadWrite);
         XOR_THROW(!!f, SerializationException, "Failed to open file");
-        f.write(m_contents);
+
+        auto &main     = mainChunk();
+        Block previous = main.m_fileBlock;
+        main.update(f);
+
+        // The header only needs to be written if the main chunk moved.
+        if (main.m_fileBlock.begin != previous.begin || main.m_fileBlock.end != previous.end)
+            writeChunkFileHeader(f, main.m_fileBlock);
+    }
+
+    void ChunkFile::compressChunks()
+    {
+        // Compress all changed chunks up front, so it can be done in parallel.
+        std::vector<Chunk *> chunks;
+        mainChunk().findChunksToCompress(chunks);
+
+        // Load the dictionary before it is needed by multiple threads.
+        dictionary();
+
+        parallelFor(chunks.size(), [&] (size_t i)
+        {
+            chunks[i]->compress();
+        });
+    }
+
+    Block ChunkFile::allocateFileBlock(Block previous, size_t bytes)
+    {
+        if (previous && previous.size() == bytes)
+            return previous;
+
+        if (previous)
+            m_allocator.release(previous);
+
+        Block block = m_allocator.allocate(bytes);
+        if (!block)
+        {
+            // There is no hole big enough, so append to the end of the file.
+            m_fileSize += static_cast<int64_t>(bytes);
+            m_allocator.resize(static_cast<size_t>(m_fileSize));
+            block = m_allocator.allocate(bytes);
+            XOR_CHECK(block.valid(), "Failed to allocate space at the end of the file");
+        }
+
+        return block;
     }
 
     void ChunkFile::printDescription()
@@ -197,50 +489,231 @@ namespace Xor
         : m_file(&file)
     {}
 
-    ChunkFile::Chunk::Chunk(ChunkFile & file, serialization::FileBlock block)
+    ChunkFile::Chunk::Chunk(ChunkFile & file, Block block)
         : m_file(&file)
         , m_block(block)
+        , m_fileBlock(block)
+        , m_parsed(false)
+        , m_inMemory(false)
+        , m_dataDirty(false)
+        , m_directoryDirty(false)
     {}
 
-    Reader ChunkFile::Chunk::reader() const { return Reader(m_file->span(m_dataBlock)); }
+    Span<const uint8_t> ChunkFile::Chunk::data() const
+    {
+        if (m_inMemory)
+            return m_data;
+
+        auto stored = storedData();
+        if (stored.codec == Codec::None)
+            return stored.bytes;
+
+        XOR_CHUNKFILE_OP("Decompressing chunk data: %zu -> %llu bytes\n",
+                         stored.bytes.sizeBytes(), static_cast<llu>(stored.uncompressedSize));
+        m_data     = decompressData(stored, m_file->dictionary());
+        m_inMemory = true;
+        return m_data;
+    }
 
-    void ChunkFile::Chunk::write()
+    ChunkFile::StoredData ChunkFile::Chunk::storedData() const
     {
-        DynamicBuffer<uint8_t> buffer;
-        auto writer = makeWriter(buffer, 1024);
-        XOR_CHUNKFILE_OP("Writing subchunk count: %zu\n", m_chunks.size());
-        writer.writeLength(static_cast<uint>(m_chunks.size()));
-        XOR_CHUNKFILE_OP("Writing chunk data size: %zu\n", m_data.sizeBytes());
-        writer.writeLength(static_cast<uint>(m_data.sizeBytes()));
+        parse();
+
+        StoredData stored;
+        stored.codec            = m_codec;
+        stored.uncompressedSize = m_uncompressedSize;
+        stored.checksum         = m_checksum;
+
+        // Chunks whose data has not been changed are stored
+        // as they were in the file they were read from.
+        if (m_dataBlock)
+        {
+            const ChunkFile &file = *m_file;
+            stored.bytes = file.span(m_dataBlock);
+        }
+        else if (m_codec == Codec::None)
+        {
+            stored.bytes = m_data;
+        }
+        else
+        {
+            XOR_ASSERT(!m_compressed.empty(), "Chunk has not been compressed");
+            stored.bytes = m_compressed;
+        }
+
+        if (m_codec == Codec::None)
+            stored.uncompressedSize = stored.bytes.sizeBytes();
+
+        return stored;
+    }
+
+    void ChunkFile::Chunk::markDataChanged()
+    {
+        parse();
+        m_inMemory   = true;
+        m_dataDirty  = true;
+        m_dataBlock  = Block();
+        m_compressed = DynamicBuffer<uint8_t>();
+    }
+
+    void ChunkFile::Chunk::setCodec(Codec codec)
+    {
+        if (codec == m_codec)
+            return;
+
+        // The data will be stored differently, so it has to be in memory.
+        auto bytes = data();
+        if (bytes.data() != m_data.data())
+            m_data = DynamicBuffer<uint8_t>(bytes);
+
+        markDataChanged();
+        m_codec = codec;
+    }
+
+    bool ChunkFile::Chunk::needsCompression() const
+    {
+        return m_codec != Codec::None && !m_dataBlock && m_compressed.empty();
+    }
+
+    void ChunkFile::Chunk::compress()
+    {
+        XOR_CHUNKFILE_OP("Compressing chunk data: %zu bytes\n", m_data.size());
+        auto stored        = compressData(m_codec, m_data, m_compressed, m_file->dictionary());
+        m_uncompressedSize = stored.uncompressedSize;
+        m_checksum         = stored.checksum;
+    }
+
+    void ChunkFile::Chunk::findChunksToCompress(std::vector<Chunk *> &chunks)
+    {
+        // Chunks that have not been parsed cannot have been changed.
+        if (!m_parsed)
+            return;
+
+        if (needsCompression())
+            chunks.emplace_back(this);
+
+        for (auto &&kv : m_chunks)
+            kv.second->findChunksToCompress(chunks);
+    }
+
+    void ChunkFile::Chunk::findChunksToDecompress(std::vector<const Chunk *> &chunks) const
+    {
+        parse();
+
+        if (!m_inMemory && m_codec != Codec::None)
+            chunks.emplace_back(this);
 
+        for (auto &&kv : m_chunks)
+            kv.second->findChunksToDecompress(chunks);
+    }
+
+    Reader ChunkFile::Chunk::reader() const
+    {
+        return Reader(data());
+    }
+
+    Block ChunkFile::Chunk::write(ChunkFileWriter &writer)
+    {
+        parse();
+
+        std::vector<std::pair<String, Block>> subchunks;
+        subchunks.reserve(m_chunks.size());
+        for (auto &&kv : m_chunks)
+            subchunks.emplace_back(kv.first, kv.second->write(writer));
+
+        Block block = writer.writeChunk(subchunks, storedData());
+        markClean(block);
+        return block;
+    }
+
+    void ChunkFile::Chunk::markClean(Block fileBlock)
+    {
+        m_fileBlock      = fileBlock;
+        m_dataDirty      = false;
+        m_directoryDirty = false;
+    }
+
+    void ChunkFile::Chunk::markAllocated(OffsetHeap &allocator) const
+    {
+        parse();
+        XOR_THROW(allocator.markAsAllocated(m_fileBlock), SerializationException, "Chunks overlap");
+        for (auto &&kv : m_chunks)
+            kv.second->markAllocated(allocator);
+    }
+
+    void ChunkFile::Chunk::releaseFileBlocks(OffsetHeap &allocator) const
+    {
+        // Chunks that have never been written have no blocks.
+        if (!m_fileBlock)
+            return;
+
+        parse();
+        allocator.release(m_fileBlock);
+        for (auto &&kv : m_chunks)
+            kv.second->releaseFileBlocks(allocator);
+    }
+
+    bool ChunkFile::Chunk::update(File &file)
+    {
+        // Chunks that have not been parsed cannot have been changed.
+        if (!m_parsed)
+            return false;
+
+        bool directoryChanged = m_directoryDirty;
         for (auto &&kv : m_chunks)
         {
-            kv.second->write();
+            if (kv.second->update(file))
+                directoryChanged = true;
+        }
 
-            XOR_CHUNKFILE_OP("Writing subchunk name: %s\n", kv.first.cStr());
-            writer.writeString(kv.first);
-            XOR_CHUNKFILE_OP("Writing subchunk block: (%lld, %lld)\n",
-                             static_cast<lld>(kv.second->m_block.begin),
-                             static_cast<lld>(kv.second->m_block.end));
-            writer.write(FileBlock(kv.second->m_block));
+        if (!m_dataDirty && !directoryChanged)
+            return false;
+
+        std::vector<std::pair<String, Block>> subchunks;
+        subchunks.reserve(m_chunks.size());
+        for (auto &&kv : m_chunks)
+            subchunks.emplace_back(kv.first, kv.second->m_fileBlock);
+
+        auto stored = storedData();
+        auto bytes  = stored.bytes;
+        DynamicBuffer<uint8_t> directory;
+        size_t directoryBytes = writeChunkDirectory(directory, subchunks, stored);
+        size_t totalBytes     = directoryBytes + bytes.sizeBytes();
+
+        Block previous = m_fileBlock;
+        if (!m_dataDirty && previous && previous.size() == totalBytes)
+        {
+            // Only the subchunk blocks changed, so just patch the directory.
+            XOR_CHUNKFILE_OP("Patching chunk directory: %zu bytes at %lld\n",
+                             directoryBytes, static_cast<lld>(previous.begin));
+            file.seek(previous.begin);
+            XOR_THROW_HR(file.write(makeSpan(directory.data(), directoryBytes)), SerializationException);
+            markClean(previous);
+            return false;
         }
 
-        auto totalBytes = buffer.sizeBytes() + m_data.sizeBytes();
-        m_file->obtainBlock(m_block, totalBytes);
-        m_dataBlock.begin = m_block.end - static_cast<int64_t>(m_data.sizeBytes());
-        m_dataBlock.end   = m_block.end;
+        Block block = m_file->allocateFileBlock(previous, totalBytes);
+        XOR_CHUNKFILE_OP("Writing chunk: %zu bytes at %lld\n",
+                         totalBytes, static_cast<lld>(block.begin));
+        file.seek(block.begin);
+        XOR_THROW_HR(file.write(makeSpan(directory.data(), directoryBytes)), SerializationException);
+        XOR_THROW_HR(file.write(bytes), SerializationException);
+        markClean(block);
 
-        auto dst = m_file->span(m_block);
-        XOR_CHUNKFILE_OP("Writing chunk header: %zu bytes\n", buffer.sizeBytes());
-        memcpy(dst.data(), buffer.data(), buffer.sizeBytes());
-        XOR_CHUNKFILE_OP("Writing chunk data: %zu bytes\n", m_data.sizeBytes());
-        memcpy(dst.data() + buffer.sizeBytes(), m_data.data(), m_data.sizeBytes());
+        return block.begin != previous.begin || block.end != previous.end;
     }
 
     void ChunkFile::Chunk::printDescription(uint depth)
     {
+        parse();
         String prefix = StringView("    ").repeat(depth);
-        print("%sDATA: %zu bytes\n", prefix.cStr(), m_dataBlock.size());
+        auto stored = storedData();
+        if (stored.codec == Codec::None)
+            print("%sDATA: %zu bytes\n", prefix.cStr(), stored.bytes.size());
+        else
+            print("%sDATA: %llu bytes, stored in %zu bytes (%s)\n", prefix.cStr(),
+                  static_cast<llu>(stored.uncompressedSize), stored.bytes.size(),
+                  codecName(stored.codec));
         for (auto &&c : m_chunks)
         {
             print("%s\"%s\":\n", prefix.cStr(), c.first.cStr());
@@ -250,25 +723,169 @@ namespace Xor
 
     void ChunkFile::Chunk::read()
     {
-        auto reader  = Reader(m_file->span(m_block));
+        std::vector<const Chunk *> chunks;
+        findChunksToDecompress(chunks);
+
+        // Load the dictionary before it is needed by multiple threads.
+        m_file->dictionary();
+
+        parallelFor(chunks.size(), [&] (size_t i)
+        {
+            chunks[i]->data();
+        });
+    }
+
+    void ChunkFile::Chunk::parse() const
+    {
+        if (m_parsed)
+            return;
+        m_parsed = true;
+
+        const ChunkFile &file = *m_file;
+        bool v1       = file.m_version == ChunkFileHeaderV1::VersionNumber;
+        bool hasCodec = file.m_version >= ChunkFileHeader::VersionNumber;
+        auto reader   = Reader(file.span(m_block));
         uint numChunks = reader.readLength();
         XOR_CHUNKFILE_OP("Reading subchunk count: %u\n", numChunks);
-        uint dataBytes = reader.readLength();
-        XOR_CHUNKFILE_OP("Reading chunk data size: %u\n", dataBytes);
+        uint64_t dataBytes = v1 ? reader.readLength() : reader.read<uint64_t>();
+        XOR_CHUNKFILE_OP("Reading chunk data size: %llu\n", static_cast<llu>(dataBytes));
+        XOR_THROW(dataBytes <= m_block.size(), SerializationException, "Chunk data is out of bounds");
+
+        if (hasCodec)
+        {
+            m_codec = reader.read<Codec>();
+            XOR_CHUNKFILE_OP("Reading chunk codec: %s\n", codecName(m_codec));
+            if (m_codec != Codec::None)
+            {
+                m_uncompressedSize = reader.read<uint64_t>();
+                m_checksum         = reader.read<uint64_t>();
+            }
+        }
 
-        m_dataBlock.begin = m_block.end - dataBytes;
+        m_dataBlock.begin = m_block.end - static_cast<int64_t>(dataBytes);
         m_dataBlock.end   = m_block.end;
 
         for (uint i = 0; i < numChunks; ++i)
         {
             auto key  = reader.readString();
             XOR_CHUNKFILE_OP("Reading subchunk name: %s\n", key.str().cStr());
-            auto block  = reader.read<FileBlock>();
-            XOR_CHUNKFILE_OP("Reading subchunk block: (%d, %d)\n", block.begin, block.end);
+            Block block = v1 ? reader.read<FileBlock>().block() : reader.read<FileBlock64>().block();
+            XOR_CHUNKFILE_OP("Reading subchunk block: (%lld, %lld)\n",
+                             static_cast<lld>(block.begin), static_cast<lld>(block.end));
             m_chunks[key].reset(new Chunk(*m_file, block));
-            m_chunks[key]->read();
         }
 
         XOR_CHUNKFILE_OP("Reading subchunk data: %zu\n", m_dataBlock.size());
     }
+
+    ChunkFileWriter::ChunkFileWriter(String path)
+        : m_path(std::move(path))
+    {
+        XOR_CHUNKFILE_OP("\nWriting ChunkFile(\"%s\")\n", m_path.cStr());
+        File::ensureDirectoryExists(m_path);
+        m_file = File(m_path, File::Mode::ReadWrite, File::Create::CreateAlways);
+        XOR_THROW(!!m_file, SerializationException, "Failed to open file");
+
+        // Leave room for the header, which is written last.
+        DynamicBuffer<uint8_t> header(serializedStructSize<ChunkFileHeader>(), 0);
+        XOR_THROW_HR(writeBytes(header), SerializationException);
+
+        m_openChunks.emplace_back();
+    }
+
+    HRESULT ChunkFileWriter::writeBytes(Span<const uint8_t> bytes)
+    {
+        m_offset += static_cast<int64_t>(bytes.sizeBytes());
+        return m_file.write(bytes);
+    }
+
+    void ChunkFileWriter::beginChunk(StringView name)
+    {
+        XOR_ASSERT(!m_openChunks.empty(), "ChunkFileWriter has already finished");
+        m_openChunks.emplace_back();
+        m_openChunks.back().name = name;
+    }
+
+    Writer<DynamicBuffer<uint8_t>> ChunkFileWriter::writer(size_t sizeEstimate)
+    {
+        XOR_ASSERT(!m_openChunks.empty(), "ChunkFileWriter has already finished");
+        return makeWriter(m_openChunks.back().data, sizeEstimate);
+    }
+
+    void ChunkFileWriter::setCodec(ChunkFile::Codec codec)
+    {
+        XOR_ASSERT(!m_openChunks.empty(), "ChunkFileWriter has already finished");
+        m_openChunks.back().codec = codec;
+    }
+
+    void ChunkFileWriter::setDictionary(ZstdDictionary dictionary)
+    {
+        XOR_ASSERT(!m_openChunks.empty(), "ChunkFileWriter has already finished");
+        XOR_THROW(!m_dictionary, SerializationException, "ChunkFileWriter already has a dictionary");
+
+        Block block = writeChunk({}, dictionary.bytes());
+        m_openChunks.front().subchunks.emplace_back(DictionaryChunkName, block);
+        m_dictionary = std::move(dictionary);
+    }
+
+    Block ChunkFileWriter::writeOpenChunk(const OpenChunk &chunk)
+    {
+        DynamicBuffer<uint8_t> compressed;
+        return writeChunk(chunk.subchunks,
+                          compressData(chunk.codec, chunk.data, compressed, m_dictionary ? &m_dictionary : nullptr));
+    }
+
+    void ChunkFileWriter::endChunk()
+    {
+        XOR_ASSERT(m_openChunks.size() > 1, "endChunk() without matching beginChunk()");
+
+        auto chunk = std::move(m_openChunks.back());
+        m_openChunks.pop_back();
+
+        Block block = writeOpenChunk(chunk);
+        m_openChunks.back().subchunks.emplace_back(std::move(chunk.name), block);
+    }
+
+    void ChunkFileWriter::finish()
+    {
+        XOR_ASSERT(m_openChunks.size() == 1, "All chunks must be ended before finishing");
+
+        auto chunk = std::move(m_openChunks.back());
+        m_openChunks.clear();
+
+        finish(writeOpenChunk(chunk));
+    }
+
+    Block ChunkFileWriter::writeChunk(Span<const std::pair<String, Block>> subchunks,
+                                      Span<const uint8_t> data)
+    {
+        ChunkFile::StoredData stored;
+        stored.bytes            = data;
+        stored.uncompressedSize = data.sizeBytes();
+        return writeChunk(subchunks, stored);
+    }
+
+    Block ChunkFileWriter::writeChunk(Span<const std::pair<String, Block>> subchunks,
+                                      const ChunkFile::StoredData &data)
+    {
+        DynamicBuffer<uint8_t> directory;
+        size_t directoryBytes = writeChunkDirectory(directory, subchunks, data);
+
+        Block block(m_offset,
+                    m_offset + static_cast<int64_t>(directoryBytes + data.bytes.sizeBytes()));
+
+        XOR_CHUNKFILE_OP("Writing chunk header: %zu bytes\n", directoryBytes);
+        XOR_THROW_HR(writeBytes(makeSpan(directory.data(), directoryBytes)), SerializationException);
+        XOR_CHUNKFILE_OP("Writing chunk data: %zu bytes\n", data.bytes.sizeBytes());
+        XOR_THROW_HR(writeBytes(data.bytes), SerializationException);
+
+        return block;
+    }
+
+    void ChunkFileWriter::finish(Block mainChunk)
+    {
+        writeChunkFileHeader(m_file, mainChunk);
+        m_file.close();
+        m_openChunks.clear();
+    }
 }
@@ -5,30 +5,86 @@
 #include "Core/String.hpp"
 #include "Core/File.hpp"
 #include "Core/Serialization.hpp"
+#include "Core/Compression.hpp"
 
 namespace Xor
 {
-    namespace serialization
-    {
-        struct FileBlock;
-    }
+    class ChunkFileWriter;
 
     class ChunkFile
     {
         friend class Chunk;
     public:
+        // Compression used for the data of a chunk. Compressed chunks
+        // are compressed when the file is written and decompressed on
+        // first access, so they are used just like uncompressed ones.
+        enum class Codec : uint8_t
+        {
+            None,
+            Zstd,
+            // Independent zstd frames that are also decompressed in
+            // parallel, which helps with very large chunks.
+            ZstdFrames,
+            // Zstd using the dictionary of the file, which helps with
+            // many small chunks of similar data.
+            ZstdDictionary,
+        };
+
+        // Data of a chunk in the form it is stored in the file.
+        struct StoredData
+        {
+            Span<const uint8_t> bytes;
+            Codec               codec            = Codec::None;
+            uint64_t            uncompressedSize = 0;
+            // Hash of the uncompressed data, for compressed chunks.
+            uint64_t            checksum         = 0;
+        };
+
         class Chunk
         {
             friend class ChunkFile;
 
-            ChunkFile *                              m_file = nullptr;
-            Block                                    m_block;
-            std::map<String, std::unique_ptr<Chunk>> m_chunks;
-            Block                                    m_dataBlock;
-            DynamicBuffer<uint8_t>                   m_data;
+            ChunkFile *                                      m_file = nullptr;
+            // Location of the chunk in the file it was read from, if any.
+            Block                                            m_block;
+            // Location of the chunk in the file on disk, which differs from
+            // m_block after the chunk has been moved by an update.
+            Block                                            m_fileBlock;
+            // The subchunk directory of chunks read from a file is parsed
+            // on first access, so untouched parts of the file are never read.
+            mutable std::map<String, std::unique_ptr<Chunk>> m_chunks;
+            mutable Block                                    m_dataBlock;
+            mutable bool                                     m_parsed = true;
+            // Chunks that have been created or written to keep their
+            // data in m_data instead of the file, and so do compressed
+            // chunks once they have been decompressed.
+            mutable bool                                     m_inMemory = true;
+            // Set when the data or the set of subchunks is changed,
+            // so that updates only need to write the changed chunks.
+            bool                                             m_dataDirty      = true;
+            bool                                             m_directoryDirty = true;
+            mutable DynamicBuffer<uint8_t>                   m_data;
+            mutable Codec                                    m_codec = Codec::None;
+            mutable uint64_t                                 m_uncompressedSize = 0;
+            mutable uint64_t                                 m_checksum         = 0;
+            // Compressed data of a changed chunk, ready to be written.
+            DynamicBuffer<uint8_t>                           m_compressed;
 
             Chunk(ChunkFile &file);
-            Chunk(ChunkFile &file, serialization::FileBlock block);
+            Chunk(ChunkFile &file, Block block);
+
+            void parse() const;
+            Span<const uint8_t> data() const;
+            StoredData storedData() const;
+            void markDataChanged();
+            bool needsCompression() const;
+            void compress();
+            void findChunksToCompress(std::vector<Chunk *> &chunks);
+            void findChunksToDecompress(std::vector<const Chunk *> &chunks) const;
+            void markAllocated(OffsetHeap &allocator) const;
+            void releaseFileBlocks(OffsetHeap &allocator) const;
+            void markClean(Block fileBlock);
+            bool update(File &file);
         public:
             Chunk() = default;
 
@@ -41,23 +97,48 @@ namespace Xor
             std::vector<std::pair<String, Chunk *>> allChunks();
             std::vector<std::pair<String, const Chunk *>> allChunks() const;
 
-            auto writer(size_t sizeEstimate = 0) { return makeWriter(m_data, sizeEstimate); }
+            // Replaces the data of the chunk.
+            auto writer(size_t sizeEstimate = 0)
+            {
+                markDataChanged();
+                return makeWriter(m_data, sizeEstimate);
+            }
             Reader reader() const;
 
+            Codec codec() const { return m_codec; }
+            // Store the data of the chunk compressed in the file.
+            void setCodec(Codec codec);
+
+            // Parse the whole subchunk tree, and decompress all compressed
+            // chunks in parallel. Chunks are parsed and decompressed lazily
+            // on first access, so calling this is never required.
             void read();
-            void write();
+            // Write the chunk and its subchunks, and return the block
+            // it was written in.
+            Block write(ChunkFileWriter &writer);
             void printDescription(uint depth = 0);
         };
 
     private:
         String                    m_path;
-        VirtualBuffer<uint8_t>    m_contents;
-        OffsetHeap                m_allocator;
+        DynamicBuffer<uint8_t>    m_contents;
+        // Used instead of m_contents for files opened with readMapped().
+        File                      m_mapping;
         std::unique_ptr<Chunk>    m_mainChunk;
+        uint                      m_version = 0;
+        // Manages the space of the file on disk, if the chunks are known
+        // to match it so that it can be updated in place.
+        OffsetHeap                m_allocator;
+        int64_t                   m_fileSize  = 0;
+        bool                      m_updatable = false;
+        mutable std::unique_ptr<ZstdDictionary> m_dictionary;
 
-        Span<uint8_t> span(Block block);
+        Span<const uint8_t> contents() const;
         Span<const uint8_t> span(Block block) const;
-        void obtainBlock(Block &block, size_t bytes);
+        void readHeader();
+        void compressChunks();
+        Block allocateFileBlock(Block previous, size_t bytes);
+        void update();
     public:
         ChunkFile() = default;
         ChunkFile(String path);
@@ -67,8 +148,90 @@ namespace Xor
         Chunk &mainChunk();
         const Chunk &mainChunk() const;
 
+        bool mapped() const { return !!m_mapping; }
+
+        // Dictionary used by chunks with the ZstdDictionary codec. It is
+        // stored in a dedicated subchunk of the main chunk, and a file can
+        // only have one, which has to be set before such chunks are written.
+        void setDictionary(ZstdDictionary dictionary);
+        // Returns nullptr if the file has no dictionary.
+        const ZstdDictionary *dictionary() const;
+        // Format version of the file that was read. Files are always
+        // written using the newest version.
+        uint version() const { return m_version; }
+
+        // Read the whole file into memory, and decompress all
+        // compressed chunks.
         void read();
+        // Map the file into memory read-only. Chunk readers point directly
+        // into the mapping, so only the touched parts of the file are ever
+        // loaded. The file cannot be written until it is closed.
+        void readMapped();
+        // Write all chunks into the file. Changed compressed chunks are
+        // compressed in parallel before writing. If the file has been read or
+        // written before, only the changed chunks are written into it
+        // in place, and the rest of the file is left untouched.
         void write();
+        // Rewrite the whole file from scratch, which removes any
+        // unused space left over by in place updates.
+        void rewrite();
+        // Release the mapping and all chunks.
+        void close();
         void printDescription();
     };
+
+    // Writes a ChunkFile into disk one chunk at a time, so that the
+    // whole file never has to be in memory. Every chunk is written to
+    // disk when it ends, which requires all of its subchunks to have
+    // ended already. Only the data of the chunks that have begun but not
+    // yet ended is kept in memory.
+    class ChunkFileWriter
+    {
+        struct OpenChunk
+        {
+            String                 name;
+            std::vector<std::pair<String, Block>> subchunks;
+            DynamicBuffer<uint8_t> data;
+            ChunkFile::Codec       codec = ChunkFile::Codec::None;
+        };
+
+        File                   m_file;
+        String                 m_path;
+        int64_t                m_offset = 0;
+        std::vector<OpenChunk> m_openChunks;
+        ZstdDictionary         m_dictionary;
+
+        HRESULT writeBytes(Span<const uint8_t> bytes);
+        Block writeOpenChunk(const OpenChunk &chunk);
+    public:
+        ChunkFileWriter() = default;
+        ChunkFileWriter(String path);
+
+        const String &path() const { return m_path; }
+        int64_t bytesWritten() const { return m_offset; }
+
+        // Begin a subchunk of the innermost open chunk. The main chunk
+        // is open from the start.
+        void beginChunk(StringView name);
+        // Replaces the data of the innermost open chunk.
+        Writer<DynamicBuffer<uint8_t>> writer(size_t sizeEstimate = 0);
+        // Compress the data of the innermost open chunk when it ends.
+        void setCodec(ChunkFile::Codec codec);
+        // Write the dictionary used by chunks with the ZstdDictionary
+        // codec. It must be set before any such chunk ends.
+        void setDictionary(ZstdDictionary dictionary);
+        // Write the innermost open chunk into disk.
+        void endChunk();
+        // End the main chunk and complete the file.
+        void finish();
+
+        // Write a chunk whose subchunks have already been written,
+        // and return the block it was written in.
+        Block writeChunk(Span<const std::pair<String, Block>> subchunks,
+                         Span<const uint8_t> data);
+        Block writeChunk(Span<const std::pair<String, Block>> subchunks,
+                         const ChunkFile::StoredData &data);
+        // Complete the file using an already written main chunk.
+        void finish(Block mainChunk);
+    };
 }
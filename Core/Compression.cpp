@@ -3,25 +3,38 @@
 #include "Core/Utils.hpp"
 
 #include "external/zstd-1.0.0/lib/zstd.h"
+#include "external/zstd-1.0.0/lib/dictBuilder/zdict.h"
 
 #include <algorithm>
+#include <limits>
 
 namespace Xor
 {
     static const int DefaultCompressionLevel = 20;
 
-    size_t compressZstd(Span<uint8_t> compressed, Span<const uint8_t> src, int compressionLevel)
+    static int zstdCompressionLevel(int compressionLevel)
     {
         int maxLevel = ZSTD_maxCLevel();
 
         if (compressionLevel < 0)
             compressionLevel = DefaultCompressionLevel;
 
-        compressionLevel = std::min(compressionLevel, maxLevel);
+        return std::min(compressionLevel, maxLevel);
+    }
+
+    static size_t checkZstd(size_t retval, const char *operation)
+    {
+        if (ZSTD_isError(retval))
+            XOR_THROW(false, CompressionException, "ZSTD %s failed: %s", operation, ZSTD_getErrorName(retval));
+
+        return retval;
+    }
 
+    size_t compressZstd(Span<uint8_t> compressed, Span<const uint8_t> src, int compressionLevel)
+    {
         return ZSTD_compress(compressed.data(), compressed.size(),
                              src.data(), src.size(),
-                             compressionLevel);
+                             zstdCompressionLevel(compressionLevel));
     }
 
     DynamicBuffer<uint8_t> compressZstd(Span<const uint8_t> src, int compressionLevel)
@@ -46,6 +59,163 @@ namespace Xor
         return compressed;
     }
 
+    // Contexts are reused for all dictionary operations on the same thread.
+    static ZSTD_CCtx *threadCompressionContext()
+    {
+        struct Context
+        {
+            ZSTD_CCtx *cctx = ZSTD_createCCtx();
+            ~Context() { ZSTD_freeCCtx(cctx); }
+        };
+        static thread_local Context context;
+        return context.cctx;
+    }
+
+    static ZSTD_DCtx *threadDecompressionContext()
+    {
+        struct Context
+        {
+            ZSTD_DCtx *dctx = ZSTD_createDCtx();
+            ~Context() { ZSTD_freeDCtx(dctx); }
+        };
+        static thread_local Context context;
+        return context.dctx;
+    }
+
+    size_t compressZstd(Span<uint8_t> compressed, Span<const uint8_t> src, const ZSTD_CDict_s *dictionary)
+    {
+        return ZSTD_compress_usingCDict(threadCompressionContext(),
+                                        compressed.data(), compressed.size(),
+                                        src.data(), src.size(),
+                                        dictionary);
+    }
+
+    DynamicBuffer<uint8_t> compressZstd(Span<const uint8_t> src, const ZSTD_CDict_s *dictionary)
+    {
+        DynamicBuffer<uint8_t> compressed(ZSTD_compressBound(src.size()));
+        compressed.resize(checkZstd(compressZstd(compressed, src, dictionary), "compression"));
+        return compressed;
+    }
+
+    size_t decompressZstd(Span<uint8_t> decompressed, Span<const uint8_t> compressed, const ZSTD_DDict_s *dictionary)
+    {
+        return ZSTD_decompress_usingDDict(threadDecompressionContext(),
+                                          decompressed.data(), decompressed.size(),
+                                          compressed.data(), compressed.size(),
+                                          dictionary);
+    }
+
+    DynamicBuffer<uint8_t> decompressZstd(size_t decompressedSize, Span<const uint8_t> compressed, const ZSTD_DDict_s *dictionary)
+    {
+        DynamicBuffer<uint8_t> decompressed(decompressedSize);
+        size_t retval = checkZstd(decompressZstd(decompressed, compressed, dictionary), "decompression");
+        XOR_THROW(retval == decompressedSize, CompressionException, "ZSTD decompressed size differs from expected");
+        return decompressed;
+    }
+
+    ZstdDictionary::ZstdDictionary(Span<const uint8_t> bytes, int compressionLevel)
+        : m_bytes(bytes)
+        , m_cdict(ZSTD_createCDict(bytes.data(), bytes.size(), zstdCompressionLevel(compressionLevel)))
+        , m_ddict(ZSTD_createDDict(bytes.data(), bytes.size()))
+        , m_id(ZDICT_getDictID(bytes.data(), bytes.size()))
+        , m_compressionLevel(zstdCompressionLevel(compressionLevel))
+    {
+        XOR_THROW(m_cdict && m_ddict, CompressionException, "Failed to create ZSTD dictionary");
+    }
+
+    ZstdDictionary::~ZstdDictionary()
+    {
+        release();
+    }
+
+    ZstdDictionary &ZstdDictionary::operator=(ZstdDictionary &&d)
+    {
+        if (this != &d)
+        {
+            release();
+            m_bytes = std::move(d.m_bytes);
+            m_cdict = std::move(d.m_cdict);
+            m_ddict = std::move(d.m_ddict);
+            m_id    = d.m_id;
+            m_compressionLevel = d.m_compressionLevel;
+        }
+        return *this;
+    }
+
+    void ZstdDictionary::release()
+    {
+        if (m_cdict)
+        {
+            ZSTD_freeCDict(m_cdict);
+            m_cdict = nullptr;
+        }
+
+        if (m_ddict)
+        {
+            ZSTD_freeDDict(m_ddict);
+            m_ddict = nullptr;
+        }
+    }
+
+    ZstdDictionary ZstdDictionary::train(Span<const Span<const uint8_t>> samples,
+                                         size_t maxSize,
+                                         int compressionLevel)
+    {
+        // The trainer wants all samples back to back.
+        DynamicBuffer<uint8_t> sampleBytes;
+        std::vector<size_t> sampleSizes;
+        sampleSizes.reserve(samples.size());
+
+        auto writer = makeWriter(sampleBytes);
+        for (auto &s : samples)
+        {
+            writer.writeBytes(s);
+            sampleSizes.emplace_back(s.size());
+        }
+
+        Timer trainingTime;
+
+        DynamicBuffer<uint8_t> dictionary(maxSize);
+        size_t size = ZDICT_trainFromBuffer(dictionary.data(), dictionary.size(),
+                                            sampleBytes.data(), sampleSizes.data(),
+                                            static_cast<unsigned>(sampleSizes.size()));
+        XOR_THROW(!ZDICT_isError(size), CompressionException,
+                  "ZSTD dictionary training failed: %s", ZDICT_getErrorName(size));
+        dictionary.resize(size);
+
+        log("Compression", "    Zstd dictionary training: %.2f ms (%zu samples, %zu bytes -> %zu byte dictionary)\n",
+            trainingTime.milliseconds(),
+            samples.size(),
+            writer.bytesWritten(),
+            size);
+
+        return ZstdDictionary(dictionary, compressionLevel);
+    }
+
+    bool ZstdDictionary::improvesCompression(Span<const Span<const uint8_t>> samples) const
+    {
+        auto cctx = threadCompressionContext();
+        DynamicBuffer<uint8_t> compressed;
+
+        size_t withDictionary    = m_bytes.size();
+        size_t withoutDictionary = 0;
+        for (auto &s : samples)
+        {
+            compressed.resize(ZSTD_compressBound(s.size()));
+            withDictionary += checkZstd(compressZstd(compressed, s, m_cdict), "compression");
+            withoutDictionary += checkZstd(ZSTD_compressCCtx(cctx,
+                                                             compressed.data(), compressed.size(),
+                                                             s.data(), s.size(),
+                                                             m_compressionLevel),
+                                           "compression");
+        }
+
+        log("Compression", "    Zstd dictionary: %zu samples compress to %zu bytes with dictionary, %zu bytes without\n",
+            samples.size(), withDictionary, withoutDictionary);
+
+        return withDictionary < withoutDictionary;
+    }
+
     size_t decompressZstd(Span<uint8_t> decompressed, Span<const uint8_t> compressed)
     {
         return ZSTD_decompress(decompressed.data(), decompressed.size(),
@@ -64,4 +234,418 @@ namespace Xor
 
         return decompressed;
     }
+
+    // Data compressed with compressParallel() contains:
+    //   - ZstdFramesHeader (struct)
+    //   - for each frame, the offset where it ends (uint64_t),
+    //     relative to the beginning of the first frame
+    //   - frames
+    // Every frame decompresses into frameSize bytes, except the last one.
+    struct ZstdFramesHeader
+    {
+        static const uint VersionNumber = 1;
+        uint32_t frameSize = 0;
+        uint32_t padding   = 0;
+        uint64_t size      = 0;
+    };
+
+    class ZstdFrameIndex
+    {
+        ZstdFramesHeader    m_header;
+        Span<const uint8_t> m_ends;
+        Span<const uint8_t> m_frames;
+    public:
+        ZstdFrameIndex(Span<const uint8_t> compressed)
+        {
+            Reader reader(compressed);
+            m_header = reader.readStruct<ZstdFramesHeader>();
+            XOR_THROW(m_header.frameSize > 0 || m_header.size == 0, CompressionException, "Invalid ZSTD frame size");
+            m_ends   = reader.readBytes(frameCount() * sizeof(uint64_t));
+            m_frames = reader.readBytes(reader.bytesLeft());
+        }
+
+        uint64_t size() const { return m_header.size; }
+        uint64_t frameSize() const { return m_header.frameSize; }
+
+        size_t frameCount() const
+        {
+            if (m_header.size == 0)
+                return 0;
+            else
+                return static_cast<size_t>((m_header.size - 1) / m_header.frameSize + 1);
+        }
+
+        uint64_t frameBegin(size_t i) const
+        {
+            return i * frameSize();
+        }
+
+        size_t frameBytes(size_t i) const
+        {
+            return static_cast<size_t>(std::min(frameSize(), size() - frameBegin(i)));
+        }
+
+        Span<const uint8_t> frame(size_t i) const
+        {
+            uint64_t begin = i > 0 ? frameEnd(i - 1) : 0;
+            uint64_t end   = frameEnd(i);
+            XOR_THROW(begin <= end && end <= m_frames.size(), CompressionException, "ZSTD frame is out of bounds");
+            return Span<const uint8_t>(m_frames.data() + begin, static_cast<size_t>(end - begin));
+        }
+
+    private:
+        uint64_t frameEnd(size_t i) const
+        {
+            uint64_t end;
+            memcpy(&end, m_ends.data() + i * sizeof(uint64_t), sizeof(end));
+            return end;
+        }
+    };
+
+    DynamicBuffer<uint8_t> compressParallel(Span<const uint8_t> src,
+                                            int compressionLevel,
+                                            size_t frameSize,
+                                            ThreadPool &pool)
+    {
+        XOR_THROW(frameSize > 0 && frameSize <= std::numeric_limits<uint32_t>::max(),
+                  CompressionException, "Invalid ZSTD frame size %zu", frameSize);
+
+        ZstdFramesHeader header;
+        header.frameSize = static_cast<uint32_t>(frameSize);
+        header.size      = src.sizeBytes();
+
+        Timer compressionTime;
+
+        size_t frameCount = (src.size() + frameSize - 1) / frameSize;
+        std::vector<DynamicBuffer<uint8_t>> frames(frameCount);
+        pool.parallelFor(frameCount, [&] (size_t i)
+        {
+            size_t begin = i * frameSize;
+            auto bytes   = Span<const uint8_t>(src.data() + begin, std::min(frameSize, src.size() - begin));
+            auto &frame  = frames[i];
+            frame.resize(ZSTD_compressBound(bytes.size()));
+            frame.resize(checkZstd(compressZstd(frame, bytes, compressionLevel), "compression"));
+        });
+
+        DynamicBuffer<uint8_t> compressed;
+        auto writer = makeWriter(compressed);
+        writer.writeStruct(header);
+
+        uint64_t end = 0;
+        for (auto &f : frames)
+        {
+            end += f.size();
+            writer.write(end);
+        }
+
+        for (auto &f : frames)
+            writer.writeBytes(f);
+
+        log("Compression", "    Zstd parallel compression: %.2f ms (%zu -> %zu, %zu frames, compression ratio: %.2f)\n",
+            compressionTime.milliseconds(),
+            src.sizeBytes(),
+            compressed.sizeBytes(),
+            frameCount,
+            static_cast<double>(src.sizeBytes()) / static_cast<double>(compressed.sizeBytes()));
+
+        return compressed;
+    }
+
+    uint64_t decompressedSizeParallel(Span<const uint8_t> compressed)
+    {
+        return ZstdFrameIndex(compressed).size();
+    }
+
+    DynamicBuffer<uint8_t> decompressParallel(Span<const uint8_t> compressed, ThreadPool &pool)
+    {
+        DynamicBuffer<uint8_t> decompressed(static_cast<size_t>(decompressedSizeParallel(compressed)));
+        decompressParallel(decompressed, compressed, 0, pool);
+        return decompressed;
+    }
+
+    void decompressParallel(Span<uint8_t> dst,
+                            Span<const uint8_t> compressed,
+                            uint64_t offset,
+                            ThreadPool &pool)
+    {
+        ZstdFrameIndex index(compressed);
+        XOR_THROW(offset + dst.size() <= index.size(), CompressionException, "Decompressed range is out of bounds");
+
+        if (dst.empty())
+            return;
+
+        uint64_t rangeEnd = offset + dst.size();
+        size_t firstFrame = static_cast<size_t>(offset / index.frameSize());
+        size_t lastFrame  = static_cast<size_t>((rangeEnd - 1) / index.frameSize());
+
+        pool.parallelFor(lastFrame - firstFrame + 1, [&] (size_t f)
+        {
+            size_t i          = firstFrame + f;
+            uint64_t begin    = index.frameBegin(i);
+            size_t bytes      = index.frameBytes(i);
+            uint64_t copyFrom = std::max(offset, begin);
+            uint64_t copyTo   = std::min(rangeEnd, begin + bytes);
+            uint8_t *out      = dst.data() + (copyFrom - offset);
+
+            // Frames that are only partially in the range need a temporary buffer.
+            DynamicBuffer<uint8_t> partial;
+            Span<uint8_t> decompressed(out, bytes);
+            if (copyTo - copyFrom != bytes)
+            {
+                partial.resize(bytes);
+                decompressed = partial;
+            }
+
+            size_t retval = checkZstd(decompressZstd(decompressed, index.frame(i)), "decompression");
+            XOR_THROW(retval == bytes, CompressionException, "ZSTD frame has the wrong size");
+
+            if (!partial.empty())
+                memcpy(out, partial.data() + (copyFrom - begin), static_cast<size_t>(copyTo - copyFrom));
+        });
+    }
+
+    ByteSink fileSink(File &file)
+    {
+        return [&file] (Span<const uint8_t> bytes)
+        {
+            XOR_THROW_HR(file.write(bytes), CompressionException);
+        };
+    }
+
+    ByteSource fileSource(File &file)
+    {
+        return [&file] (Span<uint8_t> window)
+        {
+            size_t bytesRead = 0;
+            XOR_THROW_HR(file.read(window.data(), window.sizeBytes(), &bytesRead), CompressionException);
+            return bytesRead;
+        };
+    }
+
+    ByteSource readerSource(Reader &reader)
+    {
+        return [&reader] (Span<uint8_t> window)
+        {
+            auto bytes = reader.readBytes(std::min(window.size(), reader.bytesLeft()));
+            memcpy(window.data(), bytes.data(), bytes.size());
+            return bytes.size();
+        };
+    }
+
+    ZstdCompressStream::ZstdCompressStream(ByteSink sink, int compressionLevel)
+        : m_stream(ZSTD_createCStream())
+        , m_sink(std::move(sink))
+        , m_window(ZSTD_CStreamOutSize())
+    {
+        XOR_THROW(!!m_stream, CompressionException, "Failed to create ZSTD compression stream");
+        checkZstd(ZSTD_initCStream(m_stream, zstdCompressionLevel(compressionLevel)), "compression");
+    }
+
+    ZstdCompressStream::~ZstdCompressStream()
+    {
+        release();
+    }
+
+    ZstdCompressStream &ZstdCompressStream::operator=(ZstdCompressStream &&s)
+    {
+        if (this != &s)
+        {
+            release();
+            m_stream     = std::move(s.m_stream);
+            m_sink       = std::move(s.m_sink);
+            m_window     = std::move(s.m_window);
+            m_windowUsed = s.m_windowUsed;
+            m_bytesIn    = s.m_bytesIn;
+            m_bytesOut   = s.m_bytesOut;
+            m_finished   = s.m_finished;
+        }
+        return *this;
+    }
+
+    void ZstdCompressStream::release()
+    {
+        if (m_stream)
+        {
+            ZSTD_freeCStream(m_stream);
+            m_stream = nullptr;
+        }
+    }
+
+    void ZstdCompressStream::drain()
+    {
+        if (m_windowUsed == 0)
+            return;
+
+        m_sink(Span<const uint8_t>(m_window.data(), m_windowUsed));
+        m_bytesOut  += m_windowUsed;
+        m_windowUsed = 0;
+    }
+
+    void ZstdCompressStream::write(Span<const uint8_t> bytes)
+    {
+        XOR_ASSERT(m_stream && !m_finished, "Stream is not open for writing");
+
+        ZSTD_inBuffer  in  { bytes.data(), bytes.sizeBytes(), 0 };
+        ZSTD_outBuffer out { m_window.data(), m_window.size(), m_windowUsed };
+
+        while (in.pos < in.size)
+        {
+            checkZstd(ZSTD_compressStream(m_stream, &out, &in), "compression");
+            m_windowUsed = out.pos;
+
+            if (out.pos == out.size)
+            {
+                drain();
+                out.pos = 0;
+            }
+        }
+
+        m_bytesIn += bytes.sizeBytes();
+    }
+
+    void ZstdCompressStream::write(const ByteSource &source)
+    {
+        DynamicBuffer<uint8_t> input(ZSTD_CStreamInSize());
+
+        for (;;)
+        {
+            size_t bytes = source(input);
+            if (bytes == 0)
+                break;
+
+            write(Span<const uint8_t>(input.data(), bytes));
+        }
+    }
+
+    void ZstdCompressStream::flush()
+    {
+        XOR_ASSERT(m_stream && !m_finished, "Stream is not open for writing");
+
+        for (;;)
+        {
+            ZSTD_outBuffer out { m_window.data(), m_window.size(), m_windowUsed };
+            size_t left  = checkZstd(ZSTD_flushStream(m_stream, &out), "compression");
+            m_windowUsed = out.pos;
+            drain();
+
+            if (left == 0)
+                break;
+        }
+    }
+
+    void ZstdCompressStream::finish()
+    {
+        XOR_ASSERT(m_stream && !m_finished, "Stream is not open for writing");
+
+        for (;;)
+        {
+            ZSTD_outBuffer out { m_window.data(), m_window.size(), m_windowUsed };
+            size_t left  = checkZstd(ZSTD_endStream(m_stream, &out), "compression");
+            m_windowUsed = out.pos;
+            drain();
+
+            if (left == 0)
+                break;
+        }
+
+        m_finished = true;
+    }
+
+    ZstdDecompressStream::ZstdDecompressStream(ByteSource source)
+        : m_stream(ZSTD_createDStream())
+        , m_source(std::move(source))
+        , m_window(ZSTD_DStreamInSize())
+    {
+        XOR_THROW(!!m_stream, CompressionException, "Failed to create ZSTD decompression stream");
+        checkZstd(ZSTD_initDStream(m_stream), "decompression");
+    }
+
+    ZstdDecompressStream::~ZstdDecompressStream()
+    {
+        release();
+    }
+
+    ZstdDecompressStream &ZstdDecompressStream::operator=(ZstdDecompressStream &&s)
+    {
+        if (this != &s)
+        {
+            release();
+            m_stream      = std::move(s.m_stream);
+            m_source      = std::move(s.m_source);
+            m_window      = std::move(s.m_window);
+            m_windowBegin = s.m_windowBegin;
+            m_windowEnd   = s.m_windowEnd;
+            m_bytesIn     = s.m_bytesIn;
+            m_bytesOut    = s.m_bytesOut;
+            m_finished    = s.m_finished;
+        }
+        return *this;
+    }
+
+    void ZstdDecompressStream::release()
+    {
+        if (m_stream)
+        {
+            ZSTD_freeDStream(m_stream);
+            m_stream = nullptr;
+        }
+    }
+
+    size_t ZstdDecompressStream::read(Span<uint8_t> dst)
+    {
+        XOR_ASSERT(!!m_stream, "Stream is not open for reading");
+
+        ZSTD_outBuffer out { dst.data(), dst.sizeBytes(), 0 };
+
+        while (out.pos < out.size && !m_finished)
+        {
+            // The stream may still have output buffered from earlier calls,
+            // so only read more input once it runs out of it.
+            ZSTD_inBuffer in { m_window.data(), m_windowEnd, m_windowBegin };
+            size_t hint   = checkZstd(ZSTD_decompressStream(m_stream, &out, &in), "decompression");
+            m_windowBegin = in.pos;
+
+            if (hint == 0)
+            {
+                m_finished = true;
+            }
+            else if (m_windowBegin == m_windowEnd && out.pos < out.size)
+            {
+                m_windowBegin = 0;
+                m_windowEnd   = m_source(m_window);
+                m_bytesIn    += m_windowEnd;
+                XOR_THROW(m_windowEnd > 0, CompressionException, "ZSTD stream ended in the middle of a frame");
+            }
+        }
+
+        m_bytesOut += out.pos;
+        return out.pos;
+    }
+
+    void ZstdDecompressStream::read(const ByteSink &sink)
+    {
+        DynamicBuffer<uint8_t> output(ZSTD_DStreamOutSize());
+
+        while (!m_finished)
+        {
+            size_t bytes = read(output);
+            if (bytes > 0)
+                sink(Span<const uint8_t>(output.data(), bytes));
+        }
+    }
+
+    uint64_t compressZstdStream(const ByteSink &dst, const ByteSource &src, int compressionLevel)
+    {
+        ZstdCompressStream stream(dst, compressionLevel);
+        stream.write(src);
+        stream.finish();
+        return stream.bytesOut();
+    }
+
+    uint64_t decompressZstdStream(const ByteSink &dst, const ByteSource &src)
+    {
+        ZstdDecompressStream stream(src);
+        stream.read(dst);
+        return stream.bytesOut();
+    }
 }
@@ -2,6 +2,16 @@
 
 #include "Core/Utils.hpp"
 #include "Core/Exception.hpp"
+#include "Core/File.hpp"
+#include "Core/Serialization.hpp"
+#include "Core/ThreadPool.hpp"
+
+#include <functional>
+
+struct ZSTD_CStream_s;
+struct ZSTD_DStream_s;
+struct ZSTD_CDict_s;
+struct ZSTD_DDict_s;
 
 namespace Xor
 {
@@ -12,5 +22,173 @@ namespace Xor
     DynamicBuffer<uint8_t> decompressZstd(size_t decompressedSize, Span<const uint8_t> compressed);
 
     XOR_EXCEPTION_TYPE(CompressionException)
-}
 
+    // Compress and decompress using a prepared dictionary, which has no
+    // per call setup cost.
+    size_t compressZstd(Span<uint8_t> compressed, Span<const uint8_t> src, const ZSTD_CDict_s *dictionary);
+    DynamicBuffer<uint8_t> compressZstd(Span<const uint8_t> src, const ZSTD_CDict_s *dictionary);
+
+    size_t decompressZstd(Span<uint8_t> decompressed, Span<const uint8_t> compressed, const ZSTD_DDict_s *dictionary);
+    DynamicBuffer<uint8_t> decompressZstd(size_t decompressedSize, Span<const uint8_t> compressed, const ZSTD_DDict_s *dictionary);
+
+    static const size_t ZstdDefaultDictionarySize = 64 * 1024;
+
+    // Dictionary for compressing many small buffers of similar data, which
+    // zstd compresses poorly on their own. It is prepared for both
+    // compression and decompression when created.
+    class ZstdDictionary
+    {
+        DynamicBuffer<uint8_t>    m_bytes;
+        MovingPtr<ZSTD_CDict_s *> m_cdict;
+        MovingPtr<ZSTD_DDict_s *> m_ddict;
+        uint                      m_id = 0;
+        int                       m_compressionLevel = 0;
+
+        void release();
+    public:
+        ZstdDictionary() = default;
+        ZstdDictionary(Span<const uint8_t> bytes, int compressionLevel = -1);
+        ~ZstdDictionary();
+
+        ZstdDictionary(ZstdDictionary &&) = default;
+        ZstdDictionary &operator=(ZstdDictionary &&d);
+
+        // Train a dictionary using samples of the data it will be used for.
+        // Training fails if there are too few samples.
+        static ZstdDictionary train(Span<const Span<const uint8_t>> samples,
+                                    size_t maxSize       = ZstdDefaultDictionarySize,
+                                    int compressionLevel = -1);
+
+        explicit operator bool() const { return !!m_cdict; }
+
+        // True if the samples compress smaller with the dictionary than
+        // without it, even when the size of the dictionary is included.
+        // Trained dictionaries do not help with every kind of data.
+        bool improvesCompression(Span<const Span<const uint8_t>> samples) const;
+
+        Span<const uint8_t> bytes() const { return m_bytes; }
+        uint id() const { return m_id; }
+
+        const ZSTD_CDict_s *cdict() const { return m_cdict; }
+        const ZSTD_DDict_s *ddict() const { return m_ddict; }
+    };
+
+    static const size_t ZstdDefaultFrameSize = 1024 * 1024;
+
+    // Compress the data in parallel as independent zstd frames of frameSize
+    // bytes each. The result begins with an index of the frames, so it can
+    // also be decompressed in parallel, and any range of it can be
+    // decompressed without decompressing the rest.
+    DynamicBuffer<uint8_t> compressParallel(Span<const uint8_t> src,
+                                            int compressionLevel = -1,
+                                            size_t frameSize     = ZstdDefaultFrameSize,
+                                            ThreadPool &pool     = ThreadPool::global());
+    // Decompressed size of data compressed with compressParallel().
+    uint64_t decompressedSizeParallel(Span<const uint8_t> compressed);
+    DynamicBuffer<uint8_t> decompressParallel(Span<const uint8_t> compressed,
+                                              ThreadPool &pool = ThreadPool::global());
+    // Decompress the bytes from offset to offset + dst.size(). Only the
+    // frames overlapping the range are decompressed.
+    void decompressParallel(Span<uint8_t> dst,
+                            Span<const uint8_t> compressed,
+                            uint64_t offset,
+                            ThreadPool &pool = ThreadPool::global());
+
+    // Receives the output of a stream one window at a time.
+    using ByteSink   = std::function<void(Span<const uint8_t>)>;
+    // Fills the given window with input for a stream, and returns the
+    // number of bytes filled. Returning 0 means that the input has ended.
+    using ByteSource = std::function<size_t(Span<uint8_t>)>;
+
+    ByteSink   fileSink(File &file);
+    ByteSource fileSource(File &file);
+    ByteSource readerSource(Reader &reader);
+
+    template <typename Buffer>
+    ByteSink writerSink(Writer<Buffer> &writer)
+    {
+        return [&writer] (Span<const uint8_t> bytes) { writer.writeBytes(bytes); };
+    }
+
+    // Compresses data of any size into a single zstd frame. Only one
+    // fixed size window of compressed data is kept in memory, and it is
+    // passed to the sink whenever it fills up.
+    class ZstdCompressStream
+    {
+        MovingPtr<ZSTD_CStream_s *> m_stream;
+        ByteSink                    m_sink;
+        DynamicBuffer<uint8_t>      m_window;
+        size_t                      m_windowUsed = 0;
+        uint64_t                    m_bytesIn    = 0;
+        uint64_t                    m_bytesOut   = 0;
+        bool                        m_finished   = false;
+
+        void drain();
+        void release();
+    public:
+        ZstdCompressStream() = default;
+        ZstdCompressStream(ByteSink sink, int compressionLevel = -1);
+        ~ZstdCompressStream();
+
+        ZstdCompressStream(ZstdCompressStream &&) = default;
+        ZstdCompressStream &operator=(ZstdCompressStream &&s);
+
+        explicit operator bool() const { return !!m_stream; }
+
+        uint64_t bytesIn() const { return m_bytesIn; }
+        uint64_t bytesOut() const { return m_bytesOut; }
+        bool finished() const { return m_finished; }
+
+        void write(Span<const uint8_t> bytes);
+        // Compress everything from the source until it ends.
+        void write(const ByteSource &source);
+        // Pass everything written so far to the sink.
+        void flush();
+        // End the frame and pass the rest of it to the sink. Nothing
+        // can be written after this.
+        void finish();
+    };
+
+    // Decompresses a single zstd frame of any size, without having to
+    // know its decompressed size in advance. Only one fixed size window
+    // of compressed data is kept in memory. The source may be read past
+    // the end of the frame.
+    class ZstdDecompressStream
+    {
+        MovingPtr<ZSTD_DStream_s *> m_stream;
+        ByteSource                  m_source;
+        DynamicBuffer<uint8_t>      m_window;
+        size_t                      m_windowBegin = 0;
+        size_t                      m_windowEnd   = 0;
+        uint64_t                    m_bytesIn     = 0;
+        uint64_t                    m_bytesOut    = 0;
+        bool                        m_finished    = false;
+
+        void release();
+    public:
+        ZstdDecompressStream() = default;
+        ZstdDecompressStream(ByteSource source);
+        ~ZstdDecompressStream();
+
+        ZstdDecompressStream(ZstdDecompressStream &&) = default;
+        ZstdDecompressStream &operator=(ZstdDecompressStream &&s);
+
+        explicit operator bool() const { return !!m_stream; }
+
+        uint64_t bytesIn() const { return m_bytesIn; }
+        uint64_t bytesOut() const { return m_bytesOut; }
+        // True when the whole frame has been decompressed.
+        bool finished() const { return m_finished; }
+
+        // Decompress into dst, and return the number of bytes decompressed.
+        // It is less than the size of dst only if the frame ended.
+        size_t read(Span<uint8_t> dst);
+        // Decompress the rest of the frame into the sink.
+        void read(const ByteSink &sink);
+    };
+
+    // Compress or decompress a whole stream using constant memory,
+    // and return the number of bytes passed to the sink.
+    uint64_t compressZstdStream(const ByteSink &dst, const ByteSource &src, int compressionLevel = -1);
+    uint64_t decompressZstdStream(const ByteSink &dst, const ByteSource &src);
+}
@@ -13,7 +13,12 @@
 #include "Core/Window.hpp"
 #include "Core/String.hpp"
 #include "Core/Allocators.hpp"
+#include "Core/SlotMap.hpp"
+#include "Core/AllocationTrace.hpp"
 #include "Core/Math.hpp"
 #include "Core/File.hpp"
 #include "Core/Serialization.hpp"
+#include "Core/ThreadPool.hpp"
+#include "Core/Sorting.hpp"
+#include "Core/MathBatch.hpp"
 
@@ -219,9 +219,32 @@ namespace Xor
             XOR_CHECK_LAST_ERROR(false);
     }
 
+    File &File::operator=(File &&f)
+    {
+        if (this != &f)
+        {
+            close();
+            m_file    = std::move(f.m_file);
+            m_mapping = std::move(f.m_mapping);
+            m_begin   = std::move(f.m_begin);
+            m_end     = f.m_end;
+            m_hr      = f.m_hr;
+            f.m_end   = nullptr;
+            f.m_hr    = E_NOT_SET;
+        }
+        return *this;
+    }
+
     void File::close()
     {
-        *this = File();
+        if (m_begin)
+            UnmapViewOfFile(m_begin.get());
+
+        m_begin = nullptr;
+        m_end   = nullptr;
+        m_mapping.close();
+        m_file.close();
+        m_hr    = E_NOT_SET;
     }
 
     HRESULT File::read(void *dst, size_t bytes, size_t *bytesRead)
@@ -14,7 +14,7 @@ namespace Xor
     {
         Handle         m_file;
         Handle         m_mapping;
-        const uint8_t *m_begin = nullptr;
+        MovingPtr<const uint8_t *> m_begin;
         const uint8_t *m_end   = nullptr;
         HRESULT        m_hr    = E_NOT_SET;
     public:
@@ -35,8 +35,10 @@ namespace Xor
         File() = default;
         File(const String &filename, Mode mode = Mode::ReadOnly, Create create = Create::DontCreate);
 
+        ~File() { close(); }
+
         File(File &&) = default;
-        File &operator=(File &&) = default;
+        File &operator=(File &&f);
         File(const File &) = delete;
         File &operator=(const File &) = delete;
 
@@ -0,0 +1,528 @@
+#pragma once
+
+#include "Core/Utils.hpp"
+#include "Core/Hash.hpp"
+#include "Core/MathInteger.hpp"
+
+#include <emmintrin.h>
+
+#include <memory>
+#include <iterator>
+#include <utility>
+#include <functional>
+#include <type_traits>
+
+namespace Xor
+{
+    namespace flat_hash_detail
+    {
+        // Every slot has a control byte. Full slots store the low 7 bits
+        // of the hash of their key, so that a group of 16 slots can be
+        // searched with a few SIMD instructions, and keys are only compared
+        // when those bits match.
+        static const int8_t Empty     = -128;
+        static const int8_t Deleted   = -2;
+        static const size_t GroupSize = 16;
+
+        struct Group
+        {
+            __m128i ctrl;
+
+            Group(const int8_t *ctrl)
+                : ctrl(_mm_load_si128(reinterpret_cast<const __m128i *>(ctrl)))
+            {}
+
+            uint match(int8_t h2) const
+            {
+                return static_cast<uint>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, _mm_set1_epi8(h2))));
+            }
+
+            uint matchEmpty() const { return match(Empty); }
+            // Both empty and deleted slots have the high bit set.
+            uint matchFree()  const { return static_cast<uint>(_mm_movemask_epi8(ctrl)); }
+            uint matchFull()  const { return ~matchFree() & 0xffff; }
+        };
+
+        // Index of the first full slot at or after the given one.
+        inline size_t nextFull(const int8_t *ctrl, size_t capacity, size_t index)
+        {
+            while (index < capacity)
+            {
+                size_t group = index & ~(GroupSize - 1);
+                uint full    = Group(ctrl + group).matchFull() >> (index - group);
+                if (full)
+                    return index + countTrailingZeros(full);
+                index = group + GroupSize;
+            }
+            return capacity;
+        }
+
+        template <typename Slot>
+        class Iterator
+        {
+            const int8_t *m_ctrl     = nullptr;
+            Slot *        m_slots    = nullptr;
+            size_t        m_capacity = 0;
+            size_t        m_index    = 0;
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type        = typename std::remove_const<Slot>::type;
+            using difference_type   = ptrdiff_t;
+            using pointer           = Slot *;
+            using reference         = Slot &;
+
+            Iterator() = default;
+            Iterator(const int8_t *ctrl, Slot *slots, size_t capacity, size_t index)
+                : m_ctrl(ctrl), m_slots(slots), m_capacity(capacity), m_index(index)
+            {}
+
+            size_t index() const { return m_index; }
+
+            Slot &operator*() const { return m_slots[m_index]; }
+            Slot *operator->() const { return &m_slots[m_index]; }
+
+            Iterator &operator++()
+            {
+                m_index = nextFull(m_ctrl, m_capacity, m_index + 1);
+                return *this;
+            }
+
+            Iterator operator++(int)
+            {
+                Iterator it = *this;
+                ++*this;
+                return it;
+            }
+
+            bool operator==(const Iterator &it) const { return m_index == it.m_index; }
+            bool operator!=(const Iterator &it) const { return m_index != it.m_index; }
+        };
+
+        struct SetKey
+        {
+            template <typename Key>
+            const Key &operator()(const Key &key) const { return key; }
+        };
+
+        struct MapKey
+        {
+            template <typename Pair>
+            const typename Pair::first_type &operator()(const Pair &kv) const { return kv.first; }
+        };
+    }
+
+    // Open addressing hash table in the style of SwissTable, which keeps
+    // the slots in a single array and probes 16 slots at a time using SIMD.
+    // Unlike node based containers, inserting does not allocate except when
+    // the table grows, and clear() keeps the memory for reuse.
+    template <typename Key, typename Slot, typename GetKey, typename Hash, typename Equal>
+    class FlatHashTable
+    {
+    protected:
+        using Group = flat_hash_detail::Group;
+        static const size_t GroupSize = flat_hash_detail::GroupSize;
+        static const size_t NotFound  = ~static_cast<size_t>(0);
+
+        std::unique_ptr<__m128i[]> m_ctrl;
+        std::unique_ptr<Slot[]>    m_slots;
+        size_t                     m_capacity   = 0;
+        size_t                     m_size       = 0;
+        // Slots that can still be filled before the table must grow.
+        // Deleted slots are not counted, so they eventually cause a rehash.
+        size_t                     m_growthLeft = 0;
+        // There are no full slots before this group, so repeatedly taking
+        // the first element of a shrinking table does not rescan the start.
+        mutable size_t             m_firstGroup = 0;
+        Hash                       m_hash;
+        Equal                      m_equal;
+
+        int8_t *ctrl() { return reinterpret_cast<int8_t *>(m_ctrl.get()); }
+        const int8_t *ctrl() const { return reinterpret_cast<const int8_t *>(m_ctrl.get()); }
+
+        static size_t maxLoad(size_t capacity) { return capacity - capacity / 8; }
+        static int8_t h2(size_t hash) { return static_cast<int8_t>(hash & 0x7f); }
+
+        size_t groupMask() const { return m_capacity / GroupSize - 1; }
+
+        size_t findIndex(const Key &key, size_t hash) const
+        {
+            if (!m_capacity)
+                return NotFound;
+
+            size_t mask = groupMask();
+            size_t g    = (hash >> 7) & mask;
+            // Triangular probing visits every group, since the number
+            // of groups is a power of two.
+            for (size_t step = 1;; ++step)
+            {
+                Group group(ctrl() + g * GroupSize);
+                for (uint m = group.match(h2(hash)); m; m &= m - 1)
+                {
+                    size_t i = g * GroupSize + countTrailingZeros(m);
+                    if (m_equal(GetKey()(m_slots[i]), key))
+                        return i;
+                }
+
+                if (group.matchEmpty())
+                    return NotFound;
+
+                g = (g + step) & mask;
+            }
+        }
+
+        size_t findFreeIndex(size_t hash) const
+        {
+            size_t mask = groupMask();
+            size_t g    = (hash >> 7) & mask;
+            for (size_t step = 1;; ++step)
+            {
+                uint free = Group(ctrl() + g * GroupSize).matchFree();
+                if (free)
+                    return g * GroupSize + countTrailingZeros(free);
+                g = (g + step) & mask;
+            }
+        }
+
+        void setCtrl(size_t index, int8_t value)
+        {
+            ctrl()[index] = value;
+        }
+
+        void allocate(size_t capacity)
+        {
+            m_capacity   = capacity;
+            m_ctrl.reset(new __m128i[capacity / GroupSize]);
+            m_slots.reset(new Slot[capacity]);
+            memset(m_ctrl.get(), static_cast<uint8_t>(flat_hash_detail::Empty), capacity);
+            m_size       = 0;
+            m_growthLeft = maxLoad(capacity);
+            m_firstGroup = 0;
+        }
+
+        void rehash(size_t capacity)
+        {
+            auto oldCtrl     = std::move(m_ctrl);
+            auto oldSlots    = std::move(m_slots);
+            size_t oldCapacity = m_capacity;
+            size_t size      = m_size;
+
+            allocate(capacity);
+
+            auto oldCtrlBytes = reinterpret_cast<const int8_t *>(oldCtrl.get());
+            for (size_t i = flat_hash_detail::nextFull(oldCtrlBytes, oldCapacity, 0);
+                 i < oldCapacity;
+                 i = flat_hash_detail::nextFull(oldCtrlBytes, oldCapacity, i + 1))
+            {
+                size_t hash = m_hash(GetKey()(oldSlots[i]));
+                size_t j    = findFreeIndex(hash);
+                setCtrl(j, h2(hash));
+                m_slots[j] = std::move(oldSlots[i]);
+            }
+
+            m_size        = size;
+            m_growthLeft -= size;
+            m_firstGroup  = 0;
+        }
+
+        static size_t capacityFor(size_t size)
+        {
+            size_t capacity = GroupSize;
+            while (maxLoad(capacity) < size)
+                capacity *= 2;
+            return capacity;
+        }
+
+        // Returns the index of the slot for the key, and whether it
+        // was inserted. The key of a newly inserted slot must be set
+        // by the caller.
+        std::pair<size_t, bool> insertIndex(const Key &key)
+        {
+            size_t hash = m_hash(key);
+            size_t i    = findIndex(key, hash);
+            if (i != NotFound)
+                return { i, false };
+
+            if (m_growthLeft == 0)
+            {
+                // If most of the used slots are deleted, just clean them up.
+                if (m_capacity && m_size < maxLoad(m_capacity) / 2)
+                    rehash(m_capacity);
+                else
+                    rehash(m_capacity ? m_capacity * 2 : GroupSize);
+            }
+
+            i = findFreeIndex(hash);
+            if (ctrl()[i] == flat_hash_detail::Empty)
+                --m_growthLeft;
+            setCtrl(i, h2(hash));
+            ++m_size;
+            m_firstGroup = std::min(m_firstGroup, i / GroupSize);
+            return { i, true };
+        }
+
+        void eraseIndex(size_t i)
+        {
+            m_slots[i] = Slot();
+            --m_size;
+
+            // If the group has empty slots, no probe ever continues past
+            // it, so the slot can become empty instead of a tombstone.
+            if (Group(ctrl() + (i & ~(GroupSize - 1))).matchEmpty())
+            {
+                setCtrl(i, flat_hash_detail::Empty);
+                ++m_growthLeft;
+            }
+            else
+            {
+                setCtrl(i, flat_hash_detail::Deleted);
+            }
+        }
+
+        size_t firstIndex() const
+        {
+            size_t i = flat_hash_detail::nextFull(ctrl(), m_capacity, m_firstGroup * GroupSize);
+            m_firstGroup = i / GroupSize;
+            return i;
+        }
+
+    public:
+        using key_type   = Key;
+        using value_type = Slot;
+        using size_type  = size_t;
+
+        FlatHashTable() = default;
+
+        FlatHashTable(const FlatHashTable &t)
+            : m_hash(t.m_hash)
+            , m_equal(t.m_equal)
+        {
+            if (t.m_capacity)
+            {
+                allocate(t.m_capacity);
+                memcpy(m_ctrl.get(), t.m_ctrl.get(), m_capacity);
+                for (size_t i = 0; i < m_capacity; ++i)
+                    m_slots[i] = t.m_slots[i];
+                m_size       = t.m_size;
+                m_growthLeft = t.m_growthLeft;
+                m_firstGroup = t.m_firstGroup;
+            }
+        }
+
+        FlatHashTable(FlatHashTable &&t)
+        {
+            swap(t);
+        }
+
+        FlatHashTable &operator=(FlatHashTable t)
+        {
+            swap(t);
+            return *this;
+        }
+
+        void swap(FlatHashTable &t)
+        {
+            std::swap(m_ctrl,       t.m_ctrl);
+            std::swap(m_slots,      t.m_slots);
+            std::swap(m_capacity,   t.m_capacity);
+            std::swap(m_size,       t.m_size);
+            std::swap(m_growthLeft, t.m_growthLeft);
+            std::swap(m_firstGroup, t.m_firstGroup);
+            std::swap(m_hash,       t.m_hash);
+            std::swap(m_equal,      t.m_equal);
+        }
+
+        size_t size()     const { return m_size; }
+        bool   empty()    const { return m_size == 0; }
+        size_t capacity() const { return m_capacity; }
+
+        // Remove all elements, but keep the memory.
+        void clear()
+        {
+            if (m_size == 0 && m_growthLeft == maxLoad(m_capacity))
+                return;
+
+            if (!std::is_trivially_destructible<Slot>::value)
+            {
+                for (size_t i = flat_hash_detail::nextFull(ctrl(), m_capacity, 0);
+                     i < m_capacity;
+                     i = flat_hash_detail::nextFull(ctrl(), m_capacity, i + 1))
+                {
+                    m_slots[i] = Slot();
+                }
+            }
+
+            memset(m_ctrl.get(), static_cast<uint8_t>(flat_hash_detail::Empty), m_capacity);
+            m_size       = 0;
+            m_growthLeft = maxLoad(m_capacity);
+            m_firstGroup = 0;
+        }
+
+        // Make room for the given number of elements without growing.
+        void reserve(size_t size)
+        {
+            if (size > m_size + m_growthLeft)
+                rehash(std::max(capacityFor(size), m_capacity));
+        }
+
+        size_t count(const Key &key) const
+        {
+            return findIndex(key, m_hash(key)) != NotFound ? 1 : 0;
+        }
+
+        bool contains(const Key &key) const
+        {
+            return count(key) != 0;
+        }
+
+        size_t erase(const Key &key)
+        {
+            size_t i = findIndex(key, m_hash(key));
+            if (i == NotFound)
+                return 0;
+
+            eraseIndex(i);
+            return 1;
+        }
+    };
+
+    template <typename Key,
+              typename Hash  = PodHash,
+              typename Equal = std::equal_to<Key>>
+    class FlatHashSet
+        : public FlatHashTable<Key, Key, flat_hash_detail::SetKey, Hash, Equal>
+    {
+        using Base = FlatHashTable<Key, Key, flat_hash_detail::SetKey, Hash, Equal>;
+    public:
+        // Keys cannot be modified in place, so there is only a const iterator.
+        using iterator       = flat_hash_detail::Iterator<const Key>;
+        using const_iterator = iterator;
+
+        FlatHashSet() = default;
+
+        template <typename It>
+        FlatHashSet(It begin, It end)
+        {
+            insert(begin, end);
+        }
+
+        iterator begin() const { return makeIterator(this->firstIndex()); }
+        iterator end()   const { return makeIterator(this->m_capacity); }
+
+        iterator find(const Key &key) const
+        {
+            size_t i = this->findIndex(key, this->m_hash(key));
+            return makeIterator(i == Base::NotFound ? this->m_capacity : i);
+        }
+
+        std::pair<iterator, bool> insert(const Key &key)
+        {
+            auto i = this->insertIndex(key);
+            if (i.second)
+                this->m_slots[i.first] = key;
+            return { makeIterator(i.first), i.second };
+        }
+
+        template <typename It>
+        void insert(It begin, It end)
+        {
+            for (; begin != end; ++begin)
+                insert(*begin);
+        }
+
+        std::pair<iterator, bool> emplace(const Key &key)
+        {
+            return insert(key);
+        }
+
+        using Base::erase;
+        void erase(iterator it)
+        {
+            this->eraseIndex(it.index());
+        }
+
+    private:
+        iterator makeIterator(size_t i) const
+        {
+            return iterator(this->ctrl(), this->m_slots.get(), this->m_capacity, i);
+        }
+    };
+
+    template <typename Key,
+              typename Value,
+              typename Hash  = PodHash,
+              typename Equal = std::equal_to<Key>>
+    class FlatHashMap
+        : public FlatHashTable<Key, std::pair<Key, Value>, flat_hash_detail::MapKey, Hash, Equal>
+    {
+        using Base = FlatHashTable<Key, std::pair<Key, Value>, flat_hash_detail::MapKey, Hash, Equal>;
+    public:
+        using mapped_type    = Value;
+        using iterator       = flat_hash_detail::Iterator<std::pair<Key, Value>>;
+        using const_iterator = flat_hash_detail::Iterator<const std::pair<Key, Value>>;
+
+        FlatHashMap() = default;
+
+        iterator begin() { return makeIterator(this->firstIndex()); }
+        iterator end()   { return makeIterator(this->m_capacity); }
+        const_iterator begin() const { return makeConstIterator(this->firstIndex()); }
+        const_iterator end()   const { return makeConstIterator(this->m_capacity); }
+
+        iterator find(const Key &key)
+        {
+            size_t i = this->findIndex(key, this->m_hash(key));
+            return makeIterator(i == Base::NotFound ? this->m_capacity : i);
+        }
+
+        const_iterator find(const Key &key) const
+        {
+            size_t i = this->findIndex(key, this->m_hash(key));
+            return makeConstIterator(i == Base::NotFound ? this->m_capacity : i);
+        }
+
+        // Like std::unordered_map::emplace(), the value is left
+        // untouched if the key exists already.
+        std::pair<iterator, bool> emplace(const Key &key, Value value)
+        {
+            auto i = this->insertIndex(key);
+            if (i.second)
+                this->m_slots[i.first] = std::pair<Key, Value>(key, std::move(value));
+            return { makeIterator(i.first), i.second };
+        }
+
+        std::pair<iterator, bool> insert(std::pair<Key, Value> kv)
+        {
+            return emplace(kv.first, std::move(kv.second));
+        }
+
+        Value &operator[](const Key &key)
+        {
+            auto i = this->insertIndex(key);
+            auto &slot = this->m_slots[i.first];
+            if (i.second)
+                slot = std::pair<Key, Value>(key, Value());
+            return slot.second;
+        }
+
+        using Base::erase;
+        void erase(const_iterator it)
+        {
+            this->eraseIndex(it.index());
+        }
+
+        void erase(iterator it)
+        {
+            this->eraseIndex(it.index());
+        }
+
+    private:
+        iterator makeIterator(size_t i)
+        {
+            return iterator(this->ctrl(), this->m_slots.get(), this->m_capacity, i);
+        }
+
+        const_iterator makeConstIterator(size_t i) const
+        {
+            return const_iterator(this->ctrl(), this->m_slots.get(), this->m_capacity, i);
+        }
+    };
+}
@@ -4,6 +4,7 @@
 #include "Utils.hpp"
 
 #include <cstdint>
+#include <intrin.h>
 
 namespace Xor
 {
@@ -91,12 +92,63 @@ namespace Xor
         return h.done();
     }
 
+    // Multiply-fold mixing of at most 16 bytes in the style of wyhash,
+    // which is much cheaper than running SpookyHash for small keys
+    // such as integer vectors.
+    namespace hash_detail
+    {
+        static const uint64_t SmallKeySecret0 = 0xa0761d6478bd642full;
+        static const uint64_t SmallKeySecret1 = 0xe7037ed1a0b428dbull;
+
+        inline uint64_t multiplyFold(uint64_t a, uint64_t b)
+        {
+            uint64_t hi;
+            uint64_t lo = _umul128(a, b, &hi);
+            return lo ^ hi;
+        }
+
+        template <typename T>
+        uint64_t hashSmallPod(const T &t)
+        {
+            static_assert(sizeof(T) <= 16, "hashSmallPod() only supports types of at most 16 bytes");
+            uint64_t words[2] = {};
+            memcpy(words, &t, sizeof(T));
+            return multiplyFold(SmallKeySecret1 ^ sizeof(T),
+                                multiplyFold(words[0] ^ SmallKeySecret0, words[1] ^ SmallKeySecret1));
+        }
+
+        template <typename T>
+        uint64_t hashPod(const T &t, std::true_type)
+        {
+            return hashSmallPod(t);
+        }
+
+        template <typename T>
+        uint64_t hashPod(const T &t, std::false_type)
+        {
+            return hashPods(t);
+        }
+    }
+
     struct PodHash
     {
+        // Keys of at most 16 bytes are hashed with a fast mixer, and
+        // larger ones with SpookyHash.
         template <typename T>
         size_t operator()(const T &t) const
         {
-            return hashPods(t);
+            return static_cast<size_t>(hash_detail::hashPod(t, std::integral_constant<bool, sizeof(T) <= 16>()));
+        }
+    };
+
+    // PodHash as it was before small keys got their own mixer,
+    // for comparisons.
+    struct SpookyPodHash
+    {
+        template <typename T>
+        size_t operator()(const T &t) const
+        {
+            return static_cast<size_t>(hashPods(t));
         }
     };
 
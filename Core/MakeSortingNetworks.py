@@ -0,0 +1,111 @@
+import random
+
+MinSize = 4
+MaxSize = 32
+# Networks up to this size are checked with all 0-1 inputs,
+# and larger ones with random 0-1 inputs.
+ExhaustiveMaxSize = 16
+RandomRounds = 64
+RandomInputs = 1 << 12
+
+# Optimal networks for sizes where Batcher's networks are not.
+known = {
+    9 : [(0, 1), (3, 4), (6, 7), (1, 2), (4, 5), (7, 8), (0, 1), (3, 4),
+         (6, 7), (0, 3), (3, 6), (0, 3), (1, 4), (4, 7), (1, 4), (2, 5),
+         (5, 8), (2, 5), (1, 3), (5, 7), (2, 6), (4, 6), (2, 4), (2, 3),
+         (5, 6)],
+}
+
+# Batcher's odd-even merge sort for the next power of two. Comparators
+# that touch elements past the end can be dropped, since they would
+# only compare against padding that sorts last.
+def batcher(n):
+    size = 1
+    while size < n:
+        size *= 2
+
+    pairs = []
+    p = 1
+    while p < size:
+        k = p
+        while k >= 1:
+            for j in range(k % p, size - k, 2 * k):
+                for i in range(min(k, size - j - k)):
+                    if (i + j) // (2 * p) == (i + j + k) // (2 * p):
+                        pairs.append((i + j, i + j + k))
+            k //= 2
+        p *= 2
+
+    return [(a, b) for a, b in pairs if b < n]
+
+# Check with the 0-1 principle, using bit i of every element as input i.
+def verify01(n, pairs, elements):
+    for a, b in pairs:
+        elements[a], elements[b] = elements[a] & elements[b], elements[a] | elements[b]
+    for e in range(n - 1):
+        assert elements[e] & ~elements[e + 1] == 0, "Network for %d is broken" % n
+
+def verifyExhaustive(n, pairs):
+    inputs = 1 << n
+    elements = []
+    for e in range(n):
+        bits = 0
+        for i in range(inputs):
+            if (i >> e) & 1:
+                bits |= 1 << i
+        elements.append(bits)
+    verify01(n, pairs, elements)
+
+# All 0-1 inputs are too many for large networks, so check random ones
+# instead. The density of ones varies between rounds, since inputs with
+# only a few zeros or ones are the likeliest to expose a missing
+# comparator. Random permutations are also sorted directly.
+def verifyRandom(n, pairs, rng):
+    for round in range(RandomRounds):
+        ones = rng.randint(1, 7)
+        elements = []
+        for e in range(n):
+            bits = rng.getrandbits(RandomInputs)
+            for i in range(abs(ones - 4)):
+                if ones > 4:
+                    bits |= rng.getrandbits(RandomInputs)
+                else:
+                    bits &= rng.getrandbits(RandomInputs)
+            elements.append(bits)
+        verify01(n, pairs, elements)
+
+    for round in range(RandomInputs):
+        values = list(range(n))
+        rng.shuffle(values)
+        for a, b in pairs:
+            if values[b] < values[a]:
+                values[a], values[b] = values[b], values[a]
+        assert values == list(range(n)), "Network for %d is broken" % n
+
+def network(n):
+    pairs = known.get(n) or batcher(n)
+    if n <= ExhaustiveMaxSize:
+        verifyExhaustive(n, pairs)
+    else:
+        verifyRandom(n, pairs, random.Random(n))
+    return pairs
+
+if __name__ == '__main__':
+    print('''#ifndef XOR_SORTINGNETWORKS_H
+#define XOR_SORTINGNETWORKS_H
+
+// Autogenerated using MakeSortingNetworks.py
+
+// Sorting macros defined using X macros.
+// #define SWAP(a, b) to whatever, a and b will be integer literals.
+// SWAP(a, b) must leave the smaller element in a and the larger in b.
+
+#define XOR_SORTING_NETWORK_MIN_SIZE {0}
+#define XOR_SORTING_NETWORK_MAX_SIZE {1}'''.format(MinSize, MaxSize))
+    for n in range(MinSize, MaxSize + 1):
+        lines = ['    SWAP({0}, {1});'.format(a, b) for a, b in network(n)]
+        print('')
+        print('#define XOR_SORTING_NETWORK_{0} \\'.format(n))
+        print(' \\\n'.join(lines))
+    print('')
+    print('#endif')
@@ -7,4 +7,5 @@
 #include "MathMorton.hpp"
 #include "MathColors.hpp"
 #include "MathRandom.hpp"
+#include "MathPackets.hpp"
 
@@ -0,0 +1,197 @@
+#include "Core/MathBatch.hpp"
+
+namespace Xor
+{
+    namespace batch_detail
+    {
+        static const uint Width = NativePacketWidth;
+
+        using P  = Packet<float, Width>;
+        using P3 = Packet3<float, Width>;
+
+        // Smaller inputs are done on the calling thread, and every
+        // thread gets at least one block.
+        static const size_t ParallelBatchSize = 1 << 15;
+        static const size_t ParallelBlockSize = 1 << 13;
+
+        // Call f(begin, end) for consecutive ranges that cover [0, count).
+        template <typename F>
+        static void forEachBlock(ThreadPool &pool, size_t count, F &&f)
+        {
+            size_t blocks = std::min<size_t>(pool.threadCount() + 1, count / ParallelBlockSize);
+            if (count < ParallelBatchSize || blocks <= 1)
+            {
+                f(size_t(0), count);
+                return;
+            }
+
+            pool.parallelFor(blocks, [&] (size_t b)
+            {
+                f(b * count / blocks, (b + 1) * count / blocks);
+            });
+        }
+
+        // The matrix with every element broadcast to a packet.
+        struct PacketMatrix
+        {
+            P m[4][4];
+
+            PacketMatrix(const Matrix &matrix)
+            {
+                for (uint y = 0; y < 4; ++y)
+                {
+                    for (uint x = 0; x < 4; ++x)
+                        m[y][x] = matrix(y, x);
+                }
+            }
+
+            // Same operation order as Matrix::transform(), with w = 1.
+            void transform(const P3 &p, P (&rows)[4]) const
+            {
+                for (uint y = 0; y < 4; ++y)
+                    rows[y] = m[y][0] * p.x + m[y][1] * p.y + m[y][2] * p.z + m[y][3];
+            }
+        };
+
+        static void transformBlock(const Matrix &m, const float3 *points, float4 *transformed,
+                                   size_t begin, size_t end)
+        {
+            PacketMatrix pm(m);
+
+            size_t i = begin;
+            for (; i + Width <= end; i += Width)
+            {
+                P rows[4];
+                pm.transform(P3::load(points + i), rows);
+
+                float lanes[4][Width];
+                for (uint r = 0; r < 4; ++r)
+                    rows[r].store(lanes[r]);
+
+                for (uint j = 0; j < Width; ++j)
+                    transformed[i + j] = float4(lanes[0][j], lanes[1][j], lanes[2][j], lanes[3][j]);
+            }
+
+            for (; i < end; ++i)
+                transformed[i] = m.transform(points[i]);
+        }
+
+        static void transformAndProjectBlock(const Matrix &m, const float3 *points, float3 *projected,
+                                             size_t begin, size_t end)
+        {
+            PacketMatrix pm(m);
+
+            size_t i = begin;
+            for (; i + Width <= end; i += Width)
+            {
+                P rows[4];
+                pm.transform(P3::load(points + i), rows);
+
+                float lanes[3][Width];
+                for (uint r = 0; r < 3; ++r)
+                    (rows[r] / rows[3]).store(lanes[r]);
+
+                for (uint j = 0; j < Width; ++j)
+                    projected[i + j] = float3(lanes[0][j], lanes[1][j], lanes[2][j]);
+            }
+
+            for (; i < end; ++i)
+                projected[i] = m.transformAndProject(points[i]);
+        }
+
+        static void frustumTestBlock(const AABB *boxes, Span<const float4> planes, uint8_t *visible,
+                                     size_t begin, size_t end)
+        {
+            size_t i = begin;
+            for (; i + Width <= end; i += Width)
+            {
+                float lanes[6][Width];
+                for (uint j = 0; j < Width; ++j)
+                {
+                    const AABB &box = boxes[i + j];
+                    lanes[0][j] = box.min.x;
+                    lanes[1][j] = box.min.y;
+                    lanes[2][j] = box.min.z;
+                    lanes[3][j] = box.max.x;
+                    lanes[4][j] = box.max.y;
+                    lanes[5][j] = box.max.z;
+                }
+
+                P3 boxMin = P3::load(lanes[0], lanes[1], lanes[2]);
+                P3 boxMax = P3::load(lanes[3], lanes[4], lanes[5]);
+
+                // Every plane has the same normal in all lanes, so the
+                // furthest corner can be picked without a select.
+                auto inside = P(0) == P(0);
+                for (auto &plane : planes)
+                {
+                    const P &x = plane.x >= 0 ? boxMax.x : boxMin.x;
+                    const P &y = plane.y >= 0 ? boxMax.y : boxMin.y;
+                    const P &z = plane.z >= 0 ? boxMax.z : boxMin.z;
+
+                    inside = inside & (plane.x * x + plane.y * y + plane.z * z + plane.w >= 0);
+                    if (none(inside))
+                        break;
+                }
+
+                uint bits = inside.bits();
+                for (uint j = 0; j < Width; ++j)
+                    visible[i + j] = static_cast<uint8_t>((bits >> j) & 1);
+            }
+
+            for (; i < end; ++i)
+                visible[i] = frustumTestAABB(boxes[i], planes) ? 1 : 0;
+        }
+    }
+
+    using namespace batch_detail;
+
+    void transformPoints(const Matrix &m, Span<const float3> points, Span<float4> transformed, ThreadPool &pool)
+    {
+        XOR_ASSERT(points.size() == transformed.size(), "Input and output sizes must match");
+
+        forEachBlock(pool, points.size(), [&] (size_t begin, size_t end)
+        {
+            transformBlock(m, points.data(), transformed.data(), begin, end);
+        });
+    }
+
+    void transformAndProjectPoints(const Matrix &m, Span<const float3> points, Span<float3> projected, ThreadPool &pool)
+    {
+        XOR_ASSERT(points.size() == projected.size(), "Input and output sizes must match");
+
+        forEachBlock(pool, points.size(), [&] (size_t begin, size_t end)
+        {
+            transformAndProjectBlock(m, points.data(), projected.data(), begin, end);
+        });
+    }
+
+    std::array<float4, 6> frustumPlanes(const Matrix &viewProj)
+    {
+        // Each clip space inequality, such as -w <= x, is a plane
+        // in the space that is transformed by the matrix.
+        const float4 &x = viewProj.row(0);
+        const float4 &y = viewProj.row(1);
+        const float4 &z = viewProj.row(2);
+        const float4 &w = viewProj.row(3);
+
+        return std::array<float4, 6> {
+            w + x,
+            w - x,
+            w + y,
+            w - y,
+            z,
+            w - z,
+        };
+    }
+
+    void frustumTestAABBs(Span<const AABB> boxes, Span<const float4> planes, Span<uint8_t> visible, ThreadPool &pool)
+    {
+        XOR_ASSERT(boxes.size() == visible.size(), "Input and output sizes must match");
+
+        forEachBlock(pool, boxes.size(), [&] (size_t begin, size_t end)
+        {
+            frustumTestBlock(boxes.data(), planes, visible.data(), begin, end);
+        });
+    }
+}
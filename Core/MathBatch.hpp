@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Core/Math.hpp"
+#include "Core/ThreadPool.hpp"
+
+#include <array>
+
+namespace Xor
+{
+    // Transform every point by the matrix, like Matrix::transform(). Both
+    // spans must have the same size. The points are processed a packet at
+    // a time, and large inputs are split between the threads of the pool.
+    void transformPoints(const Matrix &m,
+                         Span<const float3> points,
+                         Span<float4> transformed,
+                         ThreadPool &pool = ThreadPool::global());
+
+    // Like transformPoints(), but also divide by w like
+    // Matrix::transformAndProject().
+    void transformAndProjectPoints(const Matrix &m,
+                                   Span<const float3> points,
+                                   Span<float3> projected,
+                                   ThreadPool &pool = ThreadPool::global());
+
+    // The left, right, bottom, top, near and far planes of the frustum of
+    // a view-projection matrix, with clip space depth from 0 to w. A point
+    // p is on the inner side of a plane if dot(plane.xyz, p) + plane.w >= 0.
+    // The planes are not normalized.
+    std::array<float4, 6> frustumPlanes(const Matrix &viewProj);
+
+    // True if some part of the box may be on the inner side of every plane.
+    // Boxes that are outside the frustum near its corners can pass.
+    inline bool frustumTestAABB(const AABB &box, Span<const float4> planes)
+    {
+        for (auto &plane : planes)
+        {
+            // The corner that is furthest along the normal.
+            float x = plane.x >= 0 ? box.max.x : box.min.x;
+            float y = plane.y >= 0 ? box.max.y : box.min.y;
+            float z = plane.z >= 0 ? box.max.z : box.min.z;
+
+            if (!(plane.x * x + plane.y * y + plane.z * z + plane.w >= 0))
+                return false;
+        }
+
+        return true;
+    }
+
+    // Set visible[i] to 1 if frustumTestAABB() passes for boxes[i], and to 0
+    // otherwise. Both spans must have the same size. Vectorized across boxes,
+    // and large inputs are split between the threads of the pool.
+    void frustumTestAABBs(Span<const AABB> boxes,
+                          Span<const float4> planes,
+                          Span<uint8_t> visible,
+                          ThreadPool &pool = ThreadPool::global());
+}
@@ -136,6 +136,29 @@ namespace Xor
         }
     };
 
+    // Axis-aligned bounding box, which is empty until points are added.
+    struct AABB
+    {
+        float3 min = MaxFloat;
+        float3 max = -MaxFloat;
+
+        AABB() = default;
+        AABB(float3 min, float3 max)
+            : min(min)
+            , max(max)
+        {}
+
+        void add(float3 p)
+        {
+            min = math::min(min, p);
+            max = math::max(max, p);
+        }
+
+        bool empty() const { return any(max < min); }
+        float3 center() const { return (min + max) * .5f; }
+        float3 size() const { return max - min; }
+    };
+
     // From https://en.wikipedia.org/wiki/Circumscribed_circle
     inline Circle<float> circumcircle(float2 A, float2 B, float2 C)
     {
@@ -16,6 +16,15 @@ namespace Xor
             return -1;
     }
 
+    inline int64_t firstbithigh(uint64_t value)
+    {
+        unsigned long index;
+        if (_BitScanReverse64(&index, value))
+            return static_cast<int64_t>(index);
+        else
+            return -1;
+    }
+
     inline uint countTrailingZeros(uint64_t value)
     {
         unsigned long index;
@@ -1,4 +1,7 @@
 #include "Core/MathMorton.hpp"
+#include "Core/Utils.hpp"
+
+#include <immintrin.h>
 
 // This #include has "using namespace std" in the header, and has thus
 // been contained in this file.
@@ -29,4 +32,243 @@ namespace Xor
         morton3D_64_decode(mortonIndex, coords.x, coords.y, coords.z);
         return coords;
     }
-}
\ No newline at end of file
+
+    namespace morton_detail
+    {
+        static const uint64_t Mask2D = 0x5555555555555555ull;
+        static const uint64_t Mask3D = 0x1249249249249249ull;
+
+        // Bit spreading with shifts and masks for four 64-bit lanes at once.
+        static __m256i set1(uint64_t x)
+        {
+            return _mm256_set1_epi64x(static_cast<int64_t>(x));
+        }
+
+        template <int Shift>
+        static __m256i spreadStep(__m256i x, uint64_t mask)
+        {
+            return _mm256_and_si256(_mm256_or_si256(x, _mm256_slli_epi64(x, Shift)), set1(mask));
+        }
+
+        template <int Shift>
+        static __m256i compactStep(__m256i x, uint64_t mask)
+        {
+            return _mm256_and_si256(_mm256_or_si256(x, _mm256_srli_epi64(x, Shift)), set1(mask));
+        }
+
+        static __m256i part1By1(__m256i x)
+        {
+            x = spreadStep<16>(x, 0x0000ffff0000ffffull);
+            x = spreadStep<8> (x, 0x00ff00ff00ff00ffull);
+            x = spreadStep<4> (x, 0x0f0f0f0f0f0f0f0full);
+            x = spreadStep<2> (x, 0x3333333333333333ull);
+            x = spreadStep<1> (x, Mask2D);
+            return x;
+        }
+
+        static __m256i compact1By1(__m256i x)
+        {
+            x = _mm256_and_si256(x, set1(Mask2D));
+            x = compactStep<1> (x, 0x3333333333333333ull);
+            x = compactStep<2> (x, 0x0f0f0f0f0f0f0f0full);
+            x = compactStep<4> (x, 0x00ff00ff00ff00ffull);
+            x = compactStep<8> (x, 0x0000ffff0000ffffull);
+            x = compactStep<16>(x, 0x00000000ffffffffull);
+            return x;
+        }
+
+        static __m256i part1By2(__m256i x)
+        {
+            x = _mm256_and_si256(x, set1(0x1fffff));
+            x = spreadStep<32>(x, 0x001f00000000ffffull);
+            x = spreadStep<16>(x, 0x001f0000ff0000ffull);
+            x = spreadStep<8> (x, 0x100f00f00f00f00full);
+            x = spreadStep<4> (x, 0x10c30c30c30c30c3ull);
+            x = spreadStep<2> (x, Mask3D);
+            return x;
+        }
+
+        static __m256i compact1By2(__m256i x)
+        {
+            x = _mm256_and_si256(x, set1(Mask3D));
+            x = compactStep<2> (x, 0x10c30c30c30c30c3ull);
+            x = compactStep<4> (x, 0x100f00f00f00f00full);
+            x = compactStep<8> (x, 0x001f0000ff0000ffull);
+            x = compactStep<16>(x, 0x001f00000000ffffull);
+            x = compactStep<32>(x, 0x00000000001fffffull);
+            return x;
+        }
+
+        // Each kernel processes as many elements as it can, and returns
+        // how many it did. The rest are done with the scalar functions.
+        static size_t encode2DAVX2(const uint2 *coords, uint64_t *indices, size_t count)
+        {
+            static_assert(sizeof(uint2) == sizeof(uint64_t), "Unexpected uint2 layout");
+
+            __m256i low32 = set1(0xffffffffull);
+            size_t i = 0;
+            for (; i + 4 <= count; i += 4)
+            {
+                // Each 64-bit lane contains x in the low and y in the high half.
+                __m256i xy = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(coords + i));
+                __m256i x  = part1By1(_mm256_and_si256(xy, low32));
+                __m256i y  = part1By1(_mm256_srli_epi64(xy, 32));
+                __m256i m  = _mm256_or_si256(x, _mm256_slli_epi64(y, 1));
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(indices + i), m);
+            }
+            return i;
+        }
+
+        static size_t decode2DAVX2(const uint64_t *indices, uint2 *coords, size_t count)
+        {
+            size_t i = 0;
+            for (; i + 4 <= count; i += 4)
+            {
+                __m256i m  = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(indices + i));
+                __m256i x  = compact1By1(m);
+                __m256i y  = compact1By1(_mm256_srli_epi64(m, 1));
+                __m256i xy = _mm256_or_si256(x, _mm256_slli_epi64(y, 32));
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(coords + i), xy);
+            }
+            return i;
+        }
+
+        static __m256i gather(const uint3 *c, uint component)
+        {
+            return _mm256_set_epi64x(c[3][component], c[2][component], c[1][component], c[0][component]);
+        }
+
+        static size_t encode3DAVX2(const uint3 *coords, uint64_t *indices, size_t count)
+        {
+            size_t i = 0;
+            for (; i + 4 <= count; i += 4)
+            {
+                __m256i x = part1By2(gather(coords + i, 0));
+                __m256i y = part1By2(gather(coords + i, 1));
+                __m256i z = part1By2(gather(coords + i, 2));
+                __m256i m = _mm256_or_si256(x, _mm256_or_si256(_mm256_slli_epi64(y, 1),
+                                                               _mm256_slli_epi64(z, 2)));
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(indices + i), m);
+            }
+            return i;
+        }
+
+        static size_t decode3DAVX2(const uint64_t *indices, uint3 *coords, size_t count)
+        {
+            alignas(32) uint64_t x[4];
+            alignas(32) uint64_t y[4];
+            alignas(32) uint64_t z[4];
+
+            size_t i = 0;
+            for (; i + 4 <= count; i += 4)
+            {
+                __m256i m = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(indices + i));
+                _mm256_store_si256(reinterpret_cast<__m256i *>(x), compact1By2(m));
+                _mm256_store_si256(reinterpret_cast<__m256i *>(y), compact1By2(_mm256_srli_epi64(m, 1)));
+                _mm256_store_si256(reinterpret_cast<__m256i *>(z), compact1By2(_mm256_srli_epi64(m, 2)));
+
+                for (uint j = 0; j < 4; ++j)
+                {
+                    coords[i + j] = uint3(static_cast<uint>(x[j]),
+                                          static_cast<uint>(y[j]),
+                                          static_cast<uint>(z[j]));
+                }
+            }
+            return i;
+        }
+
+        // PDEP and PEXT deposit and extract bits under a mask, which is
+        // exactly Morton encoding and decoding.
+        static size_t encode2DBMI2(const uint2 *coords, uint64_t *indices, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                indices[i] = _pdep_u64(coords[i].x, Mask2D)
+                           | _pdep_u64(coords[i].y, Mask2D << 1);
+            }
+            return count;
+        }
+
+        static size_t decode2DBMI2(const uint64_t *indices, uint2 *coords, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                coords[i] = uint2(static_cast<uint>(_pext_u64(indices[i], Mask2D)),
+                                  static_cast<uint>(_pext_u64(indices[i], Mask2D << 1)));
+            }
+            return count;
+        }
+
+        static size_t encode3DBMI2(const uint3 *coords, uint64_t *indices, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                indices[i] = _pdep_u64(coords[i].x, Mask3D)
+                           | _pdep_u64(coords[i].y, Mask3D << 1)
+                           | _pdep_u64(coords[i].z, Mask3D << 2);
+            }
+            return count;
+        }
+
+        static size_t decode3DBMI2(const uint64_t *indices, uint3 *coords, size_t count)
+        {
+            for (size_t i = 0; i < count; ++i)
+            {
+                coords[i] = uint3(static_cast<uint>(_pext_u64(indices[i], Mask3D)),
+                                  static_cast<uint>(_pext_u64(indices[i], Mask3D << 1)),
+                                  static_cast<uint>(_pext_u64(indices[i], Mask3D << 2)));
+            }
+            return count;
+        }
+
+        template <typename In, typename Out, typename Scalar>
+        static void batch(Span<const In> in, Span<Out> out,
+                          size_t(*avx2)(const In *, Out *, size_t),
+                          size_t(*bmi2)(const In *, Out *, size_t),
+                          Scalar &&scalar)
+        {
+            XOR_ASSERT(in.size() == out.size(), "Input and output sizes must match");
+
+            size_t count = in.size();
+            size_t done  = 0;
+
+            // PDEP and PEXT do a whole coordinate in one instruction, but
+            // some CPUs that support them run them slower than AVX2.
+            if (cpuHasFastPDEP())
+                done = bmi2(in.data(), out.data(), count);
+            else if (cpuSupportsAVX2())
+                done = avx2(in.data(), out.data(), count);
+            else if (cpuSupportsBMI2())
+                done = bmi2(in.data(), out.data(), count);
+
+            for (size_t i = done; i < count; ++i)
+                out[i] = scalar(in[i]);
+        }
+    }
+
+    using namespace morton_detail;
+
+    void morton2DEncode(Span<const uint2> coords, Span<uint64_t> mortonIndices)
+    {
+        batch(coords, mortonIndices, encode2DAVX2, encode2DBMI2,
+              [] (uint2 c) { return morton2DEncode(c); });
+    }
+
+    void morton2DDecode(Span<const uint64_t> mortonIndices, Span<uint2> coords)
+    {
+        batch(mortonIndices, coords, decode2DAVX2, decode2DBMI2,
+              [] (uint64_t m) { return morton2DDecode(m); });
+    }
+
+    void morton3DEncode(Span<const uint3> coords, Span<uint64_t> mortonIndices)
+    {
+        batch(coords, mortonIndices, encode3DAVX2, encode3DBMI2,
+              [] (uint3 c) { return morton3DEncode(c); });
+    }
+
+    void morton3DDecode(Span<const uint64_t> mortonIndices, Span<uint3> coords)
+    {
+        batch(mortonIndices, coords, decode3DAVX2, decode3DBMI2,
+              [] (uint64_t m) { return morton3DDecode(m); });
+    }
+}
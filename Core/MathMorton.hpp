@@ -1,6 +1,7 @@
 #pragma once
 
 #include "Core/MathVectors.hpp"
+#include "Core/MathInteger.hpp"
 
 namespace Xor
 {
@@ -8,4 +9,54 @@ namespace Xor
     uint2    morton2DDecode(uint64_t mortonIndex);
     uint64_t morton3DEncode(uint3 coords);
     uint3    morton3DDecode(uint64_t mortonIndex);
-}
\ No newline at end of file
+
+    // Encode or decode many coordinates at once, using AVX2 or BMI2 if
+    // the CPU supports them. Both spans must have the same size.
+    void morton2DEncode(Span<const uint2> coords, Span<uint64_t> mortonIndices);
+    void morton2DDecode(Span<const uint64_t> mortonIndices, Span<uint2> coords);
+    void morton3DEncode(Span<const uint3> coords, Span<uint64_t> mortonIndices);
+    void morton3DDecode(Span<const uint64_t> mortonIndices, Span<uint3> coords);
+
+    // Indexing of 2D arrays that are stored as square tiles in row-major
+    // order, with the elements of each tile in Morton order. Unlike in
+    // row-major arrays, elements that are close to each other in any
+    // direction are likely to be on the same cache line or page.
+    struct ZOrderTiles
+    {
+        // With 4-byte elements, a tile is a 4 KB page, and a
+        // cache line is a block of 4x4 elements.
+        static const uint TileBits = 5;
+        static const uint TileSize = 1u << TileBits;
+        static const uint TileArea = TileSize * TileSize;
+
+        uint2 tiles;
+
+        ZOrderTiles() = default;
+        ZOrderTiles(uint2 size)
+            : tiles(divRoundUp(size.x, TileSize), divRoundUp(size.y, TileSize))
+        {}
+
+        // The array is padded to a whole number of tiles.
+        size_t elementCount() const
+        {
+            return static_cast<size_t>(tiles.x) * tiles.y * TileArea;
+        }
+
+        size_t index(uint2 coords) const
+        {
+            // Spreading the bits with a table is cheaper than with shifts,
+            // which matters as this is done for every lookup.
+            static const uint16_t Spread[TileSize] =
+            {
+                0x000, 0x001, 0x004, 0x005, 0x010, 0x011, 0x014, 0x015,
+                0x040, 0x041, 0x044, 0x045, 0x050, 0x051, 0x054, 0x055,
+                0x100, 0x101, 0x104, 0x105, 0x110, 0x111, 0x114, 0x115,
+                0x140, 0x141, 0x144, 0x145, 0x150, 0x151, 0x154, 0x155,
+            };
+
+            size_t tile   = static_cast<size_t>(coords.y >> TileBits) * tiles.x + (coords.x >> TileBits);
+            uint   inTile = Spread[coords.x & (TileSize - 1)] | (Spread[coords.y & (TileSize - 1)] << 1);
+            return (tile << (2 * TileBits)) | inTile;
+        }
+    };
+}
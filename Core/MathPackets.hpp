@@ -0,0 +1,477 @@
+#pragma once
+
+#include "MathVectors.hpp"
+#include "MathFloat.hpp"
+
+#include <cmath>
+
+namespace Xor
+{
+    namespace math
+    {
+        // Packets hold one value per SIMD lane, and are used to run the same
+        // math for many independent elements at once. Unlike float4, which
+        // is a single vector, Packet<float, 8> is eight unrelated floats.
+        template <typename T, uint N> struct Packet;
+        template <uint N> struct PacketMask;
+
+        // The widest packet that fits in a SIMD register.
+        static constexpr uint NativePacketWidth = XOR_MATH_SIMD >= 2 ? 8 : 4;
+
+        namespace packet_detail
+        {
+            // Plain arrays of lanes, which is the fallback for every width.
+            // All backends give bit-identical results.
+            template <uint N>
+            struct FloatScalar
+            {
+                static_assert((N & (N - 1)) == 0, "Packet width must be a power of two");
+
+                struct Reg  { float    lanes[N]; };
+                struct Mask { uint32_t lanes[N]; };
+
+                template <typename F>
+                static Reg lanewise(F &&f)
+                {
+                    Reg c;
+                    for (uint i = 0; i < N; ++i) c.lanes[i] = f(i);
+                    return c;
+                }
+
+                template <typename F>
+                static Mask compare(F &&f)
+                {
+                    Mask m;
+                    for (uint i = 0; i < N; ++i) m.lanes[i] = f(i) ? ~0u : 0u;
+                    return m;
+                }
+
+                static Reg load(const float *p) { return lanewise([&] (uint i) { return p[i]; }); }
+                static void store(float *p, Reg a) { for (uint i = 0; i < N; ++i) p[i] = a.lanes[i]; }
+                static Reg set1(float x) { return lanewise([&] (uint) { return x; }); }
+
+                static Reg add(Reg a, Reg b) { return lanewise([&] (uint i) { return a.lanes[i] + b.lanes[i]; }); }
+                static Reg sub(Reg a, Reg b) { return lanewise([&] (uint i) { return a.lanes[i] - b.lanes[i]; }); }
+                static Reg mul(Reg a, Reg b) { return lanewise([&] (uint i) { return a.lanes[i] * b.lanes[i]; }); }
+                static Reg div(Reg a, Reg b) { return lanewise([&] (uint i) { return a.lanes[i] / b.lanes[i]; }); }
+                static Reg neg(Reg a) { return lanewise([&] (uint i) { return -a.lanes[i]; }); }
+                static Reg abs(Reg a) { return lanewise([&] (uint i) { return std::abs(a.lanes[i]); }); }
+                static Reg sqrt(Reg a) { return lanewise([&] (uint i) { return std::sqrt(a.lanes[i]); }); }
+
+                // Same operand order as MINPS and MAXPS, which return
+                // the second operand if either is NaN.
+                static float min(float a, float b) { return a < b ? a : b; }
+                static float max(float a, float b) { return a > b ? a : b; }
+                static Reg min(Reg a, Reg b) { return lanewise([&] (uint i) { return min(a.lanes[i], b.lanes[i]); }); }
+                static Reg max(Reg a, Reg b) { return lanewise([&] (uint i) { return max(a.lanes[i], b.lanes[i]); }); }
+
+                static Mask lt(Reg a, Reg b)  { return compare([&] (uint i) { return a.lanes[i] <  b.lanes[i]; }); }
+                static Mask le(Reg a, Reg b)  { return compare([&] (uint i) { return a.lanes[i] <= b.lanes[i]; }); }
+                static Mask eq(Reg a, Reg b)  { return compare([&] (uint i) { return a.lanes[i] == b.lanes[i]; }); }
+                static Mask neq(Reg a, Reg b) { return compare([&] (uint i) { return a.lanes[i] != b.lanes[i]; }); }
+
+                static Reg select(Mask m, Reg a, Reg b)
+                {
+                    return lanewise([&] (uint i) { return m.lanes[i] ? a.lanes[i] : b.lanes[i]; });
+                }
+
+                static Mask maskAnd(Mask a, Mask b) { return compare([&] (uint i) { return a.lanes[i] & b.lanes[i]; }); }
+                static Mask maskOr(Mask a, Mask b)  { return compare([&] (uint i) { return a.lanes[i] | b.lanes[i]; }); }
+                static Mask maskXor(Mask a, Mask b) { return compare([&] (uint i) { return a.lanes[i] ^ b.lanes[i]; }); }
+                static Mask maskNot(Mask a)         { return compare([&] (uint i) { return !a.lanes[i]; }); }
+
+                static uint bits(Mask m)
+                {
+                    uint b = 0;
+                    for (uint i = 0; i < N; ++i) b |= (m.lanes[i] & 1) << i;
+                    return b;
+                }
+
+                // Reductions combine lanes i and i + N/2 until one is left,
+                // which is the order the SIMD versions use.
+                template <typename F>
+                static float reduce(Reg a, F &&f)
+                {
+                    for (uint half = N / 2; half > 0; half /= 2)
+                    {
+                        for (uint i = 0; i < half; ++i)
+                            a.lanes[i] = f(a.lanes[i], a.lanes[i + half]);
+                    }
+                    return a.lanes[0];
+                }
+
+                static float horizontalSum(Reg a) { return reduce(a, [] (float x, float y) { return x + y; }); }
+                static float horizontalMin(Reg a) { return reduce(a, [] (float x, float y) { return min(x, y); }); }
+                static float horizontalMax(Reg a) { return reduce(a, [] (float x, float y) { return max(x, y); }); }
+            };
+
+#if XOR_MATH_SIMD
+            struct FloatSse
+            {
+                using Reg  = __m128;
+                using Mask = __m128;
+
+                static Reg load(const float *p) { return _mm_loadu_ps(p); }
+                static void store(float *p, Reg a) { _mm_storeu_ps(p, a); }
+                static Reg set1(float x) { return _mm_set1_ps(x); }
+
+                static Reg add(Reg a, Reg b) { return _mm_add_ps(a, b); }
+                static Reg sub(Reg a, Reg b) { return _mm_sub_ps(a, b); }
+                static Reg mul(Reg a, Reg b) { return _mm_mul_ps(a, b); }
+                static Reg div(Reg a, Reg b) { return _mm_div_ps(a, b); }
+                static Reg neg(Reg a) { return _mm_xor_ps(a, _mm_set1_ps(-0.f)); }
+                static Reg abs(Reg a) { return _mm_andnot_ps(_mm_set1_ps(-0.f), a); }
+                static Reg sqrt(Reg a) { return _mm_sqrt_ps(a); }
+                static Reg min(Reg a, Reg b) { return _mm_min_ps(a, b); }
+                static Reg max(Reg a, Reg b) { return _mm_max_ps(a, b); }
+
+                static Mask lt(Reg a, Reg b)  { return _mm_cmplt_ps(a, b); }
+                static Mask le(Reg a, Reg b)  { return _mm_cmple_ps(a, b); }
+                static Mask eq(Reg a, Reg b)  { return _mm_cmpeq_ps(a, b); }
+                static Mask neq(Reg a, Reg b) { return _mm_cmpneq_ps(a, b); }
+
+                // BLENDVPS needs SSE4.1, but masks are all ones or all zeros
+                // per lane, so plain SSE bit operations give the same result.
+                static Reg select(Mask m, Reg a, Reg b) { return _mm_or_ps(_mm_and_ps(m, a), _mm_andnot_ps(m, b)); }
+
+                static Mask maskAnd(Mask a, Mask b) { return _mm_and_ps(a, b); }
+                static Mask maskOr(Mask a, Mask b)  { return _mm_or_ps(a, b); }
+                static Mask maskXor(Mask a, Mask b) { return _mm_xor_ps(a, b); }
+                static Mask maskNot(Mask a) { return _mm_xor_ps(a, _mm_castsi128_ps(_mm_set1_epi32(-1))); }
+
+                static uint bits(Mask m) { return static_cast<uint>(_mm_movemask_ps(m)); }
+
+                template <typename F>
+                static float reduce(Reg a, F &&f)
+                {
+                    a = f(a, _mm_movehl_ps(a, a));
+                    a = f(a, _mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 1, 1, 1)));
+                    return _mm_cvtss_f32(a);
+                }
+
+                static float horizontalSum(Reg a) { return reduce(a, [] (Reg x, Reg y) { return add(x, y); }); }
+                static float horizontalMin(Reg a) { return reduce(a, [] (Reg x, Reg y) { return min(x, y); }); }
+                static float horizontalMax(Reg a) { return reduce(a, [] (Reg x, Reg y) { return max(x, y); }); }
+            };
+#endif
+
+#if XOR_MATH_SIMD >= 2
+            struct FloatAvx
+            {
+                using Reg  = __m256;
+                using Mask = __m256;
+
+                static Reg load(const float *p) { return _mm256_loadu_ps(p); }
+                static void store(float *p, Reg a) { _mm256_storeu_ps(p, a); }
+                static Reg set1(float x) { return _mm256_set1_ps(x); }
+
+                static Reg add(Reg a, Reg b) { return _mm256_add_ps(a, b); }
+                static Reg sub(Reg a, Reg b) { return _mm256_sub_ps(a, b); }
+                static Reg mul(Reg a, Reg b) { return _mm256_mul_ps(a, b); }
+                static Reg div(Reg a, Reg b) { return _mm256_div_ps(a, b); }
+                static Reg neg(Reg a) { return _mm256_xor_ps(a, _mm256_set1_ps(-0.f)); }
+                static Reg abs(Reg a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.f), a); }
+                static Reg sqrt(Reg a) { return _mm256_sqrt_ps(a); }
+                static Reg min(Reg a, Reg b) { return _mm256_min_ps(a, b); }
+                static Reg max(Reg a, Reg b) { return _mm256_max_ps(a, b); }
+
+                static Mask lt(Reg a, Reg b)  { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+                static Mask le(Reg a, Reg b)  { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+                static Mask eq(Reg a, Reg b)  { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+                static Mask neq(Reg a, Reg b) { return _mm256_cmp_ps(a, b, _CMP_NEQ_UQ); }
+
+                static Reg select(Mask m, Reg a, Reg b) { return _mm256_blendv_ps(b, a, m); }
+
+                static Mask maskAnd(Mask a, Mask b) { return _mm256_and_ps(a, b); }
+                static Mask maskOr(Mask a, Mask b)  { return _mm256_or_ps(a, b); }
+                static Mask maskXor(Mask a, Mask b) { return _mm256_xor_ps(a, b); }
+                static Mask maskNot(Mask a) { return _mm256_xor_ps(a, _mm256_castsi256_ps(_mm256_set1_epi32(-1))); }
+
+                static uint bits(Mask m) { return static_cast<uint>(_mm256_movemask_ps(m)); }
+
+                static __m128 low(Reg a)  { return _mm256_castps256_ps128(a); }
+                static __m128 high(Reg a) { return _mm256_extractf128_ps(a, 1); }
+
+                static float horizontalSum(Reg a) { return FloatSse::horizontalSum(_mm_add_ps(low(a), high(a))); }
+                static float horizontalMin(Reg a) { return FloatSse::horizontalMin(_mm_min_ps(low(a), high(a))); }
+                static float horizontalMax(Reg a) { return FloatSse::horizontalMax(_mm_max_ps(low(a), high(a))); }
+            };
+#endif
+
+            template <uint N> struct FloatBackend { using Type = FloatScalar<N>; };
+#if XOR_MATH_SIMD
+            template <> struct FloatBackend<4> { using Type = FloatSse; };
+#endif
+#if XOR_MATH_SIMD >= 2
+            template <> struct FloatBackend<8> { using Type = FloatAvx; };
+#endif
+        }
+
+        // One bit per lane, as returned by packet comparisons.
+        template <uint N>
+        struct PacketMask
+        {
+            using Backend = typename packet_detail::FloatBackend<N>::Type;
+            using Reg     = typename Backend::Mask;
+
+            Reg reg;
+
+            PacketMask() = default;
+            explicit PacketMask(Reg reg) : reg(reg) {}
+
+            // Bit i is set if lane i is set.
+            uint bits() const { return Backend::bits(reg); }
+
+            PacketMask operator~() const { return PacketMask(Backend::maskNot(reg)); }
+
+            friend PacketMask operator&(PacketMask a, PacketMask b) { return PacketMask(Backend::maskAnd(a.reg, b.reg)); }
+            friend PacketMask operator|(PacketMask a, PacketMask b) { return PacketMask(Backend::maskOr(a.reg, b.reg)); }
+            friend PacketMask operator^(PacketMask a, PacketMask b) { return PacketMask(Backend::maskXor(a.reg, b.reg)); }
+        };
+
+        template <uint N> inline bool any(PacketMask<N> m)  { return m.bits() != 0; }
+        template <uint N> inline bool all(PacketMask<N> m)  { return m.bits() == (1u << N) - 1; }
+        template <uint N> inline bool none(PacketMask<N> m) { return m.bits() == 0; }
+
+        template <uint N>
+        struct Packet<float, N>
+        {
+            using Backend = typename packet_detail::FloatBackend<N>::Type;
+            using Reg     = typename Backend::Reg;
+            using Mask    = PacketMask<N>;
+
+            static const uint Width = N;
+
+            Reg reg;
+
+            Packet() = default;
+            // Broadcast the same value to every lane.
+            Packet(float x) : reg(Backend::set1(x)) {}
+            explicit Packet(Reg reg) : reg(reg) {}
+
+            // Load and store N consecutive floats, which need not be aligned.
+            static Packet load(const float *p) { return Packet(Backend::load(p)); }
+            void store(float *p) const { Backend::store(p, reg); }
+
+            float operator[](uint i) const
+            {
+                float lanes[N];
+                store(lanes);
+                return lanes[i];
+            }
+
+            Packet operator-() const { return Packet(Backend::neg(reg)); }
+
+            friend Packet operator+(Packet a, Packet b) { return Packet(Backend::add(a.reg, b.reg)); }
+            friend Packet operator-(Packet a, Packet b) { return Packet(Backend::sub(a.reg, b.reg)); }
+            friend Packet operator*(Packet a, Packet b) { return Packet(Backend::mul(a.reg, b.reg)); }
+            friend Packet operator/(Packet a, Packet b) { return Packet(Backend::div(a.reg, b.reg)); }
+
+            friend Mask operator<(Packet a, Packet b)  { return Mask(Backend::lt(a.reg, b.reg)); }
+            friend Mask operator>(Packet a, Packet b)  { return Mask(Backend::lt(b.reg, a.reg)); }
+            friend Mask operator<=(Packet a, Packet b) { return Mask(Backend::le(a.reg, b.reg)); }
+            friend Mask operator>=(Packet a, Packet b) { return Mask(Backend::le(b.reg, a.reg)); }
+            friend Mask operator==(Packet a, Packet b) { return Mask(Backend::eq(a.reg, b.reg)); }
+            friend Mask operator!=(Packet a, Packet b) { return Mask(Backend::neq(a.reg, b.reg)); }
+
+            // Only found through ADL, so these don't hide the float
+            // versions from code in this namespace.
+            friend Packet min(Packet a, Packet b) { return Packet(Backend::min(a.reg, b.reg)); }
+            friend Packet max(Packet a, Packet b) { return Packet(Backend::max(a.reg, b.reg)); }
+            friend Packet abs(Packet a)  { return Packet(Backend::abs(a.reg)); }
+            friend Packet sqrt(Packet a) { return Packet(Backend::sqrt(a.reg)); }
+        };
+
+        // Lanes where the mask is set come from a, the rest from b.
+        template <uint N>
+        inline Packet<float, N> select(PacketMask<N> m, Packet<float, N> a, Packet<float, N> b)
+        {
+            using Backend = typename Packet<float, N>::Backend;
+            return Packet<float, N>(Backend::select(m.reg, a.reg, b.reg));
+        }
+
+        template <uint N>
+        inline float horizontalSum(Packet<float, N> a)
+        {
+            return Packet<float, N>::Backend::horizontalSum(a.reg);
+        }
+
+        template <uint N>
+        inline float horizontalMin(Packet<float, N> a)
+        {
+            return Packet<float, N>::Backend::horizontalMin(a.reg);
+        }
+
+        template <uint N>
+        inline float horizontalMax(Packet<float, N> a)
+        {
+            return Packet<float, N>::Backend::horizontalMax(a.reg);
+        }
+
+        // N three-component vectors in SoA layout, so that each component
+        // is a packet. Not to be confused with float3x3, which is a matrix.
+        template <typename T, uint N>
+        struct Packet3
+        {
+            using Elem = Packet<T, N>;
+
+            Elem x;
+            Elem y;
+            Elem z;
+
+            Packet3() = default;
+            Packet3(Elem x, Elem y, Elem z) : x(x), y(y), z(z) {}
+            // Broadcast the same vector to every lane.
+            Packet3(Vector<T, 3> v) : x(v.x), y(v.y), z(v.z) {}
+
+            static Packet3 load(const T *x, const T *y, const T *z)
+            {
+                return Packet3(Elem::load(x), Elem::load(y), Elem::load(z));
+            }
+
+            void store(T *x, T *y, T *z) const
+            {
+                this->x.store(x);
+                this->y.store(y);
+                this->z.store(z);
+            }
+
+            // Transpose N consecutive vectors into the lanes.
+            static Packet3 load(const Vector<T, 3> *v)
+            {
+                T lanes[3][N];
+                for (uint i = 0; i < N; ++i)
+                {
+                    lanes[0][i] = v[i].x;
+                    lanes[1][i] = v[i].y;
+                    lanes[2][i] = v[i].z;
+                }
+                return load(lanes[0], lanes[1], lanes[2]);
+            }
+
+            Vector<T, 3> operator[](uint i) const
+            {
+                return Vector<T, 3>(x[i], y[i], z[i]);
+            }
+
+            Packet3 operator-() const { return Packet3(-x, -y, -z); }
+
+            friend Packet3 operator+(const Packet3 &a, const Packet3 &b) { return Packet3(a.x + b.x, a.y + b.y, a.z + b.z); }
+            friend Packet3 operator-(const Packet3 &a, const Packet3 &b) { return Packet3(a.x - b.x, a.y - b.y, a.z - b.z); }
+            friend Packet3 operator*(const Packet3 &a, const Packet3 &b) { return Packet3(a.x * b.x, a.y * b.y, a.z * b.z); }
+            friend Packet3 operator*(const Packet3 &a, Elem k) { return Packet3(a.x * k, a.y * k, a.z * k); }
+            friend Packet3 operator*(Elem k, const Packet3 &a) { return Packet3(k * a.x, k * a.y, k * a.z); }
+            friend Packet3 operator/(const Packet3 &a, Elem k) { return Packet3(a.x / k, a.y / k, a.z / k); }
+        };
+
+        using float3x4 = Packet3<float, 4>;
+        using float3x8 = Packet3<float, 8>;
+
+        // Same operation order as the float3 versions, so each lane gets
+        // the same result as the scalar code would.
+        template <uint N>
+        inline Packet<float, N> dot(const Packet3<float, N> &a, const Packet3<float, N> &b)
+        {
+            return a.x * b.x + a.y * b.y + a.z * b.z;
+        }
+
+        template <uint N>
+        inline Packet3<float, N> cross(const Packet3<float, N> &a, const Packet3<float, N> &b)
+        {
+            return Packet3<float, N>(
+                a.y * b.z - a.z * b.y,
+                a.z * b.x - a.x * b.z,
+                a.x * b.y - a.y * b.x);
+        }
+
+        template <uint N>
+        inline Packet<float, N> lengthSqr(const Packet3<float, N> &a)
+        {
+            return dot(a, a);
+        }
+
+        template <uint N>
+        inline Packet<float, N> length(const Packet3<float, N> &a)
+        {
+            return sqrt(lengthSqr(a));
+        }
+
+        template <uint N>
+        inline Packet3<float, N> normalize(const Packet3<float, N> &a)
+        {
+            return a / length(a);
+        }
+    }
+
+    using Xor::math::Packet;
+    using Xor::math::PacketMask;
+    using Xor::math::Packet3;
+    using Xor::math::NativePacketWidth;
+
+    // N quadratic equations of the form ax^2 + bx + c == 0, solved at once.
+    template <uint N>
+    struct QuadraticPacket
+    {
+        using Elem = Packet<float, N>;
+
+        Elem a = 0;
+        Elem b = 0;
+        Elem c = 0;
+
+        QuadraticPacket() = default;
+        QuadraticPacket(Elem a, Elem b, Elem c) : a(a), b(b), c(c) {}
+
+        Elem discriminant() const
+        {
+            return b*b - 4*a*c;
+        }
+
+        // Unlike Quadratic::Roots, a single root is returned twice.
+        // The roots of lanes without any are undefined.
+        struct Roots
+        {
+            Elem x0;
+            Elem x1;
+            PacketMask<N> hasRoots;
+        };
+
+        Roots solve() const
+        {
+            Elem D  = discriminant();
+            Elem d  = sqrt(D);
+            Elem a2 = 2 * a;
+
+            Roots roots;
+            roots.x0       = (-b + d) / a2;
+            roots.x1       = (-b - d) / a2;
+            roots.hasRoots = D >= 0;
+            return roots;
+        }
+    };
+
+    template <uint N>
+    inline Packet3<float, N> interpolateBarycentric(float3 a, float3 b, float3 c, const Packet3<float, N> &bary)
+    {
+        return Packet3<float, N>(a) * bary.x
+            +  Packet3<float, N>(b) * bary.y
+            +  Packet3<float, N>(c) * bary.z;
+    }
+
+    template <uint N>
+    inline Packet<float, N> interpolateBarycentric(float a, float b, float c, const Packet3<float, N> &bary)
+    {
+        return a * bary.x
+            +  b * bary.y
+            +  c * bary.z;
+    }
+
+    template <uint N>
+    inline Packet3<float, N> uniformBarycentric(Packet<float, N> r1, Packet<float, N> r2)
+    {
+        Packet<float, N> sr1 = sqrt(r1);
+        return Packet3<float, N>(1 - sr1, sr1 * (1 - r2), r2 * sr1);
+    }
+}
+
+using Xor::math::float3x4;
+using Xor::math::float3x8;
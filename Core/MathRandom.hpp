@@ -6,6 +6,7 @@
 #include "MathRandomXoroshiro128p.hpp"
 
 #include <random>
+#include <cstring>
 
 namespace Xor
 {
@@ -28,6 +29,234 @@ namespace Xor
         return f * RandomGenCoeff;
     }
 
+    namespace random_detail
+    {
+        // Operations for advancing Streams xoroshiro128+ generators at once,
+        // with their states in one register per state word.
+        struct Scalar
+        {
+            static constexpr uint Streams = 1;
+            using Int = uint64_t;
+
+            static Int load(const uint64_t *p) { return *p; }
+            static void store(uint64_t *p, Int a) { *p = a; }
+            static Int add(Int a, Int b) { return a + b; }
+            static Int bitXor(Int a, Int b) { return a ^ b; }
+            template <int K> static Int shl(Int a) { return a << K; }
+            template <int K> static Int shr(Int a) { return a >> K; }
+
+            static void storeFloats(float *dst, Int a)
+            {
+                dst[0] = floatFromBits(uint32_t(a));
+                dst[1] = floatFromBits(uint32_t(a >> 32));
+            }
+
+            // The top 23 bits as the mantissa of a float in [1, 2),
+            // moved to [0, 1). The subtraction is exact.
+            static float floatFromBits(uint32_t bits)
+            {
+                uint32_t one = (bits >> 9) | 0x3f800000;
+                float f;
+                memcpy(&f, &one, sizeof(f));
+                return f - 1.f;
+            }
+        };
+
+#if XOR_MATH_SIMD
+        struct Sse
+        {
+            static constexpr uint Streams = 2;
+            using Int = __m128i;
+
+            static Int load(const uint64_t *p) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)); }
+            static void store(uint64_t *p, Int a) { _mm_storeu_si128(reinterpret_cast<__m128i *>(p), a); }
+            static Int add(Int a, Int b) { return _mm_add_epi64(a, b); }
+            static Int bitXor(Int a, Int b) { return _mm_xor_si128(a, b); }
+            template <int K> static Int shl(Int a) { return _mm_slli_epi64(a, K); }
+            template <int K> static Int shr(Int a) { return _mm_srli_epi64(a, K); }
+
+            static void storeFloats(float *dst, Int a)
+            {
+                __m128i one = _mm_or_si128(_mm_srli_epi32(a, 9), _mm_set1_epi32(0x3f800000));
+                _mm_storeu_ps(dst, _mm_sub_ps(_mm_castsi128_ps(one), _mm_set1_ps(1.f)));
+            }
+        };
+
+        // MSVC accepts AVX2 intrinsics without /arch:AVX2, so this is
+        // compiled with Sse and only used if cpuSupportsAVX2().
+        struct Avx2
+        {
+            static constexpr uint Streams = 4;
+            using Int = __m256i;
+
+            static Int load(const uint64_t *p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)); }
+            static void store(uint64_t *p, Int a) { _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), a); }
+            static Int add(Int a, Int b) { return _mm256_add_epi64(a, b); }
+            static Int bitXor(Int a, Int b) { return _mm256_xor_si256(a, b); }
+            template <int K> static Int shl(Int a) { return _mm256_slli_epi64(a, K); }
+            template <int K> static Int shr(Int a) { return _mm256_srli_epi64(a, K); }
+
+            static void storeFloats(float *dst, Int a)
+            {
+                __m256i one = _mm256_or_si256(_mm256_srli_epi32(a, 9), _mm256_set1_epi32(0x3f800000));
+                _mm256_storeu_ps(dst, _mm256_sub_ps(_mm256_castsi256_ps(one), _mm256_set1_ps(1.f)));
+            }
+        };
+#endif
+
+        // Same operations as Random::next().
+        template <typename B>
+        inline typename B::Int next(typename B::Int &s0, typename B::Int &s1)
+        {
+            auto result = B::add(s0, s1);
+
+            s1 = B::bitXor(s1, s0);
+            auto rotl55 = B::bitXor(B::template shl<55>(s0), B::template shr<9>(s0));
+            s0 = B::bitXor(B::bitXor(rotl55, s1), B::template shl<14>(s1));
+            s1 = B::bitXor(B::template shl<36>(s1), B::template shr<28>(s1));
+
+            return result;
+        }
+    }
+
+    // N independent xoroshiro128+ generators that are advanced together,
+    // several streams per instruction when SIMD is available, with AVX2
+    // chosen at runtime if the CPU has it. Stream i
+    // starts where the given generator would be after i calls to jump(),
+    // so the streams do not overlap. Giving each thread or tile its own
+    // RandomStreams made from one generator, with a call to longJump()
+    // between them, keeps all of their streams apart.
+    template <unsigned N>
+    class RandomStreams
+    {
+        static_assert(N % 4 == 0, "Stream count must be a multiple of 4");
+
+        uint64_t m_s0[N];
+        uint64_t m_s1[N];
+    public:
+        static constexpr uint Streams = N;
+        // Every round of fillUniformFloat() makes this many floats, so
+        // filling in multiples of it wastes no output.
+        static constexpr uint FloatsPerRound = 2 * N;
+
+        explicit RandomStreams(Random gen = Random())
+        {
+            for (uint i = 0; i < N; ++i)
+            {
+                m_s0[i] = gen.s[0];
+                m_s1[i] = gen.s[1];
+                gen.jump();
+            }
+        }
+
+        // The generator for stream i in its current state.
+        Random stream(uint i) const
+        {
+            return Random(m_s0[i], m_s1[i]);
+        }
+
+        // Advance every stream once, and write result i of stream i.
+        void next(uint64_t (&results)[N])
+        {
+#if XOR_MATH_SIMD
+            if (cpuSupportsAVX2())
+                advance<random_detail::Avx2>(results);
+            else
+                advance<random_detail::Sse>(results);
+#else
+            advance<random_detail::Scalar>(results);
+#endif
+        }
+
+        // Advance every stream by 2^96 steps, like Random::longJump().
+        void longJump()
+        {
+            for (uint i = 0; i < N; ++i)
+            {
+                Random gen = stream(i);
+                gen.longJump();
+                m_s0[i] = gen.s[0];
+                m_s1[i] = gen.s[1];
+            }
+        }
+
+        // Fill the span with floats in [0, 1) with 23 random bits each. Every
+        // round advances all streams once and makes the two floats from the
+        // low and high halves of each result, in stream order. The results
+        // do not depend on the instruction set. If the size is not a multiple
+        // of FloatsPerRound, the rest of the last round is thrown away.
+        void fillUniformFloat(Span<float> floats)
+        {
+#if XOR_MATH_SIMD
+            if (cpuSupportsAVX2())
+                fill<random_detail::Avx2>(floats);
+            else
+                fill<random_detail::Sse>(floats);
+#else
+            fill<random_detail::Scalar>(floats);
+#endif
+        }
+
+    private:
+        template <typename B>
+        void advance(uint64_t (&results)[N])
+        {
+            static constexpr uint Registers = N / B::Streams;
+
+            for (uint r = 0; r < Registers; ++r)
+            {
+                uint i = r * B::Streams;
+                auto s0 = B::load(m_s0 + i);
+                auto s1 = B::load(m_s1 + i);
+                B::store(results + i, random_detail::next<B>(s0, s1));
+                B::store(m_s0 + i, s0);
+                B::store(m_s1 + i, s1);
+            }
+        }
+
+        template <typename B>
+        void fill(Span<float> floats)
+        {
+            static constexpr uint Registers = N / B::Streams;
+
+            typename B::Int s0[Registers];
+            typename B::Int s1[Registers];
+            for (uint r = 0; r < Registers; ++r)
+            {
+                s0[r] = B::load(m_s0 + r * B::Streams);
+                s1[r] = B::load(m_s1 + r * B::Streams);
+            }
+
+            auto round = [&] (float *dst)
+            {
+                for (uint r = 0; r < Registers; ++r)
+                    B::storeFloats(dst + r * 2 * B::Streams, random_detail::next<B>(s0[r], s1[r]));
+            };
+
+            float *dst   = floats.data();
+            size_t size  = floats.size();
+            size_t i     = 0;
+            for (; i + FloatsPerRound <= size; i += FloatsPerRound)
+                round(dst + i);
+
+            if (i < size)
+            {
+                float last[FloatsPerRound];
+                round(last);
+                memcpy(dst + i, last, (size - i) * sizeof(float));
+            }
+
+            for (uint r = 0; r < Registers; ++r)
+            {
+                B::store(m_s0 + r * B::Streams, s0[r]);
+                B::store(m_s1 + r * B::Streams, s1[r]);
+            }
+        }
+    };
+
+    using Random4 = RandomStreams<4>;
+    using Random8 = RandomStreams<8>;
+
     inline float3 uniformBarycentric(float2 u)
     {
         float r1  = u.x;
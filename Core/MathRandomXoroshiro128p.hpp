@@ -40,6 +40,8 @@ See <http://creativecommons.org/publicdomain/zero/1.0/>. */
 
 namespace Xor
 {
+    template <unsigned N> class RandomStreams;
+
     constexpr uint64_t DefaultRandomSeed0 = 39529057;
     constexpr uint64_t DefaultRandomSeed1 = 61768894;
 
@@ -99,12 +101,28 @@ namespace Xor
            non-overlapping subsequences for parallel computations. */
         void jump(void) {
             static const uint64_t JUMP[] = { 0xbeac0467eba5facb, 0xd86b048b86aa9922 };
+            jumpPolynomial(JUMP);
+        }
+
+        // Equivalent to 2^96 calls to next(). It can be used to give 2^32
+        // starting points, each of which can be split further with jump().
+        // The polynomial is x^(2^96) modulo the characteristic polynomial
+        // of this (55, 14, 36) version of the generator, so constants
+        // published for the later (24, 16, 37) version do not apply.
+        void longJump(void) {
+            static const uint64_t LONG_JUMP[] = { 0x18f7c399ccebda8d, 0xf2deac28bef3bb07 };
+            jumpPolynomial(LONG_JUMP);
+        }
 
+    private:
+        template <unsigned N> friend class RandomStreams;
+
+        void jumpPolynomial(const uint64_t (&poly)[2]) {
             uint64_t s0 = 0;
             uint64_t s1 = 0;
-            for (int i = 0; i < sizeof JUMP / sizeof *JUMP; i++)
+            for (int i = 0; i < 2; i++)
                 for (int b = 0; b < 64; b++) {
-                    if (JUMP[i] & UINT64_C(1) << b) {
+                    if (poly[i] & UINT64_C(1) << b) {
                         s0 ^= s[0];
                         s1 ^= s[1];
                     }
@@ -115,7 +133,6 @@ namespace Xor
             s[1] = s1;
         }
 
-    private:
         static inline uint64_t rotl(const uint64_t x, int k) {
             return (x << k) | (x >> (64 - k));
         }
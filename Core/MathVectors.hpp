@@ -7,6 +7,33 @@
 
 #include <cstdint>
 
+// Instruction sets used for float4, int4 and Matrix, chosen at compile
+// time. 0 is plain scalar code, 1 is SSE2, which every x64 CPU has, and
+// 2 also uses AVX where it helps. All of them give bit-identical results.
+#if !defined(XOR_MATH_SIMD)
+#if defined(__AVX__)
+#define XOR_MATH_SIMD 2
+#elif defined(_M_X64) || defined(__SSE2__)
+#define XOR_MATH_SIMD 1
+#else
+#define XOR_MATH_SIMD 0
+#endif
+#endif
+
+// int4 multiplication, min and max need SSE4.1, which MSVC only
+// assumes under /arch:AVX or higher.
+#if !defined(XOR_MATH_SSE41)
+#if XOR_MATH_SIMD && (defined(__SSE4_1__) || defined(__AVX__))
+#define XOR_MATH_SSE41 1
+#else
+#define XOR_MATH_SSE41 0
+#endif
+#endif
+
+#if XOR_MATH_SIMD
+#include <immintrin.h>
+#endif
+
 namespace Xor
 {
     namespace math
@@ -30,6 +57,14 @@ namespace Xor
         }
 
         template <typename T, uint N> struct VectorBase;
+        template <typename T, uint N> struct Vector;
+
+        namespace vector_detail
+        {
+            // Elementwise arithmetic of vectors, which is specialized
+            // for SIMD after Vector has been defined.
+            template <typename T, uint N> struct Ops;
+        }
 
         template <typename T>
         struct VectorBase<T, 2>
@@ -129,30 +164,22 @@ namespace Xor
 
             friend Vector operator+(Vector a, Vector b)
             {
-                Vector c;
-                for (uint i = 0; i < N; ++i) c[i] = a[i] + b[i];
-                return c;
+                return vector_detail::Ops<T, N>::add(a, b);
             }
 
             friend Vector operator-(Vector a, Vector b)
             {
-                Vector c;
-                for (uint i = 0; i < N; ++i) c[i] = a[i] - b[i];
-                return c;
+                return vector_detail::Ops<T, N>::sub(a, b);
             }
 
             friend Vector operator*(Vector a, Vector b)
             {
-                Vector c;
-                for (uint i = 0; i < N; ++i) c[i] = a[i] * b[i];
-                return c;
+                return vector_detail::Ops<T, N>::mul(a, b);
             }
 
             friend Vector operator/(Vector a, Vector b)
             {
-                Vector c;
-                for (uint i = 0; i < N; ++i) c[i] = a[i] / b[i];
-                return c;
+                return vector_detail::Ops<T, N>::div(a, b);
             }
 
             friend Vector operator%(Vector a, Vector b)
@@ -352,6 +379,149 @@ namespace Xor
         using bool3 = Vector<bool, 3>;
         using bool4 = Vector<bool, 4>;
 
+        namespace vector_detail
+        {
+            template <typename T, uint N>
+            struct ScalarOps
+            {
+                using V = Vector<T, N>;
+
+                static V add(V a, V b) { V c; for (uint i = 0; i < N; ++i) c[i] = a[i] + b[i]; return c; }
+                static V sub(V a, V b) { V c; for (uint i = 0; i < N; ++i) c[i] = a[i] - b[i]; return c; }
+                static V mul(V a, V b) { V c; for (uint i = 0; i < N; ++i) c[i] = a[i] * b[i]; return c; }
+                static V div(V a, V b) { V c; for (uint i = 0; i < N; ++i) c[i] = a[i] / b[i]; return c; }
+                static V min(V a, V b) { V c; for (uint i = 0; i < N; ++i) c[i] = std::min(a[i], b[i]); return c; }
+                static V max(V a, V b) { V c; for (uint i = 0; i < N; ++i) c[i] = std::max(a[i], b[i]); return c; }
+            };
+
+            template <typename T, uint N>
+            struct Ops : ScalarOps<T, N> {};
+
+            // Operations on float4 kept in registers, which the Matrix
+            // functions are written with. Every operation is done the same
+            // way for every lane in every implementation, so the results
+            // only depend on the order of operations in the caller.
+            struct Float4Scalar
+            {
+                using Reg = Vector<float, 4>;
+
+                static Reg load(const Vector<float, 4> &v) { return v; }
+                static Vector<float, 4> store(Reg a) { return a; }
+                static Reg zero() { return Reg(0.f); }
+
+                static Reg add(Reg a, Reg b) { return ScalarOps<float, 4>::add(a, b); }
+                static Reg sub(Reg a, Reg b) { return ScalarOps<float, 4>::sub(a, b); }
+                static Reg mul(Reg a, Reg b) { return ScalarOps<float, 4>::mul(a, b); }
+                static Reg div(Reg a, Reg b) { return ScalarOps<float, 4>::div(a, b); }
+                static Reg min(Reg a, Reg b) { return ScalarOps<float, 4>::min(a, b); }
+                static Reg max(Reg a, Reg b) { return ScalarOps<float, 4>::max(a, b); }
+
+                template <uint I>
+                static Reg splat(Reg a) { return Reg(a[I]); }
+
+                // (a[X], a[Y], b[Z], b[W]) like _mm_shuffle_ps
+                template <uint X, uint Y, uint Z, uint W>
+                static Reg shuffle(Reg a, Reg b) { return Reg(a[X], a[Y], b[Z], b[W]); }
+
+                // (a0 + a1) + (a2 + a3) in every lane
+                static Reg horizontalSum(Reg a) { return Reg((a[0] + a[1]) + (a[2] + a[3])); }
+
+                static void transpose(Reg &r0, Reg &r1, Reg &r2, Reg &r3)
+                {
+                    Reg t0(r0[0], r1[0], r2[0], r3[0]);
+                    Reg t1(r0[1], r1[1], r2[1], r3[1]);
+                    Reg t2(r0[2], r1[2], r2[2], r3[2]);
+                    Reg t3(r0[3], r1[3], r2[3], r3[3]);
+                    r0 = t0; r1 = t1; r2 = t2; r3 = t3;
+                }
+            };
+
+#if XOR_MATH_SIMD
+            struct Float4Sse
+            {
+                using Reg = __m128;
+
+                static Reg load(const Vector<float, 4> &v) { return _mm_loadu_ps(v.data()); }
+                static Vector<float, 4> store(Reg a) { Vector<float, 4> v; _mm_storeu_ps(v.data(), a); return v; }
+                static Reg zero() { return _mm_setzero_ps(); }
+
+                static Reg add(Reg a, Reg b) { return _mm_add_ps(a, b); }
+                static Reg sub(Reg a, Reg b) { return _mm_sub_ps(a, b); }
+                static Reg mul(Reg a, Reg b) { return _mm_mul_ps(a, b); }
+                static Reg div(Reg a, Reg b) { return _mm_div_ps(a, b); }
+                // std::min(a, b) is b < a ? b : a, and MINPS returns
+                // its second operand unless the first is smaller.
+                static Reg min(Reg a, Reg b) { return _mm_min_ps(b, a); }
+                static Reg max(Reg a, Reg b) { return _mm_max_ps(b, a); }
+
+                template <uint I>
+                static Reg splat(Reg a) { return _mm_shuffle_ps(a, a, _MM_SHUFFLE(I, I, I, I)); }
+
+                template <uint X, uint Y, uint Z, uint W>
+                static Reg shuffle(Reg a, Reg b) { return _mm_shuffle_ps(a, b, _MM_SHUFFLE(W, Z, Y, X)); }
+
+                static Reg horizontalSum(Reg a)
+                {
+                    Reg pairs = _mm_add_ps(a, shuffle<1, 0, 3, 2>(a, a));
+                    return _mm_add_ps(pairs, shuffle<2, 3, 0, 1>(pairs, pairs));
+                }
+
+                static void transpose(Reg &r0, Reg &r1, Reg &r2, Reg &r3)
+                {
+                    _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+                }
+            };
+
+            // Same as SSE for single float4s, but Matrix functions that
+            // process two rows at once are specialized for it.
+            struct Float4Avx : Float4Sse {};
+
+#if XOR_MATH_SSE41
+            struct Int4Sse
+            {
+                using V = Vector<int, 4>;
+
+                static __m128i load(const V &v) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(v.data())); }
+                static V store(__m128i a) { V v; _mm_storeu_si128(reinterpret_cast<__m128i *>(v.data()), a); return v; }
+
+                static V add(V a, V b) { return store(_mm_add_epi32(load(a), load(b))); }
+                static V sub(V a, V b) { return store(_mm_sub_epi32(load(a), load(b))); }
+                static V mul(V a, V b) { return store(_mm_mullo_epi32(load(a), load(b))); }
+                static V div(V a, V b) { return ScalarOps<int, 4>::div(a, b); }
+                static V min(V a, V b) { return store(_mm_min_epi32(load(a), load(b))); }
+                static V max(V a, V b) { return store(_mm_max_epi32(load(a), load(b))); }
+            };
+#endif
+
+#if XOR_MATH_SIMD >= 2
+            using Float4Native = Float4Avx;
+#else
+            using Float4Native = Float4Sse;
+#endif
+
+            template <>
+            struct Ops<float, 4>
+            {
+                using R = Float4Sse;
+                using V = Vector<float, 4>;
+
+                static V add(V a, V b) { return R::store(R::add(R::load(a), R::load(b))); }
+                static V sub(V a, V b) { return R::store(R::sub(R::load(a), R::load(b))); }
+                static V mul(V a, V b) { return R::store(R::mul(R::load(a), R::load(b))); }
+                static V div(V a, V b) { return R::store(R::div(R::load(a), R::load(b))); }
+                static V min(V a, V b) { return R::store(R::min(R::load(a), R::load(b))); }
+                static V max(V a, V b) { return R::store(R::max(R::load(a), R::load(b))); }
+            };
+
+#if XOR_MATH_SSE41
+            template <>
+            struct Ops<int, 4> : Int4Sse {};
+#endif
+#else
+            using Float4Native = Float4Scalar;
+#endif
+        }
+
         template <uint N>
         inline bool all(Vector<bool, N> a)
         {
@@ -460,17 +630,13 @@ namespace Xor
         template <typename T, uint N>
         Vector<T, N> min(Vector<T, N> a, Vector<T, N> b)
         {
-            Vector<T, N> c;
-            for (uint i = 0; i < N; ++i) c[i] = std::min(a[i], b[i]);
-            return c;
+            return vector_detail::Ops<T, N>::min(a, b);
         }
 
         template <typename T, uint N>
         Vector<T, N> max(Vector<T, N> a, Vector<T, N> b)
         {
-            Vector<T, N> c;
-            for (uint i = 0; i < N; ++i) c[i] = std::max(a[i], b[i]);
-            return c;
+            return vector_detail::Ops<T, N>::max(a, b);
         }
 
         inline float3 cross(float3 a, float3 b)
@@ -530,6 +696,22 @@ namespace Xor
         static const float DefaultDepth0Plane = 100.f;
         static const float DefaultDepth1Plane =    .1f;
 
+        class Matrix;
+
+        namespace matrix_detail
+        {
+            // Implementations of Matrix functions for each
+            // of the register types in vector_detail.
+            template <typename R> Matrix multiply(const Matrix &a, const Matrix &b);
+            template <typename R> Matrix transpose(const Matrix &m);
+            template <typename R> float4 transform(const Matrix &m, float4 v);
+            template <typename R> Matrix inverse(const Matrix &m);
+
+#if XOR_MATH_SIMD >= 2
+            template <> inline Matrix multiply<vector_detail::Float4Avx>(const Matrix &a, const Matrix &b);
+#endif
+        }
+
         class Matrix
         {
             float4 m_rows[4];
@@ -599,7 +781,7 @@ namespace Xor
             }
 
             float4 &row(uint r) { return m_rows[r]; }
-            float4 row(uint r) const { return m_rows[r]; }
+            const float4 &row(uint r) const { return m_rows[r]; }
 
             float &m(uint y, uint x) { return row(y)[x]; }
             float m(uint y, uint x) const { return row(y)[x]; }
@@ -641,12 +823,7 @@ namespace Xor
 
             Matrix transpose() const
             {
-                return Matrix {
-                    {row(0)[0], row(1)[0], row(2)[0], row(3)[0]},
-                    {row(0)[1], row(1)[1], row(2)[1], row(3)[1]},
-                    {row(0)[2], row(1)[2], row(2)[2], row(3)[2]},
-                    {row(0)[3], row(1)[3], row(2)[3], row(3)[3]},
-                };
+                return matrix_detail::transpose<vector_detail::Float4Native>(*this);
             }
 
             float determinant() const;
@@ -654,18 +831,7 @@ namespace Xor
 
             friend inline Matrix operator*(const Matrix &a, const Matrix &b)
             {
-                Matrix m(Matrix::ZeroMatrix {});
-
-                for (uint y = 0; y < 4; ++y)
-                {
-                    for (uint x = 0; x < 4; ++x)
-                    {
-                        for (uint i = 0; i < 4; ++i)
-                            m(y, x) += a.row(y)[i] * b.row(i)[x];
-                    }
-                }
-
-                return m;
+                return matrix_detail::multiply<vector_detail::Float4Native>(a, b);
             }
 
             friend inline Matrix operator+(const Matrix &a, const Matrix &b)
@@ -742,13 +908,7 @@ namespace Xor
 
         inline float4 operator*(const Matrix &m, float4 v)
         {
-            return
-            {
-                dot(m.row(0), v),
-                dot(m.row(1), v),
-                dot(m.row(2), v),
-                dot(m.row(3), v),
-            };
+            return matrix_detail::transform<vector_detail::Float4Native>(m, v);
         }
 
         inline float4 Matrix::transform(float4 v) const
@@ -756,6 +916,185 @@ namespace Xor
             return (*this) * v;
         }
 
+        namespace matrix_detail
+        {
+            // Like the scalar loops that these replaced, every element is
+            // 0 + a0 * b0 + a1 * b1 + a2 * b2 + a3 * b3, added in that order.
+            template <typename R>
+            Matrix multiply(const Matrix &a, const Matrix &b)
+            {
+                using Reg = typename R::Reg;
+
+                Reg b0 = R::load(b.row(0));
+                Reg b1 = R::load(b.row(1));
+                Reg b2 = R::load(b.row(2));
+                Reg b3 = R::load(b.row(3));
+
+                Matrix m = Matrix::zero();
+                for (uint y = 0; y < 4; ++y)
+                {
+                    Reg ay = R::load(a.row(y));
+                    Reg c  = R::zero();
+                    c = R::add(c, R::mul(R::template splat<0>(ay), b0));
+                    c = R::add(c, R::mul(R::template splat<1>(ay), b1));
+                    c = R::add(c, R::mul(R::template splat<2>(ay), b2));
+                    c = R::add(c, R::mul(R::template splat<3>(ay), b3));
+                    m.row(y) = R::store(c);
+                }
+                return m;
+            }
+
+            template <typename R>
+            Matrix transpose(const Matrix &m)
+            {
+                using Reg = typename R::Reg;
+
+                Reg r0 = R::load(m.row(0));
+                Reg r1 = R::load(m.row(1));
+                Reg r2 = R::load(m.row(2));
+                Reg r3 = R::load(m.row(3));
+                R::transpose(r0, r1, r2, r3);
+                return Matrix(R::store(r0), R::store(r1), R::store(r2), R::store(r3));
+            }
+
+            template <typename R>
+            float4 transform(const Matrix &m, float4 v)
+            {
+                using Reg = typename R::Reg;
+
+                Reg c0 = R::load(m.row(0));
+                Reg c1 = R::load(m.row(1));
+                Reg c2 = R::load(m.row(2));
+                Reg c3 = R::load(m.row(3));
+                R::transpose(c0, c1, c2, c3);
+
+                Reg x = R::load(v);
+                Reg c = R::zero();
+                c = R::add(c, R::mul(c0, R::template splat<0>(x)));
+                c = R::add(c, R::mul(c1, R::template splat<1>(x)));
+                c = R::add(c, R::mul(c2, R::template splat<2>(x)));
+                c = R::add(c, R::mul(c3, R::template splat<3>(x)));
+                return R::store(c);
+            }
+
+            // 2x2 matrices are stored in one register as (m00, m01, m10, m11).
+            // Computes a * b.
+            template <typename R>
+            typename R::Reg mat2Mul(typename R::Reg a, typename R::Reg b)
+            {
+                return R::add(R::mul(a, R::template shuffle<0, 3, 0, 3>(b, b)),
+                              R::mul(R::template shuffle<1, 0, 3, 2>(a, a),
+                                     R::template shuffle<2, 1, 2, 1>(b, b)));
+            }
+
+            // Computes adjugate(a) * b.
+            template <typename R>
+            typename R::Reg mat2AdjMul(typename R::Reg a, typename R::Reg b)
+            {
+                return R::sub(R::mul(R::template shuffle<3, 3, 0, 0>(a, a), b),
+                              R::mul(R::template shuffle<1, 1, 2, 2>(a, a),
+                                     R::template shuffle<2, 3, 0, 1>(b, b)));
+            }
+
+            // Computes a * adjugate(b).
+            template <typename R>
+            typename R::Reg mat2MulAdj(typename R::Reg a, typename R::Reg b)
+            {
+                return R::sub(R::mul(a, R::template shuffle<3, 0, 3, 0>(b, b)),
+                              R::mul(R::template shuffle<1, 0, 3, 2>(a, a),
+                                     R::template shuffle<2, 1, 2, 1>(b, b)));
+            }
+
+            // Blockwise inversion with 2x2 submatrices A B / C D,
+            // which only needs operations on whole registers.
+            template <typename R>
+            Matrix inverse(const Matrix &m)
+            {
+                using Reg = typename R::Reg;
+
+                Reg r0 = R::load(m.row(0));
+                Reg r1 = R::load(m.row(1));
+                Reg r2 = R::load(m.row(2));
+                Reg r3 = R::load(m.row(3));
+
+                Reg A = R::template shuffle<0, 1, 0, 1>(r0, r1);
+                Reg B = R::template shuffle<2, 3, 2, 3>(r0, r1);
+                Reg C = R::template shuffle<0, 1, 0, 1>(r2, r3);
+                Reg D = R::template shuffle<2, 3, 2, 3>(r2, r3);
+
+                // Determinants of A, B, C and D
+                Reg detSub = R::sub(
+                    R::mul(R::template shuffle<0, 2, 0, 2>(r0, r2), R::template shuffle<1, 3, 1, 3>(r1, r3)),
+                    R::mul(R::template shuffle<1, 3, 1, 3>(r0, r2), R::template shuffle<0, 2, 0, 2>(r1, r3)));
+                Reg detA = R::template splat<0>(detSub);
+                Reg detB = R::template splat<1>(detSub);
+                Reg detC = R::template splat<2>(detSub);
+                Reg detD = R::template splat<3>(detSub);
+
+                Reg adjDC = mat2AdjMul<R>(D, C);
+                Reg adjAB = mat2AdjMul<R>(A, B);
+
+                Reg X = R::sub(R::mul(detD, A), mat2Mul<R>(B, adjDC));
+                Reg W = R::sub(R::mul(detA, D), mat2Mul<R>(C, adjAB));
+                Reg Y = R::sub(R::mul(detB, C), mat2MulAdj<R>(D, adjAB));
+                Reg Z = R::sub(R::mul(detC, B), mat2MulAdj<R>(A, adjDC));
+
+                // |M| = |A| |D| + |B| |C| - trace(adjugate(A) B adjugate(D) C)
+                Reg detM  = R::add(R::mul(detA, detD), R::mul(detB, detC));
+                Reg trace = R::horizontalSum(R::mul(adjAB, R::template shuffle<0, 2, 1, 3>(adjDC, adjDC)));
+                detM = R::sub(detM, trace);
+
+                Reg invDetM = R::div(R::load(float4(1, -1, -1, 1)), detM);
+                X = R::mul(X, invDetM);
+                Y = R::mul(Y, invDetM);
+                Z = R::mul(Z, invDetM);
+                W = R::mul(W, invDetM);
+
+                // Adjugates of the blocks, put back into rows.
+                return Matrix(R::store(R::template shuffle<3, 1, 3, 1>(X, Y)),
+                              R::store(R::template shuffle<2, 0, 2, 0>(X, Y)),
+                              R::store(R::template shuffle<3, 1, 3, 1>(Z, W)),
+                              R::store(R::template shuffle<2, 0, 2, 0>(Z, W)));
+            }
+
+#if XOR_MATH_SIMD >= 2
+            inline __m256 combine(__m128 low, __m128 high)
+            {
+                return _mm256_insertf128_ps(_mm256_castps128_ps256(low), high, 1);
+            }
+
+            // Two rows at once, in the same order of operations as above.
+            template <>
+            inline Matrix multiply<vector_detail::Float4Avx>(const Matrix &a, const Matrix &b)
+            {
+                using R = vector_detail::Float4Avx;
+
+                __m128 b0 = R::load(b.row(0));
+                __m128 b1 = R::load(b.row(1));
+                __m128 b2 = R::load(b.row(2));
+                __m128 b3 = R::load(b.row(3));
+                __m256 bb0 = combine(b0, b0);
+                __m256 bb1 = combine(b1, b1);
+                __m256 bb2 = combine(b2, b2);
+                __m256 bb3 = combine(b3, b3);
+
+                Matrix m = Matrix::zero();
+                for (uint y = 0; y < 4; y += 2)
+                {
+                    __m256 ay = combine(R::load(a.row(y)), R::load(a.row(y + 1)));
+                    __m256 c  = _mm256_setzero_ps();
+                    c = _mm256_add_ps(c, _mm256_mul_ps(_mm256_permute_ps(ay, 0x00), bb0));
+                    c = _mm256_add_ps(c, _mm256_mul_ps(_mm256_permute_ps(ay, 0x55), bb1));
+                    c = _mm256_add_ps(c, _mm256_mul_ps(_mm256_permute_ps(ay, 0xaa), bb2));
+                    c = _mm256_add_ps(c, _mm256_mul_ps(_mm256_permute_ps(ay, 0xff), bb3));
+                    m.row(y)     = R::store(_mm256_castps256_ps128(c));
+                    m.row(y + 1) = R::store(_mm256_extractf128_ps(c, 1));
+                }
+                return m;
+            }
+#endif
+        }
+
         // Matrix of arbitrary dimensions. Less functionality, more generality.
         // Amount of rows comes first to conform with M-by-N notation.
         template <typename T, uint M, uint N>
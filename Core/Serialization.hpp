@@ -58,6 +58,16 @@ namespace Xor
 
         uint readLength();
 
+        // Return the version number of the struct at the cursor
+        // without reading it.
+        uint peekStructVersion() const
+        {
+            checkBounds(sizeof(uint32_t));
+            uint32_t structHeader;
+            memcpy(&structHeader, m_cursor, sizeof(structHeader));
+            return structHeader >> serialization::StructSizeBits;
+        }
+
         template <typename T>
         T readStruct()
         {
@@ -73,6 +83,15 @@ namespace Xor
             return read<T>();
         }
 
+        // Read raw bytes without a length prefix.
+        Span<const uint8_t> readBytes(size_t bytes)
+        {
+            checkBounds(bytes);
+            Span<const uint8_t> span(m_cursor, bytes);
+            m_cursor += bytes;
+            return span;
+        }
+
         Span<const uint8_t> readBlob();
         StringView readString();
     };
@@ -143,6 +162,14 @@ namespace Xor
             write(value);
         }
 
+        // Write raw bytes without a length prefix.
+        void writeBytes(Span<const uint8_t> bytes)
+        {
+            ensureSpace(bytes.sizeBytes());
+            memcpy(cursor(), bytes.data(), bytes.sizeBytes());
+            m_cursor += bytes.sizeBytes();
+        }
+
         void writeBlob(Span<const uint8_t> bytes)
         {
             uint length = static_cast<uint>(bytes.sizeBytes());
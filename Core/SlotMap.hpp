@@ -0,0 +1,468 @@
+#pragma once
+
+#include "Utils.hpp"
+#include "Error.hpp"
+
+#include <vector>
+#include <memory>
+#include <thread>
+#include <type_traits>
+
+// Handle classes like Mesh and Material keep their State in a StatePtr.
+// It is a std::shared_ptr unless this is defined as 1, in which case
+// the states of each type are kept in a StableSlotMap instead.
+#if !defined(XOR_SLOTMAP_STATES)
+#define XOR_SLOTMAP_STATES 0
+#endif
+
+namespace Xor
+{
+    // Refers to an object in a SlotMap. Handles stay valid until
+    // their object is erased, after which they can be detected as stale.
+    struct SlotMapHandle
+    {
+        uint32_t index      = ~0U;
+        uint32_t generation = 0;
+
+        bool valid() const { return index != ~0U; }
+        explicit operator bool() const { return valid(); }
+
+        bool operator==(SlotMapHandle h) const { return index == h.index && generation == h.generation; }
+        bool operator!=(SlotMapHandle h) const { return !operator==(h); }
+    };
+
+    // The part of the slot maps that does not depend on the object type, so
+    // that SlotMapRef can be copied and destroyed with an incomplete type.
+    // Slot maps are not thread-safe. A map is owned by the thread that
+    // created it, and only that thread may insert, erase, retain or release.
+    class SlotMapBase
+    {
+    protected:
+        static const uint32_t InvalidIndex = ~0U;
+
+        struct Slot
+        {
+            // Index of the object if the slot is in use,
+            // and index of the next free slot otherwise.
+            uint32_t index      = InvalidIndex;
+            // Incremented whenever the slot is freed, so stale handles
+            // never match.
+            uint32_t generation = 0;
+            // Number of SlotMapRefs referring to the object.
+            uint32_t references = 0;
+            bool     used       = false;
+        };
+
+        std::vector<Slot> m_slots;
+        uint32_t          m_freeSlot = InvalidIndex;
+        std::thread::id   m_owner    = std::this_thread::get_id();
+
+        void checkOwner() const
+        {
+            XOR_ASSERT(m_owner == std::this_thread::get_id(),
+                       "SlotMap used by a thread that does not own it");
+        }
+
+        SlotMapHandle allocateSlot(uint32_t objectIndex)
+        {
+            checkOwner();
+
+            uint32_t s;
+            if (m_freeSlot != InvalidIndex)
+            {
+                s = m_freeSlot;
+                m_freeSlot = m_slots[s].index;
+            }
+            else
+            {
+                XOR_CHECK(m_slots.size() < InvalidIndex, "Too many objects in the SlotMap");
+                s = static_cast<uint32_t>(m_slots.size());
+                m_slots.emplace_back();
+            }
+
+            auto &slot      = m_slots[s];
+            slot.index      = objectIndex;
+            slot.references = 0;
+            slot.used       = true;
+
+            SlotMapHandle h;
+            h.index      = s;
+            h.generation = slot.generation;
+            return h;
+        }
+
+        // Put the slot on the free list, which invalidates its handles.
+        void freeSlot(SlotMapHandle h)
+        {
+            checkOwner();
+
+            auto &slot = m_slots[h.index];
+            ++slot.generation;
+            slot.index = m_freeSlot;
+            slot.used  = false;
+            m_freeSlot = h.index;
+        }
+
+    public:
+        SlotMapBase() = default;
+        virtual ~SlotMapBase() = default;
+
+        SlotMapBase(SlotMapBase &&) = default;
+        SlotMapBase &operator=(SlotMapBase &&) = default;
+
+        bool contains(SlotMapHandle h) const
+        {
+            return h.index < m_slots.size() && m_slots[h.index].generation == h.generation;
+        }
+
+        virtual bool erase(SlotMapHandle h) = 0;
+
+        void retain(SlotMapHandle h)
+        {
+            checkOwner();
+            XOR_ASSERT(contains(h), "Retained a stale handle");
+            ++m_slots[h.index].references;
+        }
+
+        // Erase the object when its last reference is released.
+        void release(SlotMapHandle h)
+        {
+            checkOwner();
+            XOR_ASSERT(contains(h), "Released a stale handle");
+            auto &slot = m_slots[h.index];
+            XOR_ASSERT(slot.references > 0, "Released a handle without references");
+            if (--slot.references == 0)
+                erase(h);
+        }
+    };
+
+    // Container that keeps its objects densely in one contiguous array,
+    // so they can be iterated without pointer chasing, and refers to them
+    // with handles of a 32-bit slot index and a 32-bit generation.
+    // Inserting and erasing take constant time. Inserting can reallocate
+    // the array, and erasing moves the last object into the hole, so
+    // unlike handles, pointers to objects are not stable.
+    template <typename T>
+    class SlotMap : public SlotMapBase
+    {
+        std::vector<T>        m_objects;
+        // Slot of each object in the dense array.
+        std::vector<uint32_t> m_objectSlots;
+    public:
+        using Handle = SlotMapHandle;
+
+        SlotMap() = default;
+
+        size_t size() const { return m_objects.size(); }
+        bool empty() const  { return m_objects.empty(); }
+
+        void reserve(size_t size)
+        {
+            m_objects.reserve(size);
+            m_objectSlots.reserve(size);
+            m_slots.reserve(size);
+        }
+
+        template <typename... Ts>
+        Handle emplace(Ts &&... ts)
+        {
+            m_objects.emplace_back(std::forward<Ts>(ts)...);
+            auto h = allocateSlot(static_cast<uint32_t>(m_objects.size() - 1));
+            m_objectSlots.emplace_back(h.index);
+            return h;
+        }
+
+        Handle insert(T object)
+        {
+            return emplace(std::move(object));
+        }
+
+        bool erase(Handle h) override
+        {
+            if (!contains(h))
+                return false;
+
+            uint32_t i    = m_slots[h.index].index;
+            uint32_t last = static_cast<uint32_t>(m_objects.size() - 1);
+
+            // Keep the array dense by moving the last object into the hole.
+            if (i != last)
+            {
+                m_objects[i]     = std::move(m_objects[last]);
+                m_objectSlots[i] = m_objectSlots[last];
+                m_slots[m_objectSlots[i]].index = i;
+            }
+
+            m_objects.pop_back();
+            m_objectSlots.pop_back();
+            freeSlot(h);
+            return true;
+        }
+
+        void clear()
+        {
+            while (!m_objects.empty())
+                erase(handle(m_objects.size() - 1));
+        }
+
+        // Handle of the object at the given index of the dense array.
+        Handle handle(size_t objectIndex) const
+        {
+            Handle h;
+            h.index      = m_objectSlots[objectIndex];
+            h.generation = m_slots[h.index].generation;
+            return h;
+        }
+
+        // Return nullptr if the handle is stale.
+        T *get(Handle h)
+        {
+            return contains(h) ? &m_objects[m_slots[h.index].index] : nullptr;
+        }
+
+        const T *get(Handle h) const
+        {
+            return contains(h) ? &m_objects[m_slots[h.index].index] : nullptr;
+        }
+
+        T &operator[](Handle h)
+        {
+            XOR_ASSERT(contains(h), "Accessed a stale handle");
+            return m_objects[m_slots[h.index].index];
+        }
+
+        const T &operator[](Handle h) const
+        {
+            XOR_ASSERT(contains(h), "Accessed a stale handle");
+            return m_objects[m_slots[h.index].index];
+        }
+
+        // Iterate over all objects in the dense array, in no particular order.
+        Span<T> objects() { return m_objects; }
+        Span<const T> objects() const { return m_objects; }
+
+        T *begin() { return m_objects.data(); }
+        T *end()   { return m_objects.data() + m_objects.size(); }
+        const T *begin() const { return m_objects.data(); }
+        const T *end() const   { return m_objects.data() + m_objects.size(); }
+    };
+
+    // Slot map that never moves its objects, so pointers and references
+    // to them stay valid until they are erased. Objects are kept in
+    // fixed size pages in slot order, and erased slots are reused by
+    // later inserts, so iteration skips over any holes.
+    template <typename T>
+    class StableSlotMap : public SlotMapBase
+    {
+        static const uint32_t PageSize = 256;
+
+        using Storage = typename std::aligned_storage<sizeof(T), alignof(T)>::type;
+
+        std::vector<std::unique_ptr<Storage[]>> m_pages;
+        size_t                                  m_size = 0;
+
+        T *object(uint32_t slot) const
+        {
+            return reinterpret_cast<T *>(&m_pages[slot / PageSize][slot % PageSize]);
+        }
+    public:
+        using Handle = SlotMapHandle;
+
+        StableSlotMap() = default;
+        ~StableSlotMap() { clear(); }
+
+        StableSlotMap(const StableSlotMap &) = delete;
+        StableSlotMap &operator=(const StableSlotMap &) = delete;
+
+        size_t size() const { return m_size; }
+        bool empty() const  { return m_size == 0; }
+
+        template <typename... Ts>
+        Handle emplace(Ts &&... ts)
+        {
+            // The object of a slot lives in the slot's own position.
+            auto h = allocateSlot(InvalidIndex);
+            m_slots[h.index].index = h.index;
+
+            while (m_pages.size() * PageSize <= h.index)
+                m_pages.emplace_back(new Storage[PageSize]);
+
+            try
+            {
+                new (object(h.index)) T(std::forward<Ts>(ts)...);
+            }
+            catch (...)
+            {
+                freeSlot(h);
+                throw;
+            }
+
+            ++m_size;
+            return h;
+        }
+
+        Handle insert(T object)
+        {
+            return emplace(std::move(object));
+        }
+
+        bool erase(Handle h) override
+        {
+            if (!contains(h))
+                return false;
+
+            object(h.index)->~T();
+            freeSlot(h);
+            --m_size;
+            return true;
+        }
+
+        void clear()
+        {
+            for (uint32_t s = 0; s < m_slots.size(); ++s)
+            {
+                if (m_slots[s].used)
+                    erase(handle(s));
+            }
+        }
+
+        Handle handle(uint32_t slot) const
+        {
+            Handle h;
+            h.index      = slot;
+            h.generation = m_slots[slot].generation;
+            return h;
+        }
+
+        // Return nullptr if the handle is stale.
+        T *get(Handle h) const
+        {
+            return contains(h) ? object(h.index) : nullptr;
+        }
+
+        T &operator[](Handle h) const
+        {
+            XOR_ASSERT(contains(h), "Accessed a stale handle");
+            return *object(h.index);
+        }
+
+        // Call f for every object, in slot order.
+        template <typename F>
+        void forEach(F &&f) const
+        {
+            for (uint32_t s = 0; s < m_slots.size(); ++s)
+            {
+                if (m_slots[s].used)
+                    f(*object(s));
+            }
+        }
+    };
+
+    // Reference counted handle to an object in a slot map, which can be
+    // used instead of std::shared_ptr. The object is erased from the map
+    // when its last reference is destroyed. Unlike std::shared_ptr, the
+    // reference count is not atomic, so the references must be copied and
+    // destroyed by the thread that owns the map. Pointers from get() are
+    // only stable if the map is a StableSlotMap.
+    template <typename T, typename Map = SlotMap<T>>
+    class SlotMapRef
+    {
+        SlotMapBase  *m_map = nullptr;
+        SlotMapHandle m_handle;
+    public:
+        SlotMapRef() = default;
+        SlotMapRef(Map &map, SlotMapHandle h)
+            : m_map(&map)
+            , m_handle(h)
+        {
+            m_map->retain(m_handle);
+        }
+
+        template <typename... Ts>
+        static SlotMapRef make(Map &map, Ts &&... ts)
+        {
+            return SlotMapRef(map, map.emplace(std::forward<Ts>(ts)...));
+        }
+
+        SlotMapRef(const SlotMapRef &r)
+            : m_map(r.m_map)
+            , m_handle(r.m_handle)
+        {
+            if (m_map)
+                m_map->retain(m_handle);
+        }
+
+        SlotMapRef(SlotMapRef &&r)
+            : m_map(r.m_map)
+            , m_handle(r.m_handle)
+        {
+            r.m_map    = nullptr;
+            r.m_handle = SlotMapHandle();
+        }
+
+        SlotMapRef &operator=(const SlotMapRef &r)
+        {
+            SlotMapRef copy(r);
+            return operator=(std::move(copy));
+        }
+
+        SlotMapRef &operator=(SlotMapRef &&r)
+        {
+            if (this != &r)
+            {
+                reset();
+                std::swap(m_map, r.m_map);
+                std::swap(m_handle, r.m_handle);
+            }
+            return *this;
+        }
+
+        ~SlotMapRef() { reset(); }
+
+        void reset()
+        {
+            if (m_map)
+                m_map->release(m_handle);
+            m_map    = nullptr;
+            m_handle = SlotMapHandle();
+        }
+
+        SlotMapHandle handle() const { return m_handle; }
+
+        bool valid() const { return !!m_map; }
+        explicit operator bool() const { return valid(); }
+
+        T *get() const { return m_map ? static_cast<Map *>(m_map)->get(m_handle) : nullptr; }
+        T &operator*() const { return *get(); }
+        T *operator->() const { return get(); }
+    };
+
+#if XOR_SLOTMAP_STATES
+    template <typename T>
+    using StatePtr = SlotMapRef<T, StableSlotMap<T>>;
+
+    // The states of each type share one map. It is never destroyed,
+    // so that states in static objects can be released safely.
+    template <typename T>
+    StableSlotMap<T> &stateSlotMap()
+    {
+        static StableSlotMap<T> *states = new StableSlotMap<T>();
+        return *states;
+    }
+
+    template <typename T, typename... Ts>
+    StatePtr<T> makeStatePtr(Ts &&... ts)
+    {
+        return StatePtr<T>::make(stateSlotMap<T>(), std::forward<Ts>(ts)...);
+    }
+#else
+    template <typename T>
+    using StatePtr = std::shared_ptr<T>;
+
+    template <typename T, typename... Ts>
+    StatePtr<T> makeStatePtr(Ts &&... ts)
+    {
+        return std::make_shared<T>(std::forward<Ts>(ts)...);
+    }
+#endif
+}
@@ -0,0 +1,369 @@
+#include "Core/Sorting.hpp"
+#include "Core/SortingNetworks.h"
+
+#include <immintrin.h>
+
+#include <array>
+#include <limits>
+#include <utility>
+
+namespace Xor
+{
+    namespace sorting_detail
+    {
+        // The networks of SortingNetworks.h applied to an array of N
+        // elements, using f(a, b) as the comparator.
+        template <uint N> struct Network;
+
+#define SWAP(a, b) f(e[a], e[b])
+#define XOR_NETWORK(N) \
+        template <> struct Network<N> \
+        { \
+            template <typename T, typename F> \
+            static void apply(T *e, F &&f) { XOR_SORTING_NETWORK_ ## N } \
+        };
+
+        XOR_NETWORK(4)  XOR_NETWORK(5)  XOR_NETWORK(6)  XOR_NETWORK(7)
+        XOR_NETWORK(8)  XOR_NETWORK(9)  XOR_NETWORK(10) XOR_NETWORK(11)
+        XOR_NETWORK(12) XOR_NETWORK(13) XOR_NETWORK(14) XOR_NETWORK(15)
+        XOR_NETWORK(16) XOR_NETWORK(17) XOR_NETWORK(18) XOR_NETWORK(19)
+        XOR_NETWORK(20) XOR_NETWORK(21) XOR_NETWORK(22) XOR_NETWORK(23)
+        XOR_NETWORK(24) XOR_NETWORK(25) XOR_NETWORK(26) XOR_NETWORK(27)
+        XOR_NETWORK(28) XOR_NETWORK(29) XOR_NETWORK(30) XOR_NETWORK(31)
+        XOR_NETWORK(32)
+
+#undef XOR_NETWORK
+#undef SWAP
+
+        static const uint MinSize = XOR_SORTING_NETWORK_MIN_SIZE;
+        static const uint MaxSize = XOR_SORTING_NETWORK_MAX_SIZE;
+
+        // SIMD operations on Width lanes of keys, and of 32-bit values
+        // that are moved along with them. The SSE versions only use SSE2,
+        // which every x64 CPU has, so they need no CPU check.
+        struct Sse
+        {
+            static const uint Width = 4;
+            using Values = __m128i;
+
+            static Values loadValues(const uint32_t *p) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)); }
+            static void storeValues(uint32_t *p, Values v) { _mm_storeu_si128(reinterpret_cast<__m128i *>(p), v); }
+            static Values select(Values mask, Values a, Values b)
+            {
+                return _mm_or_si128(_mm_and_si128(mask, b), _mm_andnot_si128(mask, a));
+            }
+        };
+
+        struct SseFloat : Sse
+        {
+            using Scalar = float;
+            using Keys   = __m128;
+
+            static Keys load(const float *p) { return _mm_loadu_ps(p); }
+            static void store(float *p, Keys k) { _mm_storeu_ps(p, k); }
+            static Keys min(Keys a, Keys b) { return _mm_min_ps(a, b); }
+            static Keys max(Keys a, Keys b) { return _mm_max_ps(a, b); }
+            static Values greater(Keys a, Keys b) { return _mm_castps_si128(_mm_cmpgt_ps(a, b)); }
+        };
+
+        struct SseUint : Sse
+        {
+            using Scalar = uint32_t;
+            using Keys   = __m128i;
+
+            static Keys load(const uint32_t *p) { return loadValues(p); }
+            static void store(uint32_t *p, Keys k) { storeValues(p, k); }
+            static Keys min(Keys a, Keys b) { return select(greater(a, b), a, b); }
+            static Keys max(Keys a, Keys b) { return select(greater(a, b), b, a); }
+            // SSE2 only has signed comparisons, but flipping the sign
+            // bits of both sides turns them into unsigned ones.
+            static Values greater(Keys a, Keys b)
+            {
+                auto signBit = _mm_set1_epi32(std::numeric_limits<int32_t>::min());
+                return _mm_cmpgt_epi32(_mm_xor_si128(a, signBit), _mm_xor_si128(b, signBit));
+            }
+        };
+
+        struct Avx
+        {
+            static const uint Width = 8;
+            using Values = __m256i;
+
+            static Values loadValues(const uint32_t *p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)); }
+            static void storeValues(uint32_t *p, Values v) { _mm256_storeu_si256(reinterpret_cast<__m256i *>(p), v); }
+            static Values select(Values mask, Values a, Values b) { return _mm256_blendv_epi8(a, b, mask); }
+        };
+
+        struct AvxFloat : Avx
+        {
+            using Scalar = float;
+            using Keys   = __m256;
+
+            static Keys load(const float *p) { return _mm256_loadu_ps(p); }
+            static void store(float *p, Keys k) { _mm256_storeu_ps(p, k); }
+            static Keys min(Keys a, Keys b) { return _mm256_min_ps(a, b); }
+            static Keys max(Keys a, Keys b) { return _mm256_max_ps(a, b); }
+            static Values greater(Keys a, Keys b) { return _mm256_castps_si256(_mm256_cmp_ps(a, b, _CMP_GT_OQ)); }
+        };
+
+        struct AvxUint : Avx
+        {
+            using Scalar = uint32_t;
+            using Keys   = __m256i;
+
+            static Keys load(const uint32_t *p) { return loadValues(p); }
+            static void store(uint32_t *p, Keys k) { storeValues(p, k); }
+            static Keys min(Keys a, Keys b) { return _mm256_min_epu32(a, b); }
+            static Keys max(Keys a, Keys b) { return _mm256_max_epu32(a, b); }
+            static Values greater(Keys a, Keys b)
+            {
+                return _mm256_xor_si256(_mm256_cmpeq_epi32(min(a, b), a), _mm256_set1_epi32(-1));
+            }
+        };
+
+        // Padding for partial blocks of arrays, which sorts last.
+        template <typename T> T padding() { return std::numeric_limits<T>::max(); }
+        template <> float padding<float>() { return std::numeric_limits<float>::infinity(); }
+
+        // Sort Width arrays that are stride elements apart.
+        template <uint N, typename L>
+        void sortKeys(typename L::Scalar *keys, size_t stride)
+        {
+            typename L::Keys k[N];
+            for (uint i = 0; i < N; ++i)
+                k[i] = L::load(keys + i * stride);
+
+            Network<N>::apply(k, [] (typename L::Keys &a, typename L::Keys &b)
+            {
+                auto lo = L::min(a, b);
+                b = L::max(a, b);
+                a = lo;
+            });
+
+            for (uint i = 0; i < N; ++i)
+                L::store(keys + i * stride, k[i]);
+        }
+
+        template <uint N, typename L>
+        void sortPairs(typename L::Scalar *keys, uint32_t *values, size_t stride)
+        {
+            struct Pair
+            {
+                typename L::Keys   k;
+                typename L::Values v;
+            };
+
+            Pair p[N];
+            for (uint i = 0; i < N; ++i)
+            {
+                p[i].k = L::load(keys + i * stride);
+                p[i].v = L::loadValues(values + i * stride);
+            }
+
+            Network<N>::apply(p, [] (Pair &a, Pair &b)
+            {
+                auto swap = L::greater(a.k, b.k);
+                auto lo   = L::min(a.k, b.k);
+                b.k = L::max(a.k, b.k);
+                a.k = lo;
+
+                auto v = L::select(swap, a.v, b.v);
+                b.v = L::select(swap, b.v, a.v);
+                a.v = v;
+            });
+
+            for (uint i = 0; i < N; ++i)
+            {
+                L::store(keys + i * stride, p[i].k);
+                L::storeValues(values + i * stride, p[i].v);
+            }
+        }
+
+        // Only the middle element is stored, so the compiler can drop
+        // all comparators that don't contribute to it.
+        template <uint N, typename L>
+        void medianKeys(const typename L::Scalar *keys, typename L::Scalar *medians, size_t stride)
+        {
+            typename L::Keys k[N];
+            for (uint i = 0; i < N; ++i)
+                k[i] = L::load(keys + i * stride);
+
+            Network<N>::apply(k, [] (typename L::Keys &a, typename L::Keys &b)
+            {
+                auto lo = L::min(a, b);
+                b = L::max(a, b);
+                a = lo;
+            });
+
+            L::store(medians, k[N / 2]);
+        }
+
+        // Process all complete blocks of Width arrays in place, and the
+        // remaining arrays in a padded copy.
+        template <uint N, typename L>
+        void sortKeysSoA(typename L::Scalar *keys, size_t arrays)
+        {
+            using T = typename L::Scalar;
+
+            size_t j = 0;
+            for (; j + L::Width <= arrays; j += L::Width)
+                sortKeys<N, L>(keys + j, arrays);
+
+            if (j < arrays)
+            {
+                size_t left = arrays - j;
+                T block[N * L::Width];
+                for (uint i = 0; i < N; ++i)
+                {
+                    for (uint l = 0; l < L::Width; ++l)
+                        block[i * L::Width + l] = l < left ? keys[i * arrays + j + l] : padding<T>();
+                }
+
+                sortKeys<N, L>(block, L::Width);
+
+                for (uint i = 0; i < N; ++i)
+                {
+                    for (uint l = 0; l < left; ++l)
+                        keys[i * arrays + j + l] = block[i * L::Width + l];
+                }
+            }
+        }
+
+        template <uint N, typename L>
+        void sortPairsSoA(typename L::Scalar *keys, uint32_t *values, size_t arrays)
+        {
+            using T = typename L::Scalar;
+
+            size_t j = 0;
+            for (; j + L::Width <= arrays; j += L::Width)
+                sortPairs<N, L>(keys + j, values + j, arrays);
+
+            if (j < arrays)
+            {
+                size_t left = arrays - j;
+                T        blockKeys[N * L::Width];
+                uint32_t blockValues[N * L::Width];
+                for (uint i = 0; i < N; ++i)
+                {
+                    for (uint l = 0; l < L::Width; ++l)
+                    {
+                        bool valid = l < left;
+                        blockKeys[i * L::Width + l]   = valid ? keys[i * arrays + j + l]   : padding<T>();
+                        blockValues[i * L::Width + l] = valid ? values[i * arrays + j + l] : 0;
+                    }
+                }
+
+                sortPairs<N, L>(blockKeys, blockValues, L::Width);
+
+                for (uint i = 0; i < N; ++i)
+                {
+                    for (uint l = 0; l < left; ++l)
+                    {
+                        keys[i * arrays + j + l]   = blockKeys[i * L::Width + l];
+                        values[i * arrays + j + l] = blockValues[i * L::Width + l];
+                    }
+                }
+            }
+        }
+
+        template <uint N, typename L>
+        void medianKeysSoA(const typename L::Scalar *keys, typename L::Scalar *medians, size_t arrays)
+        {
+            using T = typename L::Scalar;
+
+            size_t j = 0;
+            for (; j + L::Width <= arrays; j += L::Width)
+                medianKeys<N, L>(keys + j, medians + j, arrays);
+
+            if (j < arrays)
+            {
+                size_t left = arrays - j;
+                T block[N * L::Width];
+                T blockMedians[L::Width];
+                for (uint i = 0; i < N; ++i)
+                {
+                    for (uint l = 0; l < L::Width; ++l)
+                        block[i * L::Width + l] = l < left ? keys[i * arrays + j + l] : padding<T>();
+                }
+
+                medianKeys<N, L>(block, blockMedians, L::Width);
+
+                for (uint l = 0; l < left; ++l)
+                    medians[j + l] = blockMedians[l];
+            }
+        }
+
+        // Tables of the functions for every supported size.
+        template <typename Fn, size_t... Ns, typename Make>
+        std::array<Fn, sizeof...(Ns)> makeTable(std::index_sequence<Ns...>, Make)
+        {
+            return { Make::template get<static_cast<uint>(Ns) + MinSize>()... };
+        }
+
+        template <typename L>
+        struct SortKeysFn
+        {
+            using Fn = void (*)(typename L::Scalar *, size_t);
+            template <uint N> static Fn get() { return &sortKeysSoA<N, L>; }
+        };
+
+        template <typename L>
+        struct SortPairsFn
+        {
+            using Fn = void (*)(typename L::Scalar *, uint32_t *, size_t);
+            template <uint N> static Fn get() { return &sortPairsSoA<N, L>; }
+        };
+
+        template <typename L>
+        struct MedianKeysFn
+        {
+            using Fn = void (*)(const typename L::Scalar *, typename L::Scalar *, size_t);
+            template <uint N> static Fn get() { return &medianKeysSoA<N, L>; }
+        };
+
+        // Choose the AVX2 or SSE version of the kernel for count elements.
+        template <template <typename> class Kernel, typename AvxLanes, typename SseLanes>
+        typename Kernel<SseLanes>::Fn kernel(uint count)
+        {
+            XOR_ASSERT(count >= MinSize && count <= MaxSize,
+                       "Sorting networks only support arrays of %u to %u elements", MinSize, MaxSize);
+
+            using Fn = typename Kernel<SseLanes>::Fn;
+            using Sizes = std::make_index_sequence<MaxSize - MinSize + 1>;
+            static const std::array<Fn, MaxSize - MinSize + 1> avx = makeTable<Fn>(Sizes(), Kernel<AvxLanes>());
+            static const std::array<Fn, MaxSize - MinSize + 1> sse = makeTable<Fn>(Sizes(), Kernel<SseLanes>());
+
+            return (cpuSupportsAVX2() ? avx : sse)[count - MinSize];
+        }
+
+        void sortSoA(float *elements, size_t size, uint count)
+        {
+            kernel<SortKeysFn, AvxFloat, SseFloat>(count)(elements, size / count);
+        }
+
+        void sortSoA(uint32_t *elements, size_t size, uint count)
+        {
+            kernel<SortKeysFn, AvxUint, SseUint>(count)(elements, size / count);
+        }
+
+        void sortSoA(float *keys, uint32_t *values, size_t size, uint count)
+        {
+            kernel<SortPairsFn, AvxFloat, SseFloat>(count)(keys, values, size / count);
+        }
+
+        void sortSoA(uint32_t *keys, uint32_t *values, size_t size, uint count)
+        {
+            kernel<SortPairsFn, AvxUint, SseUint>(count)(keys, values, size / count);
+        }
+
+        void medianSoA(const float *elements, float *medians, size_t size, uint count)
+        {
+            kernel<MedianKeysFn, AvxFloat, SseFloat>(count)(elements, medians, size / count);
+        }
+
+        void medianSoA(const uint32_t *elements, uint32_t *medians, size_t size, uint count)
+        {
+            kernel<MedianKeysFn, AvxUint, SseUint>(count)(elements, medians, size / count);
+        }
+    }
+}
@@ -1,5 +1,358 @@
 #pragma once
 
+#include "Core/Utils.hpp"
+#include "Core/ThreadPool.hpp"
+#include "Core/SortingNetworks.h"
+
+#include <vector>
+#include <algorithm>
+#include <limits>
+#include <utility>
+
 namespace Xor
 {
+    namespace sorting_detail
+    {
+        // 11-bit digits sort 32-bit keys in three passes and 64-bit keys
+        // in six. 8-bit digits scatter into fewer buckets at a time, but
+        // the extra passes make them slower even for 64-bit keys.
+        template <typename Key> struct RadixDigitBits;
+        template <> struct RadixDigitBits<uint32_t> { static const uint Bits = 11; };
+        template <> struct RadixDigitBits<uint64_t> { static const uint Bits = 11; };
+
+        template <typename Key>
+        struct Radix
+        {
+            static const uint Bits    = RadixDigitBits<Key>::Bits;
+            static const uint Buckets = 1u << Bits;
+            static const uint Passes  = (sizeof(Key) * 8 + Bits - 1) / Bits;
+
+            static uint digit(Key key, uint pass)
+            {
+                return static_cast<uint>(key >> (pass * Bits)) & (Buckets - 1);
+            }
+        };
+
+        // Inputs smaller than this are sorted by comparison, since
+        // clearing and scanning the histograms would dominate.
+        static const size_t SmallSortSize      = 256;
+        // Inputs smaller than this are not worth splitting between threads.
+        static const size_t ParallelSortSize   = 64 * 1024;
+        static const size_t ParallelBlockSize  = 16 * 1024;
+        static const size_t SortingNetworkSize = 9;
+
+        // Used in place of the values when only keys are sorted.
+        struct NoValue {};
+
+        template <typename Value>
+        void moveValue(Value *dst, size_t to, const Value *src, size_t from)
+        {
+            dst[to] = src[from];
+        }
+
+        inline void moveValue(NoValue *, size_t, const NoValue *, size_t) {}
+
+        template <typename T>
+        void compareExchange(T &a, T &b)
+        {
+            T lo = std::min(a, b);
+            T hi = std::max(a, b);
+            a = lo;
+            b = hi;
+        }
+
+        // Sort up to SortingNetworkSize elements with a sorting network,
+        // padding them with elements that sort last.
+        template <typename T>
+        void sortingNetwork(T *elements, size_t count, T padding)
+        {
+            T e[SortingNetworkSize];
+            for (size_t i = 0; i < SortingNetworkSize; ++i)
+                e[i] = i < count ? elements[i] : padding;
+
+#define SWAP(a, b) compareExchange(e[a], e[b])
+            XOR_SORTING_NETWORK_9
+#undef SWAP
+
+            for (size_t i = 0; i < count; ++i)
+                elements[i] = e[i];
+        }
+
+        template <typename Key>
+        void smallSort(Key *keys, NoValue *, size_t count)
+        {
+            if (count <= SortingNetworkSize)
+                sortingNetwork(keys, count, std::numeric_limits<Key>::max());
+            else
+                std::sort(keys, keys + count);
+        }
+
+        template <typename Key, typename Value>
+        void smallSort(Key *keys, Value *values, size_t count)
+        {
+            // Sorting the original indices along with the keys keeps
+            // equal keys in order, just like the radix sort.
+            using KeyIndex = std::pair<Key, uint>;
+            KeyIndex order[SmallSortSize];
+            for (size_t i = 0; i < count; ++i)
+                order[i] = KeyIndex(keys[i], static_cast<uint>(i));
+
+            if (count <= SortingNetworkSize)
+                sortingNetwork(order, count, KeyIndex(std::numeric_limits<Key>::max(), std::numeric_limits<uint>::max()));
+            else
+                std::sort(order, order + count);
+
+            std::vector<Value> unsorted(values, values + count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                keys[i]   = order[i].first;
+                values[i] = unsorted[order[i].second];
+            }
+        }
+
+        // Keys whose digit is the same for every key don't need the pass.
+        template <typename Key>
+        bool isTrivialPass(const size_t *counts, size_t count)
+        {
+            for (uint d = 0; d < Radix<Key>::Buckets; ++d)
+            {
+                if (counts[d] != 0)
+                    return counts[d] == count;
+            }
+            return true;
+        }
+
+        template <typename Key, typename Value>
+        void scatter(const Key *srcKeys, const Value *srcValues,
+                     Key *dstKeys, Value *dstValues,
+                     size_t begin, size_t end,
+                     uint pass, size_t *offsets)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                Key k    = srcKeys[i];
+                size_t o = offsets[Radix<Key>::digit(k, pass)]++;
+                dstKeys[o] = k;
+                moveValue(dstValues, o, srcValues, i);
+            }
+        }
+
+        template <typename Key, typename Value>
+        void radixSort(Key *keys, Value *values, size_t count)
+        {
+            using R = Radix<Key>;
+
+            if (count < SmallSortSize)
+            {
+                smallSort(keys, values, count);
+                return;
+            }
+
+            // The digit counts don't depend on the order of the keys,
+            // so the histograms of all passes are computed at once.
+            std::vector<size_t> histograms(R::Passes * R::Buckets);
+            for (size_t i = 0; i < count; ++i)
+            {
+                Key k = keys[i];
+                for (uint p = 0; p < R::Passes; ++p)
+                    ++histograms[p * R::Buckets + R::digit(k, p)];
+            }
+
+            std::vector<Key>   tempKeys(count);
+            std::vector<Value> tempValues(std::is_same<Value, NoValue>::value ? 0 : count);
+
+            Key   *srcKeys   = keys;
+            Value *srcValues = values;
+            Key   *dstKeys   = tempKeys.data();
+            Value *dstValues = tempValues.data();
+
+            for (uint p = 0; p < R::Passes; ++p)
+            {
+                size_t *offsets = &histograms[p * R::Buckets];
+                if (isTrivialPass<Key>(offsets, count))
+                    continue;
+
+                size_t offset = 0;
+                for (uint d = 0; d < R::Buckets; ++d)
+                {
+                    size_t c   = offsets[d];
+                    offsets[d] = offset;
+                    offset    += c;
+                }
+
+                scatter(srcKeys, srcValues, dstKeys, dstValues, 0, count, p, offsets);
+
+                std::swap(srcKeys, dstKeys);
+                std::swap(srcValues, dstValues);
+            }
+
+            if (srcKeys != keys)
+            {
+                std::copy(srcKeys, srcKeys + count, keys);
+                for (size_t i = 0; i < count; ++i)
+                    moveValue(values, i, srcValues, i);
+            }
+        }
+
+        template <typename Key, typename Value>
+        void parallelRadixSort(ThreadPool &pool, Key *keys, Value *values, size_t count)
+        {
+            using R = Radix<Key>;
+
+            size_t blocks = std::min<size_t>(pool.threadCount() + 1, count / ParallelBlockSize);
+            if (count < ParallelSortSize || blocks <= 1)
+            {
+                radixSort(keys, values, count);
+                return;
+            }
+
+            // Every block of the input counts its own digits, which gives it
+            // an exclusive range of the output to scatter into for each digit.
+            std::vector<size_t> histograms(blocks * R::Buckets);
+            auto blockBegin = [&] (size_t b) { return b * count / blocks; };
+
+            std::vector<Key>   tempKeys(count);
+            std::vector<Value> tempValues(std::is_same<Value, NoValue>::value ? 0 : count);
+
+            Key   *srcKeys   = keys;
+            Value *srcValues = values;
+            Key   *dstKeys   = tempKeys.data();
+            Value *dstValues = tempValues.data();
+
+            for (uint p = 0; p < R::Passes; ++p)
+            {
+                pool.parallelFor(blocks, [&] (size_t b)
+                {
+                    size_t *counts = &histograms[b * R::Buckets];
+                    std::fill(counts, counts + R::Buckets, size_t(0));
+                    for (size_t i = blockBegin(b), e = blockBegin(b + 1); i < e; ++i)
+                        ++counts[R::digit(srcKeys[i], p)];
+                });
+
+                bool trivial  = false;
+                size_t offset = 0;
+                for (uint d = 0; d < R::Buckets; ++d)
+                {
+                    size_t digitBegin = offset;
+                    for (size_t b = 0; b < blocks; ++b)
+                    {
+                        size_t &h = histograms[b * R::Buckets + d];
+                        size_t c  = h;
+                        h         = offset;
+                        offset   += c;
+                    }
+
+                    if (offset - digitBegin == count)
+                        trivial = true;
+                }
+
+                if (trivial)
+                    continue;
+
+                pool.parallelFor(blocks, [&] (size_t b)
+                {
+                    scatter(srcKeys, srcValues, dstKeys, dstValues,
+                            blockBegin(b), blockBegin(b + 1),
+                            p, &histograms[b * R::Buckets]);
+                });
+
+                std::swap(srcKeys, dstKeys);
+                std::swap(srcValues, dstValues);
+            }
+
+            if (srcKeys != keys)
+            {
+                pool.parallelFor(blocks, [&] (size_t b)
+                {
+                    for (size_t i = blockBegin(b), e = blockBegin(b + 1); i < e; ++i)
+                    {
+                        keys[i] = srcKeys[i];
+                        moveValue(values, i, srcValues, i);
+                    }
+                });
+            }
+        }
+
+        void sortSoA(float *elements, size_t size, uint count);
+        void sortSoA(uint32_t *elements, size_t size, uint count);
+        void sortSoA(float *keys, uint32_t *values, size_t size, uint count);
+        void sortSoA(uint32_t *keys, uint32_t *values, size_t size, uint count);
+        void medianSoA(const float *elements, float *medians, size_t size, uint count);
+        void medianSoA(const uint32_t *elements, uint32_t *medians, size_t size, uint count);
+    }
+
+    // Sort unsigned 32-bit or 64-bit integer keys with an LSD radix sort.
+    template <typename Keys>
+    void radixSort(Keys &&keys)
+    {
+        auto k = asSpan(keys);
+        sorting_detail::radixSort(k.data(), static_cast<sorting_detail::NoValue *>(nullptr), k.size());
+    }
+
+    // Sort the keys, and reorder the values in the same way. The sort is
+    // stable, so values with equal keys stay in their original order.
+    template <typename Keys, typename Values>
+    void radixSort(Keys &&keys, Values &&values)
+    {
+        auto k = asSpan(keys);
+        auto v = asSpan(values);
+        XOR_ASSERT(k.size() == v.size(), "Keys and values must have the same size");
+        sorting_detail::radixSort(k.data(), v.data(), k.size());
+    }
+
+    // Like radixSort(), but large inputs are counted and scattered by
+    // all threads of the pool.
+    template <typename Keys>
+    void parallelRadixSort(Keys &&keys, ThreadPool &pool = ThreadPool::global())
+    {
+        auto k = asSpan(keys);
+        sorting_detail::parallelRadixSort(pool, k.data(), static_cast<sorting_detail::NoValue *>(nullptr), k.size());
+    }
+
+    template <typename Keys, typename Values>
+    void parallelRadixSort(Keys &&keys, Values &&values, ThreadPool &pool = ThreadPool::global())
+    {
+        auto k = asSpan(keys);
+        auto v = asSpan(values);
+        XOR_ASSERT(k.size() == v.size(), "Keys and values must have the same size");
+        sorting_detail::parallelRadixSort(pool, k.data(), v.data(), k.size());
+    }
+
+    // Sort many independent arrays of float or uint32_t elements at once
+    // with SIMD sorting networks, such as 8 arrays per AVX2 register. The
+    // arrays are in SoA form, so element i of array j is at
+    // elements[i * arrays + j], and there are elements.size() / count
+    // arrays. Count must be between XOR_SORTING_NETWORK_MIN_SIZE and
+    // XOR_SORTING_NETWORK_MAX_SIZE. NaNs are not supported.
+    template <typename Elements>
+    void sortSoA(Elements &&elements, uint count)
+    {
+        auto e = asSpan(elements);
+        XOR_ASSERT(e.size() % count == 0, "Elements must consist of whole arrays");
+        sorting_detail::sortSoA(e.data(), e.size(), count);
+    }
+
+    // Sort the keys, and reorder the uint32_t values in the same way.
+    // Unlike radixSort(), this is not stable.
+    template <typename Keys, typename Values>
+    void sortSoA(Keys &&keys, Values &&values, uint count)
+    {
+        auto k = asSpan(keys);
+        auto v = asSpan(values);
+        XOR_ASSERT(k.size() % count == 0, "Keys must consist of whole arrays");
+        XOR_ASSERT(k.size() == v.size(), "Keys and values must have the same size");
+        sorting_detail::sortSoA(k.data(), v.data(), k.size(), count);
+    }
+
+    // Store the median of each array in medians, e.g. for median filters.
+    // The elements are not modified.
+    template <typename Elements, typename Medians>
+    void medianSoA(const Elements &elements, Medians &&medians, uint count)
+    {
+        auto e = asConstSpan(elements);
+        auto m = asSpan(medians);
+        XOR_ASSERT(e.size() % count == 0, "Elements must consist of whole arrays");
+        XOR_ASSERT(m.size() == e.size() / count, "There must be one median for each array");
+        sorting_detail::medianSoA(e.data(), m.data(), e.size(), count);
+    }
 }
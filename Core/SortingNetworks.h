@@ -1,8 +1,85 @@
 #ifndef XOR_SORTINGNETWORKS_H
 #define XOR_SORTINGNETWORKS_H
 
+// Autogenerated using MakeSortingNetworks.py
+
 // Sorting macros defined using X macros.
 // #define SWAP(a, b) to whatever, a and b will be integer literals.
+// SWAP(a, b) must leave the smaller element in a and the larger in b.
+
+#define XOR_SORTING_NETWORK_MIN_SIZE 4
+#define XOR_SORTING_NETWORK_MAX_SIZE 32
+
+#define XOR_SORTING_NETWORK_4 \
+    SWAP(0, 1); \
+    SWAP(2, 3); \
+    SWAP(0, 2); \
+    SWAP(1, 3); \
+    SWAP(1, 2);
+
+#define XOR_SORTING_NETWORK_5 \
+    SWAP(0, 1); \
+    SWAP(2, 3); \
+    SWAP(0, 2); \
+    SWAP(1, 3); \
+    SWAP(1, 2); \
+    SWAP(0, 4); \
+    SWAP(2, 4); \
+    SWAP(1, 2); \
+    SWAP(3, 4);
+
+#define XOR_SORTING_NETWORK_6 \
+    SWAP(0, 1); \
+    SWAP(2, 3); \
+    SWAP(4, 5); \
+    SWAP(0, 2); \
+    SWAP(1, 3); \
+    SWAP(1, 2); \
+    SWAP(0, 4); \
+    SWAP(1, 5); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(1, 2); \
+    SWAP(3, 4);
+
+#define XOR_SORTING_NETWORK_7 \
+    SWAP(0, 1); \
+    SWAP(2, 3); \
+    SWAP(4, 5); \
+    SWAP(0, 2); \
+    SWAP(1, 3); \
+    SWAP(4, 6); \
+    SWAP(1, 2); \
+    SWAP(5, 6); \
+    SWAP(0, 4); \
+    SWAP(1, 5); \
+    SWAP(2, 6); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6);
+
+#define XOR_SORTING_NETWORK_8 \
+    SWAP(0, 1); \
+    SWAP(2, 3); \
+    SWAP(4, 5); \
+    SWAP(6, 7); \
+    SWAP(0, 2); \
+    SWAP(1, 3); \
+    SWAP(4, 6); \
+    SWAP(5, 7); \
+    SWAP(1, 2); \
+    SWAP(5, 6); \
+    SWAP(0, 4); \
+    SWAP(1, 5); \
+    SWAP(2, 6); \
+    SWAP(3, 7); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6);
 
 #define XOR_SORTING_NETWORK_9 \
     SWAP(0, 1); \
@@ -31,4 +108,2582 @@
     SWAP(2, 3); \
     SWAP(5, 6);
 
+#define XOR_SORTING_NETWORK_10 \
+    SWAP(0, 1); \
+    SWAP(2, 3); \
+    SWAP(4, 5); \
+    SWAP(6, 7); \
+    SWAP(8, 9); \
+    SWAP(0, 2); \
+    SWAP(1, 3); \
+    SWAP(4, 6); \
+    SWAP(5, 7); \
+    SWAP(1, 2); \
+    SWAP(5, 6); \
+    SWAP(0, 4); \
+    SWAP(1, 5); \
+    SWAP(2, 6); \
+    SWAP(3, 7); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(0, 8); \
+    SWAP(1, 9); \
+    SWAP(4, 8); \
+    SWAP(5, 9); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(6, 8); \
+    SWAP(7, 9); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(7, 8);
+
+#define XOR_SORTING_NETWORK_11 \
+    SWAP(0, 1); \
+    SWAP(2, 3); \
+    SWAP(4, 5); \
+    SWAP(6, 7); \
+    SWAP(8, 9); \
+    SWAP(0, 2); \
+    SWAP(1, 3); \
+    SWAP(4, 6); \
+    SWAP(5, 7); \
+    SWAP(8, 10); \
+    SWAP(1, 2); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(0, 4); \
+    SWAP(1, 5); \
+    SWAP(2, 6); \
+    SWAP(3, 7); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(0, 8); \
+    SWAP(1, 9); \
+    SWAP(2, 10); \
+    SWAP(4, 8); \
+    SWAP(5, 9); \
+    SWAP(6, 10); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(6, 8); \
+    SWAP(7, 9); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(7, 8); \
+    SWAP(9, 10);
+
+#define XOR_SORTING_NETWORK_12 \
+    SWAP(0, 1); \
+    SWAP(2, 3); \
+    SWAP(4, 5); \
+    SWAP(6, 7); \
+    SWAP(8, 9); \
+    SWAP(10, 11); \
+    SWAP(0, 2); \
+    SWAP(1, 3); \
+    SWAP(4, 6); \
+    SWAP(5, 7); \
+    SWAP(8, 10); \
+    SWAP(9, 11); \
+    SWAP(1, 2); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(0, 4); \
+    SWAP(1, 5); \
+    SWAP(2, 6); \
+    SWAP(3, 7); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(0, 8); \
+    SWAP(1, 9); \
+    SWAP(2, 10); \
+    SWAP(3, 11); \
+    SWAP(4, 8); \
+    SWAP(5, 9); \
+    SWAP(6, 10); \
+    SWAP(7, 11); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(6, 8); \
+    SWAP(7, 9); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(7, 8); \
+    SWAP(9, 10);
+
+#define XOR_SORTING_NETWORK_13 \
+    SWAP(0, 1); \
+    SWAP(2, 3); \
+    SWAP(4, 5); \
+    SWAP(6, 7); \
+    SWAP(8, 9); \
+    SWAP(10, 11); \
+    SWAP(0, 2); \
+    SWAP(1, 3); \
+    SWAP(4, 6); \
+    SWAP(5, 7); \
+    SWAP(8, 10); \
+    SWAP(9, 11); \
+    SWAP(1, 2); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(0, 4); \
+    SWAP(1, 5); \
+    SWAP(2, 6); \
+    SWAP(3, 7); \
+    SWAP(8, 12); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(10, 12); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(0, 8); \
+    SWAP(1, 9); \
+    SWAP(2, 10); \
+    SWAP(3, 11); \
+    SWAP(4, 12); \
+    SWAP(4, 8); \
+    SWAP(5, 9); \
+    SWAP(6, 10); \
+    SWAP(7, 11); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(6, 8); \
+    SWAP(7, 9); \
+    SWAP(10, 12); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(7, 8); \
+    SWAP(9, 10); \
+    SWAP(11, 12);
+
+#define XOR_SORTING_NETWORK_14 \
+    SWAP(0, 1); \
+    SWAP(2, 3); \
+    SWAP(4, 5); \
+    SWAP(6, 7); \
+    SWAP(8, 9); \
+    SWAP(10, 11); \
+    SWAP(12, 13); \
+    SWAP(0, 2); \
+    SWAP(1, 3); \
+    SWAP(4, 6); \
+    SWAP(5, 7); \
+    SWAP(8, 10); \
+    SWAP(9, 11); \
+    SWAP(1, 2); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(0, 4); \
+    SWAP(1, 5); \
+    SWAP(2, 6); \
+    SWAP(3, 7); \
+    SWAP(8, 12); \
+    SWAP(9, 13); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(0, 8); \
+    SWAP(1, 9); \
+    SWAP(2, 10); \
+    SWAP(3, 11); \
+    SWAP(4, 12); \
+    SWAP(5, 13); \
+    SWAP(4, 8); \
+    SWAP(5, 9); \
+    SWAP(6, 10); \
+    SWAP(7, 11); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(6, 8); \
+    SWAP(7, 9); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(7, 8); \
+    SWAP(9, 10); \
+    SWAP(11, 12);
+
+#define XOR_SORTING_NETWORK_15 \
+    SWAP(0, 1); \
+    SWAP(2, 3); \
+    SWAP(4, 5); \
+    SWAP(6, 7); \
+    SWAP(8, 9); \
+    SWAP(10, 11); \
+    SWAP(12, 13); \
+    SWAP(0, 2); \
+    SWAP(1, 3); \
+    SWAP(4, 6); \
+    SWAP(5, 7); \
+    SWAP(8, 10); \
+    SWAP(9, 11); \
+    SWAP(12, 14); \
+    SWAP(1, 2); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(13, 14); \
+    SWAP(0, 4); \
+    SWAP(1, 5); \
+    SWAP(2, 6); \
+    SWAP(3, 7); \
+    SWAP(8, 12); \
+    SWAP(9, 13); \
+    SWAP(10, 14); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(0, 8); \
+    SWAP(1, 9); \
+    SWAP(2, 10); \
+    SWAP(3, 11); \
+    SWAP(4, 12); \
+    SWAP(5, 13); \
+    SWAP(6, 14); \
+    SWAP(4, 8); \
+    SWAP(5, 9); \
+    SWAP(6, 10); \
+    SWAP(7, 11); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(6, 8); \
+    SWAP(7, 9); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(7, 8); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14);
+
+#define XOR_SORTING_NETWORK_16 \
+    SWAP(0, 1); \
+    SWAP(2, 3); \
+    SWAP(4, 5); \
+    SWAP(6, 7); \
+    SWAP(8, 9); \
+    SWAP(10, 11); \
+    SWAP(12, 13); \
+    SWAP(14, 15); \
+    SWAP(0, 2); \
+    SWAP(1, 3); \
+    SWAP(4, 6); \
+    SWAP(5, 7); \
+    SWAP(8, 10); \
+    SWAP(9, 11); \
+    SWAP(12, 14); \
+    SWAP(13, 15); \
+    SWAP(1, 2); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(13, 14); \
+    SWAP(0, 4); \
+    SWAP(1, 5); \
+    SWAP(2, 6); \
+    SWAP(3, 7); \
+    SWAP(8, 12); \
+    SWAP(9, 13); \
+    SWAP(10, 14); \
+    SWAP(11, 15); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(0, 8); \
+    SWAP(1, 9); \
+    SWAP(2, 10); \
+    SWAP(3, 11); \
+    SWAP(4, 12); \
+    SWAP(5, 13); \
+    SWAP(6, 14); \
+    SWAP(7, 15); \
+    SWAP(4, 8); \
+    SWAP(5, 9); \
+    SWAP(6, 10); \
+    SWAP(7, 11); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(6, 8); \
+    SWAP(7, 9); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(7, 8); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14);
+
+#define XOR_SORTING_NETWORK_17 \
+    SWAP(0, 1); \
+    SWAP(2, 3); \
+    SWAP(4, 5); \
+    SWAP(6, 7); \
+    SWAP(8, 9); \
+    SWAP(10, 11); \
+    SWAP(12, 13); \
+    SWAP(14, 15); \
+    SWAP(0, 2); \
+    SWAP(1, 3); \
+    SWAP(4, 6); \
+    SWAP(5, 7); \
+    SWAP(8, 10); \
+    SWAP(9, 11); \
+    SWAP(12, 14); \
+    SWAP(13, 15); \
+    SWAP(1, 2); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(13, 14); \
+    SWAP(0, 4); \
+    SWAP(1, 5); \
+    SWAP(2, 6); \
+    SWAP(3, 7); \
+    SWAP(8, 12); \
+    SWAP(9, 13); \
+    SWAP(10, 14); \
+    SWAP(11, 15); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(0, 8); \
+    SWAP(1, 9); \
+    SWAP(2, 10); \
+    SWAP(3, 11); \
+    SWAP(4, 12); \
+    SWAP(5, 13); \
+    SWAP(6, 14); \
+    SWAP(7, 15); \
+    SWAP(4, 8); \
+    SWAP(5, 9); \
+    SWAP(6, 10); \
+    SWAP(7, 11); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(6, 8); \
+    SWAP(7, 9); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(7, 8); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(0, 16); \
+    SWAP(8, 16); \
+    SWAP(4, 8); \
+    SWAP(5, 9); \
+    SWAP(6, 10); \
+    SWAP(7, 11); \
+    SWAP(12, 16); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(6, 8); \
+    SWAP(7, 9); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(14, 16); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(7, 8); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(15, 16);
+
+#define XOR_SORTING_NETWORK_18 \
+    SWAP(0, 1); \
+    SWAP(2, 3); \
+    SWAP(4, 5); \
+    SWAP(6, 7); \
+    SWAP(8, 9); \
+    SWAP(10, 11); \
+    SWAP(12, 13); \
+    SWAP(14, 15); \
+    SWAP(16, 17); \
+    SWAP(0, 2); \
+    SWAP(1, 3); \
+    SWAP(4, 6); \
+    SWAP(5, 7); \
+    SWAP(8, 10); \
+    SWAP(9, 11); \
+    SWAP(12, 14); \
+    SWAP(13, 15); \
+    SWAP(1, 2); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(13, 14); \
+    SWAP(0, 4); \
+    SWAP(1, 5); \
+    SWAP(2, 6); \
+    SWAP(3, 7); \
+    SWAP(8, 12); \
+    SWAP(9, 13); \
+    SWAP(10, 14); \
+    SWAP(11, 15); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(0, 8); \
+    SWAP(1, 9); \
+    SWAP(2, 10); \
+    SWAP(3, 11); \
+    SWAP(4, 12); \
+    SWAP(5, 13); \
+    SWAP(6, 14); \
+    SWAP(7, 15); \
+    SWAP(4, 8); \
+    SWAP(5, 9); \
+    SWAP(6, 10); \
+    SWAP(7, 11); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(6, 8); \
+    SWAP(7, 9); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(7, 8); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(0, 16); \
+    SWAP(1, 17); \
+    SWAP(8, 16); \
+    SWAP(9, 17); \
+    SWAP(4, 8); \
+    SWAP(5, 9); \
+    SWAP(6, 10); \
+    SWAP(7, 11); \
+    SWAP(12, 16); \
+    SWAP(13, 17); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(6, 8); \
+    SWAP(7, 9); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(14, 16); \
+    SWAP(15, 17); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(7, 8); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(15, 16);
+
+#define XOR_SORTING_NETWORK_19 \
+    SWAP(0, 1); \
+    SWAP(2, 3); \
+    SWAP(4, 5); \
+    SWAP(6, 7); \
+    SWAP(8, 9); \
+    SWAP(10, 11); \
+    SWAP(12, 13); \
+    SWAP(14, 15); \
+    SWAP(16, 17); \
+    SWAP(0, 2); \
+    SWAP(1, 3); \
+    SWAP(4, 6); \
+    SWAP(5, 7); \
+    SWAP(8, 10); \
+    SWAP(9, 11); \
+    SWAP(12, 14); \
+    SWAP(13, 15); \
+    SWAP(16, 18); \
+    SWAP(1, 2); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(13, 14); \
+    SWAP(17, 18); \
+    SWAP(0, 4); \
+    SWAP(1, 5); \
+    SWAP(2, 6); \
+    SWAP(3, 7); \
+    SWAP(8, 12); \
+    SWAP(9, 13); \
+    SWAP(10, 14); \
+    SWAP(11, 15); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(17, 18); \
+    SWAP(0, 8); \
+    SWAP(1, 9); \
+    SWAP(2, 10); \
+    SWAP(3, 11); \
+    SWAP(4, 12); \
+    SWAP(5, 13); \
+    SWAP(6, 14); \
+    SWAP(7, 15); \
+    SWAP(4, 8); \
+    SWAP(5, 9); \
+    SWAP(6, 10); \
+    SWAP(7, 11); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(6, 8); \
+    SWAP(7, 9); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(7, 8); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(17, 18); \
+    SWAP(0, 16); \
+    SWAP(1, 17); \
+    SWAP(2, 18); \
+    SWAP(8, 16); \
+    SWAP(9, 17); \
+    SWAP(10, 18); \
+    SWAP(4, 8); \
+    SWAP(5, 9); \
+    SWAP(6, 10); \
+    SWAP(7, 11); \
+    SWAP(12, 16); \
+    SWAP(13, 17); \
+    SWAP(14, 18); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(6, 8); \
+    SWAP(7, 9); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(14, 16); \
+    SWAP(15, 17); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(7, 8); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(15, 16); \
+    SWAP(17, 18);
+
+#define XOR_SORTING_NETWORK_20 \
+    SWAP(0, 1); \
+    SWAP(2, 3); \
+    SWAP(4, 5); \
+    SWAP(6, 7); \
+    SWAP(8, 9); \
+    SWAP(10, 11); \
+    SWAP(12, 13); \
+    SWAP(14, 15); \
+    SWAP(16, 17); \
+    SWAP(18, 19); \
+    SWAP(0, 2); \
+    SWAP(1, 3); \
+    SWAP(4, 6); \
+    SWAP(5, 7); \
+    SWAP(8, 10); \
+    SWAP(9, 11); \
+    SWAP(12, 14); \
+    SWAP(13, 15); \
+    SWAP(16, 18); \
+    SWAP(17, 19); \
+    SWAP(1, 2); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(13, 14); \
+    SWAP(17, 18); \
+    SWAP(0, 4); \
+    SWAP(1, 5); \
+    SWAP(2, 6); \
+    SWAP(3, 7); \
+    SWAP(8, 12); \
+    SWAP(9, 13); \
+    SWAP(10, 14); \
+    SWAP(11, 15); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(17, 18); \
+    SWAP(0, 8); \
+    SWAP(1, 9); \
+    SWAP(2, 10); \
+    SWAP(3, 11); \
+    SWAP(4, 12); \
+    SWAP(5, 13); \
+    SWAP(6, 14); \
+    SWAP(7, 15); \
+    SWAP(4, 8); \
+    SWAP(5, 9); \
+    SWAP(6, 10); \
+    SWAP(7, 11); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(6, 8); \
+    SWAP(7, 9); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(7, 8); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(17, 18); \
+    SWAP(0, 16); \
+    SWAP(1, 17); \
+    SWAP(2, 18); \
+    SWAP(3, 19); \
+    SWAP(8, 16); \
+    SWAP(9, 17); \
+    SWAP(10, 18); \
+    SWAP(11, 19); \
+    SWAP(4, 8); \
+    SWAP(5, 9); \
+    SWAP(6, 10); \
+    SWAP(7, 11); \
+    SWAP(12, 16); \
+    SWAP(13, 17); \
+    SWAP(14, 18); \
+    SWAP(15, 19); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(6, 8); \
+    SWAP(7, 9); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(14, 16); \
+    SWAP(15, 17); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(7, 8); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(15, 16); \
+    SWAP(17, 18);
+
+#define XOR_SORTING_NETWORK_21 \
+    SWAP(0, 1); \
+    SWAP(2, 3); \
+    SWAP(4, 5); \
+    SWAP(6, 7); \
+    SWAP(8, 9); \
+    SWAP(10, 11); \
+    SWAP(12, 13); \
+    SWAP(14, 15); \
+    SWAP(16, 17); \
+    SWAP(18, 19); \
+    SWAP(0, 2); \
+    SWAP(1, 3); \
+    SWAP(4, 6); \
+    SWAP(5, 7); \
+    SWAP(8, 10); \
+    SWAP(9, 11); \
+    SWAP(12, 14); \
+    SWAP(13, 15); \
+    SWAP(16, 18); \
+    SWAP(17, 19); \
+    SWAP(1, 2); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(13, 14); \
+    SWAP(17, 18); \
+    SWAP(0, 4); \
+    SWAP(1, 5); \
+    SWAP(2, 6); \
+    SWAP(3, 7); \
+    SWAP(8, 12); \
+    SWAP(9, 13); \
+    SWAP(10, 14); \
+    SWAP(11, 15); \
+    SWAP(16, 20); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(18, 20); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(17, 18); \
+    SWAP(19, 20); \
+    SWAP(0, 8); \
+    SWAP(1, 9); \
+    SWAP(2, 10); \
+    SWAP(3, 11); \
+    SWAP(4, 12); \
+    SWAP(5, 13); \
+    SWAP(6, 14); \
+    SWAP(7, 15); \
+    SWAP(4, 8); \
+    SWAP(5, 9); \
+    SWAP(6, 10); \
+    SWAP(7, 11); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(6, 8); \
+    SWAP(7, 9); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(18, 20); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(7, 8); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(17, 18); \
+    SWAP(19, 20); \
+    SWAP(0, 16); \
+    SWAP(1, 17); \
+    SWAP(2, 18); \
+    SWAP(3, 19); \
+    SWAP(4, 20); \
+    SWAP(8, 16); \
+    SWAP(9, 17); \
+    SWAP(10, 18); \
+    SWAP(11, 19); \
+    SWAP(12, 20); \
+    SWAP(4, 8); \
+    SWAP(5, 9); \
+    SWAP(6, 10); \
+    SWAP(7, 11); \
+    SWAP(12, 16); \
+    SWAP(13, 17); \
+    SWAP(14, 18); \
+    SWAP(15, 19); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(6, 8); \
+    SWAP(7, 9); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(14, 16); \
+    SWAP(15, 17); \
+    SWAP(18, 20); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(7, 8); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(15, 16); \
+    SWAP(17, 18); \
+    SWAP(19, 20);
+
+#define XOR_SORTING_NETWORK_22 \
+    SWAP(0, 1); \
+    SWAP(2, 3); \
+    SWAP(4, 5); \
+    SWAP(6, 7); \
+    SWAP(8, 9); \
+    SWAP(10, 11); \
+    SWAP(12, 13); \
+    SWAP(14, 15); \
+    SWAP(16, 17); \
+    SWAP(18, 19); \
+    SWAP(20, 21); \
+    SWAP(0, 2); \
+    SWAP(1, 3); \
+    SWAP(4, 6); \
+    SWAP(5, 7); \
+    SWAP(8, 10); \
+    SWAP(9, 11); \
+    SWAP(12, 14); \
+    SWAP(13, 15); \
+    SWAP(16, 18); \
+    SWAP(17, 19); \
+    SWAP(1, 2); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(13, 14); \
+    SWAP(17, 18); \
+    SWAP(0, 4); \
+    SWAP(1, 5); \
+    SWAP(2, 6); \
+    SWAP(3, 7); \
+    SWAP(8, 12); \
+    SWAP(9, 13); \
+    SWAP(10, 14); \
+    SWAP(11, 15); \
+    SWAP(16, 20); \
+    SWAP(17, 21); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(18, 20); \
+    SWAP(19, 21); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(17, 18); \
+    SWAP(19, 20); \
+    SWAP(0, 8); \
+    SWAP(1, 9); \
+    SWAP(2, 10); \
+    SWAP(3, 11); \
+    SWAP(4, 12); \
+    SWAP(5, 13); \
+    SWAP(6, 14); \
+    SWAP(7, 15); \
+    SWAP(4, 8); \
+    SWAP(5, 9); \
+    SWAP(6, 10); \
+    SWAP(7, 11); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(6, 8); \
+    SWAP(7, 9); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(18, 20); \
+    SWAP(19, 21); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(7, 8); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(17, 18); \
+    SWAP(19, 20); \
+    SWAP(0, 16); \
+    SWAP(1, 17); \
+    SWAP(2, 18); \
+    SWAP(3, 19); \
+    SWAP(4, 20); \
+    SWAP(5, 21); \
+    SWAP(8, 16); \
+    SWAP(9, 17); \
+    SWAP(10, 18); \
+    SWAP(11, 19); \
+    SWAP(12, 20); \
+    SWAP(13, 21); \
+    SWAP(4, 8); \
+    SWAP(5, 9); \
+    SWAP(6, 10); \
+    SWAP(7, 11); \
+    SWAP(12, 16); \
+    SWAP(13, 17); \
+    SWAP(14, 18); \
+    SWAP(15, 19); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(6, 8); \
+    SWAP(7, 9); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(14, 16); \
+    SWAP(15, 17); \
+    SWAP(18, 20); \
+    SWAP(19, 21); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(7, 8); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(15, 16); \
+    SWAP(17, 18); \
+    SWAP(19, 20);
+
+#define XOR_SORTING_NETWORK_23 \
+    SWAP(0, 1); \
+    SWAP(2, 3); \
+    SWAP(4, 5); \
+    SWAP(6, 7); \
+    SWAP(8, 9); \
+    SWAP(10, 11); \
+    SWAP(12, 13); \
+    SWAP(14, 15); \
+    SWAP(16, 17); \
+    SWAP(18, 19); \
+    SWAP(20, 21); \
+    SWAP(0, 2); \
+    SWAP(1, 3); \
+    SWAP(4, 6); \
+    SWAP(5, 7); \
+    SWAP(8, 10); \
+    SWAP(9, 11); \
+    SWAP(12, 14); \
+    SWAP(13, 15); \
+    SWAP(16, 18); \
+    SWAP(17, 19); \
+    SWAP(20, 22); \
+    SWAP(1, 2); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(13, 14); \
+    SWAP(17, 18); \
+    SWAP(21, 22); \
+    SWAP(0, 4); \
+    SWAP(1, 5); \
+    SWAP(2, 6); \
+    SWAP(3, 7); \
+    SWAP(8, 12); \
+    SWAP(9, 13); \
+    SWAP(10, 14); \
+    SWAP(11, 15); \
+    SWAP(16, 20); \
+    SWAP(17, 21); \
+    SWAP(18, 22); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(18, 20); \
+    SWAP(19, 21); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(17, 18); \
+    SWAP(19, 20); \
+    SWAP(21, 22); \
+    SWAP(0, 8); \
+    SWAP(1, 9); \
+    SWAP(2, 10); \
+    SWAP(3, 11); \
+    SWAP(4, 12); \
+    SWAP(5, 13); \
+    SWAP(6, 14); \
+    SWAP(7, 15); \
+    SWAP(4, 8); \
+    SWAP(5, 9); \
+    SWAP(6, 10); \
+    SWAP(7, 11); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(6, 8); \
+    SWAP(7, 9); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(18, 20); \
+    SWAP(19, 21); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(7, 8); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(17, 18); \
+    SWAP(19, 20); \
+    SWAP(21, 22); \
+    SWAP(0, 16); \
+    SWAP(1, 17); \
+    SWAP(2, 18); \
+    SWAP(3, 19); \
+    SWAP(4, 20); \
+    SWAP(5, 21); \
+    SWAP(6, 22); \
+    SWAP(8, 16); \
+    SWAP(9, 17); \
+    SWAP(10, 18); \
+    SWAP(11, 19); \
+    SWAP(12, 20); \
+    SWAP(13, 21); \
+    SWAP(14, 22); \
+    SWAP(4, 8); \
+    SWAP(5, 9); \
+    SWAP(6, 10); \
+    SWAP(7, 11); \
+    SWAP(12, 16); \
+    SWAP(13, 17); \
+    SWAP(14, 18); \
+    SWAP(15, 19); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(6, 8); \
+    SWAP(7, 9); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(14, 16); \
+    SWAP(15, 17); \
+    SWAP(18, 20); \
+    SWAP(19, 21); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(7, 8); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(15, 16); \
+    SWAP(17, 18); \
+    SWAP(19, 20); \
+    SWAP(21, 22);
+
+#define XOR_SORTING_NETWORK_24 \
+    SWAP(0, 1); \
+    SWAP(2, 3); \
+    SWAP(4, 5); \
+    SWAP(6, 7); \
+    SWAP(8, 9); \
+    SWAP(10, 11); \
+    SWAP(12, 13); \
+    SWAP(14, 15); \
+    SWAP(16, 17); \
+    SWAP(18, 19); \
+    SWAP(20, 21); \
+    SWAP(22, 23); \
+    SWAP(0, 2); \
+    SWAP(1, 3); \
+    SWAP(4, 6); \
+    SWAP(5, 7); \
+    SWAP(8, 10); \
+    SWAP(9, 11); \
+    SWAP(12, 14); \
+    SWAP(13, 15); \
+    SWAP(16, 18); \
+    SWAP(17, 19); \
+    SWAP(20, 22); \
+    SWAP(21, 23); \
+    SWAP(1, 2); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(13, 14); \
+    SWAP(17, 18); \
+    SWAP(21, 22); \
+    SWAP(0, 4); \
+    SWAP(1, 5); \
+    SWAP(2, 6); \
+    SWAP(3, 7); \
+    SWAP(8, 12); \
+    SWAP(9, 13); \
+    SWAP(10, 14); \
+    SWAP(11, 15); \
+    SWAP(16, 20); \
+    SWAP(17, 21); \
+    SWAP(18, 22); \
+    SWAP(19, 23); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(18, 20); \
+    SWAP(19, 21); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(17, 18); \
+    SWAP(19, 20); \
+    SWAP(21, 22); \
+    SWAP(0, 8); \
+    SWAP(1, 9); \
+    SWAP(2, 10); \
+    SWAP(3, 11); \
+    SWAP(4, 12); \
+    SWAP(5, 13); \
+    SWAP(6, 14); \
+    SWAP(7, 15); \
+    SWAP(4, 8); \
+    SWAP(5, 9); \
+    SWAP(6, 10); \
+    SWAP(7, 11); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(6, 8); \
+    SWAP(7, 9); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(18, 20); \
+    SWAP(19, 21); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(7, 8); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(17, 18); \
+    SWAP(19, 20); \
+    SWAP(21, 22); \
+    SWAP(0, 16); \
+    SWAP(1, 17); \
+    SWAP(2, 18); \
+    SWAP(3, 19); \
+    SWAP(4, 20); \
+    SWAP(5, 21); \
+    SWAP(6, 22); \
+    SWAP(7, 23); \
+    SWAP(8, 16); \
+    SWAP(9, 17); \
+    SWAP(10, 18); \
+    SWAP(11, 19); \
+    SWAP(12, 20); \
+    SWAP(13, 21); \
+    SWAP(14, 22); \
+    SWAP(15, 23); \
+    SWAP(4, 8); \
+    SWAP(5, 9); \
+    SWAP(6, 10); \
+    SWAP(7, 11); \
+    SWAP(12, 16); \
+    SWAP(13, 17); \
+    SWAP(14, 18); \
+    SWAP(15, 19); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(6, 8); \
+    SWAP(7, 9); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(14, 16); \
+    SWAP(15, 17); \
+    SWAP(18, 20); \
+    SWAP(19, 21); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(7, 8); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(15, 16); \
+    SWAP(17, 18); \
+    SWAP(19, 20); \
+    SWAP(21, 22);
+
+#define XOR_SORTING_NETWORK_25 \
+    SWAP(0, 1); \
+    SWAP(2, 3); \
+    SWAP(4, 5); \
+    SWAP(6, 7); \
+    SWAP(8, 9); \
+    SWAP(10, 11); \
+    SWAP(12, 13); \
+    SWAP(14, 15); \
+    SWAP(16, 17); \
+    SWAP(18, 19); \
+    SWAP(20, 21); \
+    SWAP(22, 23); \
+    SWAP(0, 2); \
+    SWAP(1, 3); \
+    SWAP(4, 6); \
+    SWAP(5, 7); \
+    SWAP(8, 10); \
+    SWAP(9, 11); \
+    SWAP(12, 14); \
+    SWAP(13, 15); \
+    SWAP(16, 18); \
+    SWAP(17, 19); \
+    SWAP(20, 22); \
+    SWAP(21, 23); \
+    SWAP(1, 2); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(13, 14); \
+    SWAP(17, 18); \
+    SWAP(21, 22); \
+    SWAP(0, 4); \
+    SWAP(1, 5); \
+    SWAP(2, 6); \
+    SWAP(3, 7); \
+    SWAP(8, 12); \
+    SWAP(9, 13); \
+    SWAP(10, 14); \
+    SWAP(11, 15); \
+    SWAP(16, 20); \
+    SWAP(17, 21); \
+    SWAP(18, 22); \
+    SWAP(19, 23); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(18, 20); \
+    SWAP(19, 21); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(17, 18); \
+    SWAP(19, 20); \
+    SWAP(21, 22); \
+    SWAP(0, 8); \
+    SWAP(1, 9); \
+    SWAP(2, 10); \
+    SWAP(3, 11); \
+    SWAP(4, 12); \
+    SWAP(5, 13); \
+    SWAP(6, 14); \
+    SWAP(7, 15); \
+    SWAP(16, 24); \
+    SWAP(4, 8); \
+    SWAP(5, 9); \
+    SWAP(6, 10); \
+    SWAP(7, 11); \
+    SWAP(20, 24); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(6, 8); \
+    SWAP(7, 9); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(18, 20); \
+    SWAP(19, 21); \
+    SWAP(22, 24); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(7, 8); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(17, 18); \
+    SWAP(19, 20); \
+    SWAP(21, 22); \
+    SWAP(23, 24); \
+    SWAP(0, 16); \
+    SWAP(1, 17); \
+    SWAP(2, 18); \
+    SWAP(3, 19); \
+    SWAP(4, 20); \
+    SWAP(5, 21); \
+    SWAP(6, 22); \
+    SWAP(7, 23); \
+    SWAP(8, 24); \
+    SWAP(8, 16); \
+    SWAP(9, 17); \
+    SWAP(10, 18); \
+    SWAP(11, 19); \
+    SWAP(12, 20); \
+    SWAP(13, 21); \
+    SWAP(14, 22); \
+    SWAP(15, 23); \
+    SWAP(4, 8); \
+    SWAP(5, 9); \
+    SWAP(6, 10); \
+    SWAP(7, 11); \
+    SWAP(12, 16); \
+    SWAP(13, 17); \
+    SWAP(14, 18); \
+    SWAP(15, 19); \
+    SWAP(20, 24); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(6, 8); \
+    SWAP(7, 9); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(14, 16); \
+    SWAP(15, 17); \
+    SWAP(18, 20); \
+    SWAP(19, 21); \
+    SWAP(22, 24); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(7, 8); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(15, 16); \
+    SWAP(17, 18); \
+    SWAP(19, 20); \
+    SWAP(21, 22); \
+    SWAP(23, 24);
+
+#define XOR_SORTING_NETWORK_26 \
+    SWAP(0, 1); \
+    SWAP(2, 3); \
+    SWAP(4, 5); \
+    SWAP(6, 7); \
+    SWAP(8, 9); \
+    SWAP(10, 11); \
+    SWAP(12, 13); \
+    SWAP(14, 15); \
+    SWAP(16, 17); \
+    SWAP(18, 19); \
+    SWAP(20, 21); \
+    SWAP(22, 23); \
+    SWAP(24, 25); \
+    SWAP(0, 2); \
+    SWAP(1, 3); \
+    SWAP(4, 6); \
+    SWAP(5, 7); \
+    SWAP(8, 10); \
+    SWAP(9, 11); \
+    SWAP(12, 14); \
+    SWAP(13, 15); \
+    SWAP(16, 18); \
+    SWAP(17, 19); \
+    SWAP(20, 22); \
+    SWAP(21, 23); \
+    SWAP(1, 2); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(13, 14); \
+    SWAP(17, 18); \
+    SWAP(21, 22); \
+    SWAP(0, 4); \
+    SWAP(1, 5); \
+    SWAP(2, 6); \
+    SWAP(3, 7); \
+    SWAP(8, 12); \
+    SWAP(9, 13); \
+    SWAP(10, 14); \
+    SWAP(11, 15); \
+    SWAP(16, 20); \
+    SWAP(17, 21); \
+    SWAP(18, 22); \
+    SWAP(19, 23); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(18, 20); \
+    SWAP(19, 21); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(17, 18); \
+    SWAP(19, 20); \
+    SWAP(21, 22); \
+    SWAP(0, 8); \
+    SWAP(1, 9); \
+    SWAP(2, 10); \
+    SWAP(3, 11); \
+    SWAP(4, 12); \
+    SWAP(5, 13); \
+    SWAP(6, 14); \
+    SWAP(7, 15); \
+    SWAP(16, 24); \
+    SWAP(17, 25); \
+    SWAP(4, 8); \
+    SWAP(5, 9); \
+    SWAP(6, 10); \
+    SWAP(7, 11); \
+    SWAP(20, 24); \
+    SWAP(21, 25); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(6, 8); \
+    SWAP(7, 9); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(18, 20); \
+    SWAP(19, 21); \
+    SWAP(22, 24); \
+    SWAP(23, 25); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(7, 8); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(17, 18); \
+    SWAP(19, 20); \
+    SWAP(21, 22); \
+    SWAP(23, 24); \
+    SWAP(0, 16); \
+    SWAP(1, 17); \
+    SWAP(2, 18); \
+    SWAP(3, 19); \
+    SWAP(4, 20); \
+    SWAP(5, 21); \
+    SWAP(6, 22); \
+    SWAP(7, 23); \
+    SWAP(8, 24); \
+    SWAP(9, 25); \
+    SWAP(8, 16); \
+    SWAP(9, 17); \
+    SWAP(10, 18); \
+    SWAP(11, 19); \
+    SWAP(12, 20); \
+    SWAP(13, 21); \
+    SWAP(14, 22); \
+    SWAP(15, 23); \
+    SWAP(4, 8); \
+    SWAP(5, 9); \
+    SWAP(6, 10); \
+    SWAP(7, 11); \
+    SWAP(12, 16); \
+    SWAP(13, 17); \
+    SWAP(14, 18); \
+    SWAP(15, 19); \
+    SWAP(20, 24); \
+    SWAP(21, 25); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(6, 8); \
+    SWAP(7, 9); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(14, 16); \
+    SWAP(15, 17); \
+    SWAP(18, 20); \
+    SWAP(19, 21); \
+    SWAP(22, 24); \
+    SWAP(23, 25); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(7, 8); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(15, 16); \
+    SWAP(17, 18); \
+    SWAP(19, 20); \
+    SWAP(21, 22); \
+    SWAP(23, 24);
+
+#define XOR_SORTING_NETWORK_27 \
+    SWAP(0, 1); \
+    SWAP(2, 3); \
+    SWAP(4, 5); \
+    SWAP(6, 7); \
+    SWAP(8, 9); \
+    SWAP(10, 11); \
+    SWAP(12, 13); \
+    SWAP(14, 15); \
+    SWAP(16, 17); \
+    SWAP(18, 19); \
+    SWAP(20, 21); \
+    SWAP(22, 23); \
+    SWAP(24, 25); \
+    SWAP(0, 2); \
+    SWAP(1, 3); \
+    SWAP(4, 6); \
+    SWAP(5, 7); \
+    SWAP(8, 10); \
+    SWAP(9, 11); \
+    SWAP(12, 14); \
+    SWAP(13, 15); \
+    SWAP(16, 18); \
+    SWAP(17, 19); \
+    SWAP(20, 22); \
+    SWAP(21, 23); \
+    SWAP(24, 26); \
+    SWAP(1, 2); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(13, 14); \
+    SWAP(17, 18); \
+    SWAP(21, 22); \
+    SWAP(25, 26); \
+    SWAP(0, 4); \
+    SWAP(1, 5); \
+    SWAP(2, 6); \
+    SWAP(3, 7); \
+    SWAP(8, 12); \
+    SWAP(9, 13); \
+    SWAP(10, 14); \
+    SWAP(11, 15); \
+    SWAP(16, 20); \
+    SWAP(17, 21); \
+    SWAP(18, 22); \
+    SWAP(19, 23); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(18, 20); \
+    SWAP(19, 21); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(17, 18); \
+    SWAP(19, 20); \
+    SWAP(21, 22); \
+    SWAP(25, 26); \
+    SWAP(0, 8); \
+    SWAP(1, 9); \
+    SWAP(2, 10); \
+    SWAP(3, 11); \
+    SWAP(4, 12); \
+    SWAP(5, 13); \
+    SWAP(6, 14); \
+    SWAP(7, 15); \
+    SWAP(16, 24); \
+    SWAP(17, 25); \
+    SWAP(18, 26); \
+    SWAP(4, 8); \
+    SWAP(5, 9); \
+    SWAP(6, 10); \
+    SWAP(7, 11); \
+    SWAP(20, 24); \
+    SWAP(21, 25); \
+    SWAP(22, 26); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(6, 8); \
+    SWAP(7, 9); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(18, 20); \
+    SWAP(19, 21); \
+    SWAP(22, 24); \
+    SWAP(23, 25); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(7, 8); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(17, 18); \
+    SWAP(19, 20); \
+    SWAP(21, 22); \
+    SWAP(23, 24); \
+    SWAP(25, 26); \
+    SWAP(0, 16); \
+    SWAP(1, 17); \
+    SWAP(2, 18); \
+    SWAP(3, 19); \
+    SWAP(4, 20); \
+    SWAP(5, 21); \
+    SWAP(6, 22); \
+    SWAP(7, 23); \
+    SWAP(8, 24); \
+    SWAP(9, 25); \
+    SWAP(10, 26); \
+    SWAP(8, 16); \
+    SWAP(9, 17); \
+    SWAP(10, 18); \
+    SWAP(11, 19); \
+    SWAP(12, 20); \
+    SWAP(13, 21); \
+    SWAP(14, 22); \
+    SWAP(15, 23); \
+    SWAP(4, 8); \
+    SWAP(5, 9); \
+    SWAP(6, 10); \
+    SWAP(7, 11); \
+    SWAP(12, 16); \
+    SWAP(13, 17); \
+    SWAP(14, 18); \
+    SWAP(15, 19); \
+    SWAP(20, 24); \
+    SWAP(21, 25); \
+    SWAP(22, 26); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(6, 8); \
+    SWAP(7, 9); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(14, 16); \
+    SWAP(15, 17); \
+    SWAP(18, 20); \
+    SWAP(19, 21); \
+    SWAP(22, 24); \
+    SWAP(23, 25); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(7, 8); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(15, 16); \
+    SWAP(17, 18); \
+    SWAP(19, 20); \
+    SWAP(21, 22); \
+    SWAP(23, 24); \
+    SWAP(25, 26);
+
+#define XOR_SORTING_NETWORK_28 \
+    SWAP(0, 1); \
+    SWAP(2, 3); \
+    SWAP(4, 5); \
+    SWAP(6, 7); \
+    SWAP(8, 9); \
+    SWAP(10, 11); \
+    SWAP(12, 13); \
+    SWAP(14, 15); \
+    SWAP(16, 17); \
+    SWAP(18, 19); \
+    SWAP(20, 21); \
+    SWAP(22, 23); \
+    SWAP(24, 25); \
+    SWAP(26, 27); \
+    SWAP(0, 2); \
+    SWAP(1, 3); \
+    SWAP(4, 6); \
+    SWAP(5, 7); \
+    SWAP(8, 10); \
+    SWAP(9, 11); \
+    SWAP(12, 14); \
+    SWAP(13, 15); \
+    SWAP(16, 18); \
+    SWAP(17, 19); \
+    SWAP(20, 22); \
+    SWAP(21, 23); \
+    SWAP(24, 26); \
+    SWAP(25, 27); \
+    SWAP(1, 2); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(13, 14); \
+    SWAP(17, 18); \
+    SWAP(21, 22); \
+    SWAP(25, 26); \
+    SWAP(0, 4); \
+    SWAP(1, 5); \
+    SWAP(2, 6); \
+    SWAP(3, 7); \
+    SWAP(8, 12); \
+    SWAP(9, 13); \
+    SWAP(10, 14); \
+    SWAP(11, 15); \
+    SWAP(16, 20); \
+    SWAP(17, 21); \
+    SWAP(18, 22); \
+    SWAP(19, 23); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(18, 20); \
+    SWAP(19, 21); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(17, 18); \
+    SWAP(19, 20); \
+    SWAP(21, 22); \
+    SWAP(25, 26); \
+    SWAP(0, 8); \
+    SWAP(1, 9); \
+    SWAP(2, 10); \
+    SWAP(3, 11); \
+    SWAP(4, 12); \
+    SWAP(5, 13); \
+    SWAP(6, 14); \
+    SWAP(7, 15); \
+    SWAP(16, 24); \
+    SWAP(17, 25); \
+    SWAP(18, 26); \
+    SWAP(19, 27); \
+    SWAP(4, 8); \
+    SWAP(5, 9); \
+    SWAP(6, 10); \
+    SWAP(7, 11); \
+    SWAP(20, 24); \
+    SWAP(21, 25); \
+    SWAP(22, 26); \
+    SWAP(23, 27); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(6, 8); \
+    SWAP(7, 9); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(18, 20); \
+    SWAP(19, 21); \
+    SWAP(22, 24); \
+    SWAP(23, 25); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(7, 8); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(17, 18); \
+    SWAP(19, 20); \
+    SWAP(21, 22); \
+    SWAP(23, 24); \
+    SWAP(25, 26); \
+    SWAP(0, 16); \
+    SWAP(1, 17); \
+    SWAP(2, 18); \
+    SWAP(3, 19); \
+    SWAP(4, 20); \
+    SWAP(5, 21); \
+    SWAP(6, 22); \
+    SWAP(7, 23); \
+    SWAP(8, 24); \
+    SWAP(9, 25); \
+    SWAP(10, 26); \
+    SWAP(11, 27); \
+    SWAP(8, 16); \
+    SWAP(9, 17); \
+    SWAP(10, 18); \
+    SWAP(11, 19); \
+    SWAP(12, 20); \
+    SWAP(13, 21); \
+    SWAP(14, 22); \
+    SWAP(15, 23); \
+    SWAP(4, 8); \
+    SWAP(5, 9); \
+    SWAP(6, 10); \
+    SWAP(7, 11); \
+    SWAP(12, 16); \
+    SWAP(13, 17); \
+    SWAP(14, 18); \
+    SWAP(15, 19); \
+    SWAP(20, 24); \
+    SWAP(21, 25); \
+    SWAP(22, 26); \
+    SWAP(23, 27); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(6, 8); \
+    SWAP(7, 9); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(14, 16); \
+    SWAP(15, 17); \
+    SWAP(18, 20); \
+    SWAP(19, 21); \
+    SWAP(22, 24); \
+    SWAP(23, 25); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(7, 8); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(15, 16); \
+    SWAP(17, 18); \
+    SWAP(19, 20); \
+    SWAP(21, 22); \
+    SWAP(23, 24); \
+    SWAP(25, 26);
+
+#define XOR_SORTING_NETWORK_29 \
+    SWAP(0, 1); \
+    SWAP(2, 3); \
+    SWAP(4, 5); \
+    SWAP(6, 7); \
+    SWAP(8, 9); \
+    SWAP(10, 11); \
+    SWAP(12, 13); \
+    SWAP(14, 15); \
+    SWAP(16, 17); \
+    SWAP(18, 19); \
+    SWAP(20, 21); \
+    SWAP(22, 23); \
+    SWAP(24, 25); \
+    SWAP(26, 27); \
+    SWAP(0, 2); \
+    SWAP(1, 3); \
+    SWAP(4, 6); \
+    SWAP(5, 7); \
+    SWAP(8, 10); \
+    SWAP(9, 11); \
+    SWAP(12, 14); \
+    SWAP(13, 15); \
+    SWAP(16, 18); \
+    SWAP(17, 19); \
+    SWAP(20, 22); \
+    SWAP(21, 23); \
+    SWAP(24, 26); \
+    SWAP(25, 27); \
+    SWAP(1, 2); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(13, 14); \
+    SWAP(17, 18); \
+    SWAP(21, 22); \
+    SWAP(25, 26); \
+    SWAP(0, 4); \
+    SWAP(1, 5); \
+    SWAP(2, 6); \
+    SWAP(3, 7); \
+    SWAP(8, 12); \
+    SWAP(9, 13); \
+    SWAP(10, 14); \
+    SWAP(11, 15); \
+    SWAP(16, 20); \
+    SWAP(17, 21); \
+    SWAP(18, 22); \
+    SWAP(19, 23); \
+    SWAP(24, 28); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(18, 20); \
+    SWAP(19, 21); \
+    SWAP(26, 28); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(17, 18); \
+    SWAP(19, 20); \
+    SWAP(21, 22); \
+    SWAP(25, 26); \
+    SWAP(27, 28); \
+    SWAP(0, 8); \
+    SWAP(1, 9); \
+    SWAP(2, 10); \
+    SWAP(3, 11); \
+    SWAP(4, 12); \
+    SWAP(5, 13); \
+    SWAP(6, 14); \
+    SWAP(7, 15); \
+    SWAP(16, 24); \
+    SWAP(17, 25); \
+    SWAP(18, 26); \
+    SWAP(19, 27); \
+    SWAP(20, 28); \
+    SWAP(4, 8); \
+    SWAP(5, 9); \
+    SWAP(6, 10); \
+    SWAP(7, 11); \
+    SWAP(20, 24); \
+    SWAP(21, 25); \
+    SWAP(22, 26); \
+    SWAP(23, 27); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(6, 8); \
+    SWAP(7, 9); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(18, 20); \
+    SWAP(19, 21); \
+    SWAP(22, 24); \
+    SWAP(23, 25); \
+    SWAP(26, 28); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(7, 8); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(17, 18); \
+    SWAP(19, 20); \
+    SWAP(21, 22); \
+    SWAP(23, 24); \
+    SWAP(25, 26); \
+    SWAP(27, 28); \
+    SWAP(0, 16); \
+    SWAP(1, 17); \
+    SWAP(2, 18); \
+    SWAP(3, 19); \
+    SWAP(4, 20); \
+    SWAP(5, 21); \
+    SWAP(6, 22); \
+    SWAP(7, 23); \
+    SWAP(8, 24); \
+    SWAP(9, 25); \
+    SWAP(10, 26); \
+    SWAP(11, 27); \
+    SWAP(12, 28); \
+    SWAP(8, 16); \
+    SWAP(9, 17); \
+    SWAP(10, 18); \
+    SWAP(11, 19); \
+    SWAP(12, 20); \
+    SWAP(13, 21); \
+    SWAP(14, 22); \
+    SWAP(15, 23); \
+    SWAP(4, 8); \
+    SWAP(5, 9); \
+    SWAP(6, 10); \
+    SWAP(7, 11); \
+    SWAP(12, 16); \
+    SWAP(13, 17); \
+    SWAP(14, 18); \
+    SWAP(15, 19); \
+    SWAP(20, 24); \
+    SWAP(21, 25); \
+    SWAP(22, 26); \
+    SWAP(23, 27); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(6, 8); \
+    SWAP(7, 9); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(14, 16); \
+    SWAP(15, 17); \
+    SWAP(18, 20); \
+    SWAP(19, 21); \
+    SWAP(22, 24); \
+    SWAP(23, 25); \
+    SWAP(26, 28); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(7, 8); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(15, 16); \
+    SWAP(17, 18); \
+    SWAP(19, 20); \
+    SWAP(21, 22); \
+    SWAP(23, 24); \
+    SWAP(25, 26); \
+    SWAP(27, 28);
+
+#define XOR_SORTING_NETWORK_30 \
+    SWAP(0, 1); \
+    SWAP(2, 3); \
+    SWAP(4, 5); \
+    SWAP(6, 7); \
+    SWAP(8, 9); \
+    SWAP(10, 11); \
+    SWAP(12, 13); \
+    SWAP(14, 15); \
+    SWAP(16, 17); \
+    SWAP(18, 19); \
+    SWAP(20, 21); \
+    SWAP(22, 23); \
+    SWAP(24, 25); \
+    SWAP(26, 27); \
+    SWAP(28, 29); \
+    SWAP(0, 2); \
+    SWAP(1, 3); \
+    SWAP(4, 6); \
+    SWAP(5, 7); \
+    SWAP(8, 10); \
+    SWAP(9, 11); \
+    SWAP(12, 14); \
+    SWAP(13, 15); \
+    SWAP(16, 18); \
+    SWAP(17, 19); \
+    SWAP(20, 22); \
+    SWAP(21, 23); \
+    SWAP(24, 26); \
+    SWAP(25, 27); \
+    SWAP(1, 2); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(13, 14); \
+    SWAP(17, 18); \
+    SWAP(21, 22); \
+    SWAP(25, 26); \
+    SWAP(0, 4); \
+    SWAP(1, 5); \
+    SWAP(2, 6); \
+    SWAP(3, 7); \
+    SWAP(8, 12); \
+    SWAP(9, 13); \
+    SWAP(10, 14); \
+    SWAP(11, 15); \
+    SWAP(16, 20); \
+    SWAP(17, 21); \
+    SWAP(18, 22); \
+    SWAP(19, 23); \
+    SWAP(24, 28); \
+    SWAP(25, 29); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(18, 20); \
+    SWAP(19, 21); \
+    SWAP(26, 28); \
+    SWAP(27, 29); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(17, 18); \
+    SWAP(19, 20); \
+    SWAP(21, 22); \
+    SWAP(25, 26); \
+    SWAP(27, 28); \
+    SWAP(0, 8); \
+    SWAP(1, 9); \
+    SWAP(2, 10); \
+    SWAP(3, 11); \
+    SWAP(4, 12); \
+    SWAP(5, 13); \
+    SWAP(6, 14); \
+    SWAP(7, 15); \
+    SWAP(16, 24); \
+    SWAP(17, 25); \
+    SWAP(18, 26); \
+    SWAP(19, 27); \
+    SWAP(20, 28); \
+    SWAP(21, 29); \
+    SWAP(4, 8); \
+    SWAP(5, 9); \
+    SWAP(6, 10); \
+    SWAP(7, 11); \
+    SWAP(20, 24); \
+    SWAP(21, 25); \
+    SWAP(22, 26); \
+    SWAP(23, 27); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(6, 8); \
+    SWAP(7, 9); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(18, 20); \
+    SWAP(19, 21); \
+    SWAP(22, 24); \
+    SWAP(23, 25); \
+    SWAP(26, 28); \
+    SWAP(27, 29); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(7, 8); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(17, 18); \
+    SWAP(19, 20); \
+    SWAP(21, 22); \
+    SWAP(23, 24); \
+    SWAP(25, 26); \
+    SWAP(27, 28); \
+    SWAP(0, 16); \
+    SWAP(1, 17); \
+    SWAP(2, 18); \
+    SWAP(3, 19); \
+    SWAP(4, 20); \
+    SWAP(5, 21); \
+    SWAP(6, 22); \
+    SWAP(7, 23); \
+    SWAP(8, 24); \
+    SWAP(9, 25); \
+    SWAP(10, 26); \
+    SWAP(11, 27); \
+    SWAP(12, 28); \
+    SWAP(13, 29); \
+    SWAP(8, 16); \
+    SWAP(9, 17); \
+    SWAP(10, 18); \
+    SWAP(11, 19); \
+    SWAP(12, 20); \
+    SWAP(13, 21); \
+    SWAP(14, 22); \
+    SWAP(15, 23); \
+    SWAP(4, 8); \
+    SWAP(5, 9); \
+    SWAP(6, 10); \
+    SWAP(7, 11); \
+    SWAP(12, 16); \
+    SWAP(13, 17); \
+    SWAP(14, 18); \
+    SWAP(15, 19); \
+    SWAP(20, 24); \
+    SWAP(21, 25); \
+    SWAP(22, 26); \
+    SWAP(23, 27); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(6, 8); \
+    SWAP(7, 9); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(14, 16); \
+    SWAP(15, 17); \
+    SWAP(18, 20); \
+    SWAP(19, 21); \
+    SWAP(22, 24); \
+    SWAP(23, 25); \
+    SWAP(26, 28); \
+    SWAP(27, 29); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(7, 8); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(15, 16); \
+    SWAP(17, 18); \
+    SWAP(19, 20); \
+    SWAP(21, 22); \
+    SWAP(23, 24); \
+    SWAP(25, 26); \
+    SWAP(27, 28);
+
+#define XOR_SORTING_NETWORK_31 \
+    SWAP(0, 1); \
+    SWAP(2, 3); \
+    SWAP(4, 5); \
+    SWAP(6, 7); \
+    SWAP(8, 9); \
+    SWAP(10, 11); \
+    SWAP(12, 13); \
+    SWAP(14, 15); \
+    SWAP(16, 17); \
+    SWAP(18, 19); \
+    SWAP(20, 21); \
+    SWAP(22, 23); \
+    SWAP(24, 25); \
+    SWAP(26, 27); \
+    SWAP(28, 29); \
+    SWAP(0, 2); \
+    SWAP(1, 3); \
+    SWAP(4, 6); \
+    SWAP(5, 7); \
+    SWAP(8, 10); \
+    SWAP(9, 11); \
+    SWAP(12, 14); \
+    SWAP(13, 15); \
+    SWAP(16, 18); \
+    SWAP(17, 19); \
+    SWAP(20, 22); \
+    SWAP(21, 23); \
+    SWAP(24, 26); \
+    SWAP(25, 27); \
+    SWAP(28, 30); \
+    SWAP(1, 2); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(13, 14); \
+    SWAP(17, 18); \
+    SWAP(21, 22); \
+    SWAP(25, 26); \
+    SWAP(29, 30); \
+    SWAP(0, 4); \
+    SWAP(1, 5); \
+    SWAP(2, 6); \
+    SWAP(3, 7); \
+    SWAP(8, 12); \
+    SWAP(9, 13); \
+    SWAP(10, 14); \
+    SWAP(11, 15); \
+    SWAP(16, 20); \
+    SWAP(17, 21); \
+    SWAP(18, 22); \
+    SWAP(19, 23); \
+    SWAP(24, 28); \
+    SWAP(25, 29); \
+    SWAP(26, 30); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(18, 20); \
+    SWAP(19, 21); \
+    SWAP(26, 28); \
+    SWAP(27, 29); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(17, 18); \
+    SWAP(19, 20); \
+    SWAP(21, 22); \
+    SWAP(25, 26); \
+    SWAP(27, 28); \
+    SWAP(29, 30); \
+    SWAP(0, 8); \
+    SWAP(1, 9); \
+    SWAP(2, 10); \
+    SWAP(3, 11); \
+    SWAP(4, 12); \
+    SWAP(5, 13); \
+    SWAP(6, 14); \
+    SWAP(7, 15); \
+    SWAP(16, 24); \
+    SWAP(17, 25); \
+    SWAP(18, 26); \
+    SWAP(19, 27); \
+    SWAP(20, 28); \
+    SWAP(21, 29); \
+    SWAP(22, 30); \
+    SWAP(4, 8); \
+    SWAP(5, 9); \
+    SWAP(6, 10); \
+    SWAP(7, 11); \
+    SWAP(20, 24); \
+    SWAP(21, 25); \
+    SWAP(22, 26); \
+    SWAP(23, 27); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(6, 8); \
+    SWAP(7, 9); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(18, 20); \
+    SWAP(19, 21); \
+    SWAP(22, 24); \
+    SWAP(23, 25); \
+    SWAP(26, 28); \
+    SWAP(27, 29); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(7, 8); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(17, 18); \
+    SWAP(19, 20); \
+    SWAP(21, 22); \
+    SWAP(23, 24); \
+    SWAP(25, 26); \
+    SWAP(27, 28); \
+    SWAP(29, 30); \
+    SWAP(0, 16); \
+    SWAP(1, 17); \
+    SWAP(2, 18); \
+    SWAP(3, 19); \
+    SWAP(4, 20); \
+    SWAP(5, 21); \
+    SWAP(6, 22); \
+    SWAP(7, 23); \
+    SWAP(8, 24); \
+    SWAP(9, 25); \
+    SWAP(10, 26); \
+    SWAP(11, 27); \
+    SWAP(12, 28); \
+    SWAP(13, 29); \
+    SWAP(14, 30); \
+    SWAP(8, 16); \
+    SWAP(9, 17); \
+    SWAP(10, 18); \
+    SWAP(11, 19); \
+    SWAP(12, 20); \
+    SWAP(13, 21); \
+    SWAP(14, 22); \
+    SWAP(15, 23); \
+    SWAP(4, 8); \
+    SWAP(5, 9); \
+    SWAP(6, 10); \
+    SWAP(7, 11); \
+    SWAP(12, 16); \
+    SWAP(13, 17); \
+    SWAP(14, 18); \
+    SWAP(15, 19); \
+    SWAP(20, 24); \
+    SWAP(21, 25); \
+    SWAP(22, 26); \
+    SWAP(23, 27); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(6, 8); \
+    SWAP(7, 9); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(14, 16); \
+    SWAP(15, 17); \
+    SWAP(18, 20); \
+    SWAP(19, 21); \
+    SWAP(22, 24); \
+    SWAP(23, 25); \
+    SWAP(26, 28); \
+    SWAP(27, 29); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(7, 8); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(15, 16); \
+    SWAP(17, 18); \
+    SWAP(19, 20); \
+    SWAP(21, 22); \
+    SWAP(23, 24); \
+    SWAP(25, 26); \
+    SWAP(27, 28); \
+    SWAP(29, 30);
+
+#define XOR_SORTING_NETWORK_32 \
+    SWAP(0, 1); \
+    SWAP(2, 3); \
+    SWAP(4, 5); \
+    SWAP(6, 7); \
+    SWAP(8, 9); \
+    SWAP(10, 11); \
+    SWAP(12, 13); \
+    SWAP(14, 15); \
+    SWAP(16, 17); \
+    SWAP(18, 19); \
+    SWAP(20, 21); \
+    SWAP(22, 23); \
+    SWAP(24, 25); \
+    SWAP(26, 27); \
+    SWAP(28, 29); \
+    SWAP(30, 31); \
+    SWAP(0, 2); \
+    SWAP(1, 3); \
+    SWAP(4, 6); \
+    SWAP(5, 7); \
+    SWAP(8, 10); \
+    SWAP(9, 11); \
+    SWAP(12, 14); \
+    SWAP(13, 15); \
+    SWAP(16, 18); \
+    SWAP(17, 19); \
+    SWAP(20, 22); \
+    SWAP(21, 23); \
+    SWAP(24, 26); \
+    SWAP(25, 27); \
+    SWAP(28, 30); \
+    SWAP(29, 31); \
+    SWAP(1, 2); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(13, 14); \
+    SWAP(17, 18); \
+    SWAP(21, 22); \
+    SWAP(25, 26); \
+    SWAP(29, 30); \
+    SWAP(0, 4); \
+    SWAP(1, 5); \
+    SWAP(2, 6); \
+    SWAP(3, 7); \
+    SWAP(8, 12); \
+    SWAP(9, 13); \
+    SWAP(10, 14); \
+    SWAP(11, 15); \
+    SWAP(16, 20); \
+    SWAP(17, 21); \
+    SWAP(18, 22); \
+    SWAP(19, 23); \
+    SWAP(24, 28); \
+    SWAP(25, 29); \
+    SWAP(26, 30); \
+    SWAP(27, 31); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(18, 20); \
+    SWAP(19, 21); \
+    SWAP(26, 28); \
+    SWAP(27, 29); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(17, 18); \
+    SWAP(19, 20); \
+    SWAP(21, 22); \
+    SWAP(25, 26); \
+    SWAP(27, 28); \
+    SWAP(29, 30); \
+    SWAP(0, 8); \
+    SWAP(1, 9); \
+    SWAP(2, 10); \
+    SWAP(3, 11); \
+    SWAP(4, 12); \
+    SWAP(5, 13); \
+    SWAP(6, 14); \
+    SWAP(7, 15); \
+    SWAP(16, 24); \
+    SWAP(17, 25); \
+    SWAP(18, 26); \
+    SWAP(19, 27); \
+    SWAP(20, 28); \
+    SWAP(21, 29); \
+    SWAP(22, 30); \
+    SWAP(23, 31); \
+    SWAP(4, 8); \
+    SWAP(5, 9); \
+    SWAP(6, 10); \
+    SWAP(7, 11); \
+    SWAP(20, 24); \
+    SWAP(21, 25); \
+    SWAP(22, 26); \
+    SWAP(23, 27); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(6, 8); \
+    SWAP(7, 9); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(18, 20); \
+    SWAP(19, 21); \
+    SWAP(22, 24); \
+    SWAP(23, 25); \
+    SWAP(26, 28); \
+    SWAP(27, 29); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(7, 8); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(17, 18); \
+    SWAP(19, 20); \
+    SWAP(21, 22); \
+    SWAP(23, 24); \
+    SWAP(25, 26); \
+    SWAP(27, 28); \
+    SWAP(29, 30); \
+    SWAP(0, 16); \
+    SWAP(1, 17); \
+    SWAP(2, 18); \
+    SWAP(3, 19); \
+    SWAP(4, 20); \
+    SWAP(5, 21); \
+    SWAP(6, 22); \
+    SWAP(7, 23); \
+    SWAP(8, 24); \
+    SWAP(9, 25); \
+    SWAP(10, 26); \
+    SWAP(11, 27); \
+    SWAP(12, 28); \
+    SWAP(13, 29); \
+    SWAP(14, 30); \
+    SWAP(15, 31); \
+    SWAP(8, 16); \
+    SWAP(9, 17); \
+    SWAP(10, 18); \
+    SWAP(11, 19); \
+    SWAP(12, 20); \
+    SWAP(13, 21); \
+    SWAP(14, 22); \
+    SWAP(15, 23); \
+    SWAP(4, 8); \
+    SWAP(5, 9); \
+    SWAP(6, 10); \
+    SWAP(7, 11); \
+    SWAP(12, 16); \
+    SWAP(13, 17); \
+    SWAP(14, 18); \
+    SWAP(15, 19); \
+    SWAP(20, 24); \
+    SWAP(21, 25); \
+    SWAP(22, 26); \
+    SWAP(23, 27); \
+    SWAP(2, 4); \
+    SWAP(3, 5); \
+    SWAP(6, 8); \
+    SWAP(7, 9); \
+    SWAP(10, 12); \
+    SWAP(11, 13); \
+    SWAP(14, 16); \
+    SWAP(15, 17); \
+    SWAP(18, 20); \
+    SWAP(19, 21); \
+    SWAP(22, 24); \
+    SWAP(23, 25); \
+    SWAP(26, 28); \
+    SWAP(27, 29); \
+    SWAP(1, 2); \
+    SWAP(3, 4); \
+    SWAP(5, 6); \
+    SWAP(7, 8); \
+    SWAP(9, 10); \
+    SWAP(11, 12); \
+    SWAP(13, 14); \
+    SWAP(15, 16); \
+    SWAP(17, 18); \
+    SWAP(19, 20); \
+    SWAP(21, 22); \
+    SWAP(23, 24); \
+    SWAP(25, 26); \
+    SWAP(27, 28); \
+    SWAP(29, 30);
+
 #endif
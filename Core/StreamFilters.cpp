@@ -0,0 +1,397 @@
+#include "Core/StreamFilters.hpp"
+
+#include <emmintrin.h>
+
+#include <vector>
+#include <limits>
+#include <cmath>
+
+namespace Xor
+{
+    // Quantized streams begin with the minimum and the scale of each
+    // component as floats.
+    static size_t quantizationHeaderSize(uint components)
+    {
+        return components * 2 * sizeof(float);
+    }
+
+    // Deltas are computed between 16-bit quantized values, and otherwise
+    // between 32-bit components if the elements consist of them.
+    static uint deltaLaneSize(uint storedSize, bool quantized)
+    {
+        uint lane = (quantized || storedSize % 4 != 0) ? 2 : 4;
+        XOR_THROW(storedSize % lane == 0, StreamFilterException,
+                  "Delta filter requires elements of 16-bit or 32-bit components");
+        return lane;
+    }
+
+    template <typename T>
+    static T loadLane(const uint8_t *p)
+    {
+        T v;
+        memcpy(&v, p, sizeof(T));
+        return v;
+    }
+
+    template <typename T>
+    static void storeLane(uint8_t *p, T v)
+    {
+        memcpy(p, &v, sizeof(T));
+    }
+
+    static DynamicBuffer<uint8_t> quantize(Span<const uint8_t> elements, size_t count, uint components)
+    {
+        std::vector<float> minimum(components,  std::numeric_limits<float>::max());
+        std::vector<float> maximum(components, -std::numeric_limits<float>::max());
+
+        // The elements may come straight from a file, so they
+        // are not necessarily aligned.
+        auto value = [&] (size_t i, uint c)
+        {
+            return loadLane<float>(elements.data() + (i * components + c) * sizeof(float));
+        };
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            for (uint c = 0; c < components; ++c)
+            {
+                float v = value(i, c);
+                if (std::isfinite(v))
+                {
+                    minimum[c] = std::min(minimum[c], v);
+                    maximum[c] = std::max(maximum[c], v);
+                }
+            }
+        }
+
+        DynamicBuffer<uint8_t> quantized(quantizationHeaderSize(components) + count * components * sizeof(uint16_t));
+        uint8_t *header = quantized.data();
+        uint16_t *dst   = reinterpret_cast<uint16_t *>(quantized.data() + quantizationHeaderSize(components));
+
+        for (uint c = 0; c < components; ++c)
+        {
+            if (minimum[c] > maximum[c])
+                minimum[c] = maximum[c] = 0;
+
+            float range = maximum[c] - minimum[c];
+            float scale = range / 65535.f;
+            float toQuantized = range > 0 ? 65535.f / range : 0;
+
+            storeLane(header + (c * 2 + 0) * sizeof(float), minimum[c]);
+            storeLane(header + (c * 2 + 1) * sizeof(float), scale);
+
+            for (size_t i = 0; i < count; ++i)
+            {
+                float q = std::round((value(i, c) - minimum[c]) * toQuantized);
+                // Also maps NaN to zero.
+                q = q > 0 ? std::min(q, 65535.f) : 0;
+                dst[i * components + c] = static_cast<uint16_t>(q);
+            }
+        }
+
+        return quantized;
+    }
+
+    static void dequantize(float *dst, const uint16_t *src, size_t count, uint components,
+                           Span<const uint8_t> header)
+    {
+        // The component pattern repeats every lcm(components, 4) values,
+        // so the minimums and scales for SIMD are tabulated for that period.
+        uint period = components;
+        while (period % 4 != 0)
+            period += components;
+
+        std::vector<float> minimum(period);
+        std::vector<float> scale(period);
+        for (uint i = 0; i < period; ++i)
+        {
+            uint c = i % components;
+            minimum[i] = loadLane<float>(header.data() + (c * 2 + 0) * sizeof(float));
+            scale[i]   = loadLane<float>(header.data() + (c * 2 + 1) * sizeof(float));
+        }
+
+        size_t values = count * components;
+        size_t v      = 0;
+        __m128i zero  = _mm_setzero_si128();
+
+        for (; v + period <= values; v += period)
+        {
+            for (uint i = 0; i < period; i += 4)
+            {
+                __m128i q = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(src + v + i));
+                __m128 f  = _mm_cvtepi32_ps(_mm_unpacklo_epi16(q, zero));
+                f = _mm_add_ps(_mm_mul_ps(f, _mm_loadu_ps(&scale[i])), _mm_loadu_ps(&minimum[i]));
+                _mm_storeu_ps(dst + v + i, f);
+            }
+        }
+
+        for (; v < values; ++v)
+        {
+            uint i = static_cast<uint>(v % period);
+            dst[v] = minimum[i] + static_cast<float>(src[v]) * scale[i];
+        }
+    }
+
+    static void deltaEncode(uint8_t *stream, size_t count, uint storedSize, uint laneSize)
+    {
+        // Go backwards so that the previous element is still intact.
+        for (size_t i = count; i-- > 1;)
+        {
+            uint8_t *element  = stream + i * storedSize;
+            uint8_t *previous = element - storedSize;
+
+            for (uint l = 0; l < storedSize; l += laneSize)
+            {
+                if (laneSize == 4)
+                {
+                    int32_t d = static_cast<int32_t>(loadLane<uint32_t>(element + l) - loadLane<uint32_t>(previous + l));
+                    storeLane(element + l, (static_cast<uint32_t>(d) << 1) ^ static_cast<uint32_t>(d >> 31));
+                }
+                else
+                {
+                    int16_t d = static_cast<int16_t>(loadLane<uint16_t>(element + l) - loadLane<uint16_t>(previous + l));
+                    storeLane(element + l, static_cast<uint16_t>((static_cast<uint16_t>(d) << 1) ^ static_cast<uint16_t>(d >> 15)));
+                }
+            }
+        }
+    }
+
+    static void deltaDecode(uint8_t *stream, size_t count, uint storedSize, uint laneSize)
+    {
+        if (count <= 1)
+            return;
+
+        size_t i = 1;
+
+        // Index buffers have a single lane, and their prefix sums are
+        // computed four or eight lanes at a time.
+        if (storedSize == laneSize)
+        {
+            __m128i one  = laneSize == 4 ? _mm_set1_epi32(1) : _mm_set1_epi16(1);
+            __m128i zero = _mm_setzero_si128();
+            uint lanesPerVector = 16 / laneSize;
+
+            if (laneSize == 4)
+            {
+                __m128i previous = _mm_set1_epi32(static_cast<int>(loadLane<uint32_t>(stream)));
+                for (; i + lanesPerVector <= count; i += lanesPerVector)
+                {
+                    auto p    = reinterpret_cast<__m128i *>(stream + i * 4);
+                    __m128i v = _mm_loadu_si128(p);
+                    v = _mm_xor_si128(_mm_srli_epi32(v, 1), _mm_sub_epi32(zero, _mm_and_si128(v, one)));
+                    v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+                    v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+                    v = _mm_add_epi32(v, previous);
+                    _mm_storeu_si128(p, v);
+                    previous = _mm_shuffle_epi32(v, _MM_SHUFFLE(3, 3, 3, 3));
+                }
+            }
+            else
+            {
+                __m128i previous = _mm_set1_epi16(static_cast<short>(loadLane<uint16_t>(stream)));
+                for (; i + lanesPerVector <= count; i += lanesPerVector)
+                {
+                    auto p    = reinterpret_cast<__m128i *>(stream + i * 2);
+                    __m128i v = _mm_loadu_si128(p);
+                    v = _mm_xor_si128(_mm_srli_epi16(v, 1), _mm_sub_epi16(zero, _mm_and_si128(v, one)));
+                    v = _mm_add_epi16(v, _mm_slli_si128(v, 2));
+                    v = _mm_add_epi16(v, _mm_slli_si128(v, 4));
+                    v = _mm_add_epi16(v, _mm_slli_si128(v, 8));
+                    v = _mm_add_epi16(v, previous);
+                    _mm_storeu_si128(p, v);
+                    previous = _mm_set1_epi16(static_cast<short>(_mm_extract_epi16(v, 7)));
+                }
+            }
+        }
+
+        for (; i < count; ++i)
+        {
+            uint8_t *element  = stream + i * storedSize;
+            uint8_t *previous = element - storedSize;
+
+            for (uint l = 0; l < storedSize; l += laneSize)
+            {
+                if (laneSize == 4)
+                {
+                    uint32_t z = loadLane<uint32_t>(element + l);
+                    uint32_t d = (z >> 1) ^ (0u - (z & 1));
+                    storeLane(element + l, loadLane<uint32_t>(previous + l) + d);
+                }
+                else
+                {
+                    uint16_t z = loadLane<uint16_t>(element + l);
+                    uint16_t d = static_cast<uint16_t>((z >> 1) ^ (0u - (z & 1)));
+                    storeLane(element + l, static_cast<uint16_t>(loadLane<uint16_t>(previous + l) + d));
+                }
+            }
+        }
+    }
+
+    static void shuffle(uint8_t *dst, const uint8_t *src, size_t count, uint storedSize)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            for (uint b = 0; b < storedSize; ++b)
+                dst[b * count + i] = src[i * storedSize + b];
+        }
+    }
+
+    static void unshuffle(uint8_t *dst, const uint8_t *src, size_t count, uint storedSize)
+    {
+        // Sixteen elements at a time, planes are interleaved four or two
+        // at a time, and the resulting pieces of elements are scattered
+        // into place unless the elements consist of just those planes.
+        size_t simdCount = count & ~static_cast<size_t>(15);
+        uint b = 0;
+
+        for (; b + 4 <= storedSize; b += 4)
+        {
+            const uint8_t *plane = src + b * count;
+            for (size_t i = 0; i < simdCount; i += 16)
+            {
+                __m128i p0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(plane + 0 * count + i));
+                __m128i p1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(plane + 1 * count + i));
+                __m128i p2 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(plane + 2 * count + i));
+                __m128i p3 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(plane + 3 * count + i));
+
+                __m128i p01lo = _mm_unpacklo_epi8(p0, p1);
+                __m128i p01hi = _mm_unpackhi_epi8(p0, p1);
+                __m128i p23lo = _mm_unpacklo_epi8(p2, p3);
+                __m128i p23hi = _mm_unpackhi_epi8(p2, p3);
+
+                __m128i pieces[4] =
+                {
+                    _mm_unpacklo_epi16(p01lo, p23lo),
+                    _mm_unpackhi_epi16(p01lo, p23lo),
+                    _mm_unpacklo_epi16(p01hi, p23hi),
+                    _mm_unpackhi_epi16(p01hi, p23hi),
+                };
+
+                if (storedSize == 4)
+                {
+                    for (uint v = 0; v < 4; ++v)
+                        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 4 + v * 16), pieces[v]);
+                }
+                else
+                {
+                    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(pieces);
+                    for (uint e = 0; e < 16; ++e)
+                        memcpy(dst + (i + e) * storedSize + b, bytes + e * 4, 4);
+                }
+            }
+        }
+
+        for (; b + 2 <= storedSize; b += 2)
+        {
+            const uint8_t *plane = src + b * count;
+            for (size_t i = 0; i < simdCount; i += 16)
+            {
+                __m128i p0 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(plane + 0 * count + i));
+                __m128i p1 = _mm_loadu_si128(reinterpret_cast<const __m128i *>(plane + 1 * count + i));
+
+                __m128i pieces[2] =
+                {
+                    _mm_unpacklo_epi8(p0, p1),
+                    _mm_unpackhi_epi8(p0, p1),
+                };
+
+                if (storedSize == 2)
+                {
+                    for (uint v = 0; v < 2; ++v)
+                        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i * 2 + v * 16), pieces[v]);
+                }
+                else
+                {
+                    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(pieces);
+                    for (uint e = 0; e < 16; ++e)
+                        memcpy(dst + (i + e) * storedSize + b, bytes + e * 2, 2);
+                }
+            }
+        }
+
+        for (; b < storedSize; ++b)
+        {
+            for (size_t i = 0; i < simdCount; ++i)
+                dst[i * storedSize + b] = src[b * count + i];
+        }
+
+        for (size_t i = simdCount; i < count; ++i)
+        {
+            for (b = 0; b < storedSize; ++b)
+                dst[i * storedSize + b] = src[b * count + i];
+        }
+    }
+
+    static void checkFilters(uint filters, uint elementSize)
+    {
+        XOR_THROW((filters & ~StreamFilter::All) == 0, StreamFilterException, "Unknown stream filters 0x%x", filters);
+        XOR_THROW(elementSize > 0, StreamFilterException, "Stream elements must not be empty");
+        XOR_THROW(!(filters & StreamFilter::Quantize16) || elementSize % sizeof(float) == 0,
+                  StreamFilterException, "Quantize16 filter requires elements of 32-bit floats");
+    }
+
+    DynamicBuffer<uint8_t> encodeStream(uint filters, Span<const uint8_t> elements, uint elementSize)
+    {
+        checkFilters(filters, elementSize);
+        XOR_THROW(elements.size() % elementSize == 0, StreamFilterException,
+                  "Stream size is not a multiple of the element size");
+
+        size_t count      = elements.size() / elementSize;
+        bool quantized    = !!(filters & StreamFilter::Quantize16);
+        uint components   = elementSize / sizeof(float);
+        uint storedSize   = quantized ? components * static_cast<uint>(sizeof(uint16_t)) : elementSize;
+        size_t headerSize = quantized ? quantizationHeaderSize(components) : 0;
+
+        DynamicBuffer<uint8_t> encoded = quantized
+            ? quantize(elements, count, components)
+            : DynamicBuffer<uint8_t>(elements);
+        uint8_t *stream = encoded.data() + headerSize;
+
+        if (filters & StreamFilter::Delta)
+            deltaEncode(stream, count, storedSize, deltaLaneSize(storedSize, quantized));
+
+        if (filters & StreamFilter::ByteShuffle)
+        {
+            DynamicBuffer<uint8_t> unshuffled(Span<const uint8_t>(stream, count * storedSize));
+            shuffle(stream, unshuffled.data(), count, storedSize);
+        }
+
+        return encoded;
+    }
+
+    DynamicBuffer<uint8_t> decodeStream(uint filters, Span<const uint8_t> encoded, uint elementSize)
+    {
+        checkFilters(filters, elementSize);
+
+        bool quantized    = !!(filters & StreamFilter::Quantize16);
+        uint components   = elementSize / sizeof(float);
+        uint storedSize   = quantized ? components * static_cast<uint>(sizeof(uint16_t)) : elementSize;
+        size_t headerSize = quantized ? quantizationHeaderSize(components) : 0;
+
+        XOR_THROW(encoded.size() >= headerSize && (encoded.size() - headerSize) % storedSize == 0,
+                  StreamFilterException, "Encoded stream size is invalid");
+
+        size_t count = (encoded.size() - headerSize) / storedSize;
+        Span<const uint8_t> header(encoded.data(), headerSize);
+        const uint8_t *src = encoded.data() + headerSize;
+
+        DynamicBuffer<uint8_t> stream(count * storedSize);
+
+        if (filters & StreamFilter::ByteShuffle)
+            unshuffle(stream.data(), src, count, storedSize);
+        else if (count > 0)
+            memcpy(stream.data(), src, stream.size());
+
+        if (filters & StreamFilter::Delta)
+            deltaDecode(stream.data(), count, storedSize, deltaLaneSize(storedSize, quantized));
+
+        if (!quantized)
+            return stream;
+
+        DynamicBuffer<uint8_t> elements(count * elementSize);
+        dequantize(reinterpret_cast<float *>(elements.data()),
+                   reinterpret_cast<const uint16_t *>(stream.data()),
+                   count, components, header);
+        return elements;
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "Core/Utils.hpp"
+#include "Core/Exception.hpp"
+
+namespace Xor
+{
+    // Reversible transforms for arrays of fixed size elements, such as
+    // vertex and index streams, that make them compress much better.
+    // Any combination of filters can be used. They are applied in the
+    // order listed when encoding, and in reverse when decoding.
+    struct StreamFilter
+    {
+        enum Flags : uint8_t
+        {
+            None        = 0,
+            // Elements of 32-bit floats are quantized to 16 bits within
+            // the range of each component. This is the only lossy filter.
+            Quantize16  = 1 << 0,
+            // Components are replaced by zigzag coded differences to the
+            // same component of the previous element, which turns
+            // mostly increasing data such as indices into small numbers.
+            Delta       = 1 << 1,
+            // Byte i of every element is stored in plane i, so that e.g.
+            // the rarely changing exponent bytes of floats are together.
+            ByteShuffle = 1 << 2,
+
+            All         = Quantize16 | Delta | ByteShuffle,
+        };
+    };
+
+    XOR_EXCEPTION_TYPE(StreamFilterException)
+
+    // Encode elements of elementSize bytes with the given StreamFilter flags.
+    DynamicBuffer<uint8_t> encodeStream(uint filters, Span<const uint8_t> elements, uint elementSize);
+    // Decode a stream encoded with encodeStream(), and return its elements.
+    DynamicBuffer<uint8_t> decodeStream(uint filters, Span<const uint8_t> encoded, uint elementSize);
+}
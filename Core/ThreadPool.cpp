@@ -0,0 +1,141 @@
+#include "Core/ThreadPool.hpp"
+
+namespace Xor
+{
+    static thread_local bool g_isWorkerThread = false;
+
+    ThreadPool::ThreadPool(int threads)
+    {
+        if (threads < 0)
+            threads = std::max(static_cast<int>(std::thread::hardware_concurrency()) - 1, 0);
+
+        m_threads.reserve(static_cast<size_t>(threads));
+        for (int i = 0; i < threads; ++i)
+            m_threads.emplace_back([this] { workerThread(); });
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_quit = true;
+        }
+        m_jobAvailable.notify_all();
+
+        for (auto &t : m_threads)
+            t.join();
+    }
+
+    ThreadPool &ThreadPool::global()
+    {
+        static ThreadPool pool;
+        return pool;
+    }
+
+    bool ThreadPool::isWorkerThread()
+    {
+        return g_isWorkerThread;
+    }
+
+    void ThreadPool::run(std::function<void()> job)
+    {
+        // Without workers, the job has to run right away.
+        if (m_threads.empty())
+        {
+            job();
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_jobs.emplace_back(std::move(job));
+        }
+        m_jobAvailable.notify_one();
+    }
+
+    void ThreadPool::workerThread()
+    {
+        g_isWorkerThread = true;
+
+        for (;;)
+        {
+            std::function<void()> job;
+
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_jobAvailable.wait(lock, [this] { return m_quit || !m_jobs.empty(); });
+                if (m_jobs.empty())
+                    return;
+
+                job = std::move(m_jobs.front());
+                m_jobs.pop_front();
+            }
+
+            job();
+        }
+    }
+
+    // Shared between a parallel call and its helper jobs. The jobs may
+    // only start running after the call has already returned, if all
+    // of the work got done before a worker was free to run them.
+    struct ParallelCall
+    {
+        std::mutex              mutex;
+        std::condition_variable finished;
+        uint                    running = 0;
+        bool                    closed  = false;
+        std::exception_ptr      error;
+
+        void run(const std::function<void()> &f)
+        {
+            try
+            {
+                f();
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!error)
+                    error = std::current_exception();
+            }
+        }
+    };
+
+    void ThreadPool::runOnThreads(uint helperThreads, const std::function<void()> &f)
+    {
+        auto call = std::make_shared<ParallelCall>();
+
+        for (uint i = 0; i < helperThreads; ++i)
+        {
+            run([call, &f]
+            {
+                {
+                    std::lock_guard<std::mutex> lock(call->mutex);
+                    // f is no longer valid once the call has been closed.
+                    if (call->closed)
+                        return;
+                    ++call->running;
+                }
+
+                call->run(f);
+
+                std::lock_guard<std::mutex> lock(call->mutex);
+                if (--call->running == 0)
+                    call->finished.notify_one();
+            });
+        }
+
+        call->run(f);
+
+        // Helpers that have not started yet will find nothing left to do,
+        // so only wait for the ones that are running.
+        {
+            std::unique_lock<std::mutex> lock(call->mutex);
+            call->closed = true;
+            call->finished.wait(lock, [&] { return call->running == 0; });
+        }
+
+        if (call->error)
+            std::rethrow_exception(call->error);
+    }
+}
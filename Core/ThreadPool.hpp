@@ -0,0 +1,82 @@
+#pragma once
+
+#include "Core/Utils.hpp"
+
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+namespace Xor
+{
+    // Fixed set of worker threads that run jobs from a shared queue.
+    class ThreadPool
+    {
+        std::vector<std::thread>          m_threads;
+        std::mutex                        m_mutex;
+        std::condition_variable           m_jobAvailable;
+        std::deque<std::function<void()>> m_jobs;
+        bool                              m_quit = false;
+
+        void workerThread();
+        // Run the function on the calling thread and on up to
+        // helperThreads workers, and wait for all of them to return.
+        // Helpers that start late are skipped, so the function must
+        // only return once there is no work left for it to claim.
+        void runOnThreads(uint helperThreads, const std::function<void()> &f);
+    public:
+        // By default, there is one worker for every hardware thread
+        // except the calling one, which also runs jobs in parallelFor().
+        ThreadPool(int threads = -1);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool &) = delete;
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        // The pool shared by everything in the process.
+        static ThreadPool &global();
+        // True if the calling thread is a worker of any pool.
+        static bool isWorkerThread();
+
+        uint threadCount() const { return static_cast<uint>(m_threads.size()); }
+
+        // Run the job on some worker thread.
+        void run(std::function<void()> job);
+
+        // Call f(i) for every i in [0, count) in parallel, and return when
+        // all of the calls have completed. If any call throws, one of the
+        // exceptions is rethrown after the rest have completed. Calls from
+        // worker threads run serially to avoid deadlocking the pool.
+        template <typename F>
+        void parallelFor(size_t count, F &&f)
+        {
+            if (count == 0)
+                return;
+
+            std::atomic<size_t> next { 0 };
+            auto helpers = static_cast<uint>(std::min<size_t>(threadCount(), count - 1));
+
+            runOnThreads(isWorkerThread() ? 0 : helpers, [&]
+            {
+                for (;;)
+                {
+                    size_t i = next.fetch_add(1, std::memory_order_relaxed);
+                    if (i >= count)
+                        break;
+                    f(i);
+                }
+            });
+        }
+    };
+
+    template <typename F>
+    void parallelFor(size_t count, F &&f)
+    {
+        ThreadPool::global().parallelFor(count, std::forward<F>(f));
+    }
+}
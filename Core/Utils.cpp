@@ -5,6 +5,7 @@
 #include "Math.hpp"
 
 #include <cstring>
+#include <intrin.h>
 #include <vector>
 
 namespace Xor
@@ -185,4 +186,57 @@ namespace Xor
     {
         return String::format("%f", d);
     }
+
+    struct CpuFeatures
+    {
+        bool avx2     = false;
+        bool bmi2     = false;
+        bool fastPdep = false;
+
+        CpuFeatures()
+        {
+            int info[4];
+            __cpuid(info, 0);
+            if (info[0] < 7)
+                return;
+
+            // "AuthenticAMD" in EBX, EDX, ECX
+            bool amd = info[1] == 0x68747541 && info[3] == 0x69746e65 && info[2] == 0x444d4163;
+
+            __cpuid(info, 1);
+            bool osxsave = (info[2] & (1 << 27)) != 0;
+            bool avx     = (info[2] & (1 << 28)) != 0;
+            uint family  = (info[0] >> 8) & 0xf;
+            if (family == 0xf)
+                family += (info[0] >> 20) & 0xff;
+
+            __cpuidex(info, 7, 0);
+            bmi2 = (info[1] & (1 << 8)) != 0;
+            // AMD CPUs before Zen 3 implement PDEP and PEXT in microcode.
+            fastPdep = bmi2 && !(amd && family < 0x19);
+            // The OS must also preserve the upper halves of YMM registers.
+            avx2 = (info[1] & (1 << 5)) != 0 && osxsave && avx && (_xgetbv(0) & 6) == 6;
+        }
+    };
+
+    static const CpuFeatures &cpuFeatures()
+    {
+        static CpuFeatures features;
+        return features;
+    }
+
+    bool cpuSupportsAVX2()
+    {
+        return cpuFeatures().avx2;
+    }
+
+    bool cpuSupportsBMI2()
+    {
+        return cpuFeatures().bmi2;
+    }
+
+    bool cpuHasFastPDEP()
+    {
+        return cpuFeatures().fastPdep;
+    }
 }
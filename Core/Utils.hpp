@@ -153,7 +153,15 @@ namespace Xor
         {}
 
         Handle(Handle &&) = default;
-        Handle &operator=(Handle &&) = default;
+        Handle &operator=(Handle &&h)
+        {
+            if (this != &h)
+            {
+                close();
+                m_handle = std::move(h.m_handle);
+            }
+            return *this;
+        }
 
         ~Handle()
         {
@@ -671,21 +679,36 @@ namespace Xor
     String toString(float f);
     String toString(double d);
 
+    // Instruction set extensions for choosing code paths at runtime.
+    // AVX2 also requires support from the OS.
+    bool cpuSupportsAVX2();
+    bool cpuSupportsBMI2();
+    // BMI2 with PDEP and PEXT fast enough to prefer them over AVX2.
+    bool cpuHasFastPDEP();
+
     template <typename F>
     class ScopeGuard
     {
-        MovingPtr<F *> m_f;
+        // The function is stored by value, since it is usually
+        // a temporary lambda.
+        F    m_f;
+        bool m_active = true;
     public:
-        ScopeGuard(F &&f) : m_f(&f) {}
+        ScopeGuard(F &&f) : m_f(std::move(f)) {}
         ~ScopeGuard()
         {
-            if (m_f)
-                (*m_f)();
+            if (m_active)
+                m_f();
+        }
+        ScopeGuard(ScopeGuard &&g)
+            : m_f(std::move(g.m_f))
+            , m_active(g.m_active)
+        {
+            g.m_active = false;
         }
-        ScopeGuard(ScopeGuard &&) = default;
-        ScopeGuard &operator=(ScopeGuard &&) = default;
+        ScopeGuard &operator=(ScopeGuard &&) = delete;
 
-        void cancel() { m_f = nullptr; }
+        void cancel() { m_active = false; }
     };
 
     template <typename F>
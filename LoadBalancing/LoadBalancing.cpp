@@ -146,7 +146,7 @@ public:
             }
         }
 
-        sort(workload.correctOutput);
+        parallelRadixSort(workload.correctOutput);
 
         workload.inputSRV = device.createBufferSRV(info::BufferInfoBuilder()
                                                    .rawBuffer(sizeBytes(workload.input))
@@ -170,7 +170,7 @@ public:
 
         size_t size = std::min(output.size(), correct.size());
         std::vector<uint> sortedOutput(output.begin(), output.begin() + size);
-        sort(sortedOutput);
+        parallelRadixSort(sortedOutput);
 
         uint failures = 0;
 
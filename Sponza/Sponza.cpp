@@ -11,13 +11,11 @@ using namespace Xor;
 
 void debugMatrix(Matrix m, Span<const float3> verts)
 {
-    std::vector<float3> t;
+    std::vector<float3> t(verts.size());
+    transformAndProjectPoints(m, verts, t);
 
-    for (auto v : verts)
-    {
-        t.emplace_back(m.transformAndProject(v));
-        print("%s -> %s\n", toString(v).cStr(), toString(t.back()).cStr());
-    }
+    for (size_t i = 0; i < verts.size(); ++i)
+        print("%s -> %s\n", toString(verts[i]).cStr(), toString(t[i]).cStr());
 }
 
 class Sponza : public Window
@@ -16,7 +16,6 @@
 #include "TerrainShadowFiltering.sig.h"
 
 #include <random>
-#include <unordered_set>
 
 // Top CPU problems:
 // - CopyDescriptors
@@ -286,6 +285,8 @@ struct Heightmap
 {
     Device *device = nullptr;
     Image height;
+    // Copy of height for random access on the CPU.
+    RWImageData heightTiled;
     TextureSRV heightSRV;
     Image color;
     TextureSRV colorSRV;
@@ -327,6 +328,7 @@ struct Heightmap
         XOR_ASSERT(height.format() == DXGI_FORMAT_R32_FLOAT, "Expected a float heightmap");
 
         heightSRV = device.createTextureSRV(Texture::Info(height));
+        heightTiled = RWImageData(height.imageData(), ImageLayout::ZOrderTiled);
 
         size  = int2(height.size());
         this->texelSize = texelSize;
@@ -391,7 +393,7 @@ struct Terrain
     {
         this->device = device;
         this->heightmap = &heightmap;
-        heightData = heightmap.height.imageData();
+        heightData = heightmap.heightTiled;
 
         uniformGrid(Rect::withSize(heightmap.size));
     }
@@ -506,8 +508,10 @@ struct Terrain
 
         auto numVerts = mesh.numVertices();
 
+        FrameArenaScope arenaScope;
+
         int seenVertexCounter = 0;
-        std::vector<int> newVertexIndices;
+        FrameVector<int> newVertexIndices;
         std::vector<int> vertexForNewIndex(numVerts);
         auto newVertexIdx = [&] (int v)
         {
@@ -525,14 +529,14 @@ struct Terrain
             }
         };
 
-        std::vector<int> recentVertices;
-        std::vector<int> liveTriangles;
-        std::vector<uint8_t> triangleEmitted;
+        FrameVector<int> recentVertices;
+        FrameVector<int> liveTriangles;
+        FrameVector<uint8_t> triangleEmitted;
         std::vector<int> indices;
 
         constexpr int VertexCacheSize = 16;
         int vertexCacheTime = 0;
-        std::vector<int> vertexCacheTimestamps;
+        FrameVector<int> vertexCacheTimestamps;
 
         auto processVertex = [&] (int v)
         {
@@ -714,9 +718,10 @@ struct Terrain
             float2 vertexDistance = float2(area.size()) / float2(float(vertsPerSide - 1));
             int numVerts = vertsPerSide * vertsPerSide;
 
-            std::vector<int2>  pixelCoords;
-            std::vector<float> heights;
-            std::vector<uint>  indices;
+            FrameArenaScope arenaScope;
+            FrameVector<int2>  pixelCoords;
+            FrameVector<float> heights;
+            FrameVector<uint>  indices;
 
             pixelCoords.reserve(numVerts);
             heights.reserve(numVerts);
@@ -791,6 +796,8 @@ struct Terrain
             t.milliseconds());
     }
 
+    // VertexHash is only a parameter so different hashes can be benchmarked.
+    template <typename VertexHash = PodHash>
     void incrementalMaxError(Rect area, bool tipsify = true)
     {
         Timer timer;
@@ -827,9 +834,10 @@ struct Terrain
 
         Random gen(95832);
 
-        std::priority_queue<LargestError> largestError;
+        FrameArenaScope arenaScope;
+        std::priority_queue<LargestError, FrameVector<LargestError>> largestError;
         std::vector<int> newTriangles;
-        std::unordered_set<int2, PodHash, PodEqual> usedVertices;
+        FlatHashSet<int2, VertexHash, PodEqual> usedVertices;
 
         std::vector<MB> lods;
         std::vector<std::vector<Block32>> lodClusters;
@@ -912,9 +920,8 @@ struct Terrain
                     constexpr int InteriorSamples = 30;
                     constexpr int EdgeSamples = 0;
 
-                    auto errorAt = [&](float3 bary)
+                    auto errorAt = [&](float3 interpolated)
                     {
-                        float3 interpolated = interpolateBarycentric(float3(v0), float3(v1), float3(v2), bary);
                         Vert point = vertex(int2(interpolated));
 
                         float error = abs(float(point.z) - interpolated.z);
@@ -927,10 +934,33 @@ struct Terrain
                         }
                     };
 
-                    for (int i = 0; i < InteriorSamples; ++i)
+                    // Interpolate a packet of samples at once, and then look
+                    // them up in the heightmap one by one.
+                    constexpr int Width = NativePacketWidth;
+                    std::uniform_real_distribution<float> U;
+                    for (int i = 0; i < InteriorSamples; i += Width)
                     {
-                        float3 bary = uniformBarycentricGen(gen);
-                        errorAt(bary);
+                        int samples = std::min(Width, InteriorSamples - i);
+
+                        float r1[Width] = {};
+                        float r2[Width] = {};
+                        for (int j = 0; j < samples; ++j)
+                        {
+                            r1[j] = U(gen);
+                            r2[j] = U(gen);
+                        }
+
+                        auto bary = uniformBarycentric(Packet<float, Width>::load(r1),
+                                                       Packet<float, Width>::load(r2));
+                        auto interpolated = interpolateBarycentric(float3(v0), float3(v1), float3(v2), bary);
+
+                        float x[Width];
+                        float y[Width];
+                        float z[Width];
+                        interpolated.store(x, y, z);
+
+                        for (int j = 0; j < samples; ++j)
+                            errorAt(float3(x[j], y[j], z[j]));
                     }
 
                     for (int i = 0; i < EdgeSamples; ++i)
@@ -939,7 +969,7 @@ struct Terrain
                         int e = std::uniform_int_distribution<int>(0, 2)(gen);
                         float3 bary(0, x, 1 - x);
                         std::swap(bary[0], bary[e]);
-                        errorAt(bary);
+                        errorAt(interpolateBarycentric(float3(v0), float3(v1), float3(v2), bary));
                     }
 
                     triData.coords = largestErrorCoords;
@@ -964,7 +994,7 @@ struct Terrain
             // Add extra vertices on area boundaries so the overall shape ends up being
             // a rectangle.
             {
-                std::vector<std::pair<int2, int>> newBorderVerts;
+                FrameVector<std::pair<int2, int>> newBorderVerts;
 
                 auto spv = delaunay.superPolygonVertices();
                 for (int sv : spv.span())
@@ -2118,6 +2148,40 @@ public:
 #endif
     }
 
+    // Time the incremental max error triangulation of the current area
+    // with the old SpookyHash-based vertex hash and the current PodHash.
+    void benchmarkVertexHash()
+    {
+        constexpr int Runs = 5;
+
+        auto area = Rect::withSize(areaStart, areaSize);
+
+        auto measure = [&] (const char *name, auto hash)
+        {
+            using Hash = decltype(hash);
+
+            double best = std::numeric_limits<double>::max();
+            for (int i = 0; i < Runs; ++i)
+            {
+                Timer t;
+                terrain.incrementalMaxError<Hash>(area, false);
+                best = std::min(best, t.milliseconds());
+            }
+
+            log("Terrain", "incrementalMaxError with %-12s %8.2f ms (best of %d)\n",
+                name, best, Runs);
+            return best;
+        };
+
+        double spooky = measure("SpookyHash", SpookyPodHash());
+        double pod    = measure("PodHash", PodHash());
+
+        log("Terrain", "PodHash speedup: %.2fx\n", spooky / pod);
+
+        terrain.incrementalMaxError(area, tipsifyMesh);
+        terrain.calculateMeshError();
+    }
+
     void mainLoop(double deltaTime) override
     {
         camera.update(*this);
@@ -2163,6 +2227,9 @@ public:
 
             if (ImGui::Button("Measurement"))
                 measureTerrain();
+
+            if (ImGui::Button("Benchmark vertex hash"))
+                benchmarkVertexHash();
         }
         ImGui::End();
 
@@ -0,0 +1,2957 @@
+#include "Core/Core.hpp"
+#include "Core/ChunkFile.hpp"
+#include "Core/Compression.hpp"
+#include "Core/StreamFilters.hpp"
+#include "Core/Hash.hpp"
+#include "Core/FlatHash.hpp"
+#include "Core/AssetCache.hpp"
+#include "Core/Sorting.hpp"
+#include "Xor/DirectedEdge.hpp"
+#include "TestCore/TestUtils.hpp"
+
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <unordered_set>
+#include <unordered_map>
+
+using namespace Xor;
+using namespace Xor::test;
+
+// Checks that the given blocks don't overlap each other, and that they
+// account for all of the used space in the heap.
+template <typename Heap>
+void checkHeapBlocks(const Heap &heap, size_t heapSize, std::vector<Block> blocks)
+{
+    std::sort(blocks.begin(), blocks.end(),
+              [] (const Block &a, const Block &b) { return a.begin < b.begin; });
+
+    size_t used = 0;
+    for (size_t i = 0; i < blocks.size(); ++i)
+    {
+        XOR_CHECK(blocks[i].begin >= 0 && blocks[i].end <= static_cast<int64_t>(heapSize),
+                  "Block (%lld, %lld) is out of bounds",
+                  static_cast<lld>(blocks[i].begin), static_cast<lld>(blocks[i].end));
+        if (i > 0)
+        {
+            XOR_CHECK(blocks[i - 1].end <= blocks[i].begin,
+                      "Blocks (%lld, %lld) and (%lld, %lld) overlap",
+                      static_cast<lld>(blocks[i - 1].begin), static_cast<lld>(blocks[i - 1].end),
+                      static_cast<lld>(blocks[i].begin), static_cast<lld>(blocks[i].end));
+        }
+        used += blocks[i].size();
+    }
+
+    XOR_CHECK(heap.freeSpace() == heapSize - used, "Free space does not match the allocated blocks");
+}
+
+template <typename Heap>
+void testHeap(const char *name)
+{
+    static const size_t HeapSize     = 1 << 20;
+    static const uint   MinAlignment = 16;
+
+    Heap heap(HeapSize, MinAlignment);
+    Random gen;
+    std::vector<Block> blocks;
+
+    for (uint i = 0; i < 100000; ++i)
+    {
+        if (blocks.empty() || gen() % 3 != 0)
+        {
+            size_t size    = 1 + gen() % 4096;
+            uint alignment = 1U << (gen() % 9);
+            Block b        = heap.allocate(size, alignment);
+
+            if (b)
+            {
+                XOR_CHECK(b.begin % std::max(alignment, MinAlignment) == 0, "Block is misaligned");
+                XOR_CHECK(b.size() >= size, "Block is too small");
+                blocks.emplace_back(b);
+            }
+        }
+        else
+        {
+            size_t j = gen() % blocks.size();
+            heap.release(blocks[j]);
+            std::swap(blocks[j], blocks.back());
+            blocks.pop_back();
+        }
+
+        if (i % 10000 == 0)
+            checkHeapBlocks(heap, HeapSize, blocks);
+    }
+
+    checkHeapBlocks(heap, HeapSize, blocks);
+
+    for (auto &b : blocks)
+        heap.release(b);
+
+    // Everything should have coalesced back into one block.
+    XOR_CHECK(heap.empty(), "Heap is not empty after releasing everything");
+    Block all = heap.allocate(HeapSize);
+    XOR_CHECK(all.begin == 0 && all.size() == HeapSize, "Released blocks were not coalesced");
+    heap.release(all);
+
+    // Mark a header as allocated, like ChunkFile does.
+    XOR_CHECK(heap.resize(HeapSize * 2), "Failed to grow the heap");
+    XOR_CHECK(heap.markAsAllocated(Block(0, 64)), "Failed to mark a free block as allocated");
+    XOR_CHECK(!heap.markAsAllocated(Block(32, 128)), "Marked an allocated block as allocated");
+    Block b = heap.allocate(64);
+    XOR_CHECK(b.begin >= 64, "Allocated a block that was marked as allocated");
+    XOR_CHECK(!heap.resize(static_cast<size_t>(b.begin)), "Shrunk the heap over an allocated block");
+    heap.release(b);
+    XOR_CHECK(heap.resize(64), "Failed to shrink the heap");
+    XOR_CHECK(heap.full(), "Shrunk heap should be full");
+    heap.release(Block(0, 64));
+    XOR_CHECK(heap.empty(), "Heap is not empty after releasing the header");
+
+    print("%s: OK\n", name);
+}
+
+// Coalesced blocks must leave their size bins, so the bins never
+// hold more entries than there are gaps between allocated blocks.
+void testOffsetHeapBins()
+{
+    static const size_t HeapSize = 1 << 20;
+
+    OffsetHeap heap(HeapSize, 16);
+    Random gen;
+    std::vector<Block> blocks;
+
+    for (uint i = 0; i < 100000; ++i)
+    {
+        if (blocks.empty() || gen() % 3 != 0)
+        {
+            Block b = heap.allocate(1 + gen() % 4096, 1U << (gen() % 9));
+            if (b)
+                blocks.emplace_back(b);
+        }
+        else
+        {
+            size_t j = gen() % blocks.size();
+            heap.release(blocks[j]);
+            std::swap(blocks[j], blocks.back());
+            blocks.pop_back();
+        }
+
+        if (i % 1000 == 0)
+        {
+            std::vector<Block> sorted = blocks;
+            std::sort(sorted.begin(), sorted.end(),
+                      [] (const Block &a, const Block &b) { return a.begin < b.begin; });
+
+            size_t gaps = 0;
+            int64_t end = 0;
+            for (auto &b : sorted)
+            {
+                if (b.begin > end)
+                    ++gaps;
+                end = b.end;
+            }
+            if (end < static_cast<int64_t>(HeapSize))
+                ++gaps;
+
+            XOR_CHECK(heap.freeBlockCount() == gaps, "OffsetHeap has %zu free blocks in its size bins, expected %zu",
+                      heap.freeBlockCount(), gaps);
+        }
+    }
+
+    for (auto &b : blocks)
+        heap.release(b);
+    XOR_CHECK(heap.freeBlockCount() == 1, "Released blocks were not coalesced");
+
+    print("OffsetHeap size bins: OK\n");
+}
+
+void testBuddy()
+{
+    // Not a power of two, to test the excess at the end.
+    static const size_t HeapSize     = (1 << 20) + (1 << 18) + 4096;
+    static const size_t MinBlockSize = 16;
+
+    OffsetBuddy buddy(HeapSize, MinBlockSize);
+    Random gen;
+    std::vector<Block> blocks;
+
+    for (uint i = 0; i < 100000; ++i)
+    {
+        if (blocks.empty() || gen() % 3 != 0)
+        {
+            size_t size      = 1 + gen() % 4096;
+            size_t alignment = size_t(1) << (gen() % 9);
+            Block b          = buddy.allocate(size, alignment);
+
+            if (b)
+            {
+                XOR_CHECK(b.begin % static_cast<int64_t>(std::max(alignment, MinBlockSize)) == 0, "Block is misaligned");
+                XOR_CHECK(b.size() >= size, "Block is too small");
+                XOR_CHECK(popCount(b.size()) == 1, "Block size is not a power of two");
+                blocks.emplace_back(b);
+            }
+        }
+        else
+        {
+            size_t j = gen() % blocks.size();
+            buddy.release(blocks[j]);
+            std::swap(blocks[j], blocks.back());
+            blocks.pop_back();
+        }
+
+        if (i % 10000 == 0)
+            checkHeapBlocks(buddy, HeapSize, blocks);
+    }
+
+    checkHeapBlocks(buddy, HeapSize, blocks);
+
+    for (auto &b : blocks)
+        buddy.release(b);
+
+    // Everything should have merged back into the largest blocks.
+    XOR_CHECK(buddy.empty(), "Buddy allocator is not empty after releasing everything");
+    auto report = buddy.fragmentation();
+    XOR_CHECK(report.freeBytes == HeapSize, "Fragmentation report has the wrong free space");
+    XOR_CHECK(report.largestFreeBlock == (1 << 20), "Released blocks were not merged");
+    XOR_CHECK(report.freeBytesPerOrder[16] == (1 << 20) &&
+              report.freeBytesPerOrder[14] == (1 << 18) &&
+              report.freeBytesPerOrder[8]  == 4096,
+              "Released blocks were not merged");
+
+    Block all = buddy.allocate(1 << 20);
+    XOR_CHECK(all.begin == 0 && all.size() == (1 << 20), "Released blocks were not merged");
+    XOR_CHECK(!buddy.allocate(1 << 19), "Allocated more than there is space");
+    buddy.release(all);
+
+    print("OffsetBuddy: OK\n");
+}
+
+struct HeapOp
+{
+    size_t size      = 0;
+    uint   alignment = 0;
+    // Index of the live block to release, or -1 to allocate.
+    int64_t release  = -1;
+};
+
+// Generate a random sequence of allocations and releases
+// that keeps the heap partially full.
+std::vector<HeapOp> generateHeapOps(size_t count, size_t maxLiveBlocks, bool powerOfTwo = false)
+{
+    Random gen;
+    std::vector<HeapOp> ops;
+    ops.reserve(count);
+    size_t live = 0;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        HeapOp op;
+
+        if (live < maxLiveBlocks && (live == 0 || gen() % 2 == 0))
+        {
+            // Mostly small blocks, with the occasional large one.
+            op.size      = (gen() % 16 == 0)
+                ? 1 + gen() % (256 * 1024)
+                : 1 + gen() % 1024;
+            op.alignment = 1U << (gen() % 8);
+            if (powerOfTwo)
+                op.size = roundUpToPow2(op.size);
+            ++live;
+        }
+        else
+        {
+            op.release = static_cast<int64_t>(gen() % live);
+            --live;
+        }
+
+        ops.emplace_back(op);
+    }
+
+    return ops;
+}
+
+template <typename Heap>
+void printFragmentation(const Heap &heap) {}
+
+void printFragmentation(const OffsetBuddy &buddy)
+{
+    auto report = buddy.fragmentation();
+    print("    largest free block %zu bytes, free bytes per order:", report.largestFreeBlock);
+    for (uint k = 0; k < buddy.orders(); ++k)
+    {
+        if (report.freeBytesPerOrder[k])
+            print(" %zu: %zu", buddy.blockSize(k), report.freeBytesPerOrder[k]);
+    }
+    print("\n");
+}
+
+template <typename Heap>
+void benchmarkHeap(const char *name, const std::vector<HeapOp> &ops, size_t heapSize)
+{
+    Heap heap(heapSize, 16);
+    std::vector<Block> blocks;
+    blocks.reserve(ops.size());
+    size_t failures = 0;
+
+    Timer timer;
+    for (auto &op : ops)
+    {
+        if (op.release < 0)
+        {
+            Block b = heap.allocate(op.size, op.alignment);
+            if (!b)
+                ++failures;
+            blocks.emplace_back(b);
+        }
+        else
+        {
+            auto i = static_cast<size_t>(op.release);
+            if (blocks[i])
+                heap.release(blocks[i]);
+            blocks[i] = blocks.back();
+            blocks.pop_back();
+        }
+    }
+    double seconds = timer.seconds();
+
+    print("%-16s %10.2f ns/op, %zu failed allocations, %.2f%% free at the end\n",
+          name,
+          seconds * 1e9 / static_cast<double>(ops.size()),
+          failures,
+          100.0 * static_cast<double>(heap.freeSpace()) / static_cast<double>(heapSize));
+    printFragmentation(heap);
+}
+
+void benchmarkHeaps()
+{
+    static const size_t HeapSize = 256 * 1024 * 1024;
+
+    for (bool powerOfTwo : { false, true })
+    {
+        auto ops = generateHeapOps(2000000, 4096, powerOfTwo);
+
+        print("Heap benchmark, %zu operations, %s sizes:\n",
+              ops.size(),
+              powerOfTwo ? "power of two" : "arbitrary");
+        benchmarkHeap<OffsetHeap>("OffsetHeap", ops, HeapSize);
+        benchmarkHeap<OffsetHeapTLSF>("OffsetHeapTLSF", ops, HeapSize);
+        benchmarkHeap<OffsetBuddy>("OffsetBuddy", ops, HeapSize);
+    }
+}
+
+template <typename F>
+void runThreads(uint threadCount, F &&f)
+{
+    std::vector<std::thread> threads;
+    for (uint t = 0; t < threadCount; ++t)
+        threads.emplace_back(f, t);
+    for (auto &t : threads)
+        t.join();
+}
+
+void testConcurrentPool()
+{
+    static const size_t PoolSize = 4096;
+
+    // When used from one thread, the pool should behave exactly like OffsetPool.
+    {
+        OffsetPool reference(PoolSize);
+        ConcurrentOffsetPool pool(PoolSize);
+        std::vector<int64_t> offsets;
+        Random gen;
+
+        for (uint i = 0; i < 100000; ++i)
+        {
+            if (offsets.empty() || gen() % 3 != 0)
+            {
+                int64_t offset = pool.allocate();
+                XOR_CHECK(offset == reference.allocate(), "Allocated offset differs from OffsetPool");
+                if (offset >= 0)
+                    offsets.emplace_back(offset);
+            }
+            else
+            {
+                size_t j = gen() % offsets.size();
+                pool.release(offsets[j]);
+                reference.release(offsets[j]);
+                std::swap(offsets[j], offsets.back());
+                offsets.pop_back();
+            }
+
+            XOR_CHECK(pool.spaceLeft() == reference.spaceLeft(), "Space left differs from OffsetPool");
+        }
+    }
+
+    // Every offset must be owned by at most one thread at a time.
+    {
+        static const uint Threads = 16;
+        ConcurrentOffsetPool pool(PoolSize);
+        std::unique_ptr<std::atomic<uint8_t>[]> owned(new std::atomic<uint8_t>[PoolSize]);
+        for (size_t i = 0; i < PoolSize; ++i)
+            owned[i] = 0;
+
+        runThreads(Threads, [&] (uint t)
+        {
+            Random gen(t + 1);
+            std::vector<int64_t> offsets;
+
+            for (uint i = 0; i < 100000; ++i)
+            {
+                if (offsets.empty() || (offsets.size() < 512 && gen() % 2 == 0))
+                {
+                    int64_t offset = pool.allocate();
+                    if (offset >= 0)
+                    {
+                        XOR_CHECK(owned[offset].exchange(1) == 0, "Offset was allocated twice");
+                        offsets.emplace_back(offset);
+                    }
+                }
+                else
+                {
+                    int64_t offset = offsets.back();
+                    offsets.pop_back();
+                    owned[offset] = 0;
+                    pool.release(offset);
+                }
+            }
+
+            for (auto offset : offsets)
+            {
+                owned[offset] = 0;
+                pool.release(offset);
+            }
+        });
+
+        XOR_CHECK(pool.full(), "All offsets were not released");
+
+        // All offsets must still be there exactly once.
+        std::vector<int64_t> offsets;
+        for (size_t i = 0; i < PoolSize; ++i)
+            offsets.emplace_back(pool.allocate());
+        XOR_CHECK(pool.empty() && pool.allocate() < 0, "Pool has too many offsets");
+        std::sort(offsets.begin(), offsets.end());
+        for (size_t i = 0; i < PoolSize; ++i)
+            XOR_CHECK(offsets[i] == static_cast<int64_t>(i), "Offset %zu was lost", i);
+    }
+
+    // With only a few offsets left, threads keep stealing the same offsets
+    // from each other, but allocation must never fail as long as there are
+    // offsets left.
+    {
+        static const uint Threads   = 16;
+        static const uint PerThread = 2;
+        ConcurrentOffsetPool pool(PoolSize);
+
+        std::vector<int64_t> filled;
+        for (size_t i = 0; i < PoolSize - Threads * PerThread; ++i)
+            filled.emplace_back(pool.allocate());
+
+        runThreads(Threads, [&] (uint t)
+        {
+            Random gen(t + 1);
+            std::vector<int64_t> offsets;
+
+            for (uint i = 0; i < 200000; ++i)
+            {
+                if (offsets.empty() || (offsets.size() < PerThread && gen() % 2 == 0))
+                {
+                    int64_t offset = pool.allocate();
+                    XOR_CHECK(offset >= 0, "Allocation failed even though the pool had space left");
+                    offsets.emplace_back(offset);
+                }
+                else
+                {
+                    size_t j = gen() % offsets.size();
+                    pool.release(offsets[j]);
+                    std::swap(offsets[j], offsets.back());
+                    offsets.pop_back();
+                }
+            }
+
+            for (auto offset : offsets)
+                pool.release(offset);
+        });
+
+        XOR_CHECK(pool.spaceLeft() == Threads * PerThread, "Offsets were lost");
+        for (auto offset : filled)
+            pool.release(offset);
+        XOR_CHECK(pool.full(), "All offsets were not released");
+    }
+
+    print("ConcurrentOffsetPool: OK\n");
+}
+
+// OffsetPool protected by a lock, for comparison.
+class LockedOffsetPool
+{
+    std::mutex m_mutex;
+    OffsetPool m_pool;
+public:
+    LockedOffsetPool(size_t size) : m_pool(size) {}
+
+    int64_t allocate()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_pool.allocate();
+    }
+
+    void release(int64_t offset)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_pool.release(offset);
+    }
+};
+
+template <typename Pool>
+void benchmarkPool(const char *name, uint threadCount)
+{
+    static const uint Iterations = 200000;
+    static const uint BatchSize  = 8;
+
+    Pool pool(64 * 1024);
+
+    Timer timer;
+    runThreads(threadCount, [&] (uint)
+    {
+        int64_t offsets[BatchSize];
+        for (uint i = 0; i < Iterations; ++i)
+        {
+            for (auto &o : offsets)
+                o = pool.allocate();
+            for (auto &o : offsets)
+                pool.release(o);
+        }
+    });
+    double seconds = timer.seconds();
+
+    double ops = static_cast<double>(threadCount) * Iterations * BatchSize * 2;
+    print("%-24s %2u threads: %8.2f Mops/s\n", name, threadCount, ops / seconds / 1e6);
+}
+
+void benchmarkPools()
+{
+    print("Offset pool benchmark:\n");
+    for (uint threads = 1; threads <= 16; threads *= 2)
+    {
+        benchmarkPool<LockedOffsetPool>("OffsetPool + std::mutex", threads);
+        benchmarkPool<ConcurrentOffsetPool>("ConcurrentOffsetPool", threads);
+    }
+}
+
+void testConcurrentRing()
+{
+    static const size_t RingSize    = 64 * 1024;
+    static const uint   Threads     = 8;
+    static const uint   Allocations = 50000;
+    static const uint   MaxLive     = 16;
+    static const int64_t Idle       = std::numeric_limits<int64_t>::max();
+
+    ConcurrentOffsetRing ring(RingSize);
+
+    std::unique_ptr<std::atomic<uint8_t>[]> owned(new std::atomic<uint8_t>[RingSize]);
+    for (size_t i = 0; i < RingSize; ++i)
+        owned[i] = 0;
+
+    // Every thread publishes a position that is not newer than any of its live
+    // blocks, so everything older than the oldest of them can be released.
+    std::unique_ptr<std::atomic<int64_t>[]> oldestLive(new std::atomic<int64_t>[Threads]);
+    for (uint t = 0; t < Threads; ++t)
+        oldestLive[t] = Idle;
+    std::atomic<uint> running { Threads };
+
+    std::thread releaser([&]
+    {
+        while (running > 0)
+        {
+            int64_t position = ring.position();
+            for (uint t = 0; t < Threads; ++t)
+                position = std::min<int64_t>(position, oldestLive[t]);
+            ring.releaseUntilPosition(position);
+            std::this_thread::yield();
+        }
+    });
+
+    runThreads(Threads, [&] (uint t)
+    {
+        Random gen(t + 1);
+        struct Live
+        {
+            Block   block;
+            int64_t start;
+        };
+        std::vector<Live> live;
+
+        for (uint i = 0; i < Allocations; ++i)
+        {
+            if (live.size() < MaxLive && gen() % 2 == 0)
+            {
+                size_t amount    = 1 + gen() % 256;
+                size_t alignment = size_t(1) << (gen() % 7);
+
+                int64_t start = ring.position();
+                if (live.empty())
+                    oldestLive[t] = start;
+
+                int64_t position;
+                Block b = ring.allocateBlock(amount, alignment, position);
+                if (!b)
+                {
+                    if (live.empty())
+                        oldestLive[t] = Idle;
+                    continue;
+                }
+
+                XOR_CHECK(b.begin % static_cast<int64_t>(alignment) == 0, "Block is misaligned");
+                XOR_CHECK(b.end <= static_cast<int64_t>(RingSize), "Block is out of bounds");
+                XOR_CHECK(position - static_cast<int64_t>(amount) >= start, "Block is older than expected");
+
+                for (int64_t j = b.begin; j < b.end; ++j)
+                    XOR_CHECK(owned[j].exchange(1) == 0, "Live blocks overlap");
+
+                live.push_back({ b, start });
+            }
+            else if (!live.empty())
+            {
+                for (int64_t j = live.front().block.begin; j < live.front().block.end; ++j)
+                    owned[j] = 0;
+                live.erase(live.begin());
+                oldestLive[t] = live.empty() ? Idle : live.front().start;
+            }
+        }
+
+        for (auto &l : live)
+        {
+            for (int64_t j = l.block.begin; j < l.block.end; ++j)
+                owned[j] = 0;
+        }
+        oldestLive[t] = Idle;
+        --running;
+    });
+
+    releaser.join();
+    ring.releaseUntilPosition(ring.position());
+    XOR_CHECK(ring.empty(), "Ring is not empty after releasing everything");
+
+    print("ConcurrentOffsetRing: OK\n");
+}
+
+void testFrameArena()
+{
+    FrameArena arena(4096);
+
+    // Simulate a few frames that allocate a varying amount of temporary memory.
+    for (uint frame = 0; frame < 4; ++frame)
+    {
+        arena.reset();
+        arena.resetStatistics();
+
+        FrameVector<int> ints(arena);
+        for (int i = 0; i < 10000; ++i)
+            ints.emplace_back(i);
+
+        {
+            FrameArenaScope scope(arena);
+            auto used = arena.statistics().usedBytes;
+
+            auto bytes = arena.allocate<uint8_t>(3);
+            auto big   = arena.allocate<double>(20000);
+            auto align = arena.allocate(16, 256);
+            XOR_CHECK(reinterpret_cast<uintptr_t>(big) % alignof(double) == 0, "Allocation is misaligned");
+            XOR_CHECK(reinterpret_cast<uintptr_t>(align) % 256 == 0, "Allocation is misaligned");
+            XOR_CHECK(bytes != nullptr && big != nullptr, "Allocation failed");
+            XOR_CHECK(arena.statistics().usedBytes > used, "Allocations were not counted");
+
+            for (int i = 0; i < 20000; ++i)
+                big[i] = i;
+            for (int i = 0; i < 20000; ++i)
+                XOR_CHECK(big[i] == i, "Allocations overlap");
+        }
+
+        for (int i = 0; i < 10000; ++i)
+            XOR_CHECK(ints[i] == i, "Allocations overlap");
+
+        // The first frame warms up the arena, and after that
+        // there should be no heap allocations.
+        if (frame > 0)
+            XOR_CHECK(arena.statistics().heapAllocations == 0, "Arena allocated from the heap after warming up");
+
+        print("Frame %u: %zu allocations, %zu heap allocations, %zu bytes peak usage, %zu bytes reserved\n",
+              frame,
+              arena.statistics().allocations,
+              arena.statistics().heapAllocations,
+              arena.statistics().peakUsedBytes,
+              arena.statistics().reservedBytes);
+    }
+
+    arena.reset();
+    XOR_CHECK(arena.statistics().usedBytes == 0, "Arena is not empty after reset");
+
+    print("FrameArena: OK\n");
+}
+
+void testSlotMap()
+{
+    SlotMap<int> map;
+    std::vector<std::pair<SlotMapHandle, int>> live;
+    std::vector<SlotMapHandle> erased;
+    Random gen;
+
+    for (int i = 0; i < 100000; ++i)
+    {
+        if (live.empty() || gen() % 3 != 0)
+        {
+            live.emplace_back(map.insert(i), i);
+        }
+        else
+        {
+            size_t j = gen() % live.size();
+            XOR_CHECK(map.erase(live[j].first), "Failed to erase a live object");
+            erased.emplace_back(live[j].first);
+            std::swap(live[j], live.back());
+            live.pop_back();
+        }
+    }
+
+    XOR_CHECK(map.size() == live.size(), "SlotMap has the wrong size");
+    for (auto &l : live)
+        XOR_CHECK(map.get(l.first) && *map.get(l.first) == l.second, "Handle refers to the wrong object");
+    for (auto &h : erased)
+        XOR_CHECK(!map.contains(h) && !map.erase(h), "Erased handle is not stale");
+
+    int64_t sum = 0;
+    for (int x : map)
+        sum += x;
+    int64_t expected = 0;
+    for (auto &l : live)
+        expected += l.second;
+    XOR_CHECK(sum == expected, "Dense iteration does not match the live objects");
+
+    {
+        auto a = SlotMapRef<int>::make(map, 123);
+        auto h = a.handle();
+        {
+            auto b = a;
+            SlotMapRef<int> c;
+            c = std::move(a);
+            XOR_CHECK(!a && *c == 123 && b.get() == c.get(), "SlotMapRef copy is broken");
+        }
+        XOR_CHECK(!map.contains(h), "Object was not erased with its last reference");
+    }
+
+    map.clear();
+    XOR_CHECK(map.empty(), "SlotMap is not empty after clear");
+
+    // Objects in a StableSlotMap must not move when others are
+    // inserted or erased.
+    {
+        StableSlotMap<std::string> stable;
+        std::vector<std::pair<SlotMapHandle, const std::string *>> stableLive;
+
+        for (int i = 0; i < 10000; ++i)
+        {
+            if (stableLive.empty() || gen() % 3 != 0)
+            {
+                auto h = stable.emplace(std::to_string(i));
+                stableLive.emplace_back(h, &stable[h]);
+            }
+            else
+            {
+                size_t j = gen() % stableLive.size();
+                XOR_CHECK(stable.erase(stableLive[j].first), "Failed to erase a live object");
+                XOR_CHECK(!stable.contains(stableLive[j].first), "Erased handle is not stale");
+                std::swap(stableLive[j], stableLive.back());
+                stableLive.pop_back();
+            }
+        }
+
+        XOR_CHECK(stable.size() == stableLive.size(), "StableSlotMap has the wrong size");
+        for (auto &l : stableLive)
+            XOR_CHECK(stable.get(l.first) == l.second, "Object in a StableSlotMap has moved");
+
+        size_t visited = 0;
+        stable.forEach([&] (const std::string &) { ++visited; });
+        XOR_CHECK(visited == stableLive.size(), "StableSlotMap iteration does not match the live objects");
+
+        auto a = SlotMapRef<std::string, StableSlotMap<std::string>>::make(stable, "ref");
+        const std::string *p = a.get();
+        for (int i = 0; i < 1000; ++i)
+            stable.emplace("filler");
+        XOR_CHECK(a.get() == p && *a == "ref", "SlotMapRef to a StableSlotMap object has moved");
+    }
+
+    print("SlotMap: OK\n");
+}
+
+void testAllocationTrace()
+{
+    static const size_t HeapSize = 1 << 20;
+
+    AllocationTrace trace("Test", HeapSize);
+    TracedHeap<OffsetHeap> heap(HeapSize, 16);
+    heap.setTrace(&trace);
+
+    Random gen;
+    std::vector<Block> blocks;
+    for (uint i = 0; i < 10000; ++i)
+    {
+        if (blocks.empty() || gen() % 3 != 0)
+        {
+            Block b = heap.allocate(1 + gen() % 65536, 1U << (gen() % 9));
+            if (b)
+                blocks.emplace_back(b);
+        }
+        else
+        {
+            size_t j = gen() % blocks.size();
+            heap.release(blocks[j]);
+            blocks[j] = blocks.back();
+            blocks.pop_back();
+        }
+    }
+
+    auto events = trace.events();
+    XOR_CHECK(trace.allocationCount() > 0, "No allocations were traced");
+    XOR_CHECK(std::any_of(events.begin(), events.end(),
+                          [] (const AllocationEvent &e) { return e.type == AllocationEvent::Type::Failure; }),
+              "No failed allocations were traced");
+
+    String filename = "TestCore.xatr";
+    trace.save(filename);
+    auto loaded = AllocationTrace::load(filename);
+
+    XOR_CHECK(loaded.name() == trace.name(), "Loaded trace has the wrong name");
+    XOR_CHECK(loaded.capacity() == trace.capacity(), "Loaded trace has the wrong capacity");
+    XOR_CHECK(loaded.allocationCount() == trace.allocationCount(), "Loaded trace has the wrong allocation count");
+    XOR_CHECK(loaded.events().size() == events.size(), "Loaded trace has the wrong event count");
+    for (size_t i = 0; i < events.size(); ++i)
+    {
+        auto &a = events[i];
+        auto &b = loaded.events()[i];
+        XOR_CHECK(a.type == b.type &&
+                  a.alignmentLog2 == b.alignmentLog2 &&
+                  a.allocation == b.allocation &&
+                  a.time == b.time &&
+                  a.size == b.size,
+                  "Loaded event %zu does not match", i);
+    }
+
+    fs::remove(filename.cStr());
+
+    print("AllocationTrace: OK\n");
+}
+
+// Fill the chunk with random data and subchunks, and return a checksum
+// of all of it.
+uint64_t fillChunk(ChunkFile::Chunk &chunk, Random &gen, uint depth)
+{
+    uint64_t checksum = 0;
+
+    auto writer = chunk.writer();
+    uint values = static_cast<uint>(gen() % 1000);
+    for (uint i = 0; i < values; ++i)
+    {
+        uint64_t v = gen();
+        writer.write(v);
+        checksum += v;
+    }
+
+    if (depth > 0)
+    {
+        uint subchunks = static_cast<uint>(gen() % 5);
+        for (uint i = 0; i < subchunks; ++i)
+            checksum += fillChunk(chunk.setChunk(String::format("#%u", i)), gen, depth - 1);
+    }
+
+    return checksum;
+}
+
+uint64_t chunkChecksum(const ChunkFile::Chunk &chunk)
+{
+    uint64_t checksum = 0;
+
+    auto reader = chunk.reader();
+    while (reader.bytesLeft() > 0)
+        checksum += reader.read<uint64_t>();
+
+    for (auto &c : chunk.allChunks())
+        checksum += chunkChecksum(*c.second);
+
+    return checksum;
+}
+
+uint8_t patternByte(uint64_t i)
+{
+    return static_cast<uint8_t>((i >> 4) ^ ((i >> 13) * 31));
+}
+
+void testCompressionStream()
+{
+    static const uint64_t Size = 3 * 1024 * 1024 + 12345;
+
+    // Generate the input on the fly, so it is never in memory as a whole.
+    uint64_t generated = 0;
+    auto source = [&] (Span<uint8_t> window)
+    {
+        size_t bytes = static_cast<size_t>(std::min<uint64_t>(window.size(), Size - generated));
+        for (size_t i = 0; i < bytes; ++i)
+            window[i] = patternByte(generated + i);
+        generated += bytes;
+        return bytes;
+    };
+
+    std::vector<uint8_t> compressed;
+    auto writer = makeWriter(compressed);
+    uint64_t compressedSize = compressZstdStream(writerSink(writer), source, 1);
+    XOR_CHECK(compressedSize == writer.bytesWritten() && compressedSize < Size / 4,
+              "Streamed compression produced unexpected output");
+
+    // Decompress in small odd sized pieces.
+    {
+        Reader reader(Span<const uint8_t>(compressed.data(), writer.bytesWritten()));
+        ZstdDecompressStream stream(readerSource(reader));
+        uint8_t piece[1000];
+        uint64_t offset = 0;
+        bool matches    = true;
+        while (!stream.finished())
+        {
+            size_t bytes = stream.read(piece);
+            for (size_t i = 0; i < bytes; ++i)
+                matches = matches && piece[i] == patternByte(offset + i);
+            offset += bytes;
+        }
+        XOR_CHECK(matches && offset == Size, "Streamed decompression produced unexpected output");
+    }
+
+    // Streamed and whole buffer frames are interchangeable.
+    {
+        auto whole = decompressZstd(static_cast<size_t>(Size),
+                                    Span<const uint8_t>(compressed.data(), writer.bytesWritten()));
+        XOR_CHECK(whole.size() == Size && whole[Size - 1] == patternByte(Size - 1),
+                  "Streamed frame could not be decompressed as a whole");
+
+        auto frame = compressZstd(whole, 1);
+        Reader reader(frame);
+        std::vector<uint8_t> decompressed;
+        auto decompressedWriter = makeWriter(decompressed);
+        decompressZstdStream(writerSink(decompressedWriter), readerSource(reader));
+        XOR_CHECK(decompressedWriter.bytesWritten() == Size &&
+                  memcmp(decompressed.data(), whole.data(), Size) == 0,
+                  "Whole frame could not be decompressed as a stream");
+    }
+
+    // From file to file.
+    {
+        String path           = "TestCore.zst";
+        String decompressPath = "TestCore.bin";
+
+        {
+            File f(path, File::Mode::ReadWrite, File::Create::CreateAlways);
+            generated = 0;
+            compressZstdStream(fileSink(f), source, 1);
+        }
+
+        {
+            File src(path);
+            File dst(decompressPath, File::Mode::ReadWrite, File::Create::CreateAlways);
+            XOR_CHECK(decompressZstdStream(fileSink(dst), fileSource(src)) == Size,
+                      "Streamed file decompression produced unexpected output");
+        }
+
+        XOR_CHECK(File(decompressPath).size() == Size, "Decompressed file has the wrong size");
+        fs::remove(path.cStr());
+        fs::remove(decompressPath.cStr());
+    }
+
+    // Truncated frames are detected.
+    {
+        Reader reader(Span<const uint8_t>(compressed.data(), writer.bytesWritten() / 2));
+        bool threw = false;
+        try { decompressZstdStream([] (Span<const uint8_t>) {}, readerSource(reader)); }
+        catch (const CompressionException &) { threw = true; }
+        XOR_CHECK(threw, "Truncated stream was not detected");
+    }
+
+    print("Compression streams: OK\n");
+}
+
+void testCompressionParallel()
+{
+    static const size_t Size      = 5 * 1024 * 1024 + 777;
+    static const size_t FrameSize = 64 * 1024;
+
+    DynamicBuffer<uint8_t> data(Size);
+    for (size_t i = 0; i < Size; ++i)
+        data[i] = patternByte(i);
+
+    ThreadPool pool(3);
+    auto compressed = compressParallel(data, 1, FrameSize, pool);
+    XOR_CHECK(decompressedSizeParallel(compressed) == Size, "Parallel compression recorded the wrong size");
+
+    auto decompressed = decompressParallel(compressed, pool);
+    XOR_CHECK(decompressed.size() == Size && memcmp(decompressed.data(), data.data(), Size) == 0,
+              "Parallel decompression produced unexpected output");
+
+    // Ranges within one frame, across frames, and at the ends.
+    Random gen;
+    std::vector<std::pair<size_t, size_t>> ranges =
+    {
+        { 0, 1 },
+        { 0, FrameSize },
+        { FrameSize - 10, 20 },
+        { FrameSize, 3 * FrameSize },
+        { Size - 1, 1 },
+        { Size - FrameSize - 5, FrameSize + 5 },
+        { 123, 0 },
+    };
+    for (uint i = 0; i < 20; ++i)
+    {
+        size_t begin = static_cast<size_t>(gen() % Size);
+        ranges.emplace_back(begin, static_cast<size_t>(gen() % (Size - begin)));
+    }
+
+    for (auto &r : ranges)
+    {
+        DynamicBuffer<uint8_t> range(r.second);
+        decompressParallel(range, compressed, r.first, pool);
+        XOR_CHECK(r.second == 0 || memcmp(range.data(), data.data() + r.first, r.second) == 0,
+                  "Decompressing range (%zu, %zu) produced unexpected output", r.first, r.second);
+    }
+
+    bool threw = false;
+    try
+    {
+        DynamicBuffer<uint8_t> range(2);
+        decompressParallel(range, compressed, Size - 1, pool);
+    }
+    catch (const CompressionException &)
+    {
+        threw = true;
+    }
+    XOR_CHECK(threw, "Decompressing past the end was not detected");
+
+    auto empty = compressParallel(Span<const uint8_t>(), 1, FrameSize, pool);
+    XOR_CHECK(decompressParallel(empty, pool).empty(), "Empty data did not survive parallel compression");
+
+    print("Parallel compression: OK\n");
+}
+
+void benchmarkCompressionParallel()
+{
+    static const int    CompressionLevel = 3;
+    // Small enough to give every thread some frames, since data/ is small.
+    static const size_t FrameSize        = 256 * 1024;
+
+    // Everything under data/ as one blob.
+    DynamicBuffer<uint8_t> data;
+    auto writer = makeWriter(data);
+    for (auto &entry : fs::recursive_directory_iterator(XOR_DATA))
+    {
+        if (fs::is_regular_file(entry.status()))
+            writer.writeBytes(File(entry.path().string()).read());
+    }
+    auto bytes = Span<const uint8_t>(data.data(), writer.bytesWritten());
+    double mb  = static_cast<double>(bytes.size()) / (1024.0 * 1024.0);
+
+    Timer timer;
+    auto single = compressZstd(bytes, CompressionLevel);
+    double singleCompress = timer.seconds();
+    timer.reset();
+    decompressZstd(bytes.size(), single);
+    double singleDecompress = timer.seconds();
+
+    print("Parallel compression benchmark, %.2f MB from %s, level %d, %zu KB frames:\n",
+          mb, XOR_DATA, CompressionLevel, FrameSize / 1024);
+    print("    single frame        compress %8.2f MB/s, decompress %8.2f MB/s\n",
+          mb / singleCompress, mb / singleDecompress);
+
+    uint maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    for (uint threads = 1; threads <= maxThreads; ++threads)
+    {
+        // The calling thread also takes part.
+        ThreadPool pool(static_cast<int>(threads) - 1);
+
+        timer.reset();
+        auto compressed = compressParallel(bytes, CompressionLevel, FrameSize, pool);
+        double compress = timer.seconds();
+
+        timer.reset();
+        auto decompressed = decompressParallel(compressed, pool);
+        double decompress = timer.seconds();
+
+        XOR_CHECK(decompressed.size() == bytes.size(), "Parallel decompression produced unexpected output");
+        print("    %2u threads          compress %8.2f MB/s, decompress %8.2f MB/s\n",
+              threads, mb / compress, mb / decompress);
+    }
+}
+
+// Small buffers of similar text, like the small chunks of an asset.
+std::vector<DynamicBuffer<uint8_t>> dictionarySamples(Random &gen, uint count)
+{
+    std::vector<DynamicBuffer<uint8_t>> samples;
+    for (uint i = 0; i < count; ++i)
+    {
+        DynamicBuffer<uint8_t> text;
+        auto writer = makeWriter(text);
+        uint lines  = 10 + static_cast<uint>(gen() % 20);
+        for (uint l = 0; l < lines; ++l)
+        {
+            auto line = String::format("vertex %u position %u.%02u %u.%02u normal %u\n",
+                                       static_cast<uint>(gen() % 1000),
+                                       static_cast<uint>(gen() % 10), static_cast<uint>(gen() % 100),
+                                       static_cast<uint>(gen() % 10), static_cast<uint>(gen() % 100),
+                                       static_cast<uint>(gen() % 6));
+            writer.writeBytes(Span<const uint8_t>(reinterpret_cast<const uint8_t *>(line.data()),
+                                                  line.length()));
+        }
+        samples.emplace_back(std::move(text));
+    }
+    return samples;
+}
+
+void testZstdDictionary()
+{
+    Random gen;
+    auto trainingSamples = dictionarySamples(gen, 200);
+    auto testSamples     = dictionarySamples(gen, 100);
+
+    std::vector<Span<const uint8_t>> spans;
+    for (auto &s : trainingSamples)
+        spans.emplace_back(s);
+    auto dictionary = ZstdDictionary::train(spans, 8 * 1024);
+    XOR_CHECK(!!dictionary && dictionary.id() != 0, "Dictionary training failed");
+
+    size_t plainBytes      = 0;
+    size_t dictionaryBytes = 0;
+    for (auto &s : testSamples)
+    {
+        plainBytes += compressZstd(s).size();
+
+        auto compressed   = compressZstd(s, dictionary.cdict());
+        auto decompressed = decompressZstd(s.size(), compressed, dictionary.ddict());
+        XOR_CHECK(memcmp(decompressed.data(), s.data(), s.size()) == 0,
+                  "Dictionary decompression produced unexpected output");
+        dictionaryBytes += compressed.size();
+    }
+    XOR_CHECK(dictionaryBytes < plainBytes, "Dictionary did not improve compression");
+    XOR_CHECK(dictionary.improvesCompression(spans), "Dictionary did not improve compression");
+
+    String path = "TestCore.xchunk";
+
+    auto checkFile = [&] (ChunkFile &file)
+    {
+        for (uint i = 0; i < testSamples.size(); ++i)
+        {
+            auto &chunk = file.mainChunk().chunk(String::format("#%u", i));
+            auto blob   = chunk.reader().readBlob();
+            XOR_CHECK(chunk.codec() == ChunkFile::Codec::ZstdDictionary &&
+                      blob.size() == testSamples[i].size() &&
+                      memcmp(blob.data(), testSamples[i].data(), blob.size()) == 0,
+                      "Dictionary compressed chunk contents do not match");
+        }
+    };
+
+    {
+        ChunkFile file(path);
+        file.setDictionary(ZstdDictionary(dictionary.bytes()));
+        for (uint i = 0; i < testSamples.size(); ++i)
+        {
+            auto &chunk = file.mainChunk().setChunk(String::format("#%u", i));
+            chunk.setCodec(ChunkFile::Codec::ZstdDictionary);
+            chunk.writer().writeBlob(testSamples[i]);
+        }
+        file.write();
+    }
+
+    {
+        ChunkFile file(path);
+        file.read();
+        XOR_CHECK(file.dictionary() && file.dictionary()->id() == dictionary.id(),
+                  "Dictionary was not stored in the ChunkFile");
+        checkFile(file);
+    }
+
+    {
+        ChunkFileWriter writer(path);
+        writer.setDictionary(ZstdDictionary(dictionary.bytes()));
+        for (uint i = 0; i < testSamples.size(); ++i)
+        {
+            writer.beginChunk(String::format("#%u", i));
+            writer.setCodec(ChunkFile::Codec::ZstdDictionary);
+            writer.writer().writeBlob(testSamples[i]);
+            writer.endChunk();
+        }
+        writer.finish();
+
+        ChunkFile file(path);
+        file.readMapped();
+        checkFile(file);
+    }
+
+    fs::remove(path.cStr());
+
+    print("Zstd dictionaries: OK\n");
+}
+
+void benchmarkZstdDictionary(const char *name, const std::vector<DynamicBuffer<uint8_t>> &pieces)
+{
+    static const uint Rounds = 10;
+
+    // Train on every other piece.
+    std::vector<Span<const uint8_t>> samples;
+    for (size_t i = 0; i < pieces.size(); i += 2)
+        samples.emplace_back(pieces[i]);
+    auto dictionary = ZstdDictionary::train(samples);
+
+    size_t totalBytes = 0;
+    size_t maxSize    = 0;
+    for (auto &p : pieces)
+    {
+        totalBytes += p.size();
+        maxSize     = std::max(maxSize, p.size());
+    }
+    double mb = static_cast<double>(totalBytes) * Rounds / (1024.0 * 1024.0);
+
+    print("Zstd dictionary benchmark, %s, %zu pieces, %.2f MB, %zu byte dictionary:\n",
+          name, pieces.size(), static_cast<double>(totalBytes) / (1024.0 * 1024.0), dictionary.bytes().size());
+
+    auto measure = [&] (const char *name, auto &&compress, auto &&decompress)
+    {
+        std::vector<DynamicBuffer<uint8_t>> compressed;
+        size_t compressedBytes = 0;
+        for (auto &p : pieces)
+        {
+            DynamicBuffer<uint8_t> c(p.size() * 2 + 1024);
+            c.resize(compress(c, p));
+            compressedBytes += c.size();
+            compressed.emplace_back(std::move(c));
+        }
+
+        DynamicBuffer<uint8_t> decompressed(maxSize);
+        Timer timer;
+        for (uint r = 0; r < Rounds; ++r)
+        {
+            for (size_t i = 0; i < pieces.size(); ++i)
+                decompress(Span<uint8_t>(decompressed.data(), pieces[i].size()), compressed[i]);
+        }
+        double seconds = timer.seconds();
+
+        print("    %-16s ratio %6.2f, decompress %8.2f MB/s\n", name,
+              static_cast<double>(totalBytes) / static_cast<double>(compressedBytes), mb / seconds);
+    };
+
+    measure("no dictionary",
+            [&] (Span<uint8_t> dst, Span<const uint8_t> src) { return compressZstd(dst, src); },
+            [&] (Span<uint8_t> dst, Span<const uint8_t> src) { return decompressZstd(dst, src); });
+    measure("dictionary",
+            [&] (Span<uint8_t> dst, Span<const uint8_t> src) { return compressZstd(dst, src, dictionary.cdict()); },
+            [&] (Span<uint8_t> dst, Span<const uint8_t> src) { return decompressZstd(dst, src, dictionary.ddict()); });
+    print("    dictionary pays for itself: %s\n", dictionary.improvesCompression(samples) ? "yes" : "no");
+}
+
+void benchmarkZstdDictionary()
+{
+    Random gen;
+    benchmarkZstdDictionary("small records", dictionarySamples(gen, 4000));
+
+    // Split the mesh assets into pieces the size of small chunks.
+    std::vector<DynamicBuffer<uint8_t>> pieces;
+    for (const char *dir : { "/cube", "/teapot", "/crytek-sponza" })
+    {
+        String path = String(XOR_DATA) + dir;
+        if (!fs::exists(path.cStr()))
+            continue;
+
+        for (auto &entry : fs::recursive_directory_iterator(path.cStr()))
+        {
+            if (!fs::is_regular_file(entry.status()))
+                continue;
+
+            auto bytes = File(entry.path().string()).read();
+            for (size_t begin = 0; begin < bytes.size();)
+            {
+                size_t size = std::min(static_cast<size_t>(512 + gen() % 8192), bytes.size() - begin);
+                pieces.emplace_back(Span<const uint8_t>(bytes.data() + begin, size));
+                begin += size;
+            }
+        }
+    }
+
+    if (!pieces.empty())
+        benchmarkZstdDictionary("mesh assets", pieces);
+}
+
+// Vertex and index streams of a tessellated sphere, which resemble
+// the streams of imported meshes.
+struct SphereStreams
+{
+    std::vector<float> positions;
+    std::vector<float> normals;
+    std::vector<float> texcoords;
+    std::vector<uint>  indices;
+};
+
+SphereStreams sphereStreams(uint segments)
+{
+    SphereStreams s;
+    for (uint y = 0; y <= segments; ++y)
+    {
+        for (uint x = 0; x <= segments; ++x)
+        {
+            float u     = static_cast<float>(x) / static_cast<float>(segments);
+            float v     = static_cast<float>(y) / static_cast<float>(segments);
+            float theta = u * 6.2831853f;
+            float phi   = v * 3.1415927f;
+            float n[3]  = { std::cos(theta) * std::sin(phi), std::cos(phi), std::sin(theta) * std::sin(phi) };
+
+            for (float c : n)
+            {
+                s.positions.emplace_back(c * 2.5f + 10.f);
+                s.normals.emplace_back(c);
+            }
+            s.texcoords.emplace_back(u * 4);
+            s.texcoords.emplace_back(v);
+        }
+    }
+
+    for (uint y = 0; y < segments; ++y)
+    {
+        for (uint x = 0; x < segments; ++x)
+        {
+            uint i = y * (segments + 1) + x;
+            for (uint j : { i, i + segments + 1, i + 1, i + 1, i + segments + 1, i + segments + 2 })
+                s.indices.emplace_back(j);
+        }
+    }
+
+    return s;
+}
+
+template <typename T>
+Span<const uint8_t> asBytes(const std::vector<T> &v)
+{
+    return Span<const uint8_t>(reinterpret_cast<const uint8_t *>(v.data()), v.size() * sizeof(T));
+}
+
+void testStreamFilters()
+{
+    Random gen;
+
+    // Lossless filters on all element sizes, including odd element
+    // counts that don't fill the SIMD loops.
+    for (uint elementSize : { 1u, 2u, 4u, 6u, 8u, 12u, 16u })
+    {
+        for (size_t count : { 0u, 1u, 15u, 16u, 17u, 1000u, 1031u })
+        {
+            std::vector<uint8_t> elements(count * elementSize);
+            uint value = 0;
+            for (auto &b : elements)
+            {
+                value += static_cast<uint>(gen() % 5);
+                b = static_cast<uint8_t>(gen() % 4 == 0 ? gen() : value);
+            }
+
+            for (uint filters : { 0u, 2u, 4u, 6u })
+            {
+                bool delta = !!(filters & StreamFilter::Delta);
+                if (delta && elementSize % 2 != 0)
+                    continue;
+
+                auto encoded = encodeStream(filters, asBytes(elements), elementSize);
+                auto decoded = decodeStream(filters, encoded, elementSize);
+                XOR_CHECK(decoded.size() == elements.size() &&
+                          (count == 0 || memcmp(decoded.data(), elements.data(), elements.size()) == 0),
+                          "Stream filters 0x%x with %u byte elements produced unexpected output",
+                          filters, elementSize);
+            }
+        }
+    }
+
+    // Quantization is lossy, but stays within half a step of the range.
+    auto sphere = sphereStreams(37);
+    for (uint filters : { 1u, 3u, 5u, 7u })
+    {
+        auto check = [&] (const std::vector<float> &values, uint components, float range)
+        {
+            auto encoded = encodeStream(filters, asBytes(values), components * sizeof(float));
+            auto decoded = decodeStream(filters, encoded, components * sizeof(float));
+            XOR_CHECK(decoded.size() == values.size() * sizeof(float), "Quantized stream has unexpected size");
+
+            const float *d = reinterpret_cast<const float *>(decoded.data());
+            for (size_t i = 0; i < values.size(); ++i)
+            {
+                XOR_CHECK(std::abs(d[i] - values[i]) <= range / 65535.f,
+                          "Quantized value %f differs too much from %f", d[i], values[i]);
+            }
+        };
+
+        check(sphere.normals, 3, 2);
+        check(sphere.texcoords, 2, 4);
+    }
+
+    // Index buffers stay exact with both 32-bit and 16-bit indices.
+    std::vector<uint16_t> indices16(sphere.indices.begin(), sphere.indices.end());
+    auto encoded = encodeStream(StreamFilter::Delta | StreamFilter::ByteShuffle, asBytes(sphere.indices), 4);
+    auto decoded = decodeStream(StreamFilter::Delta | StreamFilter::ByteShuffle, encoded, 4);
+    XOR_CHECK(memcmp(decoded.data(), sphere.indices.data(), decoded.size()) == 0,
+              "Filtered 32-bit indices produced unexpected output");
+    encoded = encodeStream(StreamFilter::Delta | StreamFilter::ByteShuffle, asBytes(indices16), 2);
+    decoded = decodeStream(StreamFilter::Delta | StreamFilter::ByteShuffle, encoded, 2);
+    XOR_CHECK(memcmp(decoded.data(), indices16.data(), decoded.size()) == 0,
+              "Filtered 16-bit indices produced unexpected output");
+
+    bool threw = false;
+    try
+    {
+        encodeStream(StreamFilter::Quantize16, asBytes(indices16), 2);
+    }
+    catch (const StreamFilterException &)
+    {
+        threw = true;
+    }
+    XOR_CHECK(threw, "Quantizing 16-bit elements was not detected");
+
+    threw = false;
+    try
+    {
+        decodeStream(StreamFilter::ByteShuffle, Span<const uint8_t>(encoded.data(), encoded.size() - 1), 2);
+    }
+    catch (const StreamFilterException &)
+    {
+        threw = true;
+    }
+    XOR_CHECK(threw, "Decoding a stream of the wrong size was not detected");
+}
+
+void benchmarkStreamFilters()
+{
+    static const uint Rounds = 10;
+
+    auto sphere = sphereStreams(1000);
+
+    print("Stream filter benchmark, %zu vertices, %zu indices:\n",
+          sphere.positions.size() / 3, sphere.indices.size());
+
+    auto measure = [&] (const char *name, Span<const uint8_t> stream, uint elementSize, uint filters)
+    {
+        auto encoded = encodeStream(filters, stream, elementSize);
+        DynamicBuffer<uint8_t> compressed(encoded.size() * 2 + 1024);
+        compressed.resize(compressZstd(compressed, encoded, 3));
+
+        Timer timer;
+        DynamicBuffer<uint8_t> decompressed(encoded.size());
+        for (uint r = 0; r < Rounds; ++r)
+        {
+            decompressZstd(decompressed, compressed);
+            decodeStream(filters, decompressed, elementSize);
+        }
+        double seconds = timer.seconds();
+
+        print("    %-10s filters 0x%x: ratio %6.2f, decode %8.2f MB/s\n", name, filters,
+              static_cast<double>(stream.size()) / static_cast<double>(compressed.size()),
+              static_cast<double>(stream.size()) * Rounds / (1024.0 * 1024.0) / seconds);
+    };
+
+    for (uint filters : { 0u, 4u })
+        measure("positions", asBytes(sphere.positions), 12, filters);
+    for (uint filters : { 0u, 4u, 5u })
+        measure("normals", asBytes(sphere.normals), 12, filters);
+    for (uint filters : { 0u, 4u, 5u })
+        measure("texcoords", asBytes(sphere.texcoords), 8, filters);
+    for (uint filters : { 0u, 4u, 6u })
+        measure("indices", asBytes(sphere.indices), 4, filters);
+}
+
+void testThreadPool()
+{
+    ThreadPool pool(3);
+
+    std::vector<uint> counts(10000, 0);
+    pool.parallelFor(counts.size(), [&] (size_t i)
+    {
+        ++counts[i];
+    });
+    XOR_CHECK(std::all_of(counts.begin(), counts.end(), [] (uint c) { return c == 1; }),
+              "parallelFor() did not call every index exactly once");
+
+    // Nested calls from the workers run serially instead of deadlocking.
+    std::atomic<uint> nested { 0 };
+    pool.parallelFor(16, [&] (size_t)
+    {
+        pool.parallelFor(16, [&] (size_t) { ++nested; });
+    });
+    XOR_CHECK(nested == 16 * 16, "Nested parallelFor() did not complete");
+
+    bool threw = false;
+    try
+    {
+        pool.parallelFor(100, [&] (size_t i)
+        {
+            XOR_THROW(i != 50, Exception, "Expected exception");
+        });
+    }
+    catch (const Exception &)
+    {
+        threw = true;
+    }
+    XOR_CHECK(threw, "parallelFor() did not rethrow an exception");
+
+    print("ThreadPool: OK\n");
+}
+
+void testChunkFile()
+{
+    String path = "TestCore.xchunk";
+    Random gen;
+    uint64_t checksum = 0;
+
+    {
+        ChunkFile file(path);
+        checksum = fillChunk(file.mainChunk(), gen, 4);
+        file.write();
+    }
+
+    {
+        ChunkFile file(path);
+        file.read();
+        XOR_CHECK(!file.mapped(), "ChunkFile::read() should not map the file");
+        XOR_CHECK(chunkChecksum(file.mainChunk()) == checksum, "Read ChunkFile contents do not match");
+    }
+
+    {
+        ChunkFile file(path);
+        file.readMapped();
+        XOR_CHECK(file.mapped(), "ChunkFile::readMapped() did not map the file");
+        XOR_CHECK(chunkChecksum(file.mainChunk()) == checksum, "Mapped ChunkFile contents do not match");
+
+        bool threw = false;
+        try { file.write(); } catch (const SerializationException &) { threw = true; }
+        XOR_CHECK(threw, "Writing a mapped ChunkFile should fail");
+
+        file.close();
+        XOR_CHECK(!file.mapped(), "ChunkFile is still mapped after close()");
+    }
+
+    // Modify one chunk of a read file, which should keep the rest intact.
+    {
+        ChunkFile file(path);
+        file.read();
+        auto &modified = file.mainChunk().setChunk("modified");
+        modified.writer().write(uint64_t(12345));
+        file.write();
+        checksum += 12345;
+    }
+
+    {
+        ChunkFile file(path);
+        file.readMapped();
+        XOR_CHECK(file.version() == 3, "ChunkFile was not written using the newest version");
+        XOR_CHECK(chunkChecksum(file.mainChunk()) == checksum, "Modified ChunkFile contents do not match");
+    }
+
+    // Updating a chunk with data of the same size should happen in place.
+    {
+        size_t sizeBefore = File(path).size();
+
+        ChunkFile file(path);
+        file.read();
+        auto &modified = file.mainChunk().chunk("modified");
+        modified.writer().write(uint64_t(23456));
+        file.write();
+        checksum += 23456 - 12345;
+
+        XOR_CHECK(File(path).size() == sizeBefore, "Updating a chunk in place changed the file size");
+    }
+
+    {
+        ChunkFile file(path);
+        file.read();
+        XOR_CHECK(chunkChecksum(file.mainChunk()) == checksum, "Updated ChunkFile contents do not match");
+    }
+
+    // Stream a file one chunk at a time.
+    {
+        ChunkFileWriter writer(path);
+        writer.writer().write(uint64_t(1));
+        for (uint i = 0; i < 100; ++i)
+        {
+            writer.beginChunk(String::format("#%u", i));
+            writer.writer().write(uint64_t(i));
+            writer.beginChunk("nested");
+            writer.writer().write(uint64_t(i));
+            writer.endChunk();
+            writer.endChunk();
+        }
+        writer.finish();
+
+        ChunkFile file(path);
+        file.readMapped();
+        XOR_CHECK(file.mainChunk().allChunks().size() == 100, "Streamed ChunkFile has the wrong number of chunks");
+        XOR_CHECK(file.mainChunk().chunk("#42").chunk("nested").reader().read<uint64_t>() == 42,
+                  "Streamed ChunkFile contents do not match");
+        XOR_CHECK(chunkChecksum(file.mainChunk()) == 1 + 2 * (99 * 100 / 2), "Streamed ChunkFile contents do not match");
+    }
+
+    // Files of the original version with 32-bit offsets should still be readable.
+    {
+        struct HeaderV1
+        {
+            static const uint VersionNumber = 1;
+            FourCC fourCC;
+            int32_t begin;
+            int32_t end;
+        };
+
+        std::vector<uint8_t> bytes;
+        auto writer = makeWriter(bytes);
+        writer.writeStruct(HeaderV1 {});
+
+        auto subchunkBegin = static_cast<int32_t>(writer.bytesWritten());
+        writer.writeLength(0);
+        writer.writeLength(sizeof(uint64_t));
+        writer.write(uint64_t(7));
+        auto subchunkEnd = static_cast<int32_t>(writer.bytesWritten());
+
+        writer.writeLength(1);
+        writer.writeLength(sizeof(uint64_t));
+        writer.writeString("sub");
+        writer.write(subchunkBegin);
+        writer.write(subchunkEnd);
+        writer.write(uint64_t(5));
+
+        HeaderV1 header;
+        header.fourCC = FourCC("XORC");
+        header.begin  = subchunkEnd;
+        header.end    = static_cast<int32_t>(writer.bytesWritten());
+        makeWriter(bytes).writeStruct(header);
+
+        {
+            File f(path, File::Mode::ReadWrite, File::Create::CreateAlways);
+            XOR_CHECK_HR(f.write(Span<const uint8_t>(bytes.data(), writer.bytesWritten())));
+        }
+
+        ChunkFile file(path);
+        file.read();
+        XOR_CHECK(file.version() == 1, "Version 1 ChunkFile was not detected");
+        XOR_CHECK(file.mainChunk().reader().read<uint64_t>() == 5 &&
+                  file.mainChunk().chunk("sub").reader().read<uint64_t>() == 7,
+                  "Version 1 ChunkFile contents do not match");
+    }
+
+    // Compressed chunks are compressed when written and decompressed when read.
+    {
+        DynamicBuffer<uint8_t> data(64 * 1024);
+        for (size_t i = 0; i < data.size(); ++i)
+            data[i] = static_cast<uint8_t>(i / 64);
+
+        auto blobMatches = [&] (const ChunkFile::Chunk &chunk)
+        {
+            auto blob = chunk.reader().readBlob();
+            return blob.size() == data.size() && memcmp(blob.data(), data.data(), data.size()) == 0;
+        };
+
+        {
+            ChunkFile file(path);
+            file.mainChunk().writer().write(uint64_t(1));
+            for (uint i = 0; i < 16; ++i)
+            {
+                auto &chunk = file.mainChunk().setChunk(String::format("#%u", i));
+                chunk.setCodec(i % 2 ? ChunkFile::Codec::ZstdFrames : ChunkFile::Codec::Zstd);
+                chunk.writer().writeBlob(data);
+            }
+            file.write();
+        }
+
+        XOR_CHECK(File(path).size() < 16 * data.size() / 4, "Compressed chunks were not compressed");
+
+        {
+            ChunkFile file(path);
+            file.read();
+            for (auto &c : file.mainChunk().allChunks())
+            {
+                XOR_CHECK(c.second->codec() != ChunkFile::Codec::None, "Chunk codec was not preserved");
+                XOR_CHECK(blobMatches(*c.second), "Compressed chunk contents do not match");
+            }
+
+            // Change one chunk, and make another one uncompressed.
+            data[0] ^= 1;
+            file.mainChunk().chunk("#3").writer().writeBlob(data);
+            file.mainChunk().chunk("#5").setCodec(ChunkFile::Codec::None);
+            file.write();
+        }
+
+        {
+            ChunkFile file(path);
+            file.readMapped();
+            auto &main = file.mainChunk();
+            XOR_CHECK(blobMatches(main.chunk("#3")), "Updated compressed chunk contents do not match");
+            XOR_CHECK(main.chunk("#5").codec() == ChunkFile::Codec::None, "Chunk codec was not changed");
+            data[0] ^= 1;
+            XOR_CHECK(blobMatches(main.chunk("#4")) && blobMatches(main.chunk("#5")),
+                      "Unchanged compressed chunk contents do not match");
+        }
+    }
+
+    fs::remove(path.cStr());
+
+    print("ChunkFile: OK\n");
+}
+
+void benchmarkChunkFile()
+{
+    static const uint   Chunks    = 1000;
+    static const size_t ChunkSize = 512 * 1024;
+
+    String path = "TestCore.xchunk";
+    DynamicBuffer<uint8_t> data(ChunkSize, 0);
+    Random gen;
+    for (auto &d : data)
+        d = static_cast<uint8_t>(gen());
+
+    Timer timer;
+    {
+        ChunkFile file(path);
+        for (uint i = 0; i < Chunks; ++i)
+        {
+            auto writer = file.mainChunk().setChunk(String::format("#%u", i)).writer(ChunkSize);
+            writer.writeBlob(data);
+        }
+        timer.reset();
+        file.write();
+    }
+    double fullWrite = timer.milliseconds();
+
+    ChunkFile file(path);
+    timer.reset();
+    file.read();
+    double read = timer.milliseconds();
+
+    // Same size, so the chunk is overwritten in place.
+    data[0] ^= 1;
+    file.mainChunk().chunk("#500").writer().writeBlob(data);
+    timer.reset();
+    file.write();
+    double sameSize = timer.milliseconds();
+
+    // Larger, so the chunk is moved to the end of the file.
+    file.mainChunk().chunk("#501").writer().writeBlob(DynamicBuffer<uint8_t>(ChunkSize * 2, 0));
+    timer.reset();
+    file.write();
+    double larger = timer.milliseconds();
+
+    print("ChunkFile benchmark, %u chunks, %.2f MB:\n", Chunks,
+          static_cast<double>(Chunks * ChunkSize) / (1024.0 * 1024.0));
+    print("    full write                  %10.2f ms\n", fullWrite);
+    print("    read                        %10.2f ms\n", read);
+    print("    update 1 chunk, same size   %10.2f ms\n", sameSize);
+    print("    update 1 chunk, larger      %10.2f ms\n", larger);
+
+    file.close();
+    fs::remove(path.cStr());
+}
+
+// Roughly the size and layout of Mesh::State.
+struct BenchmarkMeshState
+{
+    String name;
+    std::vector<int> vertexBuffers;
+    uint64_t indexBuffer[8] = {};
+    uint numIndices  = 0;
+    uint numVertices = 0;
+};
+
+void benchmarkSlotMap()
+{
+    static const uint Meshes = 100000;
+    static const uint Rounds = 20;
+
+    Random gen;
+    std::vector<std::shared_ptr<BenchmarkMeshState>> sharedMeshes;
+    SlotMap<BenchmarkMeshState> map;
+    std::vector<SlotMapRef<BenchmarkMeshState>> refMeshes;
+    StableSlotMap<BenchmarkMeshState> stableMap;
+
+    // Interleave the allocations with other ones, like when loading
+    // real meshes, so they don't end up contiguous in memory.
+    std::vector<std::unique_ptr<uint8_t[]>> noise;
+    for (uint i = 0; i < Meshes; ++i)
+    {
+        uint n = static_cast<uint>(gen() % 1000);
+        auto s = std::make_shared<BenchmarkMeshState>();
+        s->numIndices = n;
+        sharedMeshes.emplace_back(std::move(s));
+        noise.emplace_back(new uint8_t[16 + gen() % 256]);
+
+        refMeshes.emplace_back(SlotMapRef<BenchmarkMeshState>::make(map));
+        refMeshes.back()->numIndices = n;
+
+        stableMap[stableMap.emplace()].numIndices = n;
+    }
+    for (size_t i = Meshes - 1; i > 0; --i)
+    {
+        std::swap(sharedMeshes[i], sharedMeshes[gen() % (i + 1)]);
+        std::swap(refMeshes[i], refMeshes[gen() % (i + 1)]);
+    }
+
+    auto measure = [&] (const char *name, auto &&f)
+    {
+        uint64_t sum = 0;
+        Timer timer;
+        for (uint r = 0; r < Rounds; ++r)
+            sum += f();
+        double ns = timer.seconds() * 1e9 / (static_cast<double>(Meshes) * Rounds);
+        print("%-32s %6.2f ns/mesh (%llu)\n", name, ns, static_cast<llu>(sum));
+    };
+
+    print("Iterating %u meshes:\n", Meshes);
+    measure("std::shared_ptr, by value", [&]
+    {
+        uint64_t sum = 0;
+        for (auto m : sharedMeshes)
+            sum += m->numIndices;
+        return sum;
+    });
+    measure("std::shared_ptr", [&]
+    {
+        uint64_t sum = 0;
+        for (auto &m : sharedMeshes)
+            sum += m->numIndices;
+        return sum;
+    });
+    measure("SlotMapRef, by value", [&]
+    {
+        uint64_t sum = 0;
+        for (auto m : refMeshes)
+            sum += m->numIndices;
+        return sum;
+    });
+    measure("SlotMap, dense", [&]
+    {
+        uint64_t sum = 0;
+        for (auto &m : map)
+            sum += m.numIndices;
+        return sum;
+    });
+    measure("StableSlotMap", [&]
+    {
+        uint64_t sum = 0;
+        stableMap.forEach([&] (const BenchmarkMeshState &m) { sum += m.numIndices; });
+        return sum;
+    });
+}
+
+void writeAsset(const String &path, size_t size, uint8_t value)
+{
+    std::vector<uint8_t> bytes(size, value);
+    File file(path, File::Mode::ReadWrite, File::Create::CreateAlways);
+    XOR_CHECK_HR(file.write(Span<const uint8_t>(bytes)));
+}
+
+void testAssetCache()
+{
+    String directory = "TestCoreCache";
+    std::error_code error;
+    fs::remove_all(directory.cStr(), error);
+
+    AssetKey a = Hash().string("a").done128();
+    AssetKey b = Hash().string("b").done128();
+    AssetKey c = Hash().string("c").done128();
+    String pathA;
+
+    {
+        AssetCache cache(directory, 2500);
+        XOR_CHECK(cache.assetCount() == 0, "New AssetCache is not empty");
+        XOR_CHECK(cache.find(a).empty(), "Empty AssetCache found an asset");
+
+        auto temp = cache.temporaryPath(a);
+        XOR_CHECK(temp != cache.temporaryPath(a), "AssetCache temporary paths are not unique");
+        writeAsset(temp, 1000, 1);
+        pathA = cache.insert(a, temp);
+        XOR_CHECK(!File::exists(temp), "AssetCache::insert() did not move the temporary file");
+        XOR_CHECK(cache.find(a) == pathA, "AssetCache did not find an inserted asset");
+        XOR_CHECK(File(pathA).size() == 1000, "AssetCache asset has the wrong size");
+
+        temp = cache.temporaryPath(b);
+        writeAsset(temp, 1000, 2);
+        cache.insert(b, temp);
+        XOR_CHECK(cache.totalSize() == 2000, "AssetCache total size is wrong");
+    }
+
+    // The manifest should persist across instances.
+    {
+        AssetCache cache(directory, 2500);
+        XOR_CHECK(cache.assetCount() == 2, "AssetCache manifest was not persisted");
+        XOR_CHECK(cache.find(a) == pathA, "AssetCache did not find a persisted asset");
+
+        // Since a was just used, b is the least recently used.
+        auto temp = cache.temporaryPath(c);
+        writeAsset(temp, 1000, 3);
+        cache.insert(c, temp);
+        XOR_CHECK(cache.totalSize() <= 2500, "AssetCache did not evict when full");
+        XOR_CHECK(cache.find(b).empty(), "AssetCache evicted the wrong asset");
+        XOR_CHECK(!cache.find(a).empty() && !cache.find(c).empty(), "AssetCache evicted the wrong asset");
+    }
+
+    // Without a manifest, the cache should be rebuilt from its contents.
+    fs::remove((directory + "/manifest.bin").cStr(), error);
+    {
+        AssetCache cache(directory, 2500);
+        XOR_CHECK(cache.assetCount() == 2, "AssetCache was not rebuilt from its contents");
+        XOR_CHECK(cache.find(a) == pathA, "Rebuilt AssetCache did not find an asset");
+        XOR_CHECK(cache.find(b).empty(), "Rebuilt AssetCache found an evicted asset");
+
+        // Assets removed behind the cache's back are forgotten.
+        fs::remove(pathA.cStr(), error);
+        XOR_CHECK(cache.find(a).empty(), "AssetCache found a removed asset");
+        XOR_CHECK(cache.totalSize() == 1000, "AssetCache total size is wrong after removal");
+
+        // Discarded temporary files are removed.
+        auto temp = cache.temporaryPath(b);
+        writeAsset(temp, 1000, 2);
+        cache.discard(temp);
+        XOR_CHECK(!File::exists(temp), "AssetCache::discard() did not remove the temporary file");
+    }
+
+    // A manifest of another version should be rebuilt, and stale
+    // temporary files from crashed imports should be removed.
+    {
+        auto manifestPath = directory + "/manifest.bin";
+        auto manifest     = File(manifestPath).read();
+        uint32_t structHeader;
+        memcpy(&structHeader, manifest.data(), sizeof(structHeader));
+        structHeader += 1U << serialization::StructSizeBits;
+        memcpy(manifest.data(), &structHeader, sizeof(structHeader));
+        {
+            File file(manifestPath, File::Mode::ReadWrite, File::Create::CreateAlways);
+            XOR_CHECK_HR(file.write(Span<const uint8_t>(manifest.data(), manifest.size())));
+        }
+
+        String stale = directory + "/stale.tmp";
+        String fresh = directory + "/fresh.tmp";
+        writeAsset(stale, 10, 0);
+        writeAsset(fresh, 10, 0);
+        fs::last_write_time(stale.cStr(),
+                            fs::last_write_time(stale.cStr()) - std::chrono::hours(AssetCache::StaleTemporaryHours + 1));
+
+        AssetCache cache(directory, 2500);
+        XOR_CHECK(cache.assetCount() == 1, "AssetCache manifest of another version was not rebuilt");
+        XOR_CHECK(!cache.find(c).empty(), "Rebuilt AssetCache did not find an asset");
+        XOR_CHECK(!File::exists(stale), "AssetCache did not remove a stale temporary file");
+        XOR_CHECK(File::exists(fresh), "AssetCache removed a recent temporary file");
+    }
+
+    fs::remove_all(directory.cStr(), error);
+}
+
+template <typename Key>
+void testRadixSortKeys(Random &gen, ThreadPool &pool, size_t size, uint keyBits)
+{
+    Key mask = keyBits >= sizeof(Key) * 8 ? ~Key(0) : (Key(1) << keyBits) - 1;
+
+    std::vector<Key> keys(size);
+    for (auto &k : keys)
+        k = static_cast<Key>(gen()) & mask;
+
+    auto reference = keys;
+    std::sort(reference.begin(), reference.end());
+
+    auto sorted = keys;
+    radixSort(sorted);
+    XOR_CHECK(sorted == reference, "radixSort() did not sort %zu %zu-bit keys", size, sizeof(Key) * 8);
+
+    sorted = keys;
+    parallelRadixSort(sorted, pool);
+    XOR_CHECK(sorted == reference, "parallelRadixSort() did not sort %zu %zu-bit keys", size, sizeof(Key) * 8);
+
+    // Values are the original indices, so the sort is stable if they
+    // increase within every run of equal keys.
+    auto checkPairs = [&] (const char *name, const std::vector<Key> &k, const std::vector<uint> &v)
+    {
+        XOR_CHECK(k == reference, "%s() did not sort %zu keys with values", name, size);
+        for (size_t i = 0; i < size; ++i)
+        {
+            XOR_CHECK(keys[v[i]] == k[i], "%s() did not move values with their keys", name);
+            if (i > 0 && k[i - 1] == k[i])
+                XOR_CHECK(v[i - 1] < v[i], "%s() is not stable", name);
+        }
+    };
+
+    std::vector<uint> values(size);
+    for (size_t i = 0; i < size; ++i)
+        values[i] = static_cast<uint>(i);
+
+    sorted      = keys;
+    auto moved  = values;
+    radixSort(sorted, moved);
+    checkPairs("radixSort", sorted, moved);
+
+    sorted = keys;
+    moved  = values;
+    parallelRadixSort(sorted, moved, pool);
+    checkPairs("parallelRadixSort", sorted, moved);
+}
+
+void testRadixSort()
+{
+    Random gen;
+    // Enough threads to split the input even on machines with few cores.
+    ThreadPool pool(4);
+    // Sizes around the sorting network, small sort and parallel thresholds.
+    size_t sizes[] = { 0, 1, 2, 8, 9, 10, 255, 256, 1000, 65535, 65536, 300001 };
+    for (size_t size : sizes)
+    {
+        // Few key bits cause equal keys and skipped passes.
+        for (uint bits : { 4, 20, 64 })
+        {
+            testRadixSortKeys<uint32_t>(gen, pool, size, bits);
+            testRadixSortKeys<uint64_t>(gen, pool, size, bits);
+        }
+    }
+
+    print("Radix sort: OK\n");
+}
+
+template <typename T>
+std::vector<T> randomSoA(Random &gen, uint count, size_t arrays)
+{
+    std::vector<T> elements(count * arrays);
+    for (auto &e : elements)
+        e = static_cast<T>(gen() % 1000);
+    return elements;
+}
+
+// Sort every SoA array with std::sort for reference.
+template <typename T>
+std::vector<T> sortedSoA(std::vector<T> elements, uint count)
+{
+    size_t arrays = elements.size() / count;
+    std::vector<T> a(count);
+    for (size_t j = 0; j < arrays; ++j)
+    {
+        for (uint i = 0; i < count; ++i)
+            a[i] = elements[i * arrays + j];
+        std::sort(a.begin(), a.end());
+        for (uint i = 0; i < count; ++i)
+            elements[i * arrays + j] = a[i];
+    }
+    return elements;
+}
+
+template <typename T>
+void testSortingNetworkKeys(Random &gen, uint count, size_t arrays)
+{
+    auto elements  = randomSoA<T>(gen, count, arrays);
+    auto reference = sortedSoA(elements, count);
+
+    std::vector<T> medians(arrays);
+    medianSoA(elements, medians, count);
+    for (size_t j = 0; j < arrays; ++j)
+        XOR_CHECK(medians[j] == reference[count / 2 * arrays + j], "medianSoA() is wrong for %u elements", count);
+
+    sortSoA(elements, count);
+    XOR_CHECK(elements == reference, "sortSoA() did not sort arrays of %u elements", count);
+
+    // Values are the original positions, so they must point to their keys.
+    auto keys = randomSoA<T>(gen, count, arrays);
+    auto sortedKeys = keys;
+    std::vector<uint32_t> values(keys.size());
+    for (size_t i = 0; i < values.size(); ++i)
+        values[i] = static_cast<uint32_t>(i);
+
+    sortSoA(sortedKeys, values, count);
+    XOR_CHECK(sortedKeys == sortedSoA(keys, count), "sortSoA() did not sort %u keys with values", count);
+    for (size_t i = 0; i < values.size(); ++i)
+    {
+        XOR_CHECK(keys[values[i]] == sortedKeys[i], "sortSoA() did not move values with their keys");
+        XOR_CHECK(values[i] % arrays == i % arrays, "sortSoA() moved values between arrays");
+    }
+}
+
+void testSortingNetworks()
+{
+    Random gen;
+    for (uint count = XOR_SORTING_NETWORK_MIN_SIZE; count <= XOR_SORTING_NETWORK_MAX_SIZE; ++count)
+    {
+        // Also test arrays that don't fill a whole SIMD register.
+        for (size_t arrays : { 1, 8, 37 })
+        {
+            testSortingNetworkKeys<float>(gen, count, arrays);
+            testSortingNetworkKeys<uint32_t>(gen, count, arrays);
+        }
+    }
+
+    print("Sorting networks: OK\n");
+}
+
+void testMorton()
+{
+    Random gen;
+
+    // Lengths that are not multiples of the SIMD width use the scalar tail.
+    for (size_t size : { 0, 1, 3, 4, 5, 1000, 1003 })
+    {
+        std::vector<uint2> coords2(size);
+        std::vector<uint3> coords3(size);
+        for (size_t i = 0; i < size; ++i)
+        {
+            coords2[i] = uint2(static_cast<uint>(gen()), static_cast<uint>(gen()));
+            // 3D Morton codes have 21 bits per coordinate.
+            coords3[i] = uint3(static_cast<uint>(gen() & 0x1fffff),
+                               static_cast<uint>(gen() & 0x1fffff),
+                               static_cast<uint>(gen() & 0x1fffff));
+        }
+
+        std::vector<uint64_t> indices2(size);
+        std::vector<uint64_t> indices3(size);
+        morton2DEncode(coords2, indices2);
+        morton3DEncode(coords3, indices3);
+
+        std::vector<uint2> decoded2(size);
+        std::vector<uint3> decoded3(size);
+        morton2DDecode(indices2, decoded2);
+        morton3DDecode(indices3, decoded3);
+
+        for (size_t i = 0; i < size; ++i)
+        {
+            XOR_CHECK(indices2[i] == morton2DEncode(coords2[i]), "Batch morton2DEncode() is wrong");
+            XOR_CHECK(indices3[i] == morton3DEncode(coords3[i]), "Batch morton3DEncode() is wrong");
+            XOR_CHECK(all(decoded2[i] == coords2[i]), "Batch morton2DDecode() is wrong");
+            XOR_CHECK(all(decoded3[i] == coords3[i]), "Batch morton3DDecode() is wrong");
+        }
+    }
+
+    ZOrderTiles oneTile(uint2(ZOrderTiles::TileSize, ZOrderTiles::TileSize));
+    for (uint y = 0; y < ZOrderTiles::TileSize; ++y)
+    {
+        for (uint x = 0; x < ZOrderTiles::TileSize; ++x)
+            XOR_CHECK(oneTile.index(uint2(x, y)) == morton2DEncode(uint2(x, y)), "ZOrderTiles is not in Morton order");
+    }
+
+    // Every pixel must map to a different element, also for sizes
+    // that are not multiples of the tile size.
+    for (uint2 size : { uint2(1, 1), uint2(32, 32), uint2(100, 37), uint2(33, 64) })
+    {
+        ZOrderTiles tiles(size);
+        std::vector<uint8_t> used(tiles.elementCount(), 0);
+        for (uint y = 0; y < size.y; ++y)
+        {
+            for (uint x = 0; x < size.x; ++x)
+            {
+                size_t i = tiles.index(uint2(x, y));
+                XOR_CHECK(i < used.size(), "ZOrderTiles index is out of bounds");
+                XOR_CHECK(!used[i], "ZOrderTiles maps two pixels to the same element");
+                used[i] = 1;
+            }
+        }
+    }
+
+    print("Morton codes: OK\n");
+}
+
+void testPodHash()
+{
+    // Every key of a grid of coordinates must hash differently, and the
+    // low bits used for buckets must be spread evenly.
+    static const int GridSize    = 256;
+    static const uint BucketBits = 12;
+
+    std::unordered_set<uint64_t> hashes;
+    std::vector<uint> buckets(1 << BucketBits);
+    PodHash hash;
+    for (int y = 0; y < GridSize; ++y)
+    {
+        for (int x = 0; x < GridSize; ++x)
+        {
+            uint64_t h = hash(int2(x, y));
+            XOR_CHECK(h == hash(int2(x, y)), "Hash is not deterministic");
+            hashes.emplace(h);
+            ++buckets[h & ((1 << BucketBits) - 1)];
+        }
+    }
+    XOR_CHECK(hashes.size() == GridSize * GridSize, "Grid coordinates have colliding hashes");
+
+    uint expected = GridSize * GridSize >> BucketBits;
+    uint fullest  = *std::max_element(buckets.begin(), buckets.end());
+    XOR_CHECK(fullest < expected * 3, "Hash buckets are unevenly filled (%u keys in one bucket)", fullest);
+
+    // Keys of different sizes with the same bytes differ.
+    XOR_CHECK(hash(int3(1, 2, 0)) != hash(int2(1, 2)), "Keys of different sizes have the same hash");
+    // Large keys still work through SpookyHash.
+    XOR_CHECK(hash(int4(1, 2, 3, 4)) == hash(int4(1, 2, 3, 4)) &&
+              hash(Matrix::identity()) == hashPods(Matrix::identity()),
+              "Large keys hash unexpectedly");
+}
+
+void benchmarkRadixSort()
+{
+    Random gen;
+
+    print("Radix sort benchmark:\n");
+
+    auto measure = [&] (size_t size, const char *name, auto &&makeKeys, auto &&sortKeys)
+    {
+        auto keys      = makeKeys(size);
+        auto reference = keys;
+        auto sorted    = keys;
+
+        Timer stdTimer;
+        std::sort(reference.begin(), reference.end());
+        double stdTime = stdTimer.seconds();
+
+        Timer radixTimer;
+        sortKeys(sorted);
+        double radixTime = radixTimer.seconds();
+
+        XOR_CHECK(sorted == reference, "Radix sort benchmark output is not sorted");
+
+        print("    2^%-2u %-22s std::sort %9.2f ms (%6.2f ns/key), radix sort %9.2f ms (%6.2f ns/key), %5.2fx\n",
+              static_cast<uint>(log2(static_cast<double>(size))), name,
+              stdTime * 1e3, stdTime * 1e9 / size,
+              radixTime * 1e3, radixTime * 1e9 / size,
+              stdTime / radixTime);
+    };
+
+    auto keys32 = [&] (size_t size)
+    {
+        std::vector<uint32_t> keys(size);
+        for (auto &k : keys)
+            k = static_cast<uint32_t>(gen());
+        return keys;
+    };
+
+    auto keys64 = [&] (size_t size)
+    {
+        std::vector<uint64_t> keys(size);
+        for (auto &k : keys)
+            k = gen();
+        return keys;
+    };
+
+    for (uint e = 10; e <= 26; e += 2)
+    {
+        size_t size = size_t(1) << e;
+        measure(size, "uint32", keys32, [] (auto &k) { radixSort(k); });
+        measure(size, "uint32, parallel", keys32, [] (auto &k) { parallelRadixSort(k); });
+        measure(size, "uint64", keys64, [] (auto &k) { radixSort(k); });
+        measure(size, "uint64, parallel", keys64, [] (auto &k) { parallelRadixSort(k); });
+    }
+}
+
+void benchmarkSortingNetworks()
+{
+    static const size_t Elements = 1 << 20;
+
+    Random gen;
+
+    print("Sorting network benchmark, %zu elements in small arrays:\n", Elements);
+
+    for (uint count : { 4, 9, 16, 25, 32 })
+    {
+        size_t arrays = Elements / count;
+        auto soa      = randomSoA<float>(gen, count, arrays);
+
+        // The reference sorts each array separately, as it would be stored
+        // without SIMD in mind.
+        std::vector<float> aos(soa.size());
+        for (size_t j = 0; j < arrays; ++j)
+        {
+            for (uint i = 0; i < count; ++i)
+                aos[j * count + i] = soa[i * arrays + j];
+        }
+
+        auto nthElement = aos;
+        Timer nthTimer;
+        for (size_t j = 0; j < arrays; ++j)
+        {
+            auto a = nthElement.begin() + j * count;
+            std::nth_element(a, a + count / 2, a + count);
+        }
+        double nthTime = nthTimer.seconds();
+
+        Timer stdTimer;
+        for (size_t j = 0; j < arrays; ++j)
+            std::sort(aos.begin() + j * count, aos.begin() + (j + 1) * count);
+        double stdTime = stdTimer.seconds();
+
+        std::vector<float> medians(arrays);
+        Timer medianTimer;
+        medianSoA(soa, medians, count);
+        double medianTime = medianTimer.seconds();
+
+        Timer networkTimer;
+        sortSoA(soa, count);
+        double networkTime = networkTimer.seconds();
+
+        print("    %2u elements: std::sort %6.2f ns/array, sortSoA %6.2f ns/array (%5.2fx), "
+              "std::nth_element %6.2f ns/array, medianSoA %6.2f ns/array (%5.2fx)\n",
+              count,
+              stdTime     * 1e9 / arrays,
+              networkTime * 1e9 / arrays,
+              stdTime / networkTime,
+              nthTime     * 1e9 / arrays,
+              medianTime  * 1e9 / arrays,
+              nthTime / medianTime);
+    }
+}
+
+void benchmarkMorton()
+{
+    static const size_t Coords = 1 << 22;
+
+    Random gen;
+    std::vector<uint2> coords(Coords);
+    for (auto &c : coords)
+        c = uint2(static_cast<uint>(gen() % 65536), static_cast<uint>(gen() % 65536));
+
+    std::vector<uint64_t> indices(Coords);
+    Timer scalarTimer;
+    for (size_t i = 0; i < Coords; ++i)
+        indices[i] = morton2DEncode(coords[i]);
+    double scalarTime = scalarTimer.seconds();
+
+    Timer batchTimer;
+    morton2DEncode(coords, indices);
+    double batchTime = batchTimer.seconds();
+
+    std::vector<uint2> decoded(Coords);
+    Timer scalarDecodeTimer;
+    for (size_t i = 0; i < Coords; ++i)
+        decoded[i] = morton2DDecode(indices[i]);
+    double scalarDecodeTime = scalarDecodeTimer.seconds();
+
+    Timer batchDecodeTimer;
+    morton2DDecode(indices, decoded);
+    double batchDecodeTime = batchDecodeTimer.seconds();
+
+    print("Morton benchmark, %zu 2D coordinates:\n", Coords);
+    print("    encode: per call %5.2f ns, batch %5.2f ns (%5.2fx)\n",
+          scalarTime * 1e9 / Coords, batchTime * 1e9 / Coords, scalarTime / batchTime);
+    print("    decode: per call %5.2f ns, batch %5.2f ns (%5.2fx)\n",
+          scalarDecodeTime * 1e9 / Coords, batchDecodeTime * 1e9 / Coords,
+          scalarDecodeTime / batchDecodeTime);
+}
+
+void benchmarkZOrderLookups()
+{
+    static const uint Size    = 4096;
+    static const uint Queries = 1 << 22;
+
+    Random gen;
+    std::vector<float> rowMajor(static_cast<size_t>(Size) * Size);
+    for (auto &f : rowMajor)
+        f = static_cast<float>(gen() % 1000);
+
+    ZOrderTiles tiles(uint2(Size, Size));
+    std::vector<float> tiled(tiles.elementCount());
+    for (uint y = 0; y < Size; ++y)
+    {
+        for (uint x = 0; x < Size; ++x)
+            tiled[tiles.index(uint2(x, y))] = rowMajor[y * Size + x];
+    }
+
+    auto rowMajorIndex = [] (uint2 c) { return static_cast<size_t>(c.y) * Size + c.x; };
+    auto tiledIndex    = [&] (uint2 c) { return tiles.index(c); };
+
+    std::vector<uint2> randomPixels(Queries);
+    for (auto &c : randomPixels)
+        c = uint2(static_cast<uint>(gen() % Size), static_cast<uint>(gen() % Size));
+
+    // Independent lookups anywhere in the image.
+    auto random = [&] (const std::vector<float> &pixels, auto &&index)
+    {
+        float sum = 0;
+        for (uint2 c : randomPixels)
+            sum += pixels[index(c)];
+        return sum;
+    };
+
+    // Short steps in random directions, where the next lookup depends on the
+    // previous one. Resembles the vertex lookups of terrain refinement,
+    // which sample points near the previous ones between other work.
+    auto walk = [&] (const std::vector<float> &pixels, auto &&index)
+    {
+        uint2 c(Size / 2, Size / 2);
+        float sum = 0;
+        for (uint i = 0; i < Queries; ++i)
+        {
+            float h = pixels[index(c)];
+            sum += h;
+            uint r = static_cast<uint>(h) * 2654435761u + i * 40503u;
+            c.x = (c.x + (r >> 28) - 8) & (Size - 1);
+            c.y = (c.y + ((r >> 24) & 15) - 8) & (Size - 1);
+        }
+        return sum;
+    };
+
+    auto columns = [&] (const std::vector<float> &pixels, auto &&index)
+    {
+        float sum = 0;
+        for (uint x = 0; x < Size; x += Size * Size / Queries)
+        {
+            for (uint y = 0; y < Size; ++y)
+                sum += pixels[index(uint2(x, y))];
+        }
+        return sum;
+    };
+
+    print("Z-order lookup benchmark, %ux%u floats, %u queries:\n", Size, Size, Queries);
+
+    auto compare = [&] (const char *name, auto &&lookups)
+    {
+        Timer rowTimer;
+        float rowSum = lookups(rowMajor, rowMajorIndex);
+        double rowTime = rowTimer.seconds();
+
+        Timer tiledTimer;
+        float tiledSum = lookups(tiled, tiledIndex);
+        double tiledTime = tiledTimer.seconds();
+
+        XOR_CHECK(rowSum == tiledSum, "Layouts returned different pixels");
+
+        print("    %-14s row-major %6.2f ns, Z-order tiled %6.2f ns (%5.2fx)\n",
+              name, rowTime * 1e9 / Queries, tiledTime * 1e9 / Queries, rowTime / tiledTime);
+    };
+
+    compare("random:", random);
+    compare("random walk:", walk);
+    compare("columns:", columns);
+}
+
+void benchmarkMathSimd()
+{
+    using namespace math::vector_detail;
+    using namespace math::matrix_detail;
+
+    static const uint Matrices = 1 << 12;
+    static const uint Rounds   = 256;
+    static const uint Points   = 1 << 22;
+
+    Random gen;
+    std::vector<Matrix> matrices(Matrices);
+    for (auto &m : matrices)
+        m = randomMatrix(gen) + Matrix::identity() * 50;
+
+    std::vector<float4> points(Points);
+    for (auto &p : points)
+        p = randomFloat4(gen);
+
+    // Every variant returns a result that depends on all of its work, and
+    // the results must match, which also keeps the work from being skipped.
+    auto multiplies = [&] (auto policy, float &result)
+    {
+        using R = decltype(policy);
+        Timer timer;
+        for (uint r = 0; r < Rounds; ++r)
+        {
+            for (uint i = 0; i < Matrices; ++i)
+                result += multiply<R>(matrices[i], matrices[(i + r) % Matrices])(i % 4, r % 4);
+        }
+        return timer.seconds();
+    };
+
+    auto inverses = [&] (auto policy, float &result)
+    {
+        using R = decltype(policy);
+        Timer timer;
+        for (uint r = 0; r < Rounds; ++r)
+        {
+            for (auto &a : matrices)
+                result += inverse<R>(a)(1, 2);
+        }
+        return timer.seconds();
+    };
+
+    auto transforms = [&] (auto policy, float &result)
+    {
+        using R = decltype(policy);
+        Matrix m = matrices[0];
+        Timer timer;
+        float4 sum;
+        for (auto &p : points)
+            sum += transform<R>(m, p);
+        result = sum.x + sum.y + sum.z + sum.w;
+        return timer.seconds();
+    };
+
+    float results[6] = {};
+    double scalarMultiply  = multiplies(Float4Scalar(), results[0]);
+    double nativeMultiply  = multiplies(Float4Native(), results[1]);
+    double scalarInverse   = inverses(Float4Scalar(), results[2]);
+    double nativeInverse   = inverses(Float4Native(), results[3]);
+    double scalarTransform = transforms(Float4Scalar(), results[4]);
+    double nativeTransform = transforms(Float4Native(), results[5]);
+
+    for (uint i = 0; i < 6; i += 2)
+        XOR_CHECK(bitEqual(results[i], results[i + 1]), "SIMD results differ from scalar");
+
+    double ops = static_cast<double>(Matrices) * Rounds;
+    print("Math SIMD benchmark (XOR_MATH_SIMD %d):\n", XOR_MATH_SIMD);
+    print("    4x4 multiply:    scalar %6.2f ns, native %6.2f ns (%5.2fx)\n",
+          scalarMultiply * 1e9 / ops, nativeMultiply * 1e9 / ops, scalarMultiply / nativeMultiply);
+    print("    4x4 inverse:     scalar %6.2f ns, native %6.2f ns (%5.2fx)\n",
+          scalarInverse * 1e9 / ops, nativeInverse * 1e9 / ops, scalarInverse / nativeInverse);
+    print("    point transform: scalar %6.2f ns, native %6.2f ns (%5.2fx)\n",
+          scalarTransform * 1e9 / Points, nativeTransform * 1e9 / Points, scalarTransform / nativeTransform);
+}
+
+void benchmarkPackets()
+{
+    static const uint Spheres = 64;
+    static const uint Rays    = 1 << 18;
+    static const uint Width   = NativePacketWidth;
+
+    using P  = Packet<float, Width>;
+    using P3 = Packet3<float, Width>;
+
+    Random gen;
+    std::vector<float3> centers(Spheres);
+    std::vector<float> radiusSqr(Spheres);
+    for (uint i = 0; i < Spheres; ++i)
+    {
+        centers[i]   = float3(randomFloat(gen), randomFloat(gen), randomFloat(gen));
+        radiusSqr[i] = (1 + randomFloat(gen, .5f)) * (1 + randomFloat(gen, .5f));
+    }
+
+    std::vector<float> centerX(Spheres);
+    std::vector<float> centerY(Spheres);
+    std::vector<float> centerZ(Spheres);
+    for (uint i = 0; i < Spheres; ++i)
+    {
+        centerX[i] = centers[i].x;
+        centerY[i] = centers[i].y;
+        centerZ[i] = centers[i].z;
+    }
+
+    std::vector<float3> dirs(Rays);
+    for (auto &d : dirs)
+        d = normalize(float3(randomFloat(gen), randomFloat(gen), randomFloat(gen)));
+
+    // The distance to the closest sphere in front of each ray, summed.
+    float3 origin = float3(0.5f);
+    Timer scalarTimer;
+    float scalarResult = 0;
+    for (auto &d : dirs)
+    {
+        float closest = MaxFloat;
+        for (uint i = 0; i < Spheres; ++i)
+        {
+            float3 CO = origin - centers[i];
+            auto roots = Quadratic(dot(d, d), 2 * dot(d, CO), dot(CO, CO) - radiusSqr[i]).solve();
+            for (int r = 0; r < roots.numRoots; ++r)
+            {
+                if (roots.x[r] >= 0)
+                    closest = std::min(closest, roots.x[r]);
+            }
+        }
+        scalarResult += closest == MaxFloat ? 0 : closest;
+    }
+    double scalarTime = scalarTimer.seconds();
+
+    Timer packetTimer;
+    float packetResult = 0;
+    for (auto &d : dirs)
+    {
+        P closest = MaxFloat;
+        for (uint i = 0; i < Spheres; i += Width)
+        {
+            P3 CO = P3(origin) - P3::load(&centerX[i], &centerY[i], &centerZ[i]);
+            auto roots = QuadraticPacket<Width>(dot(d, d), 2 * dot(P3(d), CO), dot(CO, CO) - P::load(&radiusSqr[i])).solve();
+            closest = min(closest, select(roots.hasRoots & (roots.x0 >= 0), roots.x0, P(MaxFloat)));
+            closest = min(closest, select(roots.hasRoots & (roots.x1 >= 0), roots.x1, P(MaxFloat)));
+        }
+        float t = horizontalMin(closest);
+        packetResult += t == MaxFloat ? 0 : t;
+    }
+    double packetTime = packetTimer.seconds();
+
+    XOR_CHECK(scalarResult == packetResult, "Packet results differ from scalar");
+
+    double tests = static_cast<double>(Spheres) * Rays;
+    print("Packet benchmark (%u lanes):\n", Width);
+    print("    ray-sphere hit: scalar %6.2f ns, packet %6.2f ns (%5.2fx)\n",
+          scalarTime * 1e9 / tests, packetTime * 1e9 / tests, scalarTime / packetTime);
+}
+
+void benchmarkBatchMath()
+{
+    static const uint Points = 1 << 20;
+    static const uint Boxes  = 1 << 16;
+    static const uint Rounds = 16;
+
+    Random gen;
+    Matrix m = randomMatrix(gen) + Matrix::identity() * 50;
+
+    std::vector<float3> points(Points);
+    for (auto &p : points)
+        p = float3(randomFloat(gen), randomFloat(gen), randomFloat(gen));
+
+    std::vector<AABB> boxes(Boxes);
+    for (auto &b : boxes)
+    {
+        float3 center = float3(randomFloat(gen, 100), randomFloat(gen, 100), randomFloat(gen, 100));
+        float3 size   = float3(1 + randomFloat(gen, 1), 1 + randomFloat(gen, 1), 1 + randomFloat(gen, 1));
+        b = AABB(center - size, center + size);
+    }
+
+    Matrix viewProj = Matrix::projectionPerspective(1.f, Angle::degrees(90.f), 1, 100);
+    auto planes     = frustumPlanes(viewProj);
+
+    std::vector<float4> transformed(Points);
+    std::vector<float3> projected(Points);
+    std::vector<uint8_t> visible(Boxes);
+
+    Timer scalarTransformTimer;
+    for (uint i = 0; i < Points; ++i)
+        transformed[i] = m.transform(points[i]);
+    double scalarTransform = scalarTransformTimer.seconds();
+    float4 scalarSum = std::accumulate(transformed.begin(), transformed.end(), float4(0));
+
+    Timer batchTransformTimer;
+    transformPoints(m, points, transformed);
+    double batchTransform = batchTransformTimer.seconds();
+    float4 batchSum = std::accumulate(transformed.begin(), transformed.end(), float4(0));
+    XOR_CHECK(all(scalarSum == batchSum), "transformPoints() results differ from scalar");
+
+    Timer scalarProjectTimer;
+    for (uint i = 0; i < Points; ++i)
+        projected[i] = m.transformAndProject(points[i]);
+    double scalarProject = scalarProjectTimer.seconds();
+
+    Timer batchProjectTimer;
+    transformAndProjectPoints(m, points, projected);
+    double batchProject = batchProjectTimer.seconds();
+
+    size_t scalarVisible = 0;
+    Timer scalarFrustumTimer;
+    for (uint r = 0; r < Rounds; ++r)
+    {
+        for (uint i = 0; i < Boxes; ++i)
+            visible[i] = frustumTestAABB(boxes[i], planes) ? 1 : 0;
+    }
+    double scalarFrustum = scalarFrustumTimer.seconds();
+    scalarVisible = std::count(visible.begin(), visible.end(), uint8_t(1));
+
+    Timer batchFrustumTimer;
+    for (uint r = 0; r < Rounds; ++r)
+        frustumTestAABBs(boxes, planes, visible);
+    double batchFrustum = batchFrustumTimer.seconds();
+    size_t batchVisible = std::count(visible.begin(), visible.end(), uint8_t(1));
+    XOR_CHECK(scalarVisible == batchVisible, "frustumTestAABBs() results differ from scalar");
+
+    double tests = static_cast<double>(Boxes) * Rounds;
+    print("Batch math benchmark (%u lanes, %u threads):\n", NativePacketWidth, ThreadPool::global().threadCount() + 1);
+    print("    transform:        scalar %6.2f ns, batch %6.2f ns (%5.2fx)\n",
+          scalarTransform * 1e9 / Points, batchTransform * 1e9 / Points, scalarTransform / batchTransform);
+    print("    transform+divide: scalar %6.2f ns, batch %6.2f ns (%5.2fx)\n",
+          scalarProject * 1e9 / Points, batchProject * 1e9 / Points, scalarProject / batchProject);
+    print("    AABB frustum:     scalar %6.2f ns, batch %6.2f ns (%5.2fx), %.1f%% visible\n",
+          scalarFrustum * 1e9 / tests, batchFrustum * 1e9 / tests, scalarFrustum / batchFrustum,
+          100.0 * batchVisible / Boxes);
+}
+
+void benchmarkRandomStreams()
+{
+    static const uint Floats = 1 << 20;
+    static const uint Rounds = 16;
+
+    std::vector<float> floats(Floats);
+
+    Random gen;
+    Timer scalarTimer;
+    for (uint r = 0; r < Rounds; ++r)
+    {
+        for (auto &f : floats)
+            f = fastUniformFloat(gen);
+    }
+    double scalar = scalarTimer.seconds();
+    double scalarSum = std::accumulate(floats.begin(), floats.end(), 0.0);
+
+    Random8 streams;
+    Timer streamsTimer;
+    for (uint r = 0; r < Rounds; ++r)
+        streams.fillUniformFloat(floats);
+    double batch = streamsTimer.seconds();
+    double batchSum = std::accumulate(floats.begin(), floats.end(), 0.0);
+
+    double count = static_cast<double>(Floats) * Rounds;
+    print("Random float benchmark (%u streams):\n", Random8::Streams);
+    print("    scalar %6.3f ns, fillUniformFloat %6.3f ns (%5.2fx), means %.4f %.4f\n",
+          scalar * 1e9 / count, batch * 1e9 / count, scalar / batch,
+          scalarSum / Floats, batchSum / Floats);
+}
+
+void benchmarkPodHash()
+{
+    static const uint Keys    = 1000000;
+    static const uint Queries = 4000000;
+
+    // Resembles the used vertex set of the terrain triangulation, which
+    // is queried for sampled points that are mostly not in the set.
+    Random gen;
+    std::vector<int2> keys;
+    std::vector<int2> queries;
+    for (uint i = 0; i < Keys; ++i)
+        keys.emplace_back(static_cast<int>(gen() % 4096), static_cast<int>(gen() % 4096));
+    for (uint i = 0; i < Queries; ++i)
+        queries.emplace_back(static_cast<int>(gen() % 4096), static_cast<int>(gen() % 4096));
+
+    print("PodHash benchmark, %u int2 keys, %u queries:\n", Keys, Queries);
+
+    auto measure = [&] (const char *name, auto hash)
+    {
+        Timer hashTimer;
+        uint64_t sum = 0;
+        for (auto &q : queries)
+            sum += hash(q);
+        double hashTime = hashTimer.seconds();
+
+        using Set = std::unordered_set<int2, decltype(hash), PodEqual>;
+        Set set;
+        set.reserve(Keys);
+        Timer insertTimer;
+        for (auto &k : keys)
+            set.emplace(k);
+        double insertTime = insertTimer.seconds();
+
+        Timer findTimer;
+        size_t found = 0;
+        for (auto &q : queries)
+            found += set.count(q);
+        double findTime = findTimer.seconds();
+
+        print("    %-10s hash %6.2f ns/key, insert %6.2f ns/key, find %6.2f ns/query (%zu found, %llx)\n",
+              name,
+              hashTime   * 1e9 / Queries,
+              insertTime * 1e9 / Keys,
+              findTime   * 1e9 / Queries,
+              found, static_cast<llu>(sum & 0xff));
+    };
+
+    measure("SpookyHash", SpookyPodHash());
+    measure("PodHash", PodHash());
+}
+
+void testFlatHash()
+{
+    static const uint Operations = 200000;
+
+    // Compare against the standard containers with a mix of operations
+    // on a small key range, so there are lots of hits and deletions.
+    Random gen;
+    FlatHashSet<int> set;
+    FlatHashMap<int, uint> map;
+    std::unordered_set<int> refSet;
+    std::unordered_map<int, uint> refMap;
+
+    for (uint i = 0; i < Operations; ++i)
+    {
+        int key = static_cast<int>(gen() % 5000) - 1000;
+        switch (gen() % 4)
+        {
+        case 0:
+        case 1:
+            XOR_CHECK(set.insert(key).second == refSet.insert(key).second, "Set insert disagrees");
+            XOR_CHECK(map.emplace(key, i).second == refMap.emplace(key, i).second, "Map emplace disagrees");
+            break;
+        case 2:
+            XOR_CHECK(set.erase(key) == refSet.erase(key), "Set erase disagrees");
+            XOR_CHECK(map.erase(key) == refMap.erase(key), "Map erase disagrees");
+            break;
+        default:
+            XOR_CHECK(set.count(key) == refSet.count(key), "Set count disagrees");
+            auto it = map.find(key);
+            auto refIt = refMap.find(key);
+            XOR_CHECK((it == map.end()) == (refIt == refMap.end()) &&
+                      (it == map.end() || it->second == refIt->second),
+                      "Map find disagrees");
+            break;
+        }
+
+        if (i % 50000 == 0)
+        {
+            // Iteration visits every element exactly once.
+            std::vector<int> keys(set.begin(), set.end());
+            std::sort(keys.begin(), keys.end());
+            std::vector<int> refKeys(refSet.begin(), refSet.end());
+            std::sort(refKeys.begin(), refKeys.end());
+            XOR_CHECK(keys == refKeys, "Set iteration disagrees");
+        }
+    }
+
+    XOR_CHECK(set.size() == refSet.size() && map.size() == refMap.size(), "Sizes disagree");
+
+    uint64_t sum    = 0;
+    uint64_t refSum = 0;
+    for (auto &kv : map)
+        sum += static_cast<uint64_t>(kv.first) * kv.second;
+    for (auto &kv : refMap)
+        refSum += static_cast<uint64_t>(kv.first) * kv.second;
+    XOR_CHECK(sum == refSum, "Map iteration disagrees");
+
+    // Copies are independent, and moves leave the source empty.
+    auto copy = set;
+    copy.insert(100000);
+    XOR_CHECK(copy.size() == set.size() + 1 && !set.count(100000), "Set copy is not independent");
+    auto moved = std::move(copy);
+    XOR_CHECK(copy.empty() && moved.count(100000), "Set move failed");
+
+    // Clearing keeps the memory.
+    size_t capacity = set.capacity();
+    set.clear();
+    XOR_CHECK(set.empty() && set.capacity() == capacity && set.begin() == set.end(),
+              "Clearing did not keep the memory");
+    for (int k = 0; k < 100; ++k)
+        set.insert(k);
+    XOR_CHECK(set.size() == 100 && set.capacity() == capacity && set.count(42) && !set.count(100),
+              "Set is not usable after clearing");
+
+    // Taking the first element until empty, like a work queue.
+    size_t taken = 0;
+    while (!set.empty())
+    {
+        set.erase(*set.begin());
+        ++taken;
+    }
+    XOR_CHECK(taken == 100, "Set did not empty as expected");
+
+    FlatHashMap<int64_t, int> counts;
+    for (int64_t k = 0; k < 1000; ++k)
+        ++counts[k % 10 + (k << 40) % 3];
+    XOR_CHECK(counts.size() == 12 && counts[0] > 0, "Map operator[] failed");
+}
+
+// Jittered grid of points in a coherent order, like the samples
+// inserted into the terrain triangulation.
+std::vector<Vector<int64_t, 3>> delaunayPoints(uint gridSize)
+{
+    static const int CellSize = 64;
+
+    Random gen;
+    std::vector<Vector<int64_t, 3>> points;
+    for (uint y = 0; y < gridSize; ++y)
+    {
+        for (uint i = 0; i < gridSize; ++i)
+        {
+            // Go back and forth, so consecutive points are always close.
+            uint x = (y % 2) ? gridSize - 1 - i : i;
+            points.emplace_back(static_cast<int64_t>(x * CellSize + 1 + gen() % (CellSize - 2)),
+                                static_cast<int64_t>(y * CellSize + 1 + gen() % (CellSize - 2)),
+                                static_cast<int64_t>(gen() % 1000));
+        }
+    }
+    return points;
+}
+
+template <typename DE>
+typename DE::MeshBuffers delaunayTriangulate(Span<const Vector<int64_t, 3>> points, uint gridSize)
+{
+    using Pos = typename DE::VertexPosition;
+
+    DE mesh;
+    DelaunayFlip<DE> delaunay(mesh);
+    delaunay.superRectangle(Pos(0), Pos(static_cast<int64_t>(gridSize) * 64));
+
+    int previous = -1;
+    for (auto &p : points)
+    {
+        previous = previous < 0
+            ? delaunay.insertVertex(p)
+            : delaunay.insertVertexNearAnother(p, previous);
+    }
+
+    return delaunay.exportWithoutSuperPolygon();
+}
+
+void testDelaunay()
+{
+    static const uint GridSize = 30;
+    using DE = DirectedEdge<Empty, Vector<int64_t, 3>>;
+
+    auto points  = delaunayPoints(GridSize);
+    auto buffers = delaunayTriangulate<DE>(points, GridSize);
+
+    // With the four corners of the super rectangle, the convex hull has
+    // four vertices, so a triangulation has 2 * (n + 4) - 6 triangles,
+    // and those without the super vertices are exported.
+    size_t triangles = buffers.ib.size() / 3;
+    XOR_CHECK(triangles > points.size() && triangles < 2 * points.size(),
+              "Triangulation has an unexpected amount of triangles (%zu for %zu points)",
+              triangles, points.size());
+
+    std::vector<uint8_t> used(buffers.vb.size());
+    for (int i : buffers.ib)
+        used[i] = 1;
+    XOR_CHECK(std::count(used.begin(), used.end(), 1) == static_cast<ptrdiff_t>(points.size()),
+              "Triangulation does not use every inserted point");
+
+    auto clustered = clusterAndOptimize(buffers.ib, 256);
+    std::vector<int> sortedIb = buffers.ib;
+    std::vector<int> sortedClustered = clustered.ib;
+    std::sort(sortedIb.begin(), sortedIb.end());
+    std::sort(sortedClustered.begin(), sortedClustered.end());
+    XOR_CHECK(sortedIb == sortedClustered, "Clustering changed the set of triangles");
+}
+
+void benchmarkDelaunay()
+{
+    static const uint GridSize = 150;
+    using DE = DirectedEdge<Empty, Vector<int64_t, 3>>;
+
+    auto points = delaunayPoints(GridSize);
+
+    Timer insertTimer;
+    auto buffers = delaunayTriangulate<DE>(points, GridSize);
+    double insertTime = insertTimer.milliseconds();
+
+    Timer clusterTimer;
+    auto clustered = clusterAndOptimize(buffers.ib, 256);
+    double clusterTime = clusterTimer.milliseconds();
+
+    print("Delaunay benchmark, %zu points:\n", points.size());
+    print("    insertion            %8.2f ms (%.2f us/point)\n", insertTime, insertTime * 1000 / points.size());
+    print("    clusterAndOptimize   %8.2f ms (%zu clusters)\n", clusterTime, clustered.clusterSpans.size());
+}
+
+int main(int argc, char **argv)
+{
+    testHeap<OffsetHeap>("OffsetHeap");
+    testHeap<OffsetHeapTLSF>("OffsetHeapTLSF");
+    testOffsetHeapBins();
+    testBuddy();
+    testConcurrentPool();
+    testConcurrentRing();
+    testFrameArena();
+    testSlotMap();
+    testAllocationTrace();
+    testThreadPool();
+    testCompressionStream();
+    testCompressionParallel();
+    testZstdDictionary();
+    testStreamFilters();
+    testPodHash();
+    testFlatHash();
+    testDelaunay();
+    testChunkFile();
+    testAssetCache();
+    testRadixSort();
+    testSortingNetworks();
+    testMorton();
+    benchmarkHeaps();
+    benchmarkPools();
+    benchmarkSlotMap();
+    benchmarkChunkFile();
+    benchmarkCompressionParallel();
+    benchmarkZstdDictionary();
+    benchmarkStreamFilters();
+    benchmarkPodHash();
+    benchmarkRadixSort();
+    benchmarkSortingNetworks();
+    benchmarkMorton();
+    benchmarkZOrderLookups();
+    benchmarkMathSimd();
+    benchmarkPackets();
+    benchmarkBatchMath();
+    benchmarkRandomStreams();
+    benchmarkDelaunay();
+    return 0;
+}
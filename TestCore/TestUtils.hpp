@@ -0,0 +1,33 @@
+#pragma once
+
+#include "Core/Core.hpp"
+
+#include <cstring>
+
+// Helpers shared by TestCore and TestMath.
+namespace Xor
+{
+    namespace test
+    {
+        template <typename T>
+        bool bitEqual(const T &a, const T &b)
+        {
+            return memcmp(&a, &b, sizeof(T)) == 0;
+        }
+
+        inline float randomFloat(Random &gen, float range = 10)
+        {
+            return (fastUniformFloat(gen) * 2 - 1) * range;
+        }
+
+        inline float4 randomFloat4(Random &gen, float range = 10)
+        {
+            return float4(randomFloat(gen, range), randomFloat(gen, range), randomFloat(gen, range), randomFloat(gen, range));
+        }
+
+        inline Matrix randomMatrix(Random &gen)
+        {
+            return Matrix(randomFloat4(gen), randomFloat4(gen), randomFloat4(gen), randomFloat4(gen));
+        }
+    }
+}
@@ -1,6 +1,8 @@
 #include "Core/Core.hpp"
+#include "TestCore/TestUtils.hpp"
 
 using namespace Xor;
+using namespace Xor::test;
 using Xor::math::Vector;
 using Xor::math::Matrix;
 using Xor::math::Angle;
@@ -208,11 +210,355 @@ void testGeometry()
     }
 }
 
+void testSimd()
+{
+    using namespace math::vector_detail;
+    using namespace math::matrix_detail;
+
+    Random gen;
+
+    // Signed zeros and infinities must also give the same bits.
+    float special[] = { 0.f, -0.f, 1.f, -1.f, std::numeric_limits<float>::infinity(), 1e-40f };
+    for (uint i = 0; i < 10000; ++i)
+    {
+        float4 a = randomFloat4(gen);
+        float4 b = randomFloat4(gen);
+        if (i % 4 == 0)
+        {
+            a[i % 3] = special[(i / 4) % 6];
+            b[i % 3] = special[(i / 24) % 6];
+        }
+
+        XOR_CHECK(bitEqual(a + b, ScalarOps<float, 4>::add(a, b)), "float4 + differs from scalar");
+        XOR_CHECK(bitEqual(a - b, ScalarOps<float, 4>::sub(a, b)), "float4 - differs from scalar");
+        XOR_CHECK(bitEqual(a * b, ScalarOps<float, 4>::mul(a, b)), "float4 * differs from scalar");
+        XOR_CHECK(bitEqual(a / b, ScalarOps<float, 4>::div(a, b)), "float4 / differs from scalar");
+        XOR_CHECK(bitEqual(min(a, b), ScalarOps<float, 4>::min(a, b)), "float4 min() differs from scalar");
+        XOR_CHECK(bitEqual(max(a, b), ScalarOps<float, 4>::max(a, b)), "float4 max() differs from scalar");
+
+        int4 ia = int4(static_cast<int>(gen()), static_cast<int>(gen()), static_cast<int>(gen() % 1000), -7);
+        int4 ib = int4(static_cast<int>(gen() % 1000), static_cast<int>(gen()), 3, static_cast<int>(gen() % 1000) + 1);
+        XOR_CHECK(all(ia + ib == ScalarOps<int, 4>::add(ia, ib)), "int4 + differs from scalar");
+        XOR_CHECK(all(ia - ib == ScalarOps<int, 4>::sub(ia, ib)), "int4 - differs from scalar");
+        XOR_CHECK(all(min(ia, ib) == ScalarOps<int, 4>::min(ia, ib)), "int4 min() differs from scalar");
+        XOR_CHECK(all(max(ia, ib) == ScalarOps<int, 4>::max(ia, ib)), "int4 max() differs from scalar");
+        ia = ia % int4(1 << 15);
+        ib = ib % int4(1 << 15);
+        XOR_CHECK(all(ia * ib == ScalarOps<int, 4>::mul(ia, ib)), "int4 * differs from scalar");
+    }
+
+    for (uint i = 0; i < 10000; ++i)
+    {
+        Matrix a = randomMatrix(gen);
+        Matrix b = randomMatrix(gen);
+        float4 v = randomFloat4(gen);
+
+        // The scalar loops used before SIMD, which must give the same bits.
+        Matrix ab = Matrix::zero();
+        float4 av;
+        for (uint y = 0; y < 4; ++y)
+        {
+            for (uint x = 0; x < 4; ++x)
+            {
+                for (uint k = 0; k < 4; ++k)
+                    ab(y, x) += a(y, k) * b(k, x);
+            }
+            av[y] = dot(a.row(y), v);
+        }
+
+        XOR_CHECK(bitEqual(a * b, ab), "Matrix multiplication differs from scalar loops");
+        XOR_CHECK(bitEqual(multiply<Float4Scalar>(a, b), ab), "Scalar Matrix multiplication differs from scalar loops");
+        XOR_CHECK(bitEqual(a * v, av), "Matrix transform differs from scalar loops");
+        XOR_CHECK(bitEqual(transform<Float4Scalar>(a, v), av), "Scalar Matrix transform differs from scalar loops");
+        XOR_CHECK(bitEqual(a.transpose(), transpose<Float4Scalar>(a)), "Matrix transpose differs from scalar");
+        XOR_CHECK(a.transpose()(1, 2) == a(2, 1), "Matrix transpose is wrong");
+        XOR_CHECK(bitEqual(a.inverse(), inverse<Float4Scalar>(a)), "Matrix inverse differs from scalar");
+
+        // Diagonally dominant, so well conditioned enough to check accuracy.
+        Matrix c = a + Matrix::identity() * 50;
+        Matrix cInv = c * c.inverse();
+        for (uint y = 0; y < 4; ++y)
+        {
+            for (uint x = 0; x < 4; ++x)
+                XOR_CHECK(std::abs(cInv(y, x) - (x == y ? 1 : 0)) < 1e-4f, "Matrix inverse is inaccurate");
+        }
+    }
+
+    print("Math SIMD: OK\n");
+}
+
+template <uint N>
+void testPacketsOfWidth()
+{
+    using P  = Packet<float, N>;
+    using P3 = Packet3<float, N>;
+
+    Random gen;
+
+    for (uint i = 0; i < 10000; ++i)
+    {
+        float a[N];
+        float b[N];
+        float c[N];
+        float3 u[N];
+        float3 v[N];
+        for (uint j = 0; j < N; ++j)
+        {
+            a[j] = randomFloat(gen);
+            b[j] = randomFloat(gen);
+            c[j] = randomFloat(gen);
+            u[j] = float3(randomFloat(gen), randomFloat(gen), randomFloat(gen));
+            v[j] = float3(randomFloat(gen), randomFloat(gen), randomFloat(gen));
+        }
+        if (i % 4 == 0)
+        {
+            b[i % N] = a[i % N];
+            c[(i + 1) % N] = 0;
+        }
+
+        P pa = P::load(a);
+        P pb = P::load(b);
+        P pc = P::load(c);
+        P3 pu = P3::load(u);
+        P3 pv = P3::load(v);
+
+        P sum = pa + pb;
+        P dif = pa - pb;
+        P mul = pa * pb;
+        P div = pa / pb;
+        P mn  = min(pa, pb);
+        P mx  = max(pa, pb);
+        P sq  = sqrt(abs(pa));
+        P sel = select(pa < pb, pa, pc);
+
+        P dp   = dot(pu, pv);
+        P3 cr  = cross(pu, pv);
+        P3 nu  = normalize(pu);
+        P3 bar = interpolateBarycentric(u[0], u[1], u[2], P3(abs(pa), abs(pb), abs(pc)));
+        P3 ub  = uniformBarycentric(abs(pa) / 10, abs(pb) / 10);
+
+        auto roots = QuadraticPacket<N>(pa, pb, pc).solve();
+
+        uint lt = (pa < pb).bits();
+        uint le = (pa <= pb).bits();
+        uint gt = (pa > pb).bits();
+        uint ge = (pa >= pb).bits();
+        uint eq = (pa == pb).bits();
+        uint ne = (pa != pb).bits();
+
+        for (uint j = 0; j < N; ++j)
+        {
+            XOR_CHECK(sum[j] == a[j] + b[j], "Packet + differs from scalar");
+            XOR_CHECK(dif[j] == a[j] - b[j], "Packet - differs from scalar");
+            XOR_CHECK(mul[j] == a[j] * b[j], "Packet * differs from scalar");
+            XOR_CHECK(div[j] == a[j] / b[j], "Packet / differs from scalar");
+            XOR_CHECK(mn[j] == std::min(a[j], b[j]), "Packet min() differs from scalar");
+            XOR_CHECK(mx[j] == std::max(a[j], b[j]), "Packet max() differs from scalar");
+            XOR_CHECK(sq[j] == std::sqrt(std::abs(a[j])), "Packet sqrt() differs from scalar");
+            XOR_CHECK(sel[j] == (a[j] < b[j] ? a[j] : c[j]), "Packet select() differs from scalar");
+            XOR_CHECK((-pa)[j] == -a[j], "Packet negation differs from scalar");
+
+            XOR_CHECK(((lt >> j) & 1) == (a[j] <  b[j]), "Packet < differs from scalar");
+            XOR_CHECK(((le >> j) & 1) == (a[j] <= b[j]), "Packet <= differs from scalar");
+            XOR_CHECK(((gt >> j) & 1) == (a[j] >  b[j]), "Packet > differs from scalar");
+            XOR_CHECK(((ge >> j) & 1) == (a[j] >= b[j]), "Packet >= differs from scalar");
+            XOR_CHECK(((eq >> j) & 1) == (a[j] == b[j]), "Packet == differs from scalar");
+            XOR_CHECK(((ne >> j) & 1) == (a[j] != b[j]), "Packet != differs from scalar");
+
+            XOR_CHECK(dp[j] == dot(u[j], v[j]), "Packet dot() differs from scalar");
+            XOR_CHECK(all(cr[j] == cross(u[j], v[j])), "Packet cross() differs from scalar");
+            XOR_CHECK(all(nu[j] == normalize(u[j])), "Packet normalize() differs from scalar");
+            XOR_CHECK(all(bar[j] == interpolateBarycentric(u[0], u[1], u[2], float3(std::abs(a[j]), std::abs(b[j]), std::abs(c[j])))),
+                      "Packet interpolateBarycentric() differs from scalar");
+            XOR_CHECK(all(ub[j] == uniformBarycentric(float2(std::abs(a[j]) / 10, std::abs(b[j]) / 10))),
+                      "Packet uniformBarycentric() differs from scalar");
+
+            auto scalarRoots = Quadratic(a[j], b[j], c[j]).solve();
+            XOR_CHECK(((roots.hasRoots.bits() >> j) & 1) == !!scalarRoots, "Packet Quadratic has different roots");
+            if (scalarRoots.numRoots == 2)
+            {
+                XOR_CHECK(roots.x0[j] == scalarRoots.x[0] && roots.x1[j] == scalarRoots.x[1],
+                          "Packet Quadratic roots differ from scalar");
+            }
+        }
+
+        // Reductions combine lanes i and i + N/2 until one is left.
+        float reduced[N];
+        std::copy(a, a + N, reduced);
+        for (uint half = N / 2; half > 0; half /= 2)
+        {
+            for (uint j = 0; j < half; ++j)
+                reduced[j] += reduced[j + half];
+        }
+        XOR_CHECK(horizontalSum(pa) == reduced[0], "Packet horizontalSum() differs from scalar");
+        XOR_CHECK(horizontalMin(pa) == *std::min_element(a, a + N), "Packet horizontalMin() differs from scalar");
+        XOR_CHECK(horizontalMax(pa) == *std::max_element(a, a + N), "Packet horizontalMax() differs from scalar");
+    }
+
+    XOR_CHECK(all(P(1) == P(1)) && none(P(1) == P(2)) && !any(P(1) != P(1)), "Packet masks are wrong");
+    XOR_CHECK(none(~(P(1) < P(2))) && all((P(1) < P(2)) | (P(1) > P(2))), "Packet masks are wrong");
+}
+
+void testPackets()
+{
+    testPacketsOfWidth<4>();
+    testPacketsOfWidth<8>();
+
+    print("Packets: OK\n");
+}
+
+float3 randomFloat3(Random &gen, float range = 10)
+{
+    return float3(randomFloat(gen, range), randomFloat(gen, range), randomFloat(gen, range));
+}
+
+void testBatch()
+{
+    Random gen;
+    ThreadPool pool(3);
+
+    // Sizes with scalar tails, and one that is split between threads.
+    Matrix m = randomMatrix(gen) + Matrix::identity() * 50;
+    for (size_t count : { 0, 1, 13, 100, 100000 })
+    {
+        std::vector<float3> points(count);
+        for (auto &p : points)
+            p = randomFloat3(gen);
+
+        std::vector<float4> transformed(count);
+        std::vector<float3> projected(count);
+        transformPoints(m, points, transformed, pool);
+        transformAndProjectPoints(m, points, projected, pool);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            XOR_CHECK(all(transformed[i] == m.transform(points[i])), "transformPoints() differs from Matrix::transform()");
+            XOR_CHECK(all(projected[i] == m.transformAndProject(points[i])), "transformAndProjectPoints() differs from Matrix::transformAndProject()");
+        }
+    }
+
+    Matrix viewProj = Matrix::projectionPerspective(1.f, Angle::degrees(90.f), 1, 100)
+                    * Matrix::lookInDirection({0, 0, -1});
+    auto planes = frustumPlanes(viewProj);
+
+    XOR_CHECK_EQ(frustumTestAABB(AABB(float3(-1, -1, -11), float3(1, 1, -9)), planes), true);
+    XOR_CHECK_EQ(frustumTestAABB(AABB(float3(-1, -1, 9), float3(1, 1, 11)), planes), false);
+    XOR_CHECK_EQ(frustumTestAABB(AABB(float3(49, -1, -11), float3(51, 1, -9)), planes), false);
+    XOR_CHECK_EQ(frustumTestAABB(AABB(float3(-1, -1, -110), float3(1, 1, -101)), planes), false);
+    XOR_CHECK_EQ(frustumTestAABB(AABB(float3(-1, -1, -2), float3(1, 1, 2)), planes), true);
+
+    for (size_t count : { 0, 1, 13, 100, 100000 })
+    {
+        std::vector<AABB> boxes(count);
+        for (auto &b : boxes)
+        {
+            float3 center = randomFloat3(gen, 100);
+            float3 size   = abs(randomFloat3(gen, 5));
+            b = AABB(center - size, center + size);
+        }
+
+        std::vector<uint8_t> visible(count);
+        frustumTestAABBs(boxes, planes, visible, pool);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            XOR_CHECK(visible[i] == (frustumTestAABB(boxes[i], planes) ? 1 : 0), "frustumTestAABBs() differs from frustumTestAABB()");
+
+            // Boxes with a corner inside must never be culled.
+            for (uint c = 0; c < 8 && !visible[i]; ++c)
+            {
+                float3 corner = float3(c & 1 ? boxes[i].max.x : boxes[i].min.x,
+                                       c & 2 ? boxes[i].max.y : boxes[i].min.y,
+                                       c & 4 ? boxes[i].max.z : boxes[i].min.z);
+                float4 clip = viewProj.transform(corner);
+                bool inside = std::abs(clip.x) <= clip.w && std::abs(clip.y) <= clip.w && clip.z >= 0 && clip.z <= clip.w;
+                XOR_CHECK(!inside, "frustumTestAABBs() culled a visible box");
+            }
+        }
+    }
+
+    print("Batch math: OK\n");
+}
+
+void testRandomStreams()
+{
+    static const uint N = 8;
+
+    Random seed(12345, 67890);
+    Random8 streams(seed);
+
+    Random gens[N];
+    for (uint i = 0; i < N; ++i)
+    {
+        gens[i] = seed;
+        seed.jump();
+    }
+
+    for (uint round = 0; round < 100; ++round)
+    {
+        uint64_t results[N];
+        streams.next(results);
+        for (uint i = 0; i < N; ++i)
+            XOR_CHECK(results[i] == gens[i].next(), "Stream %u differs from Random", i);
+    }
+
+    // Sizes that end in the middle of a round.
+    for (size_t count : { 0, 3, 16, 1001 })
+    {
+        std::vector<float> floats(count);
+        streams.fillUniformFloat(floats);
+
+        for (size_t i = 0; i < count; i += Random8::FloatsPerRound)
+        {
+            for (uint s = 0; s < N; ++s)
+            {
+                uint64_t r = gens[s].next();
+                float expected[2];
+                random_detail::Scalar::storeFloats(expected, r);
+
+                for (uint h = 0; h < 2 && i + 2 * s + h < count; ++h)
+                {
+                    float f = floats[i + 2 * s + h];
+                    XOR_CHECK(bitEqual(f, expected[h]), "fillUniformFloat() differs from Random");
+                    XOR_CHECK(f >= 0 && f < 1, "fillUniformFloat() is not in [0, 1)");
+                }
+            }
+        }
+    }
+
+    // A jump is a polynomial in the state transition, so it commutes with
+    // stepping and with other jumps.
+    Random a = gens[0];
+    Random b = gens[0];
+    a.longJump();
+    a.next();
+    a.jump();
+    b.next();
+    b.jump();
+    b.longJump();
+    XOR_CHECK(a.next() == b.next(), "longJump() does not commute with next() and jump()");
+
+    streams.longJump();
+    uint64_t results[N];
+    streams.next(results);
+    for (uint i = 0; i < N; ++i)
+    {
+        gens[i].longJump();
+        XOR_CHECK(results[i] == gens[i].next(), "RandomStreams::longJump() differs from Random");
+    }
+
+    print("Random streams: OK\n");
+}
+
 int main(int argc, char **argv)
 {
     testBasicOperations();
     testTransformMatrices();
     testProjectionMatrices();
     testGeometry();
+    testSimd();
+    testPackets();
+    testBatch();
+    testRandomStreams();
     return 0;
 }
@@ -1,13 +1,12 @@
 #pragma once
 
 #include "Core/Core.hpp"
+#include "Core/FlatHash.hpp"
 
 // A directed edge data structure for mesh processing:
 // https://www.graphics.rwth-aachen.de/media/papers/directed.pdf
 
 #include <vector>
-#include <unordered_set>
-#include <unordered_map>
 
 namespace Xor
 {
@@ -673,7 +672,7 @@ namespace Xor
         {
             int numEs = numEdges();
 
-            std::unordered_map<int64_t, int> connectingEdges;
+            FlatHashMap<int64_t, int> connectingEdges;
             connectingEdges.reserve(numEs);
 
             for (int e = 0; e < numEs; ++e)
@@ -903,13 +902,13 @@ namespace Xor
 
         // Triangles that have already been checked for circumcircle violations
         // during the current insertion.
-        std::unordered_set<int> m_trisExplored;
+        FlatHashSet<int> m_trisExplored;
         // Triangles that will be checked for circumcircle violations.
         std::vector<int> m_trisToExplore;
-        std::unordered_set<int> m_removedEdges;
-        std::unordered_set<int> m_removedTriangles;
+        FlatHashSet<int> m_removedEdges;
+        FlatHashSet<int> m_removedTriangles;
         std::vector<int> m_removedBoundary;
-        std::unordered_map<int, int> m_vertexNeighbors;
+        FlatHashMap<int, int> m_vertexNeighbors;
         int3 m_superTriangle = int3(-1);
     public:
         BowyerWatson(DE &mesh) : mesh(mesh) {}
@@ -1023,11 +1022,9 @@ namespace Xor
 
                 auto updateVertexNeighbors = [&](int vert, int edge)
                 {
-                    auto it = m_vertexNeighbors.find(vert);
-                    if (it == m_vertexNeighbors.end())
-                        m_vertexNeighbors.insert(it, { vert, edge });
-                    else
-                        mesh.edgeUpdateNeighbor(edge, it->second);
+                    auto it = m_vertexNeighbors.emplace(vert, edge);
+                    if (!it.second)
+                        mesh.edgeUpdateNeighbor(edge, it.first->second);
                 };
 
                 updateVertexNeighbors(vs.y, es.y);
@@ -1118,9 +1115,14 @@ namespace Xor
          DE &mesh;
          using Pos = typename DE::VertexPosition;
 
-         std::unordered_set<int> m_affected;
-         std::unordered_set<int> m_edges;
-         std::unordered_set<int> m_nextEdges;
+         FlatHashSet<int> m_affected;
+         FlatHashSet<int> m_edges;
+         FlatHashSet<int> m_nextEdges;
+         FlatHashSet<int> m_prevEdges;
+         // Used by insertVertexNearAnother(), kept to reuse their memory.
+         FlatHashSet<int> m_checkedTriangles;
+         FlatHashSet<int> m_triangles;
+         FlatHashSet<int> m_nextTriangles;
          int4 m_superPolygon = int4(-1);
     public:
 
@@ -1151,7 +1153,8 @@ namespace Xor
             constexpr int MaxLoops = 500;
             int loops = 0;
             int totalLoops = 0; 
-            std::unordered_set<int> prevEdges;
+            auto &prevEdges = m_prevEdges;
+            prevEdges.clear();
 
             while (!m_nextEdges.empty())
             {
@@ -1196,11 +1199,10 @@ namespace Xor
                     }
                 }
 
-                while (!m_edges.empty())
+                // Flips only add edges to m_nextEdges, so m_edges can be
+                // iterated directly.
+                for (int e : m_edges)
                 {
-                    int e = *m_edges.begin();
-                    m_edges.erase(e);
-
                     if (!isLocallyDelaunay(e))
                     {
                         m_affected.emplace(mesh.edgeTriangle(e));
@@ -1218,6 +1220,7 @@ namespace Xor
                         m_nextEdges.emplace(mesh.edgeNext(n));
                     }
                 }
+                m_edges.clear();
             }
 
             if (affectedTriangles)
@@ -1303,24 +1306,23 @@ namespace Xor
             // Search triangles in breadth-first order, starting from the given nearby
             // vertex.
 
-            std::unordered_set<int> checkedTriangles;
-            std::unordered_set<int> triangles;
-            std::unordered_set<int> nextTriangles;
-            triangles.reserve(6);
-            nextTriangles.reserve(6);
-            checkedTriangles.reserve(6);
+            auto &checkedTriangles = m_checkedTriangles;
+            auto &triangles        = m_triangles;
+            auto &nextTriangles    = m_nextTriangles;
+            checkedTriangles.clear();
+            nextTriangles.clear();
 
             mesh.vertexForEachTriangle(v, [&] (int t) { nextTriangles.emplace(t); });
 
             while (!nextTriangles.empty())
             {
                 triangles.swap(nextTriangles);
+                nextTriangles.clear();
 
-                while (!triangles.empty())
+                // New triangles only go to nextTriangles, so triangles
+                // can be iterated directly.
+                for (int t : triangles)
                 {
-                    int t = *triangles.begin();
-                    triangles.erase(triangles.begin());
-
                     auto vs = mesh.triangleVertexPositions(t);
 
                     if (isPointInsideTriangleUnknownWinding(
@@ -1483,6 +1485,10 @@ namespace Xor
 
         ClusteredMesh mesh;
 
+        // The temporaries below only live until the function returns.
+        // The hash sets still allocate their tables from the heap.
+        FrameArenaScope arenaScope;
+
         int numIndices   = int(indexBuffer.size());
         int numTriangles = numIndices / 3;
         int numVertices  = 0;
@@ -1494,8 +1500,8 @@ namespace Xor
 
         // Scan the index buffer again to find out how many triangles
         // contain each vertex. Degenerates only count double or triple.
-        std::vector<int> numTrianglesContainingVertex(numVertices, 0);
-        std::vector<std::unordered_set<int>> verticesByTriangleCount;
+        FrameVector<int> numTrianglesContainingVertex(numVertices, 0);
+        FrameVector<FlatHashSet<int>> verticesByTriangleCount;
         for (int t = 0; t < numTriangles; ++t)
         {
             int3 vs = tri(t);
@@ -1505,7 +1511,7 @@ namespace Xor
         }
 
         // Allocate space for vertex triangle associations using an inclusive prefix sum.
-        std::vector<int> containingVertexOffsets;
+        FrameVector<int> containingVertexOffsets;
         {
             containingVertexOffsets.reserve(numVertices);
             int total = 0;
@@ -1525,7 +1531,7 @@ namespace Xor
         }
 
         // The last element of the prefix sum is also the total amount.
-        std::vector<int> containingVertexData(containingVertexOffsets.back());
+        FrameVector<int> containingVertexData(containingVertexOffsets.back());
 
         // Scan the triangles again to insert the vertex triangle associations.
         for (int t = 0; t < numTriangles; ++t)
@@ -1567,8 +1573,8 @@ namespace Xor
         };
 
         // Approximate the vertex cache using a FIFO cache
-        std::vector<int> cacheTimestamps(numVertices, -1);
-        std::vector<int> vertsInCache(cacheSize, -1);
+        FrameVector<int> cacheTimestamps(numVertices, -1);
+        FrameVector<int> vertsInCache(cacheSize, -1);
         int cacheTime = 0;
         auto vertexIsInCache = [&] (int v)
         {
@@ -1588,7 +1594,7 @@ namespace Xor
 
 
         int numEmittedTriangles = 0;
-        std::vector<uint8_t> emittedTriangle(numTriangles, 0);
+        FrameVector<uint8_t> emittedTriangle(numTriangles, 0);
 
         auto cacheMissesToEmit = [&] (int v)
         {
@@ -1616,7 +1622,7 @@ namespace Xor
         int clusterCutoff   = clusterSize * 3;
         Block32 currentCluster(0, 0);
 
-        std::vector<std::unordered_set<int>> boundary(verticesByTriangleCount.size());
+        FrameVector<FlatHashSet<int>> boundary(verticesByTriangleCount.size());
         auto leastTrianglesLeftOnBoundary = [&]
         {
             // The boundary is organized by amount of triangles remaining,
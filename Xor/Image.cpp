@@ -5,6 +5,8 @@
 #include "external/FreeImage/FreeImage.h"
 #include "external/Compressonator/Compressonator.h"
 
+#include <numeric>
+
 namespace Xor
 {
     struct ImageHeader
@@ -209,6 +211,12 @@ namespace Xor
 
     Image::Image(const ImageData & sourceData)
     {
+        if (!sourceData.isRowMajor())
+        {
+            *this = Image(RWImageData(sourceData, ImageLayout::RowMajor));
+            return;
+        }
+
         m_state = std::make_shared<State>();
         m_state->arraySize = 1;
         m_state->mipLevels = 1;
@@ -223,6 +231,61 @@ namespace Xor
         memcpy(sr.data.data(), sourceData.data.data(), sr.data.sizeBytes());
     }
 
+    RWImageData::RWImageData(const ImageData &source, ImageLayout layout)
+        : RWImageData(source.size, source.format, layout)
+    {
+        XOR_ASSERT(!format.isCompressed(), "Converting block compressed images is not supported");
+
+        if (layout == ImageLayout::ZOrderTiled)
+        {
+            // Write the tiles sequentially, using the pixel coordinates
+            // of each tile in storage order.
+            std::vector<uint64_t> mortonIndices(ZOrderTiles::TileArea);
+            std::vector<uint2> inTile(ZOrderTiles::TileArea);
+            std::iota(mortonIndices.begin(), mortonIndices.end(), 0);
+            morton2DDecode(mortonIndices, inTile);
+
+            ZOrderTiles tiles(size);
+            uint8_t *dst = mutableData.data();
+
+            for (uint ty = 0; ty < tiles.tiles.y; ++ty)
+            {
+                for (uint tx = 0; tx < tiles.tiles.x; ++tx)
+                {
+                    uint2 origin = uint2(tx, ty) * ZOrderTiles::TileSize;
+                    for (uint2 c : inTile)
+                    {
+                        c += origin;
+                        if (all(c < size))
+                            memcpy(dst, &source.data[source.pixelOffset(c)], pixelSize);
+                        else
+                            memset(dst, 0, pixelSize);
+                        dst += pixelSize;
+                    }
+                }
+            }
+        }
+        else if (source.isRowMajor())
+        {
+            for (uint y = 0; y < size.y; ++y)
+            {
+                auto src = source.scanline<uint8_t>(y);
+                memcpy(scanline<uint8_t>(y).data(), src.data(), src.sizeBytes());
+            }
+        }
+        else
+        {
+            for (uint y = 0; y < size.y; ++y)
+            {
+                for (uint x = 0; x < size.x; ++x)
+                {
+                    uint2 c(x, y);
+                    memcpy(&mutableData[pixelOffset(c)], &source.data[source.pixelOffset(c)], pixelSize);
+                }
+            }
+        }
+    }
+
     uint2 Image::size() const
     {
         return m_state->subresources[0].size;
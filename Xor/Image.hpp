@@ -101,6 +101,16 @@ namespace Xor
 
     uint computePitch(Format format, uint2 size);
 
+    enum class ImageLayout : uint8_t
+    {
+        // Scanlines one after another, with pitch bytes between them.
+        // This is the layout used by files and GPU uploads.
+        RowMajor,
+        // Tiles of ZOrderTiles, which keeps 2D neighborhoods close
+        // in memory for random access on the CPU. Has no pitch.
+        ZOrderTiled,
+    };
+
     struct ImageData
     {
         Span<const uint8_t> data;
@@ -108,14 +118,26 @@ namespace Xor
         uint2 size;
         uint pitch     = 0;
         uint pixelSize = 0;
+        ImageLayout layout = ImageLayout::RowMajor;
 
         ImageData &setDefaultSizes()
         {
-            pitch     = computePitch(format, size);
+            pitch     = (layout == ImageLayout::RowMajor) ? computePitch(format, size) : 0;
             pixelSize = format.size();
             return *this;
         }
 
+        bool isRowMajor() const { return layout == ImageLayout::RowMajor; }
+
+        size_t pixelOffset(uint2 coords) const
+        {
+            // TODO: Block compressed formats
+            if (isRowMajor())
+                return static_cast<size_t>(coords.y) * pitch + coords.x * pixelSize;
+            else
+                return ZOrderTiles(size).index(coords) * pixelSize;
+        }
+
         float2 normalized(int2 coords) const
         {
             return float2(coords) / float2(size);
@@ -141,13 +163,7 @@ namespace Xor
         const T &pixel(uint2 coords) const
         {
             coords = min(coords, size - 1);
-
-            // TODO: Block compressed formats
-            uint offset =
-                coords.y * pitch +
-                coords.x * pixelSize;
-
-            return reinterpret_cast<const T &>(data[offset]);
+            return reinterpret_cast<const T &>(data[pixelOffset(coords)]);
         }
 
         template <typename T>
@@ -160,6 +176,7 @@ namespace Xor
         template <typename T>
         Span<const T> scanline(uint y) const
         {
+            XOR_ASSERT(isRowMajor(), "Tiled images have no scanlines");
             uint offset = y * pitch;
             uint length = format.areaSizeBytes(size.x);
             return reinterpretSpan<const T>(data(offset, offset + length));
@@ -170,7 +187,10 @@ namespace Xor
 
         size_t sizeBytes() const
         {
-            return static_cast<size_t>(size.y) * pitch;
+            if (isRowMajor())
+                return static_cast<size_t>(size.y) * pitch;
+            else
+                return ZOrderTiles(size).elementCount() * pixelSize;
         }
 
         uint2 areaOfPitch() const { return format.areaOfPitch(size.x, pitch); }
@@ -182,16 +202,22 @@ namespace Xor
         DynamicBuffer<uint8_t> ownedData;
 
         RWImageData() = default;
-        RWImageData(uint2 size, Format format)
+        RWImageData(uint2 size, Format format, ImageLayout layout = ImageLayout::RowMajor)
         {
+            XOR_ASSERT(layout == ImageLayout::RowMajor || !format.isCompressed(),
+                       "Block compressed images must be row-major");
             this->size = size;
             this->format = format;
+            this->layout = layout;
             setDefaultSizes();
             ownedData   = DynamicBuffer<uint8_t>(sizeBytes());
             mutableData = ownedData;
             data        = mutableData;
         }
 
+        // Copy the pixels of any image into the given layout.
+        RWImageData(const ImageData &source, ImageLayout layout);
+
         template <typename T>
         T &pixel(int2 coords)
         {
@@ -202,13 +228,7 @@ namespace Xor
         T &pixel(uint2 coords)
         {
             coords = min(coords, size - 1);
-
-            // TODO: Block compressed formats
-            uint offset =
-                coords.y * pitch +
-                coords.x * pixelSize;
-
-            return reinterpret_cast<T &>(mutableData[offset]);
+            return reinterpret_cast<T &>(mutableData[pixelOffset(coords)]);
         }
 
         template <typename T>
@@ -221,6 +241,7 @@ namespace Xor
         template <typename T>
         Span<T> scanline(uint y)
         {
+            XOR_ASSERT(isRowMajor(), "Tiled images have no scanlines");
             uint offset = y * pitch;
             uint length = format.areaSizeBytes(size.x);
             return reinterpretSpan<T>(mutableData(offset, offset + length));
@@ -1,91 +1,22 @@
 #include "Xor/Material.hpp"
 
 #include "Core/Compression.hpp"
+#include "Core/AssetCache.hpp"
 
 namespace Xor
 {
     Material::Material(String name)
     {
-        m_state = std::make_shared<State>();
+        m_state = makeStatePtr<State>();
         m_state->name = std::move(name);
     }
 
-    struct MaterialFileHeader
-    {
-        static const uint VersionNumber = 1;
-    };
-
-    void Material::import(ChunkFile &materialFile, const info::MaterialInfo &info)
-    {
-        log("Material", "Importing material \"%s\" into \"%s\"\n",
-            name().cStr(),
-            materialFile.path().cStr());
-
-        Timer time;
-
-        size_t bytes = 0;
-        materialFile.mainChunk().writer().writeStruct(MaterialFileHeader {});
-        bytes += albedo().import(materialFile.mainChunk(), info);
-        materialFile.write();
-
-        log("Material", "Imported material \"%s\" in %.2f ms (%.2f MB / s)\n",
-            m_state->name.cStr(),
-            time.milliseconds(),
-            time.bandwidthMB(bytes));
-    }
-
     void Material::load(Device &device, const Info &info)
     {
         if (valid())
         {
             Timer time;
-            size_t loadedBytes = 0;
-
-            bool loadedImported = false;
-            if (info.import)
-            {
-                String materialPath = "materials/" + name() + ".xmat";
-                ChunkFile materialFile(materialPath);
-
-                for (;;)
-                {
-
-                    try
-                    {
-                        loadedBytes = 0;
-                        materialFile.read();
-                        materialFile.mainChunk().reader().readStruct<MaterialFileHeader>();
-                        loadedBytes += albedo().load(device, info, &materialFile.mainChunk());
-                        loadedImported = true;
-                        break;
-                    }
-                    catch (const Exception &) {}
-
-                    // If we got here, reading the material failed. Attempt to import it.
-                    try
-                    {
-                        import(materialFile, info);
-                        // If the import succeeds, try loading it again.
-                        loadedBytes = 0;
-                        materialFile.read();
-                        materialFile.mainChunk().reader().readStruct<MaterialFileHeader>();
-                        loadedBytes += albedo().load(device, info, &materialFile.mainChunk());
-                        loadedImported = true;
-                    }
-                    catch (const Exception &)
-                    {
-                        // If the import fails, bail out.
-                    }
-                    break;
-                }
-            }
-
-            // If the material hasn't been loaded from an imported material
-            // file, load it the old-fashioned way.
-            if (!loadedImported)
-            {
-                loadedBytes += m_state->albedo.load(device, info);
-            }
+            size_t loadedBytes = m_state->albedo.load(device, info);
 
             log("Material", "Loaded material \"%s\" in %.2f ms (%.2f MB / s)\n",
                 m_state->name.cStr(),
@@ -96,15 +27,26 @@ namespace Xor
 
     struct MaterialLayerHeader
     {
-        static const uint VersionNumber = 1;
+        static const uint VersionNumber = 2;
 
-        uint64_t importedTime     = 0;
         uint64_t decompressedSize = 0;
     };
 
+    // Imported textures are identified by the contents of the source
+    // image and all the options that affect the import.
+    static AssetKey importedTextureKey(Span<const uint8_t> source)
+    {
+        return Hash()
+            .string("texture")
+            .pod(MaterialLayerHeader::VersionNumber)
+            .pod(true) // generateMipmaps
+            .pod(true) // compress
+            .bytes(source)
+            .done128();
+    }
+
     size_t MaterialLayer::load(Device &device,
-                               const info::MaterialInfo &info,
-                               const ChunkFile::Chunk *chunk)
+                               const info::MaterialInfo &info)
     {
         if (!filename)
             return 0;
@@ -112,48 +54,78 @@ namespace Xor
         Timer time;
         auto path = this->path(info);
 
-        if (File::exists(path))
+        if (!File::exists(path))
         {
-            if (info.import && chunk)
-            {
-                Reader reader     = chunk->chunk(path).reader();
-                auto fileTime     = File::lastWritten(path);
-                auto header       = reader.readStruct<MaterialLayerHeader>();
-                XOR_THROW(fileTime <= header.importedTime, MaterialException, "Imported texture out of date");
+            log("Material", "Could not find texture \"%s\", skipping\n",
+                filename.cStr());
 
-                auto compressed   = reader.readBlob();
-                auto decompressed = decompressZstd(header.decompressedSize, compressed);
+            return 0;
+        }
 
-                texture = device.createTextureSRV(
-                    Texture::Info(
-                        Image(Image::Builder().blob(decompressed))));
-            }
-            else
+        bool loadedImported = false;
+        if (info.import)
+        {
+            auto &cache = AssetCache::global();
+            auto key    = importedTextureKey(File(path).read());
+
+            auto importedPath = cache.find(key);
+            if (importedPath.empty())
             {
-                texture = device.createTextureSRV(
-                    Texture::Info(
-                        Image(Image::Builder()
-                              .filename(path)
-                              .generateMipmaps())));
+                try
+                {
+                    auto tempPath = cache.temporaryPath(key);
+                    auto discard  = scopeGuard([&] { cache.discard(tempPath); });
+                    import(path, tempPath);
+                    importedPath = cache.insert(key, tempPath);
+                    discard.cancel();
+                }
+                catch (const Exception &) {}
+            }
 
+            if (!importedPath.empty())
+            {
+                try
+                {
+                    loadImported(device, importedPath);
+                    loadedImported = true;
+                }
+                catch (const Exception &) {}
             }
+        }
 
-            auto bytes = texture.texture()->sizeBytes();
+        // If the texture couldn't be imported, load it the old-fashioned way.
+        if (!loadedImported)
+        {
+            texture = device.createTextureSRV(
+                Texture::Info(
+                    Image(Image::Builder()
+                          .filename(path)
+                          .generateMipmaps())));
+        }
 
-            log("Material", "Loaded texture \"%s\" in %.2f ms (%.2f MB / s)\n",
-                filename.cStr(),
-                time.milliseconds(),
-                time.bandwidthMB(bytes));
+        auto bytes = texture.texture()->sizeBytes();
 
-            return bytes;
-        }
-        else
-        {
-            log("Material", "Could not find texture \"%s\", skipping\n",
-                filename.cStr());
+        log("Material", "Loaded texture \"%s\" in %.2f ms (%.2f MB / s)\n",
+            filename.cStr(),
+            time.milliseconds(),
+            time.bandwidthMB(bytes));
 
-            return 0;
-        }
+        return bytes;
+    }
+
+    void MaterialLayer::loadImported(Device &device, const String &importedPath)
+    {
+        ChunkFile textureFile(importedPath);
+        textureFile.readMapped();
+
+        Reader reader     = textureFile.mainChunk().reader();
+        auto header       = reader.readStruct<MaterialLayerHeader>();
+        auto compressed   = reader.readBlob();
+        auto decompressed = decompressZstd(header.decompressedSize, compressed);
+
+        texture = device.createTextureSRV(
+            Texture::Info(
+                Image(Image::Builder().blob(decompressed))));
     }
 
     String MaterialLayer::path(const info::MaterialInfo & info)
@@ -161,49 +133,33 @@ namespace Xor
         return info.basePath ? (info.basePath + "/" + filename) : filename;
     }
 
-    size_t MaterialLayer::import(ChunkFile::Chunk & chunk,
-                                 const info::MaterialInfo &info)
+    void MaterialLayer::import(const String &path, const String &importedPath)
     {
-        if (!filename)
-            return 0;
-
         Timer time;
-        auto path = this->path(info);
 
-        if (File::exists(path))
-        {
-            Timer blockCompressionTime;
-            auto blockCompressed = Image(Image::Builder()
-                                         .filename(path)
-                                         .generateMipmaps()
-                                         .compress())
-                .serialize();
-            log("Material", "    Block compression: %.2f ms\n", blockCompressionTime.milliseconds());
-
-            auto compressed = compressZstd(blockCompressed);
-
-            MaterialLayerHeader header;
-            header.importedTime     = File::lastWritten(path);
-            header.decompressedSize = blockCompressed.sizeBytes();
-
-            auto writer = chunk.setChunk(path).writer(
-                sizeof(header) + 16 + compressed.sizeBytes());
-            writer.writeStruct(header);
-            writer.writeBlob(compressed);
-
-            log("Material", "Imported texture \"%s\" in %.2f ms (%.2f MB / s)\n",
-                filename.cStr(),
-                time.milliseconds(),
-                time.bandwidthMB(blockCompressed.sizeBytes()));
+        Timer blockCompressionTime;
+        auto blockCompressed = Image(Image::Builder()
+                                     .filename(path)
+                                     .generateMipmaps()
+                                     .compress())
+            .serialize();
+        log("Material", "    Block compression: %.2f ms\n", blockCompressionTime.milliseconds());
 
-            return blockCompressed.sizeBytes();
-        }
-        else
-        {
-            log("Material", "Could not find texture \"%s\", skipping\n",
-                filename.cStr());
+        auto compressed = compressZstd(blockCompressed);
 
-            return 0;
-        }
+        MaterialLayerHeader header;
+        header.decompressedSize = blockCompressed.sizeBytes();
+
+        ChunkFile textureFile(importedPath);
+        auto writer = textureFile.mainChunk().writer(
+            sizeof(header) + 16 + compressed.sizeBytes());
+        writer.writeStruct(header);
+        writer.writeBlob(compressed);
+        textureFile.write();
+
+        log("Material", "Imported texture \"%s\" in %.2f ms (%.2f MB / s)\n",
+            filename.cStr(),
+            time.milliseconds(),
+            time.bandwidthMB(blockCompressed.sizeBytes()));
     }
 }
@@ -36,11 +36,10 @@ namespace Xor
 
     private:
         String path(const info::MaterialInfo &info);
-        size_t import(ChunkFile::Chunk &chunk,
-                      const info::MaterialInfo &info);
+        void import(const String &path, const String &importedPath);
+        void loadImported(Device &device, const String &importedPath);
         size_t load(Device &device,
-                    const info::MaterialInfo &info,
-                    const ChunkFile::Chunk *chunk = nullptr);
+                    const info::MaterialInfo &info);
     };
 
     class Material
@@ -50,9 +49,8 @@ namespace Xor
             String name;
             MaterialLayer albedo;
         };
-        std::shared_ptr<State> m_state;
+        StatePtr<State> m_state;
 
-        void import(ChunkFile &materialFile, const info::MaterialInfo &info);
     public:
         using Info    = info::MaterialInfo;
         using Builder = info::MaterialInfoBuilder;
@@ -2,9 +2,12 @@
 #include "Xor/Material.hpp"
 #include "Xor/Xor.hpp"
 
-#include "Core/Compression.hpp"
+#include "Core/StreamFilters.hpp"
+#include "Core/AssetCache.hpp"
 
 #include "external/assimp/assimp/Importer.hpp"
+#include "external/assimp/assimp/IOSystem.hpp"
+#include "external/assimp/assimp/IOStream.hpp"
 #include "external/assimp/assimp/scene.h"
 #include "external/assimp/assimp/postprocess.h"
 
@@ -26,19 +29,133 @@ namespace Xor
 
     struct MeshFileHeader
     {
-        static const uint VersionNumber = 1;
+        static const uint VersionNumber = 4;
     };
 
-    Mesh::LoadedMeshFile Mesh::loadFromImported(const Info &meshInfo)
+    // Vertex and index streams are filtered before compression, and the
+    // filters used are stored in front of each stream.
+    static uint vertexStreamFilters(const char *semantic, Format format, bool quantize)
     {
-        LoadedMeshFile loaded;
+        bool floats = format == DXGI_FORMAT_R32G32_FLOAT       ||
+                      format == DXGI_FORMAT_R32G32B32_FLOAT    ||
+                      format == DXGI_FORMAT_R32G32B32A32_FLOAT;
+        // Positions are left exact, since cracks between meshes would show.
+        bool quantizable = strcmp(semantic, "NORMAL")   == 0 ||
+                           strcmp(semantic, "TANGENT")  == 0 ||
+                           strcmp(semantic, "BINORMAL") == 0 ||
+                           strcmp(semantic, "TEXCOORD") == 0;
+
+        uint filters = StreamFilter::ByteShuffle;
+        if (quantize && floats && quantizable)
+            filters |= StreamFilter::Quantize16;
+        return filters;
+    }
+
+    static const uint IndexStreamFilters = StreamFilter::Delta | StreamFilter::ByteShuffle;
+
+    // Vertex and index streams smaller than this are compressed using
+    // a dictionary trained on them, if there are enough of them.
+    static const size_t SmallStreamSize      = 64 * 1024;
+    static const size_t MinDictionarySamples = 16;
+
+    // Imported meshes are identified by the contents of the source file
+    // and all the options that affect the import. Other files that the
+    // source refers to, such as .mtl libraries, are only known after
+    // importing, so they are checked separately when loading.
+    static AssetKey importedMeshKey(const Mesh::Info &meshInfo)
+    {
+        auto source = File(meshInfo.filename).read();
+        return Hash()
+            .string("xmesh")
+            .pod(MeshFileHeader::VersionNumber)
+            .pod(meshInfo.calculateTangentSpace)
+            .pod(meshInfo.quantizeAttributes)
+            .bytes(source)
+            .done128();
+    }
+
+    static AssetKey dependencyKey(const String &path)
+    {
+        auto contents = File(path).read();
+        return Hash().bytes(contents).done128();
+    }
+
+    // Forwards all file accesses to Assimp's own file system, and
+    // records the names of all files that the importer opens.
+    class RecordingIOSystem : public Assimp::IOSystem
+    {
+        // Assimp's default file system is not public, so borrow
+        // it from another importer.
+        Assimp::Importer     m_fileSystemOwner;
+        Assimp::IOSystem    &m_fileSystem;
+        std::vector<String>  m_opened;
+    public:
+        RecordingIOSystem()
+            : m_fileSystem(*m_fileSystemOwner.GetIOHandler())
+        {}
+
+        const std::vector<String> &opened() const { return m_opened; }
+
+        bool Exists(const char *pFile) const override
+        {
+            return m_fileSystem.Exists(pFile);
+        }
+
+        char getOsSeparator() const override
+        {
+            return m_fileSystem.getOsSeparator();
+        }
+
+        Assimp::IOStream *Open(const char *pFile, const char *pMode) override
+        {
+            auto stream = m_fileSystem.Open(pFile, pMode);
+            if (stream)
+            {
+                String file(pFile);
+                if (std::find(m_opened.begin(), m_opened.end(), file) == m_opened.end())
+                    m_opened.emplace_back(std::move(file));
+            }
+            return stream;
+        }
+
+        void Close(Assimp::IOStream *pFile) override
+        {
+            m_fileSystem.Close(pFile);
+        }
+
+        bool ComparePaths(const char *one, const char *second) const override
+        {
+            return m_fileSystem.ComparePaths(one, second);
+        }
+    };
 
-        String meshFilePath = "meshes/" + meshInfo.stem() + ".xmesh";
+    Mesh::LoadedMeshFile Mesh::loadFromImported(const String &meshFilePath)
+    {
+        LoadedMeshFile loaded;
 
         ChunkFile meshFile(meshFilePath);
-        meshFile.read();
+        meshFile.readMapped();
         auto &main = meshFile.mainChunk();
         main.reader().readStruct<MeshFileHeader>();
+        // Decompress all vertex and index data in parallel.
+        main.read();
+
+        // If any of the other files the mesh was imported from have
+        // changed, the mesh needs to be imported again.
+        if (auto deps = main.maybeChunk("dependencies"))
+        {
+            auto reader = deps->reader();
+            uint count  = reader.read<uint>();
+            for (uint i = 0; i < count; ++i)
+            {
+                String path = reader.readString();
+                auto key    = reader.read<AssetKey>();
+
+                XOR_THROW(File::exists(path) && dependencyKey(path) == key, MeshException,
+                          "Imported mesh dependency \"%s\" has changed", path.cStr());
+                loaded.dependencies.emplace_back(std::move(path));
+            }
+        }
 
         if (auto mats = main.maybeChunk("materials"))
         {
@@ -60,7 +177,7 @@ namespace Xor
             {
                 loaded.meshes.emplace_back();
                 auto &dst = loaded.meshes.back().m_state;
-                dst = std::make_shared<Mesh::State>();
+                dst = makeStatePtr<Mesh::State>();
 
                 auto il = info::InputLayoutInfoBuilder();
                 uint streams = 0;
@@ -90,15 +207,13 @@ namespace Xor
                     if (auto attrChunk = kv.second->maybeChunk(attr))
                     {
                         auto r = attrChunk->reader();
-                        auto format = r.read<Format>();
+                        auto format  = r.read<Format>();
+                        auto filters = r.read<uint8_t>();
                         il.element(attr, 0, format, streams);
                         dst->vertexBuffers.emplace_back();
                         auto &d = dst->vertexBuffers.back();
                         d.format = format;
-
-                        uint decompressedSize = r.readLength();
-                        auto compressed = r.readBlob();
-                        d.data = decompressZstd(decompressedSize, compressed);
+                        d.data   = decodeStream(filters, r.readBlob(), format.size());
 
                         ++streams;
                     }
@@ -107,12 +222,10 @@ namespace Xor
                 if (auto idxChunk = kv.second->maybeChunk("indices"))
                 {
                     auto r = idxChunk->reader();
-                    auto format = r.read<Format>();
+                    auto format  = r.read<Format>();
+                    auto filters = r.read<uint8_t>();
                     dst->indexBuffer.format = format;
-
-                    uint decompressedSize = r.readLength();
-                    auto compressed = r.readBlob();
-                    dst->indexBuffer.data = decompressZstd(decompressedSize, compressed);
+                    dst->indexBuffer.data   = decodeStream(filters, r.readBlob(), format.size());
 
                     dst->numIndices = static_cast<uint>(dst->indexBuffer.data.sizeBytes() / format.size());
                 }
@@ -129,10 +242,8 @@ namespace Xor
         return loaded;
     }
 
-    void Mesh::importMeshes(const Info &meshInfo, LoadedMeshFile &loaded)
+    void Mesh::importMeshes(const Info &meshInfo, LoadedMeshFile &loaded, const String &meshFilePath)
     {
-        String meshFilePath = "meshes/" + meshInfo.stem() + ".xmesh";
-
         std::unordered_map<String, uint> materialIndices;
         for (auto &m : loaded.materials)
             materialIndices[m.second.name()] = m.first;
@@ -150,6 +261,19 @@ namespace Xor
         auto &main = meshFile.mainChunk();
         main.writer().writeStruct(MeshFileHeader {});
 
+        std::vector<ChunkFile::Chunk *> smallStreams;
+
+        if (!loaded.dependencies.empty())
+        {
+            auto writer = main.setChunk("dependencies").writer();
+            writer.write(static_cast<uint>(loaded.dependencies.size()));
+            for (auto &path : loaded.dependencies)
+            {
+                writer.writeString(path);
+                writer.write(dependencyKey(path));
+            }
+        }
+
         if (!loaded.materials.empty())
         {
             auto &mats = main.setChunk("materials");
@@ -180,35 +304,69 @@ namespace Xor
 
                 for (uint s = 0; s < m.numVertexAttributes(); ++s)
                 {
-                    auto writer = chunk.setChunk(layout[s].SemanticName).writer();
-                    auto &attr = m.vertexAttribute(s);
-                    writer.write(attr.format);
+                    auto &attrChunk = chunk.setChunk(layout[s].SemanticName);
+                    attrChunk.setCodec(ChunkFile::Codec::ZstdFrames);
 
-                    auto decompressedSize = static_cast<uint>(attr.data.sizeBytes());
-                    auto compressed = compressZstd(attr.data);
+                    auto writer  = attrChunk.writer();
+                    auto &attr   = m.vertexAttribute(s);
+                    auto filters = vertexStreamFilters(layout[s].SemanticName, attr.format,
+                                                       meshInfo.quantizeAttributes);
+                    writer.write(attr.format);
+                    writer.write(static_cast<uint8_t>(filters));
+                    writer.writeBlob(encodeStream(filters, attr.data, attr.format.size()));
 
-                    writer.writeLength(decompressedSize);
-                    writer.writeBlob(compressed);
+                    if (attr.data.sizeBytes() < SmallStreamSize)
+                        smallStreams.emplace_back(&attrChunk);
                 }
 
                 if (!m.indices().data.empty())
                 {
-                    auto writer = chunk.setChunk("indices").writer();
+                    auto &idxChunk = chunk.setChunk("indices");
+                    idxChunk.setCodec(ChunkFile::Codec::ZstdFrames);
 
+                    auto writer = idxChunk.writer();
                     auto &idx = m.indices();
                     writer.write(idx.format);
+                    writer.write(static_cast<uint8_t>(IndexStreamFilters));
+                    writer.writeBlob(encodeStream(IndexStreamFilters, idx.data, idx.format.size()));
 
-                    auto decompressedSize = static_cast<uint>(idx.data.sizeBytes());
-                    auto compressed = compressZstd(idx.data);
-
-                    writer.writeLength(decompressedSize);
-                    writer.writeBlob(compressed);
+                    if (idx.data.sizeBytes() < SmallStreamSize)
+                        smallStreams.emplace_back(&idxChunk);
                 }
 
                 ++meshNumber;
             }
         }
 
+        if (smallStreams.size() >= MinDictionarySamples)
+        {
+            std::vector<Span<const uint8_t>> samples;
+            size_t sampleBytes = 0;
+            for (auto c : smallStreams)
+            {
+                auto r = c->reader();
+                samples.emplace_back(r.readBytes(r.bytesLeft()));
+                sampleBytes += samples.back().size();
+            }
+
+            // If training fails, or the dictionary does not pay for
+            // itself, the streams just get compressed without it.
+            try
+            {
+                auto dictionary = ZstdDictionary::train(
+                    samples, std::min(ZstdDefaultDictionarySize, sampleBytes / 10));
+
+                if (dictionary.improvesCompression(samples))
+                {
+                    meshFile.setDictionary(std::move(dictionary));
+
+                    for (auto c : smallStreams)
+                        c->setCodec(ChunkFile::Codec::ZstdDictionary);
+                }
+            }
+            catch (const CompressionException &) {}
+        }
+
         meshFile.write();
     }
 
@@ -217,6 +375,10 @@ namespace Xor
         LoadedMeshFile loaded;
 
         Assimp::Importer importer;
+        // The importer owns its file system.
+        auto fileSystem = new RecordingIOSystem();
+        importer.SetIOHandler(fileSystem);
+
         auto scene = importer.ReadFile(
             meshInfo.filename.cStr(),
             aiProcess_Triangulate           |
@@ -227,6 +389,15 @@ namespace Xor
              aiProcess_CalcTangentSpace : 0)
         );
 
+        XOR_THROW(scene, MeshException, "Could not import \"%s\": %s",
+                  meshInfo.filename.cStr(), importer.GetErrorString());
+
+        for (auto &file : fileSystem->opened())
+        {
+            if (!fileSystem->ComparePaths(file.cStr(), meshInfo.filename.cStr()))
+                loaded.dependencies.emplace_back(file);
+        }
+
         loaded.meshes.reserve(scene->mNumMeshes);
 
         for (uint m = 0; m < scene->mNumMaterials; ++m)
@@ -252,7 +423,7 @@ namespace Xor
 
             loaded.meshes.emplace_back();
             auto &dst = loaded.meshes.back().m_state;
-            dst = std::make_shared<Mesh::State>();
+            dst = makeStatePtr<Mesh::State>();
 
             auto il = info::InputLayoutInfoBuilder();
             uint streams = 0;
@@ -365,23 +536,34 @@ namespace Xor
 
         if (meshInfo.import)
         {
-            for (;;)
+            auto &cache = AssetCache::global();
+            auto key    = importedMeshKey(meshInfo);
+            bool cached = false;
+
+            auto cachedPath = cache.find(key);
+            if (!cachedPath.empty())
             {
                 try
                 {
-                    loaded = loadFromImported(meshInfo);
-                    break;
+                    loaded = loadFromImported(cachedPath);
+                    cached = true;
                 }
                 catch (const Exception &) {}
+            }
+
+            if (!cached)
+            {
+                loaded = loadFromSource(meshInfo);
 
                 try
                 {
-                    loaded = loadFromSource(meshInfo);
-                    importMeshes(meshInfo, loaded);
+                    auto tempPath = cache.temporaryPath(key);
+                    auto discard  = scopeGuard([&] { cache.discard(tempPath); });
+                    importMeshes(meshInfo, loaded, tempPath);
+                    cache.insert(key, tempPath);
+                    discard.cancel();
                 }
                 catch (const Exception &) {}
-
-                break;
             }
         }
         else
@@ -433,7 +615,7 @@ namespace Xor
                         Span<const uint> indices)
     {
         Mesh m;
-        m.m_state = std::make_shared<State>();
+        m.m_state = makeStatePtr<State>();
         auto &s = *m.m_state;
 
         info::InputLayoutInfoBuilder il;
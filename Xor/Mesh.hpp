@@ -20,6 +20,9 @@ namespace Xor
             bool calculateTangentSpace = true;
             bool loadMaterials = false;
             bool import = false;
+            // Store normals, tangents and texture coordinates of imported
+            // meshes quantized to 16 bits, which makes the files smaller.
+            bool quantizeAttributes = false;
 
             MeshInfo() = default;
             MeshInfo(String filename) : filename(std::move(filename)) {}
@@ -32,9 +35,12 @@ namespace Xor
             MeshInfoBuilder &calculateTangentSpace(bool tangents = true) { MeshInfo::calculateTangentSpace = tangents; return *this; }
             MeshInfoBuilder &loadMaterials(bool load = true) { MeshInfo::loadMaterials = load; return *this; }
             MeshInfoBuilder &import(bool import = true) { MeshInfo::import = import; return *this; }
+            MeshInfoBuilder &quantizeAttributes(bool quantize = true) { MeshInfo::quantizeAttributes = quantize; return *this; }
         };
     }
 
+    XOR_EXCEPTION_TYPE(MeshException)
+
     template <typename View = bool>
     struct MeshData
     {
@@ -71,16 +77,19 @@ namespace Xor
         using Builder = info::MeshInfoBuilder;
     private:
         struct State;
-        std::shared_ptr<State> m_state;
+        StatePtr<State> m_state;
 
         struct LoadedMeshFile
         {
             std::vector<Mesh> meshes;
             std::unordered_map<uint, Material> materials;
+            // Files other than the main source file that the
+            // meshes were imported from.
+            std::vector<String> dependencies;
         };
-        static LoadedMeshFile loadFromImported(const Info & meshInfo);
+        static LoadedMeshFile loadFromImported(const String &meshFilePath);
         static LoadedMeshFile loadFromSource(const Info & meshInfo);
-        static void importMeshes(const Info & meshInfo, LoadedMeshFile &loaded);
+        static void importMeshes(const Info & meshInfo, LoadedMeshFile &loaded, const String &meshFilePath);
 
     public:
 
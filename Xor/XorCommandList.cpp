@@ -780,6 +780,7 @@ namespace Xor
 
     void CommandList::updateTexture(Texture & texture, ImageData data, ImageRect dstPos)
     {
+        XOR_ASSERT(data.isRowMajor(), "Textures must be uploaded from row-major images");
         auto block = uploadBytes(data.data, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
 
         D3D12_TEXTURE_COPY_LOCATION dst = {};
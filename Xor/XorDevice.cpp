@@ -200,6 +200,12 @@ namespace Xor
 
         S().shaderLoader->registerShaderTlog(XOR_PROJECT_NAME, XOR_PROJECT_TLOG);
 
+        {
+            char traceDirectory[MAX_PATH] = {};
+            if (GetEnvironmentVariableA("XOR_ALLOCATION_TRACES", traceDirectory, MAX_PATH) > 0)
+                traceAllocations(traceDirectory);
+        }
+
         {
             uint8_t *pixels = nullptr;
             int2 size;
@@ -1133,6 +1139,11 @@ namespace Xor
         ++S().frameNumber;
     }
 
+    void Device::traceAllocations(const String &directory)
+    {
+        S().traceAllocations(directory);
+    }
+
     void Device::resetFrameNumber(uint64_t newFrameNumber)
     {
         S().frameNumber = newFrameNumber;
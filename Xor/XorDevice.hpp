@@ -103,6 +103,13 @@ namespace Xor
         void waitUntilCompleted(SeqNum seqNum);
         void waitUntilDrained();
 
+        // Record all allocations of the transient upload, readback and
+        // descriptor allocators, and save them into the given directory
+        // when the device is destroyed, for replaying with AllocationReplay.
+        // Setting the XOR_ALLOCATION_TRACES environment variable to a
+        // directory does this for every device.
+        void traceAllocations(const String &directory);
+
     private:
         ID3D12Device *device();
 
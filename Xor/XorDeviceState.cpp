@@ -135,6 +135,7 @@ namespace Xor
         DeviceState::~DeviceState()
         {
             waitUntilDrained();
+            saveAllocationTraces();
 #if 0
             ComPtr<ID3D12DebugDevice> debug;
             XOR_CHECK_HR(device.As(&debug));
@@ -142,6 +143,60 @@ namespace Xor
 #endif
         }
 
+        void DeviceState::traceAllocations(String directory)
+        {
+            XOR_CHECK(allocationTraces.empty(), "Allocations are already being traced.");
+
+            allocationTraceDirectory = std::move(directory);
+
+            auto newTrace = [&] (const char *name, size_t capacity)
+            {
+                allocationTraces.emplace_back(std::make_unique<AllocationTrace>(name, capacity));
+                return allocationTraces.back().get();
+            };
+
+            uploadHeap->allocator.setTrace(newTrace("Upload", uploadHeap->size()));
+            readbackHeap->allocator.setTrace(newTrace("Readback", readbackHeap->size()));
+            shaderViews.setTransientTrace(newTrace("ShaderViews", shaderViews.transientSize()));
+
+            log("Device", "Tracing transient allocations into \"%s\"\n",
+                allocationTraceDirectory.cStr());
+        }
+
+        void DeviceState::saveAllocationTraces()
+        {
+            if (allocationTraces.empty())
+                return;
+
+            // The heaps can outlive the device, so stop tracing first.
+            uploadHeap->allocator.setTrace(nullptr);
+            readbackHeap->allocator.setTrace(nullptr);
+            shaderViews.setTransientTrace(nullptr);
+
+            std::error_code error;
+            fs::create_directories(allocationTraceDirectory.cStr(), error);
+
+            for (auto &trace : allocationTraces)
+            {
+                auto filename = String::format("%s/%s.xatr",
+                                               allocationTraceDirectory.cStr(),
+                                               trace->name().cStr());
+                try
+                {
+                    trace->save(filename);
+                    log("Device", "Saved %zu traced allocations into \"%s\"\n",
+                        trace->allocationCount(), filename.cStr());
+                }
+                catch (const Exception &e)
+                {
+                    log("Device", "Could not save allocation trace \"%s\": %s\n",
+                        filename.cStr(), e.what());
+                }
+            }
+
+            allocationTraces.clear();
+        }
+
         void GPUProgressTracking::executeCommandList(CommandList && cmd)
         {
             newestExecuted = std::max(newestExecuted, cmd.number());
@@ -368,6 +423,8 @@ namespace Xor
                 XOR_GPU_TRANSIENT_VERBOSE("    Allocation successful. Chunk is now (%lld, %lld).\n",
                                           free.begin, free.end);
 #endif
+                if (m_trace)
+                    m_trace->allocate(size, alignment, b.begin);
                 return b;
             }
             // If not, get a new chunk.
@@ -390,6 +447,8 @@ namespace Xor
                 auto b = free.fitAtBegin(size, alignment);
                 XOR_ASSERT(b.valid(), "Allocation failed with an empty chunk");
                 free.begin = b.end;
+                if (m_trace)
+                    m_trace->allocate(size, alignment, b.begin);
                 return b;
             }
         }
@@ -436,7 +495,10 @@ namespace Xor
 
                 // Now we reclaim the chunks, and can throw away the original owner numbers.
                 for (auto it = freeFrom; it < m_usedChunks.end(); ++it)
+                {
                     m_freeChunks.emplace_back(it->second);
+                    traceReleasedChunk(it->second);
+                }
 
                 m_usedChunks.erase(freeFrom, m_usedChunks.end());
 
@@ -459,6 +521,7 @@ namespace Xor
                     progress.waitUntilCompleted(c.first);
                     ChunkNumber newlyReleased = c.second;
                     m_usedChunks.erase(m_usedChunks.begin() + i);
+                    traceReleasedChunk(newlyReleased);
                     return newlyReleased;
                 }
             }
@@ -468,6 +531,15 @@ namespace Xor
             return -1;
         }
 
+        void GPUTransientMemoryAllocator::traceReleasedChunk(ChunkNumber chunk)
+        {
+            if (m_trace)
+            {
+                int64_t begin = chunk * m_chunkSize;
+                m_trace->releaseRange(Block(begin, begin + m_chunkSize));
+            }
+        }
+
         void ProfilingEventData::writeTime(double milliseconds)
         {
             uint i = writes % static_cast<uint>(timesMs.size());
@@ -81,12 +81,18 @@ namespace Xor
             std::vector<std::pair<SeqNum, ChunkNumber>> m_usedChunks;
 
             String m_name;
+            AllocationTrace *m_trace = nullptr;
+
+            void traceReleasedChunk(ChunkNumber chunk);
         public:
             GPUTransientMemoryAllocator() = default;
             GPUTransientMemoryAllocator(size_t size, size_t chunkSize,
                                         String name = String());
 
             size_t size() const { return static_cast<size_t>(m_size); }
+            // Record all allocations, and their releases when their
+            // chunks get reclaimed, into the given trace.
+            void setTrace(AllocationTrace *trace) { m_trace = trace; }
             size_t usedCount() const
             {
                 size_t numFreeChunks = m_freeChunks.size();
@@ -105,7 +111,7 @@ namespace Xor
         {
             ComPtr<ID3D12DescriptorHeap> m_stagingHeap;
             ComPtr<ID3D12DescriptorHeap> m_heap;
-            OffsetPool                   m_freeDescriptors;
+            ConcurrentOffsetPool         m_freeDescriptors;
             GPUTransientMemoryAllocator  m_transientAllocator;
             GPUTransientChunk            m_transientChunk;
             uint                         m_transientStart = 0;
@@ -166,7 +172,7 @@ namespace Xor
                 }
 
                 m_transientStart     = totalSize - transientSize;
-                m_freeDescriptors    = OffsetPool(m_transientStart);
+                m_freeDescriptors    = ConcurrentOffsetPool(m_transientStart);
 
                 if (transientSize)
                     m_transientAllocator = GPUTransientMemoryAllocator(transientSize, transientSize / NumChunks, "ViewHeap");
@@ -248,6 +254,7 @@ namespace Xor
 
             size_t transientSize() const { return m_transientAllocator.size(); }
             size_t transientUsed() const { return m_transientAllocator.usedCount(); }
+            void setTransientTrace(AllocationTrace *trace) { m_transientAllocator.setTrace(trace); }
         };
 
         template <D3D12_HEAP_TYPE HeapType>
@@ -527,12 +534,20 @@ namespace Xor
 
             ComPtr<ID3D12Fence> drainFence;
 
+            // Traces of the transient allocators, which are saved into
+            // allocationTraceDirectory when the device is destroyed.
+            String allocationTraceDirectory;
+            std::vector<std::unique_ptr<AllocationTrace>> allocationTraces;
+
             DeviceState(Adapter adapter_,
                         ComPtr<ID3D12Device> pDevice,
                         std::shared_ptr<backend::ShaderLoader> pShaderLoader);
 
             ~DeviceState();
 
+            void traceAllocations(String directory);
+            void saveAllocationTraces();
+
             ViewHeap &viewHeap(D3D12_DESCRIPTOR_HEAP_TYPE type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV)
             {
                 switch (type)